@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <chrono>
+#include <core/global/globals.hpp>
+#include <core/hotkeys/index.hpp>
+#include <core/objects/search.hpp>
+#include <cstdint>
+#include <functional>
+#include <helper/audio/mixer/kernels.hpp>
+#include <helper/audio/mixer/mixer.hpp>
+#include <helper/base64/base64.hpp>
+#include <helper/json/bindings.hpp>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+//* Prints the results in the same shape as the json reporter of Google Benchmark, so that the usual tooling can
+//* compare runs. A substring given as the first argument only runs the benchmarks whose name contains it.
+
+using namespace Soundux::Objects;
+using namespace std::chrono_literals;
+
+namespace
+{
+    constexpr auto minTime = 250ms;
+    constexpr std::uint32_t channels = 2;
+    constexpr std::uint32_t sampleRate = 48000;
+    constexpr std::uint32_t period = 480;
+
+    struct Result
+    {
+        std::string name;
+        std::uint64_t iterations;
+        double nsPerIteration;
+        double itemsPerSecond;
+    };
+
+    std::vector<Result> results;
+    std::string filter;
+    std::mt19937 random(1337); // NOLINT
+    //* Results are written here so that the work of a benchmark can not be optimized away
+    volatile std::size_t sink = 0;
+
+    //* `prepare` runs before every iteration and is not measured, `items` is what one iteration processes
+    void run(const std::string &name, double items, const std::function<void()> &body,
+             const std::function<void()> &prepare = {})
+    {
+        if (name.find(filter) == std::string::npos)
+        {
+            return;
+        }
+
+        if (prepare)
+        {
+            prepare();
+        }
+        body();
+
+        std::uint64_t iterations = 0;
+        std::chrono::nanoseconds elapsed{};
+
+        while (elapsed < minTime)
+        {
+            if (prepare)
+            {
+                prepare();
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            body();
+            elapsed += std::chrono::steady_clock::now() - begin;
+            iterations++;
+        }
+
+        auto nsPerIteration = static_cast<double>(elapsed.count()) / static_cast<double>(iterations);
+        results.push_back({name, iterations, nsPerIteration, items / nsPerIteration * 1e9});
+
+        std::cerr << name << ": " << nsPerIteration << "ns" << std::endl;
+    }
+
+    std::vector<float> noise(std::size_t samples)
+    {
+        std::uniform_real_distribution<float> distribution(-.5F, .5F);
+
+        std::vector<float> rtn(samples);
+        std::generate(rtn.begin(), rtn.end(), [&] { return distribution(random); });
+
+        return rtn;
+    }
+
+    std::vector<Tab> makeTabs(std::size_t tabCount, std::size_t soundsPerTab)
+    {
+        static const std::vector<std::string> words = {"airhorn", "applause", "bass",   "bell",  "boom",   "crowd",
+                                                       "drum",    "explosion", "fail",  "horn",  "kick",   "laugh",
+                                                       "meme",    "nope",      "oof",   "scream", "snare", "wow"};
+        std::uniform_int_distribution<std::size_t> word(0, words.size() - 1);
+
+        std::uint32_t id = 0;
+        std::vector<Tab> tabs;
+
+        for (std::size_t i = 0; tabCount > i; i++)
+        {
+            Tab tab;
+            tab.id = static_cast<std::uint32_t>(i);
+            tab.name = words[word(random)] + " sounds " + std::to_string(i);
+            tab.path = "/home/user/sounds/" + tab.name;
+
+            for (std::size_t j = 0; soundsPerTab > j; j++)
+            {
+                Sound sound;
+                sound.id = ++id;
+                sound.name = words[word(random)] + " " + words[word(random)] + " " + std::to_string(j) + ".mp3";
+                sound.path = tab.path + "/" + sound.name.get();
+                sound.modifiedDate = j;
+
+                tab.sounds.emplace_back(std::move(sound));
+            }
+
+            tabs.emplace_back(std::move(tab));
+        }
+
+        return tabs;
+    }
+
+    void benchKernels()
+    {
+        auto source = noise(static_cast<std::size_t>(period) * channels);
+        std::vector<float> target(source.size());
+
+        run("Kernels::mix/ramp", period, [&] { Kernels::mix(target.data(), source.data(), source.size(), .2F, .8F); });
+        run("Kernels::mix/constant", period,
+            [&] { Kernels::mix(target.data(), source.data(), source.size(), .5F, .5F); });
+
+        auto loud = noise(source.size());
+        std::transform(loud.begin(), loud.end(), loud.begin(), [](float sample) { return sample * 8; });
+        auto buffer = loud;
+        float gain = 1;
+        auto release = static_cast<float>(1 - std::exp(-1000 / (Mixer::limiterReleaseInMs * sampleRate)));
+
+        run(
+            "Kernels::limit", period,
+            [&] { Kernels::limit(buffer.data(), period, channels, Mixer::limiterThreshold, release, gain); },
+            [&] { std::copy(loud.begin(), loud.end(), buffer.begin()); });
+    }
+
+    void benchMixer(std::size_t voiceCount)
+    {
+        Mixer mixer;
+        mixer.setupOffline(channels, sampleRate);
+
+        auto source = noise(static_cast<std::size_t>(period) * channels);
+        std::vector<float> output(source.size());
+
+        std::vector<std::unique_ptr<PlayingSound>> sounds;
+        std::vector<std::unique_ptr<Voice>> voices;
+        std::vector<ma_pcm_rb> ringBuffers(voiceCount);
+
+        for (std::size_t i = 0; voiceCount > i; i++)
+        {
+            //* Traced and remote voices never call into the globals from the mixer
+            auto &sound = sounds.emplace_back(std::make_unique<PlayingSound>());
+            sound->traced = true;
+            sound->repeat = true;
+
+            auto &voice = voices.emplace_back(std::make_unique<Voice>());
+            voice->sound = sound.get();
+            voice->volume = static_cast<float>(i + 1) / static_cast<float>(voiceCount);
+
+            ma_pcm_rb_init(ma_format_f32, channels, period * 2, nullptr, nullptr, &ringBuffers[i]);
+            voice->ringBuffer = &ringBuffers[i];
+            mixer.add(voice.get());
+        }
+
+        auto refill = [&] {
+            for (auto &ringBuffer : ringBuffers)
+            {
+                auto frames = std::min(ma_pcm_rb_available_write(&ringBuffer), period);
+                void *target{};
+
+                if (frames > 0 && ma_pcm_rb_acquire_write(&ringBuffer, &frames, &target) == MA_SUCCESS)
+                {
+                    std::copy_n(source.data(), static_cast<std::size_t>(frames) * channels,
+                                reinterpret_cast<float *>(target));
+                    ma_pcm_rb_commit_write(&ringBuffer, frames);
+                }
+            }
+        };
+
+        run("Mixer::render/" + std::to_string(voiceCount) + " voices", period,
+            [&] { mixer.render(output.data(), period); }, refill);
+
+        for (std::size_t i = 0; voiceCount > i; i++)
+        {
+            mixer.remove(voices[i].get());
+            ma_pcm_rb_uninit(&ringBuffers[i]);
+        }
+    }
+
+    void benchBase64()
+    {
+        //* About the size of a 128x128 RGBA icon
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::string icon(static_cast<std::size_t>(128) * 128 * 4, '\0');
+        std::generate(icon.begin(), icon.end(), [&] { return static_cast<char>(byte(random)); });
+
+        auto encoded = base64_encode(icon);
+
+        run("base64_encode/64KiB", static_cast<double>(icon.size()), [&] { sink = base64_encode(icon).size(); });
+        run("base64_decode/64KiB", static_cast<double>(icon.size()), [&] { sink = base64_decode(encoded).size(); });
+    }
+
+    void benchSearch()
+    {
+        auto tabs = makeTabs(10, 1000);
+        auto index = SearchIndex::build(tabs, nullptr);
+
+        run("SearchIndex::build/10k sounds", 10000, [&] { sink = SearchIndex::build(tabs, nullptr) != nullptr; });
+        run("SearchIndex::search/exact", 1, [&] { sink = index->search("airhorn", 50).size(); });
+        run("SearchIndex::search/words", 1, [&] { sink = index->search("drum kick", 50).size(); });
+        run("SearchIndex::search/typo", 1, [&] { sink = index->search("explsoin", 50).size(); });
+    }
+
+    void benchHotkeys()
+    {
+        std::uniform_int_distribution<int> key(0, 255);
+        std::uniform_int_distribution<std::size_t> length(1, 3);
+
+        HotkeyIndex index;
+        for (std::uint32_t slot = 0; 10000 > slot; slot++)
+        {
+            std::vector<int> keys(length(random));
+            std::generate(keys.begin(), keys.end(), [&] { return key(random); });
+
+            index.add(slot, KeyCombination(keys));
+        }
+
+        std::vector<int> pressed{37, 50, 38};
+        auto always = [](std::uint32_t) { return true; };
+
+        run("HotkeyIndex::match/10k hotkeys", 1, [&] { sink = index.match(pressed, always).has_value(); });
+    }
+
+    void benchConfig()
+    {
+        Data data;
+        data.setTabs(makeTabs(10, 1000));
+
+        auto text = nlohmann::json(data).dump();
+
+        run("Config/serialize 10k sounds", 10000, [&] { sink = nlohmann::json(data).dump().size(); });
+        run("Config/parse 10k sounds", 10000, [&] {
+            Data loaded;
+            nlohmann::json::parse(text).get_to(loaded);
+            sink = loaded.getTabs().size();
+        });
+    }
+} // namespace
+
+int main(int argc, char **arguments)
+{
+    if (argc > 1)
+    {
+        filter = arguments[1]; // NOLINT
+    }
+
+    benchKernels();
+    benchMixer(1);
+    benchMixer(16);
+    benchMixer(64);
+    benchBase64();
+    benchSearch();
+    benchHotkeys();
+    benchConfig();
+
+    auto benchmarks = nlohmann::json::array();
+    for (const auto &result : results)
+    {
+        benchmarks.push_back({{"name", result.name},
+                              {"iterations", result.iterations},
+                              {"real_time", result.nsPerIteration},
+                              {"time_unit", "ns"},
+                              {"items_per_second", result.itemsPerSecond}});
+    }
+
+    std::cout << nlohmann::json{{"context", {{"library_build_type", "soundux_bench"}}}, {"benchmarks", benchmarks}}
+                     .dump(2)
+              << std::endl;
+
+    return 0;
+}
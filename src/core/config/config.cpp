@@ -4,7 +4,12 @@
 #include <filesystem>
 #include <fstream>
 #include <helper/json/bindings.hpp>
+#include <helper/misc/misc.hpp>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Soundux::Objects
 {
@@ -27,29 +32,6 @@ namespace Soundux::Objects
 #endif
     }();
 
-    void Config::save()
-    {
-        try
-        {
-            if (!std::filesystem::exists(path))
-            {
-                std::filesystem::path configFile(path);
-                std::filesystem::create_directories(configFile.parent_path());
-            }
-            std::ofstream configFile(path);
-            configFile << nlohmann::json(*this).dump();
-            configFile.close();
-            Fancy::fancy.logTime().success() << "Config written" << std::endl;
-        }
-        catch (const std::exception &e)
-        {
-            Fancy::fancy.logTime().failure() << "Failed to write config: " >> e.what() << std::endl;
-        }
-        catch (...)
-        {
-            Fancy::fancy.logTime().failure() << "Failed to write config" << std::endl;
-        }
-    }
     void Config::load()
     {
         try
@@ -60,11 +42,32 @@ namespace Soundux::Objects
                 return;
             }
 
-            std::ifstream configStream(path);
-            std::string content((std::istreambuf_iterator<char>(configStream)), std::istreambuf_iterator<char>());
+            std::ifstream configStream(path, std::ios::binary);
+
+            //* Tabs are taken out of the document as soon as they were parsed, so that the sounds of each tab can be
+            //* converted on their own later on
+            std::vector<nlohmann::json> parsedTabs;
+            std::vector<std::string> keys;
+
+            auto json = nlohmann::json::parse(
+                configStream,
+                [&](int depth, nlohmann::json::parse_event_t event, nlohmann::json &parsed) {
+                    if (event == nlohmann::json::parse_event_t::key)
+                    {
+                        keys.resize(depth + 1);
+                        keys[depth] = parsed.get<std::string>();
+                    }
+                    else if (event == nlohmann::json::parse_event_t::object_end && depth == 3 && keys.size() > 2 &&
+                             keys[1] == "data" && keys[2] == "tabs")
+                    {
+                        parsedTabs.emplace_back(std::move(parsed));
+                        return false;
+                    }
+                    return true;
+                },
+                false);
             configStream.close();
 
-            auto json = nlohmann::json::parse(content, nullptr, false);
             if (json.is_discarded())
             {
                 Fancy::fancy.logTime().failure() << "Config seems corrupted" << std::endl;
@@ -73,9 +76,48 @@ namespace Soundux::Objects
             {
                 try
                 {
-                    auto conf = json.get<Config>();
-                    data.set(conf.data);
-                    settings = conf.settings;
+                    const auto &dataJson = json.at("data");
+                    auto loadedSettings = json.at("settings").get<Settings>();
+
+                    //* Only the sounds of the selected tab are converted right away, the others are converted once
+                    //* `Data::hydrate` is called for them
+                    std::vector<Tab> loadedTabs;
+                    std::vector<std::pair<std::string, std::shared_ptr<nlohmann::json>>> loadedSounds;
+
+                    loadedTabs.reserve(parsedTabs.size());
+                    for (auto &tabJson : parsedTabs)
+                    {
+                        auto sounds = std::make_shared<nlohmann::json>(std::move(tabJson.at("sounds")));
+                        if (!sounds->is_array())
+                        {
+                            throw std::runtime_error("sounds is not an array");
+                        }
+                        tabJson.at("sounds") = nlohmann::json::array();
+
+                        auto &tab = loadedTabs.emplace_back(tabJson.get<Tab>());
+                        if (loadedTabs.size() - 1 == loadedSettings.selectedTab)
+                        {
+                            tab.sounds = sounds->get<std::vector<Sound>>();
+                        }
+                        else
+                        {
+                            loadedSounds.emplace_back(tab.path, std::move(sounds));
+                        }
+                    }
+
+                    data.width = dataJson.at("width").get<int>();
+                    data.height = dataJson.at("height").get<int>();
+                    data.soundIdCounter = dataJson.at("soundIdCounter").get<std::uint32_t>();
+                    data.setTabs(std::move(loadedTabs));
+
+                    for (auto &[tabPath, sounds] : loadedSounds)
+                    {
+                        data.setPending(tabPath, [sounds = std::move(sounds)] {
+                            return sounds->get<std::vector<Sound>>();
+                        });
+                    }
+
+                    settings = loadedSettings;
                     Fancy::fancy.logTime().success() << "Config read" << std::endl;
                 }
                 catch (...)
@@ -12,7 +12,6 @@ namespace Soundux
             Data data;
             Settings settings;
 
-            void save();
             void load();
             static const std::string path;
         };
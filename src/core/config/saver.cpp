@@ -0,0 +1,182 @@
+#include "saver.hpp"
+#include "config.hpp"
+#include <core/global/globals.hpp>
+#include <fancy.hpp>
+#include <helper/json/bindings.hpp>
+#include <helper/misc/misc.hpp>
+#include <algorithm>
+#include <optional>
+
+namespace Soundux::Objects
+{
+    void ConfigSaver::setup(const Settings &initial)
+    {
+        {
+            std::lock_guard lock(mutex);
+            settings = initial;
+            stop = false;
+        }
+
+        Globals::gData.setChangeCallback([this] { onDataChanged(); });
+        thread = std::thread([this] { run(); });
+    }
+    void ConfigSaver::destroy()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+        Globals::gData.setChangeCallback(nullptr);
+
+        Globals::gData.hydrateAll();
+        write();
+    }
+    void ConfigSaver::onSettingsChanged(const Settings &newSettings)
+    {
+        {
+            std::lock_guard lock(mutex);
+            settings = newSettings;
+            settingsChanged = true;
+        }
+        cv.notify_all();
+    }
+    void ConfigSaver::onDataChanged()
+    {
+        {
+            std::lock_guard lock(mutex);
+            dataChanged = true;
+        }
+        cv.notify_all();
+    }
+    void ConfigSaver::run()
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::optional<clock::time_point> firstChange, lastChange;
+        auto revision = Globals::gData.getRevision();
+        auto width = Globals::gData.width, height = Globals::gData.height;
+
+        std::unique_lock lock(mutex);
+        while (!stop)
+        {
+            //* Sleeps until something changes, or until the pending change is due
+            auto woken = [this] { return stop || settingsChanged || dataChanged; };
+            if (firstChange)
+            {
+                cv.wait_until(lock, std::min(*lastChange + debounce, *firstChange + maxDelay), woken);
+            }
+            else
+            {
+                cv.wait(lock, woken);
+            }
+
+            if (stop)
+            {
+                break;
+            }
+
+            auto changed = settingsChanged;
+            settingsChanged = false;
+            dataChanged = false;
+
+            //* `gData` calls `onDataChanged` with its lock held, so it is not queried while holding ours
+            lock.unlock();
+
+            auto now = clock::now();
+            auto currentRevision = Globals::gData.getRevision();
+
+            if (changed || currentRevision != revision || width != Globals::gData.width ||
+                height != Globals::gData.height)
+            {
+                revision = currentRevision;
+                width = Globals::gData.width;
+                height = Globals::gData.height;
+
+                lastChange = now;
+                if (!firstChange)
+                {
+                    firstChange = now;
+                }
+            }
+
+            if (firstChange && (now - *lastChange >= debounce || now - *firstChange >= maxDelay))
+            {
+                //* Tabs that are still being loaded would be written without their sounds, so the write is retried
+                if (Globals::gData.hasPendingTabs())
+                {
+                    firstChange = lastChange = now;
+                }
+                else
+                {
+                    firstChange.reset();
+                    lastChange.reset();
+                    write();
+                }
+            }
+
+            lock.lock();
+        }
+    }
+    void ConfigSaver::write()
+    {
+        std::lock_guard writeLock(writeMutex);
+
+        std::string currentSettings;
+        {
+            std::lock_guard lock(mutex);
+            currentSettings = nlohmann::json(settings).dump();
+        }
+
+        try
+        {
+            std::string tabs;
+            std::unordered_map<std::string, CachedTab> used;
+
+            Globals::gData.visitTabs([&](const Tab &tab) {
+                auto revision = Globals::gData.getTabRevision(tab.path);
+
+                CachedTab entry;
+                if (auto cached = cache.find(tab.path); cached != cache.end() && cached->second.revision == revision)
+                {
+                    entry = std::move(cached->second);
+                }
+                else
+                {
+                    entry = {revision, nlohmann::json(tab).dump()};
+                }
+
+                if (!tabs.empty())
+                {
+                    tabs += ',';
+                }
+                tabs += entry.json;
+
+                used.emplace(tab.path, std::move(entry));
+            });
+            cache = std::move(used);
+
+            //* Same layout as `adl_serializer<Config>` produces, the tabs are spliced in as they are
+            auto data = nlohmann::json{{"height", Globals::gData.height},
+                                       {"width", Globals::gData.width},
+                                       {"soundIdCounter", Globals::gData.soundIdCounter.load()}}
+                            .dump();
+            data.pop_back();
+
+            auto content = R"({"data":)" + data + R"(,"tabs":[)" + tabs + R"(]},"settings":)" + currentSettings + "}";
+            if (Helpers::writeFileAtomically(Config::path, content))
+            {
+                Fancy::fancy.logTime().success() << "Config written" << std::endl;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to write config: " >> e.what() << std::endl;
+        }
+    }
+} // namespace Soundux::Objects
@@ -0,0 +1,57 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <core/objects/settings.hpp>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Writes the config in the background shortly after `gData` or the settings changed, so that a crash only
+        //* loses the last few seconds. Tabs that did not change since the last write are not serialized again.
+        class ConfigSaver
+        {
+          public:
+            //* A change is written once nothing changed for `debounce`, but never later than `maxDelay`
+            static constexpr auto debounce = std::chrono::seconds(2);
+            static constexpr auto maxDelay = std::chrono::seconds(10);
+
+          private:
+            struct CachedTab
+            {
+                std::uint64_t revision;
+                std::string json;
+            };
+
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool stop = false;
+
+            std::mutex writeMutex;
+            std::unordered_map<std::string, CachedTab> cache;
+
+            Settings settings;
+            bool settingsChanged = false;
+            bool dataChanged = false;
+
+            void run();
+            void write();
+
+          public:
+            void setup(const Settings &);
+            //* Stops the background thread and writes the config one last time
+            void destroy();
+
+            //* Has to be called whenever `gSettings` is replaced, the settings are copied
+            void onSettingsChanged(const Settings &);
+            //* Has to be called whenever something in `gData` changed that is not tracked by its revision
+            void onDataChanged();
+        };
+    } // namespace Objects
+} // namespace Soundux
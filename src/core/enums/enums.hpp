@@ -59,5 +59,42 @@ namespace Soundux
             PipeWire,
             PulseAudio,
         };
+
+        enum class LatencyProfile : std::uint8_t
+        {
+            Conservative,
+            Low,
+            UltraLow,
+        };
+
+        enum class ImportFormat : std::uint8_t
+        {
+            Mp3,
+            Flac,
+            Wav,
+        };
+
+        enum class DownloadStatus : std::uint8_t
+        {
+            Queued,
+            Running,
+            Finished,
+            Failed,
+            Cancelled,
+        };
+
+        //* Which sound is stopped when a new one would exceed `Settings::maxPolyphony`, `None` refuses the new one
+        enum class VoiceStealing : std::uint8_t
+        {
+            Oldest,
+            Quietest,
+            None,
+        };
+
+        enum class AppType : std::uint8_t
+        {
+            Playback,
+            Recording,
+        };
     } // namespace Enums
 } // namespace Soundux
\ No newline at end of file
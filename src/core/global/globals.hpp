@@ -6,13 +6,18 @@
 #include <helper/audio/windows/winsound.hpp>
 #endif
 #include <core/config/config.hpp>
+#include <core/config/saver.hpp>
 #include <core/hotkeys/hotkeys.hpp>
 #include <core/objects/data.hpp>
 #include <core/objects/objects.hpp>
 #include <core/objects/settings.hpp>
 #include <guard.hpp>
+#include <helper/audio/metadata/metadata.hpp>
 #include <helper/icons/icons.hpp>
+#include <helper/ipc/ipc.hpp>
 #include <helper/queue/queue.hpp>
+#include <helper/trace/trace.hpp>
+#include <helper/watcher/watcher.hpp>
 #include <helper/ytdl/youtube-dl.hpp>
 #include <memory>
 #include <ui/ui.hpp>
@@ -31,16 +36,19 @@ namespace Soundux
         inline std::shared_ptr<Objects::WinSound> gWinSound;
 #endif
         inline Objects::Queue gQueue;
+        //* Rescans and metadata indexing, slow tabs must not hold up the workers of `gQueue`
+        inline Objects::Queue gScanQueue{2, true};
+        inline Objects::Watcher gWatcher;
+        inline Objects::MetadataIndex gMetadata;
+        inline Objects::Tracer gTracer;
         inline Objects::Config gConfig;
+        inline Objects::ConfigSaver gConfigSaver;
         inline Objects::YoutubeDl gYtdl;
+        inline Objects::IpcServer gIpc;
         inline Objects::Hotkeys gHotKeys;
         inline Objects::Settings gSettings;
         inline std::unique_ptr<Objects::Window> gGui;
 
         inline std::shared_ptr<guardpp::guard> gGuard;
-
-        /* Allows for fast & easy sound access, is populated on start up */
-        inline sxl::var_guard<std::map<std::uint32_t, std::reference_wrapper<Objects::Sound>>> gSounds;
-        inline sxl::var_guard<std::map<std::uint32_t, std::reference_wrapper<Objects::Sound>>> gFavorites;
     } // namespace Globals
 } // namespace Soundux
\ No newline at end of file
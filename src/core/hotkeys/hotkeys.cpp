@@ -1,26 +1,21 @@
 #include "hotkeys.hpp"
 #include <core/global/globals.hpp>
+#if defined(__linux__)
+#include "linux/backend.hpp"
+#endif
 #include <cstdint>
 
 namespace Soundux
 {
-    namespace traits
-    {
-        template <typename T> struct is_pair
-        {
-          private:
-            static std::uint8_t test(...);
-            template <typename O>
-            static auto test(O *) -> decltype(std::declval<O>().first, std::declval<O>().second, std::uint16_t{});
-
-          public:
-            static const bool value = sizeof(test(reinterpret_cast<T *>(0))) == sizeof(std::uint16_t);
-        };
-    } // namespace traits
     namespace Objects
     {
         void Hotkeys::init()
         {
+#if defined(__linux__)
+            backend = InputBackend::createInstance();
+#endif
+            //* Sequences that were rendered before there was a backend only contain placeholder names
+            onLayoutChanged();
             listener = std::thread([this] { listen(); });
         }
         void Hotkeys::shouldNotify(bool status)
@@ -59,44 +54,6 @@ namespace Soundux
             }
             return false;
         }
-        template <typename T> std::optional<Sound> getBestMatch(const T &list, const std::vector<int> &pressedKeys)
-        {
-            std::optional<Sound> rtn;
-
-            for (const auto &_sound : list)
-            {
-                const auto &sound = [&] {
-                    if constexpr (traits::is_pair<std::decay_t<decltype(_sound)>>::value)
-                    {
-                        return _sound.second.get();
-                    }
-                    else
-                    {
-                        return _sound;
-                    }
-                }();
-
-                if (sound.hotkeys.empty())
-                    continue;
-
-                if (sound.hotkeys == pressedKeys)
-                {
-                    rtn = sound;
-                    break;
-                }
-
-                if (rtn && rtn->hotkeys.size() > sound.hotkeys.size())
-                {
-                    continue;
-                }
-
-                if (isCloseMatch(pressedKeys, sound.hotkeys))
-                {
-                    rtn = sound;
-                }
-            }
-            return rtn;
-        }
         void Hotkeys::onKeyDown(int key)
         {
             if (std::find(keysToPress.begin(), keysToPress.end(), key) != keysToPress.end())
@@ -124,33 +81,23 @@ namespace Soundux
                 return;
             }
 
-            std::optional<Sound> bestMatch;
-
-            if (Globals::gSettings.tabHotkeysOnly)
-            {
-                if (Globals::gData.isOnFavorites)
+            auto sounds = Globals::gData.getSounds();
+            auto bestMatch = sounds->hotkeys->match(pressedKeys, [&](std::uint32_t slot) {
+                if (!Globals::gSettings.tabHotkeysOnly)
                 {
-                    auto sounds = Globals::gData.getFavorites();
-                    bestMatch = getBestMatch(sounds, pressedKeys);
+                    return true;
                 }
-                else
+                if (Globals::gData.isOnFavorites)
                 {
-                    auto tab = Globals::gData.getTab(Globals::gSettings.selectedTab);
-                    if (tab)
-                    {
-                        bestMatch = getBestMatch(tab->sounds, pressedKeys);
-                    }
+                    return sounds->slots[slot].sound->isFavorite;
                 }
-            }
-            else
-            {
-                auto scopedSounds = Globals::gSounds.scoped();
-                bestMatch = getBestMatch(*scopedSounds, pressedKeys);
-            }
+                return sounds->slots[slot].tab == Globals::gSettings.selectedTab;
+            });
 
             if (bestMatch)
             {
-                auto pSound = Globals::gGui->playSound(bestMatch->id);
+                Tracer::Scope trace(TracePoint::HotkeyReceived);
+                auto pSound = Globals::gGui->playSound(sounds->slots[*bestMatch].sound->id);
                 if (pSound)
                 {
                     Globals::gGui->onSoundPlayed(*pSound);
@@ -159,16 +106,35 @@ namespace Soundux
         }
         std::string Hotkeys::getKeySequence(const std::vector<int> &keys)
         {
+            if (keys.empty())
+            {
+                return "";
+            }
+
+            {
+                std::shared_lock lock(sequenceMutex);
+                if (auto cached = sequences.find(keys); cached != sequences.end())
+                {
+                    return cached->second;
+                }
+            }
+
             std::string rtn;
             for (const auto &key : keys)
             {
                 rtn += getKeyName(key) + " + ";
             }
-            if (!rtn.empty())
-            {
-                return rtn.substr(0, rtn.length() - 3);
-            }
-            return "";
+            rtn.resize(rtn.length() - 3);
+
+            std::unique_lock lock(sequenceMutex);
+            sequences.emplace(keys, rtn);
+
+            return rtn;
+        }
+        void Hotkeys::onLayoutChanged()
+        {
+            std::unique_lock lock(sequenceMutex);
+            sequences.clear();
         }
     } // namespace Objects
 } // namespace Soundux
\ No newline at end of file
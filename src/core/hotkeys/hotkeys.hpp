@@ -1,5 +1,8 @@
 #pragma once
 #include <atomic>
+#include <map>
+#include <memory>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -8,6 +11,9 @@ namespace Soundux
 {
     namespace Objects
     {
+#if defined(__linux__)
+        class InputBackend;
+#endif
         class Hotkeys
         {
             std::thread listener;
@@ -19,8 +25,14 @@ namespace Soundux
 #if defined(_WIN32)
             std::thread keyPressThread;
             std::atomic<bool> shouldPressKeys = false;
+#elif defined(__linux__)
+            std::shared_ptr<InputBackend> backend;
 #endif
 
+            //* Sounds are serialized far more often than hotkeys or the keyboard layout change
+            std::shared_mutex sequenceMutex;
+            std::map<std::vector<int>, std::string> sequences;
+
           private:
             void listen();
 
@@ -37,6 +49,8 @@ namespace Soundux
 
             std::string getKeyName(const int &);
             std::string getKeySequence(const std::vector<int> &);
+            //* Has to be called when the key names may have changed, e.g. because the keyboard layout changed
+            void onLayoutChanged();
         };
     } // namespace Objects
 } // namespace Soundux
\ No newline at end of file
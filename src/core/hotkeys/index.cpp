@@ -0,0 +1,119 @@
+#include "index.hpp"
+#include <algorithm>
+
+namespace Soundux::Objects
+{
+    bool HotkeyIndex::fits(int key)
+    {
+        return key >= 0 && static_cast<std::size_t>(key) < KeySet().size();
+    }
+    void HotkeyIndex::add(std::uint32_t slot, const KeyCombination &keys)
+    {
+        if (keys.empty())
+        {
+            return;
+        }
+
+        KeySet set;
+        for (const auto &key : keys)
+        {
+            if (!fits(key))
+            {
+                unindexed.push_back({slot, keys});
+                return;
+            }
+            set.set(key);
+        }
+
+        entries[set].push_back({slot, keys});
+    }
+    std::optional<std::uint32_t> HotkeyIndex::match(const std::vector<int> &pressed, const Filter &inScope) const
+    {
+        std::optional<std::uint32_t> exact;
+        std::optional<std::uint32_t> best;
+        std::size_t bestSize = 0;
+
+        //* Same preference as the old linear search: the first exact match, otherwise the biggest hotkey and the
+        //* last one of those if there are several
+        auto consider = [&](const Entry &entry) {
+            if (!inScope(entry.slot))
+            {
+                return;
+            }
+            if (entry.keys == pressed)
+            {
+                exact = exact ? std::min(*exact, entry.slot) : entry.slot;
+                return;
+            }
+            if (!best || entry.keys.size() > bestSize || (entry.keys.size() == bestSize && entry.slot > *best))
+            {
+                best = entry.slot;
+                bestSize = entry.keys.size();
+            }
+        };
+        auto isPressed = [&](const Entry &entry) {
+            return std::all_of(entry.keys.begin(), entry.keys.end(), [&](int key) {
+                return std::find(pressed.begin(), pressed.end(), key) != pressed.end();
+            });
+        };
+
+        KeySet pressedSet;
+        std::vector<int> indexable;
+        indexable.reserve(pressed.size());
+
+        for (const auto &key : pressed)
+        {
+            if (fits(key) && !pressedSet.test(key))
+            {
+                pressedSet.set(key);
+                indexable.emplace_back(key);
+            }
+        }
+
+        if (indexable.size() <= maxEnumeratedKeys)
+        {
+            for (std::uint32_t mask = 1; (1u << indexable.size()) > mask; mask++)
+            {
+                KeySet subset;
+                for (std::size_t i = 0; indexable.size() > i; i++)
+                {
+                    if ((mask & (1u << i)) != 0)
+                    {
+                        subset.set(indexable[i]);
+                    }
+                }
+
+                if (auto bucket = entries.find(subset); bucket != entries.end())
+                {
+                    for (const auto &entry : bucket->second)
+                    {
+                        consider(entry);
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (const auto &[set, bucket] : entries)
+            {
+                if ((set & ~pressedSet).none())
+                {
+                    for (const auto &entry : bucket)
+                    {
+                        consider(entry);
+                    }
+                }
+            }
+        }
+
+        for (const auto &entry : unindexed)
+        {
+            if (isPressed(entry))
+            {
+                consider(entry);
+            }
+        }
+
+        return exact ? exact : best;
+    }
+} // namespace Soundux::Objects
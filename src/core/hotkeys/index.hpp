@@ -0,0 +1,47 @@
+#pragma once
+#include <bitset>
+#include <core/objects/objects.hpp>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Groups hotkeys by the set of keys they consist of, so that finding the best match for the pressed keys only
+        //* has to look at the subsets of the pressed keys instead of at every sound.
+        class HotkeyIndex
+        {
+          public:
+            using KeySet = std::bitset<256>;
+            using Filter = std::function<bool(std::uint32_t)>;
+
+            //* Subsets are only enumerated up to this many pressed keys, beyond that every hotkey is checked
+            static constexpr std::size_t maxEnumeratedKeys = 10;
+
+          private:
+            struct Entry
+            {
+                std::uint32_t slot;
+                KeyCombination keys;
+            };
+
+            std::unordered_map<KeySet, std::vector<Entry>> entries;
+            //* Hotkeys with a key code that does not fit into a `KeySet`
+            std::vector<Entry> unindexed;
+
+            static bool fits(int key);
+
+          public:
+            //* Slots have to be added in ascending order
+            void add(std::uint32_t slot, const KeyCombination &keys);
+
+            //* Returns the slot of the sound whose hotkey equals `pressed`, or otherwise of the one with the most keys
+            //* that are all pressed. `inScope` decides which slots may be returned.
+            std::optional<std::uint32_t> match(const std::vector<int> &pressed, const Filter &inScope) const;
+        };
+    } // namespace Objects
+} // namespace Soundux
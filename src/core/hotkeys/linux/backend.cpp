@@ -0,0 +1,70 @@
+#if defined(__linux__)
+#include "backend.hpp"
+#include "../hotkeys.hpp"
+#include "x11.hpp"
+#include <fancy.hpp>
+
+namespace Soundux::Objects
+{
+    std::shared_ptr<InputBackend> InputBackend::createInstance()
+    {
+#if __has_include(<X11/Xlib.h>)
+        auto instance = std::shared_ptr<X11>(new X11()); // NOLINT
+        if (instance->setup())
+        {
+            return instance;
+        }
+#endif
+
+        Fancy::fancy.logTime().failure() << "Failed to create InputBackend instance, hotkeys will not work"
+                                         << std::endl;
+        return nullptr;
+    }
+
+    void Hotkeys::listen()
+    {
+        if (backend)
+        {
+            backend->listen(*this);
+        }
+    }
+
+    void Hotkeys::stop()
+    {
+        kill = true;
+        if (backend)
+        {
+            backend->stop();
+        }
+        listener.join();
+    }
+
+    std::string Hotkeys::getKeyName(const int &key)
+    {
+        if (backend)
+        {
+            return backend->getKeyName(key);
+        }
+
+        return "KEY_" + std::to_string(key);
+    }
+
+    void Hotkeys::pressKeys(const std::vector<int> &keys)
+    {
+        keysToPress = keys;
+        if (backend)
+        {
+            backend->pressKeys(keys);
+        }
+    }
+
+    void Hotkeys::releaseKeys(const std::vector<int> &keys)
+    {
+        keysToPress.clear();
+        if (backend)
+        {
+            backend->releaseKeys(keys);
+        }
+    }
+} // namespace Soundux::Objects
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#if defined(__linux__)
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        class Hotkeys;
+
+        //* Source of global key and mouse button events, forwards them to `Hotkeys::onKeyDown` / `Hotkeys::onKeyUp`.
+        //* Implementations are expected to block in `listen` without polling, so that idle hotkeys cost no CPU.
+        class InputBackend
+        {
+          protected:
+            virtual bool setup() = 0;
+            InputBackend() = default;
+
+          public:
+            static std::shared_ptr<InputBackend> createInstance();
+            virtual ~InputBackend() = default;
+
+          public:
+            //* Runs until `stop` is called
+            virtual void listen(Hotkeys &) = 0;
+            //* May be called from any thread
+            virtual void stop() = 0;
+
+            virtual std::string getKeyName(int) = 0;
+            virtual void pressKeys(const std::vector<int> &) = 0;
+            virtual void releaseKeys(const std::vector<int> &) = 0;
+        };
+    } // namespace Objects
+} // namespace Soundux
+#endif
@@ -1,46 +1,54 @@
 #if defined(__linux__) && __has_include(<X11/Xlib.h>)
+#include "x11.hpp"
 #include "../hotkeys.hpp"
 #include <X11/X.h>
 #include <X11/XKBlib.h>
-#include <X11/Xlib.h>
 #include <X11/extensions/XI2.h>
 #include <X11/extensions/XInput2.h>
 #include <X11/extensions/XTest.h>
-#include <chrono>
+#include <array>
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
 #include <fancy.hpp>
-#include <thread>
-
-using namespace std::chrono_literals;
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace Soundux::Objects
 {
-    Display *display;
-    void Hotkeys::listen()
+    bool X11::setup()
     {
+        //* `pressKeys` and `getKeyName` are called from other threads, `XInitThreads` is called at the start of `main`
         auto *displayenv = std::getenv("DISPLAY"); // NOLINT
-        auto *x11Display = XOpenDisplay(displayenv);
+        display = XOpenDisplay(displayenv);
 
-        if (!x11Display)
+        if (!display)
         {
             Fancy::fancy.logTime().warning() << "DISPLAY is not set, defaulting to :0" << std::endl;
-            if (!(x11Display = XOpenDisplay(":0")))
+            if (!(display = XOpenDisplay(":0")))
             {
                 Fancy::fancy.logTime().failure() << "Could not open X11 Display" << std::endl;
-                return;
+                return false;
             }
         }
         else
         {
             Fancy::fancy.logTime().message() << "Using DISPLAY " << displayenv << std::endl;
         }
-        display = x11Display;
 
-        int major_op = 0, event_rtn = 0, ext_rtn = 0;
-        if (!XQueryExtension(display, "XInputExtension", &major_op, &event_rtn, &ext_rtn))
+        int event_rtn = 0, ext_rtn = 0;
+        if (!XQueryExtension(display, "XInputExtension", &xiOpcode, &event_rtn, &ext_rtn))
         {
             Fancy::fancy.logTime().failure() << "Failed to find XInputExtension" << std::endl;
-            return;
+            return false;
+        }
+
+        wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wakeup < 0)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to create eventfd: " << errno << std::endl;
+            return false;
         }
 
         Window root = DefaultRootWindow(display); // NOLINT
@@ -59,42 +67,94 @@ namespace Soundux::Objects
         XSync(display, 0);
         free(mask.mask);
 
+        return true;
+    }
+    X11::~X11()
+    {
+        if (wakeup >= 0)
+        {
+            close(wakeup);
+        }
+        if (display)
+        {
+            XCloseDisplay(display);
+        }
+    }
+    void X11::handle(Hotkeys &hotkeys, XEvent &event)
+    {
+        if (event.type == MappingNotify)
+        {
+            XRefreshKeyboardMapping(&event.xmapping);
+            hotkeys.onLayoutChanged();
+            return;
+        }
+
+        auto *cookie = reinterpret_cast<XGenericEventCookie *>(&event.xcookie);
+        if (!XGetEventData(display, cookie))
+        {
+            return;
+        }
+
+        if (cookie->type == GenericEvent && cookie->extension == xiOpcode)
+        {
+            auto *data = reinterpret_cast<XIRawEvent *>(cookie->data);
+            auto key = data->detail;
+
+            if (key != 1)
+            {
+                if (cookie->evtype == XI_RawKeyPress || cookie->evtype == XI_RawButtonPress)
+                {
+                    hotkeys.onKeyDown(key);
+                }
+                else if (cookie->evtype == XI_RawKeyRelease || cookie->evtype == XI_RawButtonRelease)
+                {
+                    hotkeys.onKeyUp(key);
+                }
+            }
+        }
+
+        XFreeEventData(display, cookie);
+    }
+    void X11::listen(Hotkeys &hotkeys)
+    {
+        std::array<pollfd, 2> fds{};
+        fds[0] = {ConnectionNumber(display), POLLIN, 0};
+        fds[1] = {wakeup, POLLIN, 0};
+
         while (!kill)
         {
-            if (XPending(display) != 0)
+            //* Xlib may already have read events into its own queue, those would not wake up poll
+            while (XPending(display) > 0)
             {
                 XEvent event;
                 XNextEvent(display, &event);
-                auto *cookie = reinterpret_cast<XGenericEventCookie *>(&event.xcookie);
+                handle(hotkeys, event);
+            }
 
-                if (XGetEventData(display, cookie) && cookie->type == GenericEvent && cookie->extension == major_op &&
-                    (cookie->evtype == XI_RawKeyPress || cookie->evtype == XI_RawKeyRelease ||
-                     cookie->evtype == XI_RawButtonPress || cookie->evtype == XI_RawButtonRelease))
-                {
-                    auto *data = reinterpret_cast<XIRawEvent *>(cookie->data);
-                    auto key = data->detail;
-
-                    if (key == 1)
-                        continue;
-
-                    if (cookie->evtype == XI_RawKeyPress || cookie->evtype == XI_RawButtonPress)
-                    {
-                        onKeyDown(key);
-                    }
-                    else if (cookie->evtype == XI_RawKeyRelease || cookie->evtype == XI_RawButtonRelease)
-                    {
-                        onKeyUp(key);
-                    }
-                }
+            if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR)
+            {
+                Fancy::fancy.logTime().failure() << "Failed to poll X11 connection: " << errno << std::endl;
+                return;
             }
-            else
+
+            if ((fds[0].revents & (POLLERR | POLLHUP)) != 0)
             {
-                std::this_thread::sleep_for(100ms);
+                Fancy::fancy.logTime().failure() << "Lost connection to X11 Display" << std::endl;
+                return;
             }
         }
     }
+    void X11::stop()
+    {
+        kill = true;
 
-    std::string Hotkeys::getKeyName(const int &key)
+        std::uint64_t value = 1;
+        if (write(wakeup, &value, sizeof(value)) < 0)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to wake up X11 listener: " << errno << std::endl;
+        }
+    }
+    std::string X11::getKeyName(int key)
     {
         // TODO(curve): There is no Keysym for the mouse buttons and I couldn't find any way to get the name for the
         // mouse buttons so they'll just be named KEY_1 (1 is the Keycode). Maybe someone will be able to help me but I
@@ -115,30 +175,25 @@ namespace Soundux::Objects
 
         return str;
     }
-
-    void Hotkeys::stop()
+    void X11::pressKeys(const std::vector<int> &keys)
     {
-        kill = true;
-        listener.join();
-    }
-
-    void Hotkeys::pressKeys(const std::vector<int> &keys)
-    {
-        keysToPress = keys;
         for (const auto &key : keys)
         {
             XTestFakeKeyEvent(display, key, True, 0);
         }
-    }
 
-    void Hotkeys::releaseKeys(const std::vector<int> &keys)
+        //* The listener no longer flushes the connection periodically
+        XFlush(display);
+    }
+    void X11::releaseKeys(const std::vector<int> &keys)
     {
-        keysToPress.clear();
         for (const auto &key : keys)
         {
             XTestFakeKeyEvent(display, key, False, 0);
         }
+
+        XFlush(display);
     }
 } // namespace Soundux::Objects
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+#if defined(__linux__) && __has_include(<X11/Xlib.h>)
+#include "backend.hpp"
+#include <X11/Xlib.h>
+#include <atomic>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        class X11 : public InputBackend
+        {
+            friend class InputBackend;
+
+          private:
+            Display *display = nullptr;
+            int xiOpcode = 0;
+
+            //* Written to by `stop` to wake up `listen`
+            int wakeup = -1;
+            std::atomic<bool> kill = false;
+
+            void handle(Hotkeys &, XEvent &);
+
+          protected:
+            bool setup() override;
+            X11() = default;
+
+          public:
+            ~X11() override;
+
+            void listen(Hotkeys &) override;
+            void stop() override;
+
+            std::string getKeyName(int) override;
+            void pressKeys(const std::vector<int> &) override;
+            void releaseKeys(const std::vector<int> &) override;
+        };
+    } // namespace Objects
+} // namespace Soundux
+#endif
@@ -1,77 +1,366 @@
 #include "data.hpp"
-#include <core/global/globals.hpp>
+#include <algorithm>
 #include <fancy.hpp>
+#include <iterator>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Soundux::Objects
 {
-    Tab Data::addTab(Tab tab)
+    //* Carries over what the user set on a sound that is still present after a rescan
+    static void keepUserState(Sound &sound, const Sound &current)
     {
-        tab.id = tabs.size();
-        tabs.emplace_back(tab);
+        sound.id = current.id;
+        sound.hotkeys = current.hotkeys;
+        sound.isFavorite = current.isFavorite;
+        sound.localVolume = current.localVolume;
+        sound.remoteVolume = current.remoteVolume;
+    }
+    Data::Data(const Data &other)
+    {
+        std::lock_guard lock(other.mutex);
+        tabs = other.tabs;
+        width = other.width;
+        height = other.height;
+        isOnFavorites = other.isOnFavorites;
+        soundIdCounter = other.soundIdCounter.load();
+        pending = other.pending;
+    }
+    void Data::touch(const Tab &tab)
+    {
+        tabRevisions[tab.path] = revision;
+    }
+    void Data::record(Change::Kind kind, const std::string &path, std::uint32_t sound)
+    {
+        changes.push_back({kind, ++revision, path, sound});
+        if (changes.size() > maxChanges)
+        {
+            logStart = changes.front().revision;
+            changes.pop_front();
+        }
+
+        if (changeCallback)
+        {
+            changeCallback();
+        }
+    }
+    void Data::assignTabs(std::vector<Tab> newTabs)
+    {
+        tabs = std::move(newTabs);
+        for (std::size_t i = 0; tabs.size() > i; i++)
+        {
+            tabs.at(i).id = i;
+            touch(tabs.at(i));
+        }
+
+        sounds.rebuild(tabs);
+    }
+    void Data::setChangeCallback(std::function<void()> callback)
+    {
+        std::lock_guard lock(mutex);
+        changeCallback = std::move(callback);
+    }
+    std::uint64_t Data::getRevision() const
+    {
+        return revision;
+    }
+    std::uint64_t Data::getTabRevision(const std::string &path) const
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = tabRevisions.find(path); it != tabRevisions.end())
+        {
+            return it->second;
+        }
+
+        return 0;
+    }
+    TabChanges Data::getChangesSince(std::uint64_t since) const
+    {
+        std::lock_guard lock(mutex);
+
+        TabChanges rtn;
+        rtn.since = since;
+        rtn.revision = revision;
+
+        if (since < logStart || since > revision)
+        {
+            rtn.full = true;
+            rtn.tabs = tabs;
+            return rtn;
+        }
+
+        auto first = std::upper_bound(changes.begin(), changes.end(), since,
+                                      [](const auto &value, const auto &change) { return value < change.revision; });
+
+        bool layout = false;
+        std::unordered_set<std::string_view> changedTabs;
+        std::vector<const Change *> changedSounds;
 
-        for (auto &sound : tabs.back().sounds)
+        for (auto change = first; change != changes.end(); ++change)
         {
-            Globals::gSounds->insert({sound.id, sound});
-            if (sound.isFavorite)
+            switch (change->kind)
             {
-                Globals::gFavorites->insert({sound.id, sound});
+            case Change::Kind::Layout:
+                layout = true;
+                break;
+            case Change::Kind::Tab:
+                changedTabs.emplace(change->path);
+                break;
+            case Change::Kind::Sound:
+            case Change::Kind::SoundRemoved:
+                changedSounds.emplace_back(&*change);
+                break;
             }
         }
 
-        return tabs.back();
+        if (layout)
+        {
+            auto &shells = rtn.layout.emplace();
+            shells.reserve(tabs.size());
+
+            for (const auto &tab : tabs)
+            {
+                auto &shell = shells.emplace_back();
+                shell.id = tab.id;
+                shell.name = tab.name;
+                shell.path = tab.path;
+                shell.sortMode = tab.sortMode;
+            }
+        }
+
+        for (const auto &tab : tabs)
+        {
+            if (changedTabs.count(tab.path) > 0)
+            {
+                rtn.tabs.emplace_back(tab);
+            }
+        }
+
+        std::unordered_map<std::string_view, std::uint32_t> tabIds;
+        for (const auto &tab : tabs)
+        {
+            tabIds.emplace(tab.path, tab.id);
+        }
+
+        std::unordered_set<std::uint32_t> sent;
+        std::vector<SoundOp> upserts;
+        auto snapshot = sounds.get();
+
+        //* Only the latest change of every sound counts
+        for (auto change = changedSounds.rbegin(); change != changedSounds.rend(); ++change)
+        {
+            const auto &path = (*change)->path;
+            const auto &id = (*change)->sound;
+
+            auto tab = tabIds.find(path);
+            if (tab == tabIds.end() || changedTabs.count(path) > 0 || !sent.emplace(id).second)
+            {
+                continue;
+            }
+
+            if ((*change)->kind == Change::Kind::SoundRemoved)
+            {
+                rtn.sounds.push_back({SoundOp::Kind::Remove, tab->second, id, 0, std::nullopt});
+            }
+            else if (const auto *slot = snapshot->find(id); slot && slot->tab == tab->second)
+            {
+                upserts.push_back({SoundOp::Kind::Upsert, tab->second, id, slot->position, *slot->sound});
+            }
+        }
+
+        std::sort(upserts.begin(), upserts.end(), [](const auto &first, const auto &second) {
+            return first.tab != second.tab ? first.tab < second.tab : first.position < second.position;
+        });
+        rtn.sounds.insert(rtn.sounds.end(), std::make_move_iterator(upserts.begin()),
+                          std::make_move_iterator(upserts.end()));
+
+        return rtn;
     }
-    void Data::removeTabById(const std::uint32_t &index)
+    void Data::setPending(const std::string &path, std::function<std::vector<Sound>()> loader)
     {
-        if (tabs.size() > index)
+        std::lock_guard lock(mutex);
+        pending[path] = std::move(loader);
+    }
+    bool Data::hydrate(const std::string &path)
+    {
+        std::function<std::vector<Sound>()> loader;
         {
-            auto &tab = tabs.at(index);
-            for (auto &sound : tab.sounds)
+            std::lock_guard lock(mutex);
+            auto entry = pending.find(path);
+            if (entry == pending.end() || !entry->second)
+            {
+                return false;
+            }
+
+            //* The entry stays until the sounds are in place, so that `hasPendingTabs` holds while converting
+            loader = std::move(entry->second);
+            entry->second = nullptr;
+        }
+
+        std::vector<Sound> loaded;
+        try
+        {
+            loaded = loader();
+        }
+        catch (const std::exception &e)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to load sounds of tab " << path << ": " << e.what()
+                                             << std::endl;
+        }
+
+        std::lock_guard lock(mutex);
+        pending.erase(path);
+
+        auto tab = std::find_if(tabs.begin(), tabs.end(), [&](const auto &item) { return item.path == path; });
+        if (tab == tabs.end())
+        {
+            return false;
+        }
+
+        if (tab->sounds.empty())
+        {
+            tab->sounds = std::move(loaded);
+        }
+        else
+        {
+            //* The tab was rescanned before it was loaded, only carry over what was configured for the sounds
+            std::unordered_map<std::string_view, const Sound *> persisted;
+            persisted.reserve(loaded.size());
+            for (const auto &sound : loaded)
             {
-                Globals::gSounds->erase(sound.id);
-                if (sound.isFavorite)
+                persisted.emplace(sound.path, &sound);
+            }
+
+            for (auto &sound : tab->sounds)
+            {
+                if (auto previous = persisted.find(sound.path); previous != persisted.end())
                 {
-                    Globals::gFavorites->erase(sound.id);
+                    sound.hotkeys = previous->second->hotkeys;
+                    sound.isFavorite = previous->second->isFavorite;
+                    sound.localVolume = previous->second->localVolume;
+                    sound.remoteVolume = previous->second->remoteVolume;
                 }
             }
+        }
+
+        record(Change::Kind::Tab, path);
+        touch(*tab);
+
+        sounds.rebuild(tabs);
+        return true;
+    }
+    void Data::hydrateAll()
+    {
+        std::vector<std::string> paths;
+        {
+            std::lock_guard lock(mutex);
+            paths.reserve(pending.size());
+            for (const auto &entry : pending)
+            {
+                paths.emplace_back(entry.first);
+            }
+        }
+
+        for (const auto &path : paths)
+        {
+            hydrate(path);
+        }
+    }
+    bool Data::hasPendingTabs() const
+    {
+        std::lock_guard lock(mutex);
+        return !pending.empty();
+    }
+    Tab Data::addTab(Tab tab)
+    {
+        std::lock_guard lock(mutex);
+        tab.id = tabs.size();
+        tabs.emplace_back(tab);
+        sounds.rebuild(tabs);
 
+        record(Change::Kind::Layout);
+        record(Change::Kind::Tab, tab.path);
+        touch(tabs.back());
+
+        return tabs.back();
+    }
+    void Data::removeTabById(const std::uint32_t &index)
+    {
+        std::lock_guard lock(mutex);
+        if (tabs.size() > index)
+        {
+            tabRevisions.erase(tabs.at(index).path);
             tabs.erase(tabs.begin() + index);
+            record(Change::Kind::Layout);
 
-            for (std::size_t i = 0; tabs.size() > i; i++)
+            for (std::size_t i = index; tabs.size() > i; i++)
             {
                 tabs.at(i).id = i;
+                touch(tabs.at(i));
             }
+
+            sounds.rebuild(tabs);
         }
         else
         {
             Fancy::fancy.logTime().warning() << "Tried to remove non existent tab" << std::endl;
         }
     }
-    void Data::setTabs(const std::vector<Tab> &newTabs)
+    void Data::setTabs(std::vector<Tab> newTabs)
     {
-        tabs = newTabs;
-        Globals::gSounds->clear();
-        Globals::gFavorites->clear();
-        for (std::size_t i = 0; tabs.size() > i; i++)
+        std::lock_guard lock(mutex);
+
+        record(Change::Kind::Layout);
+        for (const auto &tab : newTabs)
         {
-            auto &tab = tabs.at(i);
-            tab.id = i;
+            record(Change::Kind::Tab, tab.path);
+        }
 
-            for (auto &sound : tab.sounds)
+        assignTabs(std::move(newTabs));
+    }
+    bool Data::reorderTabs(const std::vector<int> &order)
+    {
+        std::lock_guard lock(mutex);
+        if (order.size() != tabs.size())
+        {
+            Fancy::fancy.logTime().warning() << "Tried to reorder tabs with an incomplete order" << std::endl;
+            return false;
+        }
+
+        std::vector<bool> seen(tabs.size(), false);
+        for (const auto &id : order)
+        {
+            if (id < 0 || static_cast<std::size_t>(id) >= tabs.size() || seen[id])
             {
-                Globals::gSounds->insert({sound.id, sound});
-                if (sound.isFavorite)
-                {
-                    Globals::gFavorites->insert({sound.id, sound});
-                }
+                Fancy::fancy.logTime().warning() << "Tried to reorder tabs with an invalid order" << std::endl;
+                return false;
             }
+            seen[id] = true;
+        }
+
+        std::vector<Tab> reordered;
+        reordered.reserve(tabs.size());
+
+        for (const auto &id : order)
+        {
+            reordered.emplace_back(std::move(tabs[id]));
         }
+
+        //* Only the order changed, the content of the tabs does not have to be sent again
+        record(Change::Kind::Layout);
+        assignTabs(std::move(reordered));
+
+        return true;
     }
     std::vector<Tab> Data::getTabs() const
     {
+        std::lock_guard lock(mutex);
         return tabs;
     }
     std::optional<Tab> Data::getTab(const std::uint32_t &id) const
     {
+        std::lock_guard lock(mutex);
         if (tabs.size() > id)
         {
             return tabs.at(id);
@@ -80,123 +369,300 @@ namespace Soundux::Objects
         Fancy::fancy.logTime().warning() << "Tried to access non existent tab " << id << std::endl;
         return std::nullopt;
     }
-    std::optional<std::reference_wrapper<Sound>> Data::getSound(const std::uint32_t &id)
+    std::optional<Tab> Data::getTabByPath(const std::string &path) const
+    {
+        std::lock_guard lock(mutex);
+        auto tab = std::find_if(tabs.begin(), tabs.end(), [&](const auto &item) { return item.path == path; });
+        if (tab != tabs.end())
+        {
+            return *tab;
+        }
+
+        return std::nullopt;
+    }
+    std::optional<std::string> Data::getTabPath(const std::uint32_t &id) const
+    {
+        std::lock_guard lock(mutex);
+        if (tabs.size() > id)
+        {
+            return tabs[id].path;
+        }
+
+        Fancy::fancy.logTime().warning() << "Tried to access non existent tab " << id << std::endl;
+        return std::nullopt;
+    }
+    std::optional<SoundPage> Data::getSoundPage(const std::uint32_t &id, std::size_t offset, std::size_t limit) const
+    {
+        std::lock_guard lock(mutex);
+        if (tabs.size() > id)
+        {
+            const auto &tab = tabs[id];
+
+            SoundPage rtn{id, offset, tab.sounds.size(), {}};
+            if (offset < tab.sounds.size())
+            {
+                auto begin = tab.sounds.begin() + static_cast<std::ptrdiff_t>(offset);
+                auto end = begin + static_cast<std::ptrdiff_t>(std::min(limit, tab.sounds.size() - offset));
+                rtn.sounds.assign(begin, end);
+            }
+
+            return rtn;
+        }
+
+        Fancy::fancy.logTime().warning() << "Tried to access non existent tab " << id << std::endl;
+        return std::nullopt;
+    }
+    std::shared_ptr<const SoundTable::Snapshot> Data::getSounds() const
+    {
+        return sounds.get();
+    }
+    std::optional<Sound> Data::getSound(const std::uint32_t &id) const
+    {
+        auto snapshot = sounds.get();
+        if (const auto *slot = snapshot->find(id); slot)
+        {
+            return *slot->sound;
+        }
+
+        Fancy::fancy.logTime().warning() << "Tried to access non existent sound " << id << std::endl;
+        return std::nullopt;
+    }
+    std::shared_ptr<const Sound> Data::findSound(const std::uint32_t &id) const
+    {
+        auto snapshot = sounds.get();
+        if (const auto *slot = snapshot->find(id); slot)
+        {
+            return slot->sound;
+        }
+
+        return nullptr;
+    }
+    std::optional<Sound> Data::updateSound(const std::uint32_t &id, const std::function<void(Sound &)> &modify)
     {
-        auto scopedSounds = Globals::gSounds.scoped();
-        if (scopedSounds->find(id) != scopedSounds->end())
+        std::lock_guard lock(mutex);
+
+        //* Writers hold the mutex, so the locations of the current snapshot match `tabs`
+        auto snapshot = sounds.get();
+        if (const auto *slot = snapshot->find(id); slot)
         {
-            return scopedSounds->at(id);
+            auto &sound = tabs.at(slot->tab).sounds.at(slot->position);
+            modify(sound);
+            sounds.update(sound);
+
+            record(Change::Kind::Sound, tabs.at(slot->tab).path, id);
+            touch(tabs.at(slot->tab));
+
+            return sound;
         }
 
         Fancy::fancy.logTime().warning() << "Tried to access non existent sound " << id << std::endl;
         return std::nullopt;
     }
-    std::optional<Tab> Data::setTab(const std::uint32_t &id, const Tab &tab)
+    std::optional<Tab> Data::setTab(const std::uint32_t &id, Tab tab)
     {
+        std::lock_guard lock(mutex);
         if (tabs.size() > id)
         {
             auto &realTab = tabs.at(id);
 
+            std::unordered_map<std::string_view, const Sound *> known;
+            known.reserve(realTab.sounds.size());
             for (const auto &sound : realTab.sounds)
             {
-                Globals::gSounds->erase(sound.id);
-                if (sound.isFavorite)
-                {
-                    Globals::gFavorites->erase(sound.id);
-                }
+                known.emplace(sound.path, &sound);
             }
-
-            realTab = tab;
-
-            for (auto &sound : realTab.sounds)
+            for (auto &sound : tab.sounds)
             {
-                Globals::gSounds->insert({sound.id, sound});
-                if (sound.isFavorite)
+                if (auto current = known.find(sound.path); current != known.end())
                 {
-                    Globals::gFavorites->insert({sound.id, sound});
+                    keepUserState(sound, *current->second);
                 }
             }
+
+            realTab = std::move(tab);
+            sounds.rebuild(tabs);
+
+            record(Change::Kind::Tab, realTab.path);
+            touch(realTab);
+
             return realTab;
         }
 
         Fancy::fancy.logTime().warning() << "Tried to access non existent Tab " << id << std::endl;
         return std::nullopt;
     }
-    void Data::set(const Data &other)
+    std::optional<Tab> Data::mergeTabContent(const std::string &path, std::vector<Sound> content)
     {
-        tabs = other.tabs;
-        width = other.width;
-        height = other.height;
-        soundIdCounter = other.soundIdCounter;
+        std::lock_guard lock(mutex);
 
-        Globals::gSounds->clear();
-        Globals::gFavorites->clear();
+        auto tab = std::find_if(tabs.begin(), tabs.end(), [&](const auto &item) { return item.path == path; });
+        if (tab == tabs.end())
+        {
+            return std::nullopt;
+        }
 
-        for (std::size_t i = 0; tabs.size() > i; i++)
+        std::unordered_map<std::string_view, const Sound *> known;
+        known.reserve(tab->sounds.size());
+        for (const auto &sound : tab->sounds)
         {
-            auto &tab = tabs.at(i);
-            tab.id = i;
+            known.emplace(sound.path, &sound);
+        }
 
-            for (auto &sound : tab.sounds)
+        //* The tab may have been edited while it was scanned, the current state wins over the scanned one
+        for (auto &sound : content)
+        {
+            if (auto current = known.find(sound.path); current != known.end())
             {
-                Globals::gSounds->insert({sound.id, sound});
-                if (sound.isFavorite)
-                {
-                    Globals::gFavorites->insert({sound.id, sound});
-                }
+                keepUserState(sound, *current->second);
             }
         }
-    }
-    void Data::markFavorite(const std::uint32_t &id, bool favourite)
-    {
-        auto sound = getSound(id);
-        if (sound)
+
+        auto unchanged = std::equal(content.begin(), content.end(), tab->sounds.begin(), tab->sounds.end(),
+                                    [](const auto &first, const auto &second) {
+                                        return first.id == second.id && first.path == second.path &&
+                                               first.modifiedDate == second.modifiedDate;
+                                    });
+        if (unchanged)
+        {
+            return std::nullopt;
+        }
+
+        std::unordered_set<std::uint32_t> remaining;
+        remaining.reserve(content.size());
+        std::vector<std::uint32_t> upserted;
+
+        for (const auto &sound : content)
+        {
+            remaining.emplace(sound.id);
+
+            auto previous = known.find(sound.path);
+            if (previous == known.end() || previous->second->id != sound.id ||
+                previous->second->modifiedDate != sound.modifiedDate)
+            {
+                upserted.emplace_back(sound.id);
+            }
+        }
+
+        std::vector<std::uint32_t> removed;
+        for (const auto &sound : tab->sounds)
         {
-            sound->get().isFavorite = favourite;
-            if (favourite)
+            if (remaining.count(sound.id) == 0)
             {
-                Globals::gFavorites->insert({id, sound->get()});
+                removed.emplace_back(sound.id);
             }
-            else
+        }
+
+        //* A file that only moved in the sort order is sent again as well, its position changed
+        if (upserted.empty() && removed.empty())
+        {
+            for (std::size_t i = 0; content.size() > i; i++)
             {
-                auto scopedFavorites = Globals::gFavorites.scoped();
-                if (scopedFavorites->find(id) != scopedFavorites->end())
+                if (tab->sounds.size() <= i || tab->sounds[i].id != content[i].id)
                 {
-                    scopedFavorites->erase(id);
+                    upserted.emplace_back(content[i].id);
                 }
             }
         }
+
+        tab->sounds = std::move(content);
+        sounds.rebuild(tabs);
+
+        //* Past a point the tab itself is smaller than the changes of its sounds
+        if (upserted.size() + removed.size() > std::max<std::size_t>(tab->sounds.size() / 2, 1) ||
+            upserted.size() + removed.size() > maxChanges / 4)
+        {
+            record(Change::Kind::Tab, path);
+        }
+        else
+        {
+            for (const auto &id : removed)
+            {
+                record(Change::Kind::SoundRemoved, path, id);
+            }
+            for (const auto &id : upserted)
+            {
+                record(Change::Kind::Sound, path, id);
+            }
+        }
+        touch(*tab);
+
+        return *tab;
     }
-    std::vector<std::uint32_t> Data::getFavoriteIds()
+    void Data::set(const Data &other)
+    {
+        set(Data(other));
+    }
+    void Data::set(Data &&other)
     {
-        auto scopedFavorites = Globals::gFavorites.scoped();
+        std::scoped_lock lock(mutex, other.mutex);
+        tabs = std::move(other.tabs);
+        width = other.width;
+        height = other.height;
+        pending = std::move(other.pending);
+        soundIdCounter = other.soundIdCounter.load();
+
+        other.tabs.clear();
+        other.pending.clear();
+
+        //* Nothing that was sent before still applies, receivers have to fetch the full state again
+        changes.clear();
+        logStart = ++revision;
+
+        tabRevisions.clear();
+        for (std::size_t i = 0; tabs.size() > i; i++)
+        {
+            tabs.at(i).id = i;
+            touch(tabs.at(i));
+        }
+
+        sounds.rebuild(tabs);
 
-        std::vector<std::uint32_t> rtn;
-        rtn.reserve(scopedFavorites->size());
+        if (changeCallback)
+        {
+            changeCallback();
+        }
+    }
+    void Data::markFavorite(const std::uint32_t &id, bool favourite)
+    {
+        updateSound(id, [favourite](Sound &sound) { sound.isFavorite = favourite; });
+    }
+    std::vector<std::uint32_t> Data::getFavoriteIds() const
+    {
+        return sounds.get()->favorites;
+    }
+    std::vector<Sound> Data::searchSounds(const std::string &query, std::size_t limit) const
+    {
+        auto snapshot = sounds.get();
 
-        for (const auto &sound : *scopedFavorites)
+        std::vector<Sound> rtn;
+        for (const auto &result : snapshot->search->search(query, limit))
         {
-            rtn.emplace_back(sound.first);
+            //* Sounds that share an id with an earlier one are not part of the snapshot
+            if (const auto *slot = snapshot->find(result.id); slot)
+            {
+                rtn.emplace_back(*slot->sound);
+            }
         }
 
         return rtn;
     }
-    std::vector<Sound> Data::getFavorites()
+    std::vector<Sound> Data::getFavorites() const
     {
-        auto scopedFavorites = Globals::gFavorites.scoped();
+        auto snapshot = sounds.get();
 
         std::vector<Sound> rtn;
-        rtn.reserve(scopedFavorites->size());
+        rtn.reserve(snapshot->favorites.size());
 
-        for (const auto &sound : *scopedFavorites)
+        for (const auto &id : snapshot->favorites)
         {
-            rtn.emplace_back(sound.second);
+            rtn.emplace_back(*snapshot->find(id)->sound);
         }
 
         return rtn;
     }
     bool Data::doesTabExist(const std::string &path)
     {
+        std::lock_guard lock(mutex);
         auto it = std::find_if(tabs.begin(), tabs.end(), [&](const auto &tab) { return tab.path == path; });
         return it != tabs.end();
     }
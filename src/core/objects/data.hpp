@@ -1,7 +1,13 @@
 #pragma once
 #include "objects.hpp"
+#include "sounds.hpp"
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 namespace nlohmann
@@ -13,34 +19,171 @@ namespace Soundux
 {
     namespace Objects
     {
+        //* A single sound that was added to, changed in or removed from a tab
+        struct SoundOp
+        {
+            enum class Kind : std::uint8_t
+            {
+                Upsert,
+                Remove
+            } kind;
+
+            std::uint32_t tab;
+            std::uint32_t id;
+            //* Only set for upserts, `position` is the index of the sound in its tab
+            std::size_t position = 0;
+            std::optional<Sound> sound;
+        };
+
+        //* Everything that changed between `since` and `revision`. If `full` is set the receiver has to replace its
+        //* state with `tabs`, otherwise `layout` (tabs without sounds) is only present if tabs were added, removed or
+        //* moved, `tabs` holds the tabs that have to be replaced as a whole and `sounds` the changes of single sounds
+        //* in the other tabs. Removals come first, upserts follow in the order of their position.
+        struct TabChanges
+        {
+            std::uint64_t since = 0;
+            std::uint64_t revision = 0;
+            bool full = false;
+
+            std::optional<std::vector<Tab>> layout;
+            std::vector<Tab> tabs;
+            std::vector<SoundOp> sounds;
+        };
+
+        //* A window of the sounds of a tab, in the order given by the sort mode of the tab
+        struct SoundPage
+        {
+            std::uint32_t tab;
+            std::size_t offset;
+            std::size_t total;
+            std::vector<Sound> sounds;
+        };
+
         class Data
         {
             template <typename, typename> friend struct nlohmann::adl_serializer;
 
           private:
             std::vector<Tab> tabs;
+            SoundTable sounds;
+            mutable std::recursive_mutex mutex;
+
+            struct Change
+            {
+                enum class Kind : std::uint8_t
+                {
+                    Layout,
+                    Tab,
+                    Sound,
+                    SoundRemoved
+                } kind;
+
+                std::uint64_t revision;
+                std::string path;
+                std::uint32_t sound;
+            };
+
+            //* Bumped on every change to the tabs, `tabRevisions` remembers the revision a tab was last changed in
+            std::atomic<std::uint64_t> revision = 0;
+            std::unordered_map<std::string, std::uint64_t> tabRevisions;
+
+            //* The most recent changes, covers every revision after `logStart`
+            static constexpr std::size_t maxChanges = 1024;
+            std::deque<Change> changes;
+            std::uint64_t logStart = 0;
+
+            //* Sounds of tabs that were loaded from the config but not converted yet, keyed by tab path
+            std::unordered_map<std::string, std::function<std::vector<Sound>()>> pending;
+
+            //* Called with the data locked after every change, must not call back into `Data`
+            std::function<void()> changeCallback;
+
+            void touch(const Tab &);
+            void record(Change::Kind, const std::string &path = {}, std::uint32_t sound = 0);
+            void assignTabs(std::vector<Tab>);
 
           public:
             bool isOnFavorites = false;
             int width = 1280, height = 720;
-            std::uint32_t soundIdCounter = 0;
+            std::atomic<std::uint32_t> soundIdCounter = 0;
+
+            Data() = default;
+            //* Only copies the state, sound lookups on the copy will not find anything
+            Data(const Data &other);
+
+            void setChangeCallback(std::function<void()>);
+
+            std::uint64_t getRevision() const;
+            std::uint64_t getTabRevision(const std::string &path) const;
+            //* Returns a full state if `since` is older than the change log
+            TabChanges getChangesSince(std::uint64_t since) const;
+
+            //* Registers a loader for the sounds of the tab at `path`, the tab stays empty until `hydrate` is called
+            void setPending(const std::string &path, std::function<std::vector<Sound>()> loader);
+            //* Runs the loader of the tab at `path`. Returns false if there was none or another thread already runs it.
+            bool hydrate(const std::string &path);
+            void hydrateAll();
+            bool hasPendingTabs() const;
 
             std::vector<Tab> getTabs() const;
-            void setTabs(const std::vector<Tab> &);
+            void setTabs(std::vector<Tab>);
+            //* Moves the tabs into the given order, `order` has to contain every tab id exactly once
+            bool reorderTabs(const std::vector<int> &order);
             bool doesTabExist(const std::string &);
-            std::optional<Tab> setTab(const std::uint32_t &, const Tab &);
+            //* Sounds that are still present keep their id, hotkeys and volumes
+            std::optional<Tab> setTab(const std::uint32_t &, Tab);
+            //* Applies a rescan of the tab at `path`, sounds that are still present keep their id, hotkeys and volumes.
+            //* Only the sounds that were added, changed or removed are logged, unless that is most of the tab.
+            //* Returns the updated tab, or nothing if the content did not change.
+            std::optional<Tab> mergeTabContent(const std::string &path, std::vector<Sound>);
 
             Tab addTab(Tab);
             void removeTabById(const std::uint32_t &);
 
             std::optional<Tab> getTab(const std::uint32_t &) const;
-            std::optional<std::reference_wrapper<Sound>> getSound(const std::uint32_t &);
+            std::optional<Tab> getTabByPath(const std::string &) const;
+            std::optional<std::string> getTabPath(const std::uint32_t &) const;
+            //* Returns at most `limit` sounds of the tab starting at `offset`, together with the amount of sounds in it
+            std::optional<SoundPage> getSoundPage(const std::uint32_t &, std::size_t offset, std::size_t limit) const;
+
+            //* Calls `visitor` with every tab while the tabs are locked, the reference must not outlive the call
+            template <typename Visitor> void visitTabs(Visitor &&visitor) const
+            {
+                std::lock_guard lock(mutex);
+                for (const auto &tab : tabs)
+                {
+                    visitor(tab);
+                }
+            }
+            //* Same as `visitTabs` for a single tab, returns false if the tab does not exist
+            template <typename Visitor> bool visitTab(const std::uint32_t &id, Visitor &&visitor) const
+            {
+                std::lock_guard lock(mutex);
+                if (tabs.size() > id)
+                {
+                    visitor(tabs[id]);
+                    return true;
+                }
+
+                return false;
+            }
+            //* Does not wait for writers, the returned snapshot stays valid even if the tabs change afterwards
+            std::shared_ptr<const SoundTable::Snapshot> getSounds() const;
+            std::optional<Sound> getSound(const std::uint32_t &) const;
+            //* Same as `getSound` without copying the sound or logging a miss, for the paths that play sounds
+            std::shared_ptr<const Sound> findSound(const std::uint32_t &) const;
+            //* Applies `modify` to the stored sound and returns the result, the id of the sound must not be changed
+            std::optional<Sound> updateSound(const std::uint32_t &, const std::function<void(Sound &)> &modify);
+
+            //* Ranked by how well their name or folder matches `query`
+            std::vector<Sound> searchSounds(const std::string &query, std::size_t limit) const;
 
-            std::vector<Sound> getFavorites();
-            std::vector<std::uint32_t> getFavoriteIds();
+            std::vector<Sound> getFavorites() const;
+            std::vector<std::uint32_t> getFavoriteIds() const;
             void markFavorite(const std::uint32_t &, bool);
 
             void set(const Data &other);
+            void set(Data &&other);
             Data &operator=(const Data &other) = delete;
         };
     } // namespace Objects
@@ -1,5 +1,9 @@
 #pragma once
+#include "strings.hpp"
+#include <algorithm>
+#include <array>
 #include <core/enums/enums.hpp>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
@@ -10,14 +14,74 @@ namespace Soundux
     {
         struct AudioDevice;
 
+        //* The keys of a hotkey stored inline, so that copying a sound never allocates for them
+        class KeyCombination
+        {
+          public:
+            //* Chosen so that a combination takes 32 bytes
+            static constexpr std::size_t capacity = 7;
+
+          private:
+            std::array<int, capacity> keys{};
+            std::uint8_t count = 0;
+
+          public:
+            KeyCombination() = default;
+            //* Keys beyond `capacity` are dropped, use `fits` to check first
+            KeyCombination(const std::vector<int> &combination) // NOLINT
+                : count(static_cast<std::uint8_t>(std::min(combination.size(), capacity)))
+            {
+                std::copy_n(combination.begin(), count, keys.begin());
+            }
+            static bool fits(const std::vector<int> &combination)
+            {
+                return combination.size() <= capacity;
+            }
+
+            const int *begin() const
+            {
+                return keys.data();
+            }
+            const int *end() const
+            {
+                return keys.data() + count;
+            }
+            std::size_t size() const
+            {
+                return count;
+            }
+            bool empty() const
+            {
+                return count == 0;
+            }
+            std::vector<int> toVector() const
+            {
+                return {begin(), end()};
+            }
+
+            bool operator==(const std::vector<int> &other) const
+            {
+                return std::equal(begin(), end(), other.begin(), other.end());
+            }
+            friend bool operator==(const KeyCombination &first, const KeyCombination &second)
+            {
+                return std::equal(first.begin(), first.end(), second.begin(), second.end());
+            }
+            friend bool operator!=(const KeyCombination &first, const KeyCombination &second)
+            {
+                return !(first == second);
+            }
+        };
+
+        //* Copying a sound only bumps the reference count of its strings
         struct Sound
         {
             std::uint32_t id;
-            std::string name;
-            std::string path;
+            SharedString name;
+            SharedString path;
             bool isFavorite = false;
 
-            std::vector<int> hotkeys;
+            KeyCombination hotkeys;
             std::uint64_t modifiedDate;
 
             std::optional<int> localVolume;
@@ -0,0 +1,242 @@
+#include "search.hpp"
+#include <algorithm>
+#include <string_view>
+
+namespace Soundux::Objects
+{
+    static std::string toLower(std::string_view text)
+    {
+        std::string rtn(text);
+        std::transform(rtn.begin(), rtn.end(), rtn.begin(),
+                       [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; });
+        return rtn;
+    }
+    static std::vector<std::uint32_t> trigramsOf(std::string_view text)
+    {
+        std::vector<std::uint32_t> rtn;
+        if (text.size() < 3)
+        {
+            return rtn;
+        }
+
+        rtn.reserve(text.size() - 2);
+        for (std::size_t i = 0; text.size() - 2 > i; i++)
+        {
+            rtn.emplace_back(static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                             static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                             static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 2])));
+        }
+
+        std::sort(rtn.begin(), rtn.end());
+        rtn.erase(std::unique(rtn.begin(), rtn.end()), rtn.end());
+
+        return rtn;
+    }
+    static bool isSeparator(char c)
+    {
+        return c == ' ' || c == '_' || c == '-' || c == '.';
+    }
+    //* `similarity` is the share of the trigrams of the query found in `name`
+    static float rank(std::string_view name, std::size_t position, float similarity)
+    {
+        auto score = similarity;
+        if (position != std::string_view::npos)
+        {
+            score += 1.F;
+            if (position == 0)
+            {
+                score += 1.F;
+            }
+            else if (isSeparator(name[position - 1]))
+            {
+                score += .5F;
+            }
+        }
+
+        //* Shorter names win ties
+        return score - static_cast<float>(name.size()) * .001F;
+    }
+
+    SearchIndex::Part::Part(const Tab &tab) : path(tab.path), folder(toLower(tab.name))
+    {
+        ids.reserve(tab.sounds.size());
+        offsets.reserve(tab.sounds.size() + 1);
+
+        for (const auto &sound : tab.sounds)
+        {
+            ids.emplace_back(sound.id);
+            offsets.emplace_back(static_cast<std::uint32_t>(names.size()));
+
+            names += toLower(sound.name);
+            names += '\n';
+        }
+        offsets.emplace_back(static_cast<std::uint32_t>(names.size()));
+
+        for (std::uint32_t i = 0; ids.size() > i; i++)
+        {
+            for (const auto &trigram : trigramsOf(name(i)))
+            {
+                trigrams[trigram].emplace_back(i);
+            }
+        }
+    }
+    std::string_view SearchIndex::Part::name(std::size_t entry) const
+    {
+        return std::string_view(names).substr(offsets[entry], offsets[entry + 1] - offsets[entry] - 1);
+    }
+    bool SearchIndex::Part::contains(const Tab &tab) const
+    {
+        //* A path keeps its sound id, so equal ids mean equal names
+        return tab.path == path &&
+               std::equal(ids.begin(), ids.end(), tab.sounds.begin(), tab.sounds.end(),
+                          [](const auto &id, const auto &sound) { return id == sound.id; });
+    }
+    std::shared_ptr<const SearchIndex> SearchIndex::build(const std::vector<Tab> &tabs, const SearchIndex *previous)
+    {
+        std::unordered_map<std::string_view, std::shared_ptr<const Part>> reusable;
+        if (previous)
+        {
+            for (const auto &part : previous->parts)
+            {
+                reusable.emplace(part->path, part);
+            }
+        }
+
+        auto index = std::make_shared<SearchIndex>();
+        index->parts.reserve(tabs.size());
+
+        for (const auto &tab : tabs)
+        {
+            if (auto part = reusable.find(tab.path); part != reusable.end() && part->second->contains(tab))
+            {
+                index->parts.emplace_back(part->second);
+                continue;
+            }
+
+            index->parts.emplace_back(std::make_shared<const Part>(tab));
+        }
+
+        return index;
+    }
+    std::vector<SearchIndex::Result> SearchIndex::search(const std::string &query, std::size_t limit) const
+    {
+        auto needle = toLower(std::string_view(query).substr(0, maxQueryLength));
+        needle.erase(0, needle.find_first_not_of(' '));
+        needle.erase(needle.find_last_not_of(' ') + 1);
+
+        if (needle.empty() || limit == 0)
+        {
+            return {};
+        }
+
+        struct Candidate
+        {
+            float score;
+            std::size_t order;
+            std::uint32_t id;
+        };
+
+        //* Keeps the best `limit` candidates as a heap with the worst one on top
+        auto worse = [](const Candidate &first, const Candidate &second) {
+            return first.score != second.score ? first.score > second.score : first.order < second.order;
+        };
+
+        std::vector<Candidate> candidates;
+        candidates.reserve(limit);
+        std::size_t order = 0;
+
+        auto offer = [&](float score, std::uint32_t id) {
+            Candidate candidate{score, order, id};
+            if (limit > candidates.size())
+            {
+                candidates.push_back(candidate);
+                std::push_heap(candidates.begin(), candidates.end(), worse);
+            }
+            else if (worse(candidate, candidates.front()))
+            {
+                std::pop_heap(candidates.begin(), candidates.end(), worse);
+                candidates.back() = candidate;
+                std::push_heap(candidates.begin(), candidates.end(), worse);
+            }
+        };
+
+        //* A typo breaks up to three trigrams, so only a part of them has to match. Queries that are too short to
+        //* have a trigram have to be contained exactly.
+        auto queryTrigrams = trigramsOf(needle);
+        auto total = static_cast<std::uint8_t>(std::max<std::size_t>(queryTrigrams.size(), 1));
+        auto threshold = static_cast<std::uint8_t>(std::max((total * 2 + 4) / 5, 1));
+
+        std::vector<std::uint8_t> counts;
+        for (const auto &part : parts)
+        {
+            counts.assign(part->ids.size(), 0);
+
+            if (queryTrigrams.empty())
+            {
+                std::size_t entry = 0;
+                for (auto position = part->names.find(needle); position != std::string::npos;)
+                {
+                    while (position >= part->offsets[entry + 1])
+                    {
+                        entry++;
+                    }
+
+                    counts[entry] = total;
+                    position = part->names.find(needle, part->offsets[entry + 1]);
+                }
+            }
+            else
+            {
+                for (const auto &trigram : queryTrigrams)
+                {
+                    if (auto postings = part->trigrams.find(trigram); postings != part->trigrams.end())
+                    {
+                        for (const auto &entry : postings->second)
+                        {
+                            counts[entry]++;
+                        }
+                    }
+                }
+            }
+
+            //* Only the first sounds of a matching folder can make it into the results
+            auto folderMatch = part->folder.find(needle) != std::string::npos;
+            std::size_t folderMatches = 0;
+
+            for (std::size_t i = 0; counts.size() > i; i++, order++)
+            {
+                auto name = part->name(i);
+                if (counts[i] >= threshold)
+                {
+                    auto similarity = static_cast<float>(counts[i]) / static_cast<float>(total);
+
+                    //* Skip ranking names that could not beat the worst result even as a prefix match
+                    auto best = rank(name, 0, similarity) + (folderMatch ? .5F : 0.F);
+                    if (candidates.size() == limit && best <= candidates.front().score)
+                    {
+                        continue;
+                    }
+
+                    offer(rank(name, name.find(needle), similarity) + (folderMatch ? .5F : 0.F), part->ids[i]);
+                }
+                else if (folderMatch && limit > folderMatches)
+                {
+                    folderMatches++;
+                    offer(rank(name, std::string_view::npos, .5F), part->ids[i]);
+                }
+            }
+        }
+
+        std::sort_heap(candidates.begin(), candidates.end(), worse);
+
+        std::vector<Result> rtn;
+        rtn.reserve(candidates.size());
+
+        for (const auto &candidate : candidates)
+        {
+            rtn.push_back({candidate.id, candidate.score});
+        }
+
+        return rtn;
+    }
+} // namespace Soundux::Objects
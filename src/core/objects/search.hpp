@@ -0,0 +1,62 @@
+#pragma once
+#include "objects.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Trigram index over the names of all sounds, matching the folder of a tab also yields its sounds. Every tab
+        //* has its own part, parts of tabs whose sounds did not change are shared with the previous index.
+        class SearchIndex
+        {
+          public:
+            struct Result
+            {
+                std::uint32_t id;
+                float score;
+            };
+
+            //* Queries are truncated to this length
+            static constexpr std::size_t maxQueryLength = 64;
+
+          private:
+            class Part
+            {
+                friend class SearchIndex;
+
+                std::string path;
+                //* Lower case name of the tab, tabs are not scanned recursively so this is the folder of every sound
+                std::string folder;
+
+                std::vector<std::uint32_t> ids;
+                //* Lower case names of all sounds, each one followed by a line break. `offsets` holds the start of
+                //* every name and the end of the last one.
+                std::string names;
+                std::vector<std::uint32_t> offsets;
+                //* Trigram → indices of the names that contain it, in ascending order
+                std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> trigrams;
+
+                std::string_view name(std::size_t) const;
+
+              public:
+                explicit Part(const Tab &);
+                bool contains(const Tab &) const;
+            };
+
+            std::vector<std::shared_ptr<const Part>> parts;
+
+          public:
+            //* Reuses the parts of `previous` for tabs that still contain the same sounds
+            static std::shared_ptr<const SearchIndex> build(const std::vector<Tab> &, const SearchIndex *previous);
+
+            //* Returns at most `limit` matches, best match first. Matches may contain a small amount of typos.
+            std::vector<Result> search(const std::string &query, std::size_t limit) const;
+        };
+    } // namespace Objects
+} // namespace Soundux
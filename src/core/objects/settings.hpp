@@ -32,6 +32,23 @@ namespace Soundux
             bool minimizeToTray = false;
             bool tabHotkeysOnly = false;
             bool deleteToTrash = true;
+
+            std::uint64_t pcmCacheBudget = 64 * 1024 * 1024;
+            Enums::LatencyProfile latencyProfile = Enums::LatencyProfile::Low;
+            std::uint32_t uiUpdateRate = 30;
+            std::uint32_t maxDownloads = 3;
+            Enums::ImportFormat importFormat = Enums::ImportFormat::Flac;
+            bool normalizeImports = true;
+            std::uint32_t routingIdleTimeout = 30;
+            //* 0 means as many as the audio engine can hold
+            std::uint32_t maxPolyphony = 16;
+            Enums::VoiceStealing voiceStealing = Enums::VoiceStealing::Oldest;
+            bool restartOnRetrigger = false;
+            //* Decodes sounds with a hotkey and the sounds of the selected tab into the cache ahead of their first play
+            bool preloadSounds = true;
+            //* Plays every sound at `loudnessTarget` LUFS, the loudness is analyzed once in the background
+            bool normalizeLoudness = false;
+            int loudnessTarget = -16;
         };
     } // namespace Objects
 } // namespace Soundux
\ No newline at end of file
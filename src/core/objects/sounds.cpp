@@ -0,0 +1,115 @@
+#include "sounds.hpp"
+#include <algorithm>
+
+namespace Soundux::Objects
+{
+    const SoundTable::Slot *SoundTable::Snapshot::find(std::uint32_t id) const
+    {
+        if (auto slot = index->find(id); slot != index->end())
+        {
+            return &slots[slot->second];
+        }
+
+        return nullptr;
+    }
+    SoundTable::SoundTable()
+    {
+        auto empty = std::make_shared<Snapshot>();
+        empty->index = std::make_shared<std::unordered_map<std::uint32_t, std::uint32_t>>();
+        empty->hotkeys = std::make_shared<HotkeyIndex>();
+        empty->search = std::make_shared<SearchIndex>();
+        current = std::move(empty);
+    }
+    std::shared_ptr<const HotkeyIndex> SoundTable::indexHotkeys(const std::vector<Slot> &slots)
+    {
+        auto index = std::make_shared<HotkeyIndex>();
+        for (std::uint32_t i = 0; slots.size() > i; i++)
+        {
+            index->add(i, slots[i].sound->hotkeys);
+        }
+
+        return index;
+    }
+    std::shared_ptr<const SoundTable::Snapshot> SoundTable::get() const
+    {
+        return std::atomic_load(&current);
+    }
+    void SoundTable::rebuild(const std::vector<Tab> &tabs)
+    {
+        std::size_t size = 0;
+        for (const auto &tab : tabs)
+        {
+            size += tab.sounds.size();
+        }
+
+        auto snapshot = std::make_shared<Snapshot>();
+        auto index = std::make_shared<std::unordered_map<std::uint32_t, std::uint32_t>>();
+
+        snapshot->slots.reserve(size);
+        index->reserve(size);
+
+        for (std::uint32_t i = 0; tabs.size() > i; i++)
+        {
+            const auto &sounds = tabs[i].sounds;
+            for (std::uint32_t j = 0; sounds.size() > j; j++)
+            {
+                const auto &sound = sounds[j];
+
+                //* The first sound with a given id wins, just like it did back when this was a map
+                if (!index->emplace(sound.id, static_cast<std::uint32_t>(snapshot->slots.size())).second)
+                {
+                    continue;
+                }
+
+                snapshot->slots.push_back({std::make_shared<const Sound>(sound), i, j});
+                if (sound.isFavorite)
+                {
+                    snapshot->favorites.emplace_back(sound.id);
+                }
+            }
+        }
+
+        std::sort(snapshot->favorites.begin(), snapshot->favorites.end());
+        snapshot->index = std::move(index);
+        snapshot->hotkeys = indexHotkeys(snapshot->slots);
+        snapshot->search = SearchIndex::build(tabs, get()->search.get());
+
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+    }
+    void SoundTable::update(const Sound &sound)
+    {
+        auto previous = get();
+        auto slot = previous->index->find(sound.id);
+        if (slot == previous->index->end())
+        {
+            return;
+        }
+
+        auto snapshot = std::make_shared<Snapshot>(*previous);
+        auto &target = snapshot->slots[slot->second];
+
+        auto &favorites = snapshot->favorites;
+        if (target.sound->isFavorite != sound.isFavorite)
+        {
+            auto it = std::lower_bound(favorites.begin(), favorites.end(), sound.id);
+            if (sound.isFavorite)
+            {
+                favorites.insert(it, sound.id);
+            }
+            else if (it != favorites.end() && *it == sound.id)
+            {
+                favorites.erase(it);
+            }
+        }
+
+        auto hotkeysChanged = target.sound->hotkeys != sound.hotkeys;
+        target.sound = std::make_shared<const Sound>(sound);
+
+        if (hotkeysChanged)
+        {
+            snapshot->hotkeys = indexHotkeys(snapshot->slots);
+        }
+
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+    }
+} // namespace Soundux::Objects
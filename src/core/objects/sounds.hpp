@@ -0,0 +1,60 @@
+#pragma once
+#include "objects.hpp"
+#include "search.hpp"
+#include <core/hotkeys/index.hpp>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Read-mostly view of the sounds of every tab. Readers load the current snapshot without waiting on `Data`,
+        //* writers (which are serialized by `Data`) publish a new one. A published snapshot is never modified again,
+        //* so a reader may keep using it for as long as it holds on to it.
+        //! The snapshot is swapped with `std::atomic_load`/`std::atomic_store`, which take a short internal lock, so
+        //! it must not be read from the audio callback.
+        class SoundTable
+        {
+          public:
+            struct Slot
+            {
+                std::shared_ptr<const Sound> sound;
+
+                //* Where the sound lives in `Data::tabs`, only valid while the snapshot is the current one
+                std::uint32_t tab;
+                std::uint32_t position;
+            };
+            struct Snapshot
+            {
+                std::vector<Slot> slots;
+                //* Sound id → slot, shared between snapshots that only differ in the content of a sound
+                std::shared_ptr<const std::unordered_map<std::uint32_t, std::uint32_t>> index;
+                //* Ids of all favorites in ascending order
+                std::vector<std::uint32_t> favorites;
+                //* Hotkeys of all slots, only rebuilt when a hotkey changes
+                std::shared_ptr<const HotkeyIndex> hotkeys;
+                //* Names of all sounds, only rebuilt for tabs whose sounds changed
+                std::shared_ptr<const SearchIndex> search;
+
+                const Slot *find(std::uint32_t id) const;
+            };
+
+          private:
+            std::shared_ptr<const Snapshot> current;
+
+            static std::shared_ptr<const HotkeyIndex> indexHotkeys(const std::vector<Slot> &);
+
+          public:
+            SoundTable();
+
+            std::shared_ptr<const Snapshot> get() const;
+
+            void rebuild(const std::vector<Tab> &);
+            //* Replaces the sound with the same id, the sound has to stay at the same location and keep its name
+            void update(const Sound &);
+        };
+    } // namespace Objects
+} // namespace Soundux
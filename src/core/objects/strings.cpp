@@ -0,0 +1,84 @@
+#include "strings.hpp"
+#include <mutex>
+#include <unordered_map>
+
+namespace Soundux::Objects
+{
+    struct Pool
+    {
+        std::mutex mutex;
+        //* Keyed by views into the interned strings, a string removes its entry before it is freed
+        std::unordered_map<std::string_view, std::weak_ptr<const std::string>> strings;
+    };
+    //* Never destroyed, global sounds may still release their strings after static destruction started
+    static Pool &getPool()
+    {
+        static auto *pool = new Pool;
+        return *pool;
+    }
+
+    std::shared_ptr<const std::string> SharedString::intern(std::string &&string)
+    {
+        auto &pool = getPool();
+        std::lock_guard lock(pool.mutex);
+
+        if (auto existing = pool.strings.find(string); existing != pool.strings.end())
+        {
+            if (auto interned = existing->second.lock(); interned)
+            {
+                return interned;
+            }
+
+            //* The last copy is being released right now, its deleter will leave the new entry alone
+            pool.strings.erase(existing);
+        }
+
+        std::shared_ptr<const std::string> interned(new std::string(std::move(string)), [](const std::string *item) {
+            auto &pool = getPool();
+            {
+                std::lock_guard lock(pool.mutex);
+                if (auto entry = pool.strings.find(*item); entry != pool.strings.end() && entry->second.expired())
+                {
+                    pool.strings.erase(entry);
+                }
+            }
+            delete item;
+        });
+        pool.strings.emplace(*interned, interned);
+
+        return interned;
+    }
+    SharedString::SharedString()
+    {
+        //* Default constructed strings are common enough to not go through the pool every time
+        static const auto *empty = new std::shared_ptr<const std::string>(intern({}));
+        value = *empty;
+    }
+    SharedString::SharedString(std::string string) : value(intern(std::move(string))) {}
+    SharedString::SharedString(const char *string) : SharedString(std::string(string)) {}
+
+    const std::string &SharedString::get() const
+    {
+        return *value;
+    }
+    SharedString::operator const std::string &() const
+    {
+        return *value;
+    }
+    SharedString::operator std::string_view() const
+    {
+        return *value;
+    }
+    const char *SharedString::c_str() const
+    {
+        return value->c_str();
+    }
+    std::size_t SharedString::size() const
+    {
+        return value->size();
+    }
+    bool SharedString::empty() const
+    {
+        return value->empty();
+    }
+} // namespace Soundux::Objects
@@ -0,0 +1,80 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Immutable string, copies share the same storage so copying one only bumps a reference count. Strings are
+        //* interned, equal strings created anywhere (e.g. by a rescan of a tab) also share their storage.
+        class SharedString
+        {
+            std::shared_ptr<const std::string> value;
+
+            static std::shared_ptr<const std::string> intern(std::string &&);
+
+          public:
+            SharedString();
+            SharedString(std::string);   // NOLINT
+            SharedString(const char *);  // NOLINT
+
+            const std::string &get() const;
+            operator const std::string &() const; // NOLINT
+            operator std::string_view() const;     // NOLINT
+
+            const char *c_str() const;
+            std::size_t size() const;
+            bool empty() const;
+
+            friend bool operator==(const SharedString &first, const SharedString &second)
+            {
+                return first.value == second.value || *first.value == *second.value;
+            }
+            friend bool operator!=(const SharedString &first, const SharedString &second)
+            {
+                return !(first == second);
+            }
+            template <typename T,
+                      typename = std::enable_if_t<std::is_convertible_v<const T &, std::string_view> &&
+                                                  !std::is_same_v<T, SharedString>>>
+            friend bool operator==(const SharedString &first, const T &second)
+            {
+                return std::string_view(*first.value) == std::string_view(second);
+            }
+            template <typename T,
+                      typename = std::enable_if_t<std::is_convertible_v<const T &, std::string_view> &&
+                                                  !std::is_same_v<T, SharedString>>>
+            friend bool operator!=(const SharedString &first, const T &second)
+            {
+                return !(first == second);
+            }
+            friend bool operator<(const SharedString &first, const SharedString &second)
+            {
+                return *first.value < *second.value;
+            }
+            friend bool operator>(const SharedString &first, const SharedString &second)
+            {
+                return *first.value > *second.value;
+            }
+            friend std::ostream &operator<<(std::ostream &stream, const SharedString &string)
+            {
+                return stream << *string.value;
+            }
+        };
+    } // namespace Objects
+} // namespace Soundux
+
+namespace std
+{
+    template <> struct hash<Soundux::Objects::SharedString>
+    {
+        std::size_t operator()(const Soundux::Objects::SharedString &string) const
+        {
+            return std::hash<std::string>{}(string.get());
+        }
+    };
+} // namespace std
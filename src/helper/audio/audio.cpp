@@ -1,13 +1,15 @@
 #include "audio.hpp"
 #include <core/global/globals.hpp>
+#include <algorithm>
+#include <cmath>
 #include <fancy.hpp>
-#if defined(_WIN32)
 #include <helper/misc/misc.hpp>
-#endif
 
 #define MINIAUDIO_IMPLEMENTATION
 #include <miniaudio.h>
 
+using namespace std::chrono_literals;
+
 namespace Soundux::Objects
 {
 #if defined(_WIN32)
@@ -16,167 +18,871 @@ namespace Soundux::Objects
 
     void Audio::setup()
     {
-#if defined(__linux__)
-        nullSink = std::nullopt;
-#endif
-        for (const auto &device : getAudioDevices())
+        stopAll();
+        reclaim(true);
+        mixers->clear();
+        //* The sounds the mixers reported as finished were already released by `stopAll`
+        Globals::gQueue.discardPosts();
+
+        cache.setBudget(Globals::gSettings.pcmCacheBudget);
+
+        channels = 0;
+        sampleRate = 0;
+
+        if (!decoderRunning)
         {
-            if (device.isDefault)
-            {
-                defaultPlayback = device;
-            }
-#if defined(__linux__)
-            if (device.name == "soundux_sink")
+            decoderRunning = true;
+            decoderThread = std::thread([this] { decode(); });
+            progressThread = std::thread([this] { reportProgress(); });
+            preloadThread = std::thread([this] { runPreloads(); });
+            reclaimThread = std::thread([this] { runReclaimer(); });
+        }
+
+        if (!contextInitialized)
+        {
+            if (ma_context_init(nullptr, 0, nullptr, &context) != MA_SUCCESS)
             {
-                nullSink = device;
+                Fancy::fancy.logTime().failure() << "Failed to initialize context" << std::endl;
+                return;
             }
-#endif
+            contextInitialized = true;
         }
+
+        refreshDevices();
     }
     void Audio::destroy()
     {
         stopAll();
+        reclaim(true);
+        mixers->clear();
+        //* The sounds the mixers reported as finished were already released by `stopAll`
+        Globals::gQueue.discardPosts();
+
+        if (decoderRunning)
+        {
+            decoderRunning = false;
+            decoderCv.notify_all();
+            preloadCv.notify_all();
+            retiredCv.notify_all();
+            decoderThread.join();
+            progressThread.join();
+            preloadThread.join();
+            reclaimThread.join();
+        }
+        if (contextInitialized)
+        {
+            ma_context_uninit(&context);
+            contextInitialized = false;
+        }
     }
-    std::optional<PlayingSound> Audio::play(const Objects::Sound &sound,
-                                            const std::optional<Objects::AudioDevice> &playbackDevice)
+    void Audio::decode()
+    {
+        while (decoderRunning)
+        {
+            auto sounds = playingSounds.snapshot();
+            {
+                std::lock_guard lock(decoderMutex);
+                for (const auto &sound : sounds)
+                {
+                    fill(*sound, decodeBuffer);
+                }
+            }
+            sounds.clear();
+
+            std::unique_lock lock(decoderWakeMutex);
+            decoderCv.wait_for(lock, 10ms, [this] { return decoderWoken || !decoderRunning; });
+            decoderWoken = false;
+        }
+    }
+    void Audio::wakeDecoder()
+    {
+        {
+            std::lock_guard lock(decoderWakeMutex);
+            decoderWoken = true;
+        }
+
+        decoderCv.notify_one();
+    }
+    void Audio::reportProgress()
+    {
+        std::vector<SoundProgress> batch;
+        while (decoderRunning)
+        {
+            while (auto item = progress.pop())
+            {
+                //* Only the latest position of every sound is of interest
+                auto it = std::find_if(batch.begin(), batch.end(),
+                                       [&](const auto &entry) { return entry.id == item->id; });
+                if (it != batch.end())
+                {
+                    *it = *item;
+                }
+                else
+                {
+                    batch.emplace_back(*item);
+                }
+            }
+
+            if (Globals::gGui)
+            {
+                for (const auto &item : batch)
+                {
+                    Globals::gGui->onSoundProgressed(item);
+                }
+            }
+            batch.clear();
+
+            std::this_thread::sleep_for(50ms);
+        }
+    }
+    void Audio::runPreloads()
+    {
+        //* Preloading must never take time away from the decoder thread or the UI
+        Helpers::lowerThreadPriority();
+
+        while (decoderRunning)
+        {
+            std::optional<Objects::Sound> next;
+            {
+                std::unique_lock lock(preloadMutex);
+                preloadCv.wait(lock, [this] { return !preloads.empty() || !decoderRunning; });
+
+                if (!decoderRunning)
+                {
+                    break;
+                }
+
+                next = std::move(preloads.front());
+                preloads.pop_front();
+            }
+
+            warm(*next);
+        }
+    }
+    void Audio::runReclaimer()
+    {
+        while (decoderRunning)
+        {
+            {
+                std::unique_lock lock(retiredMutex);
+                if (retired.empty())
+                {
+                    retiredCv.wait(lock, [this] { return !retired.empty() || !decoderRunning; });
+                }
+                else
+                {
+                    //* A fade only takes a few callbacks, so there is no point in checking more often
+                    retiredCv.wait_for(lock, 5ms);
+                }
+            }
+
+            reclaim(false);
+        }
+    }
+    void Audio::retire(std::shared_ptr<PlayingSound> sound)
+    {
+        sound->stopping = true;
+        {
+            std::lock_guard lock(retiredMutex);
+            retired.push_back({std::move(sound), std::chrono::steady_clock::now()});
+        }
+
+        retiredCv.notify_one();
+    }
+    void Audio::reclaim(bool force)
     {
-        static std::atomic<std::uint64_t> id = 0;
+        std::lock_guard reclaimLock(reclaimMutex);
+
+        std::vector<std::shared_ptr<PlayingSound>> silent;
+        {
+            std::lock_guard lock(retiredMutex);
+            auto now = std::chrono::steady_clock::now();
+
+            auto isSilent = [&](const RetiredSound &item) {
+                return force || now - item.since > fadeTimeout ||
+                       std::all_of(item.sound->outputs.begin(), item.sound->outputs.end(),
+                                   [](const auto &voice) { return voice->faded || !voice->mixer; });
+            };
+
+            for (auto it = retired.begin(); it != retired.end();)
+            {
+                if (isSilent(*it))
+                {
+                    silent.emplace_back(std::move(it->sound));
+                    it = retired.erase(it);
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
 
-        auto *decoder = new ma_decoder;
+        for (const auto &sound : silent)
+        {
+            release(*sound);
+        }
+    }
+    void Audio::preload(const std::vector<Objects::Sound> &sounds, bool urgent)
+    {
+        if (!Globals::gSettings.preloadSounds || sounds.empty())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard lock(preloadMutex);
+            for (const auto &sound : sounds)
+            {
+                auto queued = std::find_if(preloads.begin(), preloads.end(),
+                                           [&](const auto &item) { return item.id == sound.id; });
+                if (queued != preloads.end())
+                {
+                    if (!urgent)
+                    {
+                        continue;
+                    }
+                    preloads.erase(queued);
+                }
+
+                if (urgent)
+                {
+                    preloads.emplace_front(sound);
+                }
+                else
+                {
+                    preloads.emplace_back(sound);
+                }
+            }
+
+            while (preloads.size() > maxPreloads)
+            {
+                preloads.pop_back();
+            }
+        }
+
+        preloadCv.notify_one();
+    }
+    void Audio::warm(const Objects::Sound &sound)
+    {
+        //* The format is only known once an output was opened, the first play opens the default one anyway
+        if (getSampleRate() == 0)
+        {
+            getMixer(getDefaultPlayback());
+        }
+
+        std::uint32_t targetChannels = 0;
+        std::uint32_t targetSampleRate = 0;
+        {
+            auto scoped = mixers.scoped();
+            targetChannels = channels;
+            targetSampleRate = sampleRate;
+        }
+
+        if (targetChannels == 0 || targetSampleRate == 0)
+        {
+            return;
+        }
+
+        auto key = PcmCache::getKey(sound, targetChannels, targetSampleRate);
+        if (cache.contains(key))
+        {
+            return;
+        }
+
+        ma_decoder decoder;
+        std::shared_ptr<const MappedFile> mapping;
+        if (openDecoder(sound, &decoder, mapping, targetChannels, targetSampleRate) != MA_SUCCESS)
+        {
+            return;
+        }
+
+        auto length = getLength(sound, &decoder, targetSampleRate);
+        if (!cache.hasRoom(length, targetChannels))
+        {
+            ma_decoder_uninit(&decoder);
+            return;
+        }
+
+        auto entry = std::make_shared<PcmCache::Entry>();
+        entry->channels = targetChannels;
+        entry->sampleRate = targetSampleRate;
+        entry->frames.reserve(length * targetChannels);
+
+        constexpr ma_uint64 chunk = 4096;
+        while (decoderRunning)
+        {
+            auto offset = entry->frames.size();
+            entry->frames.resize(offset + chunk * targetChannels);
+
+            ma_uint64 readFrames{};
+            ma_data_source_read_pcm_frames(&decoder, entry->frames.data() + offset, chunk, &readFrames);
+            entry->frames.resize(offset + readFrames * targetChannels);
+
+            if (readFrames < chunk)
+            {
+                entry->length = entry->frames.size() / targetChannels;
+                break;
+            }
+        }
+
+        ma_decoder_uninit(&decoder);
+
+        if (entry->length > 0)
+        {
+            cache.insert(key, std::move(entry));
+        }
+    }
+    ma_result Audio::openDecoder(const Objects::Sound &sound, ma_decoder *decoder,
+                                 std::shared_ptr<const MappedFile> &mapping, std::uint32_t channels,
+                                 std::uint32_t sampleRate)
+    {
+        auto decoderConfig = ma_decoder_config_init(ma_format_f32, channels, sampleRate);
+        //* This is the only conversion a sound goes through, so it may as well be a good one
+        decoderConfig.resampling.algorithm = ma_resample_algorithm_linear;
+        decoderConfig.resampling.linear.lpfOrder = MA_MAX_FILTER_ORDER;
+        //* Overlapping plays of a sound share the mapping, the decoder reads straight from the page cache
+        mapping = mappings.get(sound.path);
+        ma_result res = MA_ERROR;
+
+        if (mapping)
+        {
+            res = ma_decoder_init_memory(mapping->getData(), mapping->getSize(), &decoderConfig, decoder);
+        }
+        if (res != MA_SUCCESS)
+        {
+            mapping.reset();
 #if defined(_WIN32)
-        auto res = ma_decoder_init_file_w(widen(sound.path).c_str(), nullptr, decoder);
+            res = ma_decoder_init_file_w(widen(sound.path).c_str(), &decoderConfig, decoder);
 #else
-        auto res = ma_decoder_init_file(sound.path.c_str(), nullptr, decoder);
+            res = ma_decoder_init_file(sound.path.c_str(), &decoderConfig, decoder);
 #endif
+        }
 
-        if (res != MA_SUCCESS)
+        return res;
+    }
+    std::uint64_t Audio::getLength(const Objects::Sound &sound, ma_decoder *decoder, std::uint32_t sampleRate)
+    {
+        ma_uint64 length{};
+        if (auto metadata = Globals::gMetadata.get(sound); metadata && metadata->sampleRate > 0)
         {
-            Fancy::fancy.logTime().failure() << "Failed to create decoder from file: " << sound.path << ", error: " >>
-                res << std::endl;
-            delete decoder;
+            length = ma_calculate_frame_count_after_resampling(sampleRate, metadata->sampleRate, metadata->length);
+        }
+        else
+        {
+            ma_decoder_get_length_in_pcm_frames(decoder, &length);
+        }
 
-            return std::nullopt;
+        return length;
+    }
+    void Audio::fill(PlayingSound &sound, std::vector<float> &buffer, std::uint32_t limit)
+    {
+        ma_data_source *source = sound.raw.decoder.load();
+        if (!source)
+        {
+            source = sound.raw.audioBuffer.load();
         }
 
-        auto *device = new ma_device;
-        auto config = ma_device_config_init(ma_device_type_playback);
+        if (!source || sound.outputs.empty())
+        {
+            return;
+        }
 
-        ma_uint64 length_in_pcm_frames{};
-        ma_decoder_get_length_in_pcm_frames(decoder, &length_in_pcm_frames);
+        //* While a flush is pending the mixers still own the buffered frames, so we must not write new ones
+        for (const auto &output : sound.outputs)
+        {
+            if (output->flush)
+            {
+                return;
+            }
+        }
 
-        config.dataCallback = data_callback;
-        config.periodSizeInMilliseconds = 100;
-        config.sampleRate = decoder->outputSampleRate;
-        config.playback.format = decoder->outputFormat;
-        config.playback.channels = decoder->outputChannels;
+        if (sound.shouldSeek)
+        {
+            auto seekTo = sound.seekTo.load();
+            ma_data_source_seek_to_pcm_frame(source, seekTo);
 
-        auto pSound = std::make_shared<PlayingSound>();
-        config.pUserData = reinterpret_cast<void *>(static_cast<PlayingSound *>(pSound.get()));
+            sound.capture.reset();
+            sound.seekedTo = seekTo;
+            sound.endOfStream = false;
+            sound.shouldSeek = false;
 
-        if (playbackDevice)
+            for (const auto &output : sound.outputs)
+            {
+                output->drained = false;
+                output->flush = true;
+            }
+
+            return;
+        }
+
+        if (sound.endOfStream)
         {
-            config.playback.pDeviceID = &playbackDevice->raw.id;
+            if (!sound.repeat)
+            {
+                return;
+            }
+
+            ma_data_source_seek_to_pcm_frame(source, 0);
+            sound.endOfStream = false;
         }
-        else
+
+        bool rewound = false;
+        while (true)
         {
-            config.playback.pDeviceID = &defaultPlayback.raw.id;
+            auto frames = std::min(static_cast<ma_uint32>(buffer.size() / channels), limit);
+            for (const auto &output : sound.outputs)
+            {
+                frames = std::min(frames, ma_pcm_rb_available_write(output->ringBuffer));
+            }
+
+            if (frames == 0)
+            {
+                break;
+            }
+
+            ma_uint64 readFrames{};
+            ma_data_source_read_pcm_frames(source, buffer.data(), frames, &readFrames);
+            limit -= static_cast<std::uint32_t>(readFrames);
+
+            if (sound.capture)
+            {
+                sound.capture->frames.insert(sound.capture->frames.end(), buffer.begin(),
+                                             buffer.begin() + static_cast<std::ptrdiff_t>(readFrames * channels));
+            }
+
+            for (const auto &output : sound.outputs)
+            {
+                auto *ringBuffer = output->ringBuffer.load();
+                auto remaining = static_cast<ma_uint32>(readFrames);
+
+                //* The ring buffer may hand out less than requested when it wraps around
+                while (remaining > 0)
+                {
+                    void *target{};
+                    auto chunk = remaining;
+
+                    if (ma_pcm_rb_acquire_write(ringBuffer, &chunk, &target) != MA_SUCCESS || chunk == 0)
+                    {
+                        break;
+                    }
+
+                    std::copy_n(buffer.data() + static_cast<std::size_t>(readFrames - remaining) * channels,
+                                static_cast<std::size_t>(chunk) * channels, reinterpret_cast<float *>(target));
+
+                    ma_pcm_rb_commit_write(ringBuffer, chunk);
+                    remaining -= chunk;
+                }
+            }
+
+            if (readFrames < frames)
+            {
+                if (sound.capture)
+                {
+                    sound.capture->length = sound.capture->frames.size() / sound.capture->channels;
+                    cache.insert(sound.cacheKey, std::move(sound.capture));
+                    sound.capture.reset();
+                }
+
+                if (sound.repeat && !(rewound && readFrames == 0))
+                {
+                    rewound = true;
+                    ma_data_source_seek_to_pcm_frame(source, 0);
+                    continue;
+                }
+
+                sound.endOfStream = true;
+                break;
+            }
+        }
+    }
+    void Audio::setCacheBudget(std::size_t budget)
+    {
+        cache.setBudget(budget);
+    }
+    std::uint32_t Audio::getSampleRate()
+    {
+        auto scoped = mixers.scoped();
+        return sampleRate;
+    }
+    std::shared_ptr<Mixer> Audio::getMixer(const AudioDevice &device)
+    {
+        auto scoped = mixers.scoped();
+        if (scoped->find(device.name) != scoped->end())
+        {
+            return scoped->at(device.name);
         }
 
-        if (ma_device_init(nullptr, &config, device) != MA_SUCCESS)
+        //* The first mixer decides the format, every other output is opened in the same format so that a sound
+        //* only has to be decoded once
+        auto mixer = std::make_shared<Mixer>();
+        if (!mixer->setup(&context, device, channels, sampleRate, Globals::gSettings.latencyProfile))
         {
-            Fancy::fancy.logTime().failure() << "Failed to create device" << std::endl;
-            ma_decoder_uninit(decoder);
-            delete decoder;
-            delete device;
+            return nullptr;
+        }
+
+        if (channels == 0 || sampleRate == 0)
+        {
+            channels = mixer->getChannels();
+            sampleRate = mixer->getSampleRate();
+
+            std::lock_guard lock(decoderMutex);
+            decodeBuffer.resize(static_cast<std::size_t>(4096) * channels);
+        }
+
+        scoped->emplace(device.name, mixer);
+        return mixer;
+    }
+    std::optional<PlayingSound> Audio::play(const Objects::Sound &sound,
+                                            const std::vector<Objects::AudioDevice> &remoteDevices)
+    {
+        auto localDevice = getDefaultPlayback();
 
+        std::vector<AudioDevice> outputDevices{localDevice};
+        for (const auto &device : remoteDevices)
+        {
+            if (device.name != localDevice.name)
+            {
+                outputDevices.emplace_back(device);
+            }
+        }
+
+        if (Globals::gSettings.restartOnRetrigger)
+        {
+            if (auto restarted = retrigger(sound, outputDevices); restarted)
+            {
+                return restarted;
+            }
+        }
+
+        std::vector<std::shared_ptr<PlayingSound>> stolen;
+        if (!makeRoom(stolen))
+        {
+            Fancy::fancy.logTime().warning() << "Not playing sound " << sound.path << ", already playing "
+                                             << Globals::gSettings.maxPolyphony << " sounds" << std::endl;
             return std::nullopt;
         }
 
-        if (playbackDevice)
+        auto rtn = start(sound, outputDevices);
+
+        //* Reported after the new sound started, so that stealing does not look like every sound finished
+        for (const auto &victim : stolen)
         {
-            if (sound.remoteVolume)
+            Globals::gGui->onSoundFinished(*victim);
+        }
+
+        return rtn;
+    }
+    std::optional<PlayingSound> Audio::retrigger(const Objects::Sound &sound,
+                                                 const std::vector<AudioDevice> &outputDevices)
+    {
+        for (const auto &playing : playingSounds.snapshot())
+        {
+            if (playing->sound.id != sound.id || playing->finished ||
+                !std::equal(playing->outputs.begin(), playing->outputs.end(), outputDevices.begin(),
+                            outputDevices.end(),
+                            [](const auto &voice, const auto &device) { return voice->device.name == device.name; }))
+            {
+                continue;
+            }
+
+            playing->seekTo = 0;
+            playing->shouldSeek = true;
+            playing->paused = false;
+            playing->started = ++playCount;
+            playing->trace = Tracer::current();
+            playing->traced = false;
+            wakeDecoder();
+
+            auto rtn = *playing;
+            rtn.readFrames = 0;
+            rtn.readInMs = 0;
+
+            return rtn;
+        }
+
+        return std::nullopt;
+    }
+    bool Audio::makeRoom(std::vector<std::shared_ptr<PlayingSound>> &stolen)
+    {
+        std::size_t limit = SoundRegistry::capacity;
+        if (Globals::gSettings.maxPolyphony > 0)
+        {
+            limit = std::min<std::size_t>(limit, Globals::gSettings.maxPolyphony);
+        }
+
+        auto sounds = playingSounds.snapshot();
+        if (limit > sounds.size())
+        {
+            return true;
+        }
+
+        auto policy = Globals::gSettings.voiceStealing;
+        if (policy == Enums::VoiceStealing::None)
+        {
+            return false;
+        }
+
+        //* Paused sounds are silent, so they are the quietest of all
+        auto loudness = [](const PlayingSound &sound) {
+            float rtn = 0;
+            if (!sound.paused)
+            {
+                for (const auto &output : sound.outputs)
+                {
+                    rtn = std::max(rtn, output->volume.load());
+                }
+            }
+            return rtn;
+        };
+
+        auto isBetterVictim = [&](const auto &first, const auto &second) {
+            if (policy == Enums::VoiceStealing::Quietest)
             {
-                device->masterVolumeFactor = static_cast<float>(*sound.remoteVolume) / 100.f;
+                auto firstLoudness = loudness(*first);
+                auto secondLoudness = loudness(*second);
+
+                if (firstLoudness != secondLoudness)
+                {
+                    return firstLoudness < secondLoudness;
+                }
+            }
+
+            return first->started < second->started;
+        };
+
+        while (sounds.size() >= limit)
+        {
+            auto victim = std::min_element(sounds.begin(), sounds.end(), isBetterVictim);
+            if (playingSounds.remove((*victim)->id))
+            {
+                retire(*victim);
+                stolen.emplace_back(*victim);
+            }
+
+            sounds.erase(victim);
+        }
+
+        return true;
+    }
+    std::optional<PlayingSound> Audio::start(const Objects::Sound &sound,
+                                             const std::vector<AudioDevice> &outputDevices)
+    {
+        auto pSound = std::make_shared<PlayingSound>();
+
+        for (const auto &device : outputDevices)
+        {
+            auto mixer = getMixer(device);
+            if (!mixer)
+            {
+                Fancy::fancy.logTime().failure()
+                    << "Failed to play sound " << sound.path << " on " << device.name << ", no mixer available"
+                    << std::endl;
+                release(*pSound);
+
+                return std::nullopt;
+            }
+
+            auto output = std::make_shared<Voice>();
+            output->device = device;
+            output->sound = pSound.get();
+            output->mixer = mixer.get();
+            output->isLocal = pSound->outputs.empty();
+
+            if (output->isLocal)
+            {
+                output->volume =
+                    static_cast<float>(sound.localVolume ? *sound.localVolume : Globals::gSettings.localVolume) /
+                    100.f;
             }
             else
             {
-                device->masterVolumeFactor = static_cast<float>(Globals::gSettings.remoteVolume) / 100.f;
+                output->volume =
+                    static_cast<float>(sound.remoteVolume ? *sound.remoteVolume : Globals::gSettings.remoteVolume) /
+                    100.f;
+            }
+
+            auto *ringBuffer = new ma_pcm_rb;
+            if (ma_pcm_rb_init(ma_format_f32, channels, sampleRate / 2, nullptr, nullptr, ringBuffer) != MA_SUCCESS)
+            {
+                Fancy::fancy.logTime().failure() << "Failed to create ring buffer for " << sound.path << std::endl;
+                delete ringBuffer;
+                release(*pSound);
+
+                return std::nullopt;
             }
+
+            output->ringBuffer = ringBuffer;
+            pSound->outputs.emplace_back(output);
         }
-        else
+
+        if (Globals::gSettings.normalizeLoudness)
         {
-            if (sound.localVolume)
+            if (auto metadata = Globals::gMetadata.get(sound); metadata && metadata->loudness)
             {
-                device->masterVolumeFactor = static_cast<float>(*sound.localVolume) / 100.f;
+                auto gain = std::min(static_cast<float>(Globals::gSettings.loudnessTarget) - *metadata->loudness,
+                                     peakCeiling - *metadata->truePeak);
+                pSound->normalization = std::pow(10.F, gain / 20.F);
+            }
+        }
+
+        pSound->cacheKey = PcmCache::getKey(sound, channels, sampleRate);
+
+        if (auto pcm = cache.get(pSound->cacheKey); pcm)
+        {
+            auto *audioBuffer = new ma_audio_buffer;
+            auto bufferConfig =
+                ma_audio_buffer_config_init(ma_format_f32, pcm->channels, pcm->length, pcm->frames.data(), nullptr);
+
+            if (ma_audio_buffer_init(&bufferConfig, audioBuffer) == MA_SUCCESS)
+            {
+                pSound->pcm = pcm;
+                pSound->length = pcm->length;
+                pSound->raw.audioBuffer = audioBuffer;
             }
             else
             {
-                device->masterVolumeFactor = static_cast<float>(Globals::gSettings.localVolume) / 100.f;
+                delete audioBuffer;
             }
         }
 
-        if (ma_device_start(device) != MA_SUCCESS)
+        if (!pSound->raw.audioBuffer)
         {
-            ma_device_uninit(device);
-            ma_decoder_uninit(decoder);
+            auto *decoder = new ma_decoder;
+            std::shared_ptr<const MappedFile> mapping;
 
-            delete device;
-            delete decoder;
+            if (auto res = openDecoder(sound, decoder, mapping, channels, sampleRate); res != MA_SUCCESS)
+            {
+                Fancy::fancy.logTime().failure()
+                    << "Failed to create decoder from file: " << sound.path << ", error: " >> res << std::endl;
+                delete decoder;
+                release(*pSound);
 
-            Fancy::fancy.logTime().warning() << "Failed to play sound " << sound.path << std::endl;
+                return std::nullopt;
+            }
 
-            return std::nullopt;
+            auto length_in_pcm_frames = getLength(sound, decoder, sampleRate);
+
+            pSound->raw.decoder = decoder;
+            pSound->mapping = std::move(mapping);
+            pSound->length = length_in_pcm_frames;
+
+            if (cache.fits(length_in_pcm_frames, channels))
+            {
+                pSound->capture = std::make_shared<PcmCache::Entry>();
+                pSound->capture->channels = channels;
+                pSound->capture->sampleRate = sampleRate;
+                pSound->capture->frames.reserve(length_in_pcm_frames * channels);
+            }
         }
 
-        auto soundId = ++id;
+        auto soundId = playingSounds.reserve();
+        if (soundId == 0)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to play sound " << sound.path << ", too many sounds are playing"
+                                             << std::endl;
+            release(*pSound);
+
+            return std::nullopt;
+        }
 
         pSound->id = soundId;
         pSound->sound = sound;
-        pSound->raw.device = device;
-        pSound->raw.decoder = decoder;
-        pSound->length = length_in_pcm_frames;
-        pSound->sampleRate = config.sampleRate;
-        pSound->playbackDevice = playbackDevice ? *playbackDevice : defaultPlayback;
+        pSound->started = ++playCount;
+        pSound->trace = Tracer::current();
+        Globals::gTracer.mark(pSound->trace, TracePoint::DecoderOpened);
+        pSound->sampleRate = sampleRate;
         pSound->lengthInMs = static_cast<std::uint64_t>(static_cast<double>(pSound->length) /
-                                                        static_cast<double>(config.sampleRate) * 1000);
+                                                        static_cast<double>(pSound->sampleRate) * 1000);
 
-        playingSounds->emplace(soundId, pSound);
-        return *pSound;
-    }
-    void Audio::stopAll()
-    {
-        auto scoped = playingSounds.scoped();
-        while (!scoped->empty())
+        //* Nobody else sees the sound before it is published, so it is primed without the lock of the decoder thread.
+        //* Only a few periods are decoded here, that is all the mixers need before the decoder thread catches up.
+        std::uint32_t period = 0;
+        for (const auto &output : pSound->outputs)
         {
-            auto &sound = scoped->begin()->second;
-            if (sound->raw.device && sound->raw.decoder)
+            if (auto latency = output->mixer.load()->getLatency(); latency.sampleRate > 0)
             {
-                ma_device_uninit(sound->raw.device);
-                ma_decoder_uninit(sound->raw.decoder);
+                auto frames = static_cast<std::uint64_t>(latency.periodSizeInFrames) * sampleRate / latency.sampleRate;
+                period = std::max(period, static_cast<std::uint32_t>(frames));
             }
+        }
+        if (period == 0)
+        {
+            period = sampleRate / 100;
+        }
+
+        std::vector<float> primeBuffer(static_cast<std::size_t>(period) * primedPeriods * channels);
+        fill(*pSound, primeBuffer, period * primedPeriods);
 
-            sound->raw.device = nullptr;
-            sound->raw.decoder = nullptr;
+        playingSounds.publish(soundId, pSound);
+        wakeDecoder();
 
-            scoped->erase(sound->id);
+        for (const auto &output : pSound->outputs)
+        {
+            if (!output->mixer.load()->add(output.get()))
+            {
+                Fancy::fancy.logTime().warning() << "Failed to play sound " << sound.path << std::endl;
+                if (playingSounds.remove(soundId))
+                {
+                    release(*pSound);
+                }
+
+                return std::nullopt;
+            }
         }
+
+        Globals::gTracer.mark(pSound->trace, TracePoint::VoicesAdded);
+        return *pSound;
     }
-    bool Audio::stop(const std::uint32_t &soundId)
+    void Audio::release(PlayingSound &sound)
     {
-        auto scoped = playingSounds.scoped();
-        if (scoped->find(soundId) != scoped->end())
+        for (const auto &output : sound.outputs)
         {
-            auto &sound = scoped->at(soundId);
-            if (sound->raw.device && sound->raw.decoder)
+            if (auto *mixer = output->mixer.exchange(nullptr); mixer)
             {
-                ma_device_uninit(sound->raw.device);
-                ma_decoder_uninit(sound->raw.decoder);
+                mixer->remove(output.get());
             }
+        }
 
-            sound->raw.device = nullptr;
-            sound->raw.decoder = nullptr;
+        std::lock_guard lock(decoderMutex);
+        if (auto *decoder = sound.raw.decoder.exchange(nullptr); decoder)
+        {
+            ma_decoder_uninit(decoder);
+            delete decoder;
+        }
+        if (auto *audioBuffer = sound.raw.audioBuffer.exchange(nullptr); audioBuffer)
+        {
+            ma_audio_buffer_uninit(audioBuffer);
+            delete audioBuffer;
+        }
+        for (const auto &output : sound.outputs)
+        {
+            if (auto *ringBuffer = output->ringBuffer.exchange(nullptr); ringBuffer)
+            {
+                ma_pcm_rb_uninit(ringBuffer);
+                delete ringBuffer;
+            }
+        }
 
-            scoped->erase(sound->id);
+        sound.pcm.reset();
+        sound.mapping.reset();
+        sound.capture.reset();
+    }
+    void Audio::stopAll()
+    {
+        for (const auto &sound : playingSounds.snapshot())
+        {
+            if (playingSounds.remove(sound->id))
+            {
+                retire(sound);
+            }
+        }
+    }
+    bool Audio::stop(const std::uint32_t &soundId)
+    {
+        if (auto sound = playingSounds.remove(soundId); sound)
+        {
+            retire(std::move(sound));
             return true;
         }
 
@@ -186,20 +892,10 @@ namespace Soundux::Objects
     }
     std::optional<PlayingSound> Audio::pause(const std::uint32_t &soundId)
     {
-        auto scoped = playingSounds.scoped();
-        if (scoped->find(soundId) != scoped->end())
+        if (auto sound = playingSounds.get(soundId); sound)
         {
-            auto &sound = scoped->at(soundId);
-
-            if (!sound->paused)
-            {
-                if (ma_device_get_state(sound->raw.device) == ma_device_state_started)
-                {
-                    ma_device_stop(sound->raw.device);
-                }
-                sound->paused = true;
-            }
 
+            sound->paused = true;
             return *sound;
         }
 
@@ -209,10 +905,8 @@ namespace Soundux::Objects
     }
     std::optional<PlayingSound> Audio::repeat(const std::uint32_t &soundId, bool shouldRepeat)
     {
-        auto scoped = playingSounds.scoped();
-        if (scoped->find(soundId) != scoped->end())
+        if (auto sound = playingSounds.get(soundId); sound)
         {
-            auto &sound = scoped->at(soundId);
             sound->repeat = shouldRepeat;
 
             return *sound;
@@ -224,20 +918,10 @@ namespace Soundux::Objects
     }
     std::optional<PlayingSound> Audio::resume(const std::uint32_t &soundId)
     {
-        auto scoped = playingSounds.scoped();
-        if (scoped->find(soundId) != scoped->end())
+        if (auto sound = playingSounds.get(soundId); sound)
         {
-            auto &sound = scoped->at(soundId);
-
-            if (sound->paused)
-            {
-                if (ma_device_get_state(sound->raw.device) == ma_device_state_stopped)
-                {
-                    ma_device_start(sound->raw.device);
-                }
-                sound->paused = false;
-            }
 
+            sound->paused = false;
             return *sound;
         }
 
@@ -245,19 +929,12 @@ namespace Soundux::Objects
                                          << std::endl;
         return std::nullopt;
     }
-    void Audio::onFinished(PlayingSound sound)
+    void Audio::onFinished(std::uint32_t soundId)
     {
-        auto scoped = playingSounds.scoped();
-        if (scoped->find(sound.id) != scoped->end())
+        if (auto sound = playingSounds.remove(soundId); sound)
         {
-            ma_device_uninit(sound.raw.device);
-            ma_decoder_uninit(sound.raw.decoder);
-
-            sound.raw.device = nullptr;
-            sound.raw.decoder = nullptr;
-
-            Globals::gGui->onSoundFinished(sound);
-            scoped->erase(sound.id);
+            Globals::gGui->onSoundFinished(*sound);
+            retire(std::move(sound));
         }
         else
         {
@@ -269,34 +946,37 @@ namespace Soundux::Objects
         sound->readFrames += frames;
         sound->buffer += frames;
 
+        if (sound->repeat && sound->length > 0 && sound->readFrames >= sound->length)
+        {
+            sound->readFrames %= sound->length;
+        }
+
         if (sound->buffer > (sound->sampleRate / 2))
         {
             sound->readInMs = static_cast<std::uint64_t>(
                 (static_cast<double>(sound->readFrames) / static_cast<double>(sound->length)) *
                 static_cast<double>(sound->lengthInMs));
 
-            Globals::gGui->onSoundProgressed(*sound);
+            progress.push({sound->id, sound->readInMs, sound->paused});
 
             sound->buffer = 0;
         }
     }
     void Audio::onSoundSeeked(PlayingSound *sound, std::uint64_t frame)
     {
-        sound->shouldSeek = false;
         sound->readFrames = frame;
         sound->readInMs = static_cast<std::uint64_t>((static_cast<double>(frame) / static_cast<double>(sound->length)) *
                                                      static_cast<double>(sound->lengthInMs));
     }
     std::optional<PlayingSound> Audio::seek(const std::uint32_t &soundId, std::uint64_t position)
     {
-        auto scoped = playingSounds.scoped();
-        if (scoped->find(soundId) != scoped->end())
+        if (auto sound = playingSounds.get(soundId); sound)
         {
-            auto &sound = scoped->at(soundId);
             sound->seekTo =
                 static_cast<std::uint64_t>((static_cast<double>(position) / static_cast<double>(sound->lengthInMs)) *
                                            static_cast<double>(sound->length));
             sound->shouldSeek = true;
+            wakeDecoder();
 
             auto rtn = *sound;
             rtn.readFrames = rtn.seekTo;
@@ -311,66 +991,79 @@ namespace Soundux::Objects
                                          << std::endl;
         return std::nullopt;
     }
-    void Audio::data_callback(ma_device *device, void *output, [[maybe_unused]] const void *input,
-                              std::uint32_t frameCount)
+    std::optional<PlayingSound> Audio::setLocalVolume(const std::uint32_t &soundId, float volume)
     {
-        auto *sound = reinterpret_cast<PlayingSound *>(device->pUserData);
-        if (!sound)
+        if (auto sound = playingSounds.get(soundId); sound)
         {
-            return;
-        }
-
-        if (!sound->raw.decoder)
-        {
-            return;
-        }
-
-        ma_uint64 readFrames{};
-        ma_decoder_read_pcm_frames(sound->raw.decoder, output, frameCount, &readFrames);
+            for (const auto &output : sound->outputs)
+            {
+                if (output->isLocal)
+                {
+                    output->volume = volume;
+                }
+            }
 
-        if (sound->shouldSeek)
-        {
-            ma_decoder_seek_to_pcm_frame(sound->raw.decoder, sound->seekTo);
-            Globals::gAudio.onSoundSeeked(sound, sound->seekTo);
-        }
-        if (sound->playbackDevice.isDefault && readFrames > 0)
-        {
-            Globals::gAudio.onSoundProgressed(sound, readFrames);
+            return *sound;
         }
 
-        if (readFrames <= 0)
+        Fancy::fancy.logTime().warning() << "Failed to set local volume for sound with id " << soundId
+                                         << ", sound does not exist" << std::endl;
+        return std::nullopt;
+    }
+    std::optional<PlayingSound> Audio::setRemoteVolume(const std::uint32_t &soundId, float volume)
+    {
+        if (auto sound = playingSounds.get(soundId); sound)
         {
-            if (sound->repeat)
-            {
-                ma_decoder_seek_to_pcm_frame(sound->raw.decoder, 0);
-                Globals::gAudio.onSoundSeeked(sound, 0);
-            }
-            else
+            for (const auto &output : sound->outputs)
             {
-                Globals::gQueue.push_unique(reinterpret_cast<std::uintptr_t>(device),
-                                            [sound = *sound] { Globals::gAudio.onFinished(sound); });
+                if (!output->isLocal)
+                {
+                    output->volume = volume;
+                }
             }
+
+            return *sound;
         }
+
+        Fancy::fancy.logTime().warning() << "Failed to set remote volume for sound with id " << soundId
+                                         << ", sound does not exist" << std::endl;
+        return std::nullopt;
     }
-    std::vector<AudioDevice> Audio::getAudioDevices()
+    void Audio::invalidateDevices()
     {
-        std::string defaultName;
+        auto generation = ++deviceGeneration;
+        if (refreshQueued.exchange(true))
         {
-            ma_device device;
-            ma_device_config deviceConfig = ma_device_config_init(ma_device_type_playback);
-            ma_device_init(nullptr, &deviceConfig, &device);
-
-            defaultName = device.playback.name;
-
-            ma_device_uninit(&device);
+            //* The refresh that is queued or running notices the new generation
+            return;
         }
 
-        ma_context context;
+        //* A refresh that is about to return may still hold its key, so every refresh gets its own
+        Globals::gQueue.push_unique(reinterpret_cast<std::uintptr_t>(&devices) + generation, [this] {
+            while (true)
+            {
+                auto refreshed = deviceGeneration.load();
+                refreshDevices();
+
+                if (refreshed != deviceGeneration)
+                {
+                    continue;
+                }
 
-        if (ma_context_init(nullptr, 0, nullptr, &context) != MA_SUCCESS)
+                refreshQueued = false;
+                //* Invalidations between the check and clearing the flag did not queue another refresh
+                if (refreshed == deviceGeneration || refreshQueued.exchange(true))
+                {
+                    break;
+                }
+            }
+        });
+    }
+    void Audio::refreshDevices()
+    {
+        if (!contextInitialized)
         {
-            Fancy::fancy.logTime().failure() << "Failed to initialize context" << std::endl;
-            return {};
+            return;
         }
 
         ma_device_info *pPlayBackDeviceInfos{};
@@ -380,7 +1073,7 @@ namespace Soundux::Objects
         if (result != MA_SUCCESS)
         {
             Fancy::fancy.logTime().failure() << "Failed to get playback devices!" << std::endl;
-            return {};
+            return;
         }
 
         std::vector<AudioDevice> playBackDevices;
@@ -391,12 +1084,18 @@ namespace Soundux::Objects
             AudioDevice device;
             device.raw = rawDevice;
             device.name = rawDevice.name;
-            device.isDefault = rawDevice.name == defaultName;
+            device.isDefault = rawDevice.isDefault;
 
             playBackDevices.emplace_back(device);
         }
 
-        ma_context_uninit(&context);
+        if (!playBackDevices.empty() &&
+            std::none_of(playBackDevices.begin(), playBackDevices.end(), [](const auto &d) { return d.isDefault; }))
+        {
+            Fancy::fancy.logTime().warning() << "No default playback device reported, using "
+                                             << playBackDevices.front().name << std::endl;
+            playBackDevices.front().isDefault = true;
+        }
 
         for (auto it = playBackDevices.begin(); it != playBackDevices.end(); it++)
         {
@@ -409,12 +1108,97 @@ namespace Soundux::Objects
             }
         }
 
-        return playBackDevices;
+        {
+            auto scoped = devices.scoped();
+            *scoped = playBackDevices;
+
+            defaultPlayback = {};
+#if defined(__linux__)
+            nullSink = std::nullopt;
+#endif
+            for (const auto &device : playBackDevices)
+            {
+                if (device.isDefault)
+                {
+                    defaultPlayback = device;
+                }
+#if defined(__linux__)
+                if (device.name == "soundux_sink")
+                {
+                    nullSink = device;
+                }
+#endif
+            }
+        }
+
+        //* Sounds on an output that disappeared would never finish, so we stop them and drop the mixer
+        std::vector<std::string> vanished;
+        for (const auto &[name, mixer] : mixers.copy())
+        {
+            if (std::none_of(playBackDevices.begin(), playBackDevices.end(),
+                             [&name = name](const auto &d) { return d.name == name; }))
+            {
+                vanished.emplace_back(name);
+            }
+        }
+
+        for (const auto &sound : playingSounds.snapshot())
+        {
+            for (const auto &voice : sound->outputs)
+            {
+                if (std::find(vanished.begin(), vanished.end(), voice->device.name) != vanished.end())
+                {
+                    if (playingSounds.remove(sound->id))
+                    {
+                        release(*sound);
+                        Globals::gGui->onSoundFinished(*sound);
+                    }
+                    break;
+                }
+            }
+        }
+
+        //* Stopped sounds may still be fading out on one of the mixers that are about to be destroyed
+        if (!vanished.empty())
+        {
+            reclaim(true);
+        }
+
+        for (const auto &name : vanished)
+        {
+            Fancy::fancy.logTime().message() << "Output " << name << " disappeared" << std::endl;
+            mixers->erase(name);
+        }
+
+        getMixer(getDefaultPlayback());
+#if defined(__linux__)
+        if (auto sink = getNullSink(); sink)
+        {
+            getMixer(*sink);
+        }
+#endif
+    }
+    std::vector<AudioDevice> Audio::getAudioDevices()
+    {
+        return devices.copy();
+    }
+    AudioDevice Audio::getDefaultPlayback()
+    {
+        auto scoped = devices.scoped();
+        return defaultPlayback;
+    }
+#if defined(__linux__)
+    std::optional<AudioDevice> Audio::getNullSink()
+    {
+        auto scoped = devices.scoped();
+        return nullSink;
     }
+#endif
 #if defined(_WIN32)
     std::optional<AudioDevice> Audio::getAudioDevice(const std::string &name)
     {
-        for (const auto &device : getAudioDevices())
+        auto scoped = devices.scoped();
+        for (const auto &device : *scoped)
         {
             if (device.name == name)
             {
@@ -424,18 +1208,53 @@ namespace Soundux::Objects
         return std::nullopt;
     }
 #endif
-    std::vector<PlayingSound> Audio::getPlayingSounds()
+    std::vector<OutputLatency> Audio::getLatencies()
+    {
+        auto scoped = mixers.scoped();
+
+        std::vector<OutputLatency> rtn;
+        for (const auto &[name, mixer] : *scoped)
+        {
+            rtn.emplace_back(mixer->getLatency());
+        }
+
+        return rtn;
+    }
+    std::vector<MixerHealth> Audio::getHealth()
     {
-        auto scoped = playingSounds.scoped();
+        auto scoped = mixers.scoped();
+
+        std::vector<MixerHealth> rtn;
+        for (const auto &[name, mixer] : *scoped)
+        {
+            rtn.emplace_back(mixer->getHealth());
+        }
 
+        return rtn;
+    }
+    std::vector<PlayingSound> Audio::getPlayingSounds()
+    {
         std::vector<PlayingSound> rtn;
-        for (const auto &sound : *scoped)
+        for (const auto &sound : playingSounds.snapshot())
         {
-            rtn.emplace_back(*sound.second);
+            rtn.emplace_back(*sound);
         }
 
         return rtn;
     }
+    std::optional<PlayingSound> Audio::getPlayingSound(std::uint32_t soundId)
+    {
+        if (auto sound = playingSounds.get(soundId); sound)
+        {
+            return *sound;
+        }
+
+        return std::nullopt;
+    }
+    std::size_t Audio::getPlayingCount()
+    {
+        return playingSounds.count();
+    }
     PlayingSound::PlayingSound(const PlayingSound &other)
     {
         if (&other == this)
@@ -447,6 +1266,7 @@ namespace Soundux::Objects
         lengthInMs = other.lengthInMs;
         readFrames = other.readFrames;
         sampleRate = other.sampleRate;
+        normalization = other.normalization;
 
         id = other.id;
         sound = other.sound;
@@ -457,10 +1277,20 @@ namespace Soundux::Objects
         repeat.store(other.repeat);
         readInMs.store(other.readInMs);
         shouldSeek.store(other.shouldSeek);
+        seekedTo.store(other.seekedTo);
+        endOfStream.store(other.endOfStream);
+        started.store(other.started);
+        stopping.store(other.stopping);
+        trace.store(other.trace);
+        traced.store(other.traced);
 
-        raw.device.store(other.raw.device);
         raw.decoder.store(other.raw.decoder);
-        playbackDevice = other.playbackDevice;
+        raw.audioBuffer.store(other.raw.audioBuffer);
+
+        outputs = other.outputs;
+        pcm = other.pcm;
+        mapping = other.mapping;
+        cacheKey = other.cacheKey;
     }
     PlayingSound &PlayingSound::operator=(const PlayingSound &other)
     {
@@ -473,6 +1303,7 @@ namespace Soundux::Objects
         lengthInMs = other.lengthInMs;
         readFrames = other.readFrames;
         sampleRate = other.sampleRate;
+        normalization = other.normalization;
 
         id = other.id;
         sound = other.sound;
@@ -483,10 +1314,20 @@ namespace Soundux::Objects
         repeat.store(other.repeat);
         readInMs.store(other.readInMs);
         shouldSeek.store(other.shouldSeek);
+        seekedTo.store(other.seekedTo);
+        endOfStream.store(other.endOfStream);
+        started.store(other.started);
+        stopping.store(other.stopping);
+        trace.store(other.trace);
+        traced.store(other.traced);
 
-        raw.device.store(other.raw.device);
         raw.decoder.store(other.raw.decoder);
-        playbackDevice = other.playbackDevice;
+        raw.audioBuffer.store(other.raw.audioBuffer);
+
+        outputs = other.outputs;
+        pcm = other.pcm;
+        mapping = other.mapping;
+        cacheKey = other.cacheKey;
 
         return *this;
     }
@@ -1,14 +1,25 @@
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <core/objects/objects.hpp>
 #include <cstdint>
+#include <deque>
+#include <helper/audio/cache/cache.hpp>
+#include <helper/audio/mapping/mapping.hpp>
+#include <helper/audio/mixer/mixer.hpp>
+#include <helper/audio/registry/registry.hpp>
+#include <helper/queue/bounded.hpp>
+#include <limits>
 #include <map>
 #include <memory>
 #include <miniaudio.h>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <var_guard.hpp>
+#include <vector>
 
 namespace Soundux
 {
@@ -20,20 +31,53 @@ namespace Soundux
             std::string name;
             bool isDefault;
         };
+        struct PlayingSound;
+
+        //* A sound on one output, every output gets its own ring buffer since the devices are driven by different clocks
+        struct Voice
+        {
+            AudioDevice device;
+            bool isLocal = false;
+            PlayingSound *sound = nullptr;
+
+            std::atomic<Mixer *> mixer = nullptr;
+            std::atomic<ma_pcm_rb *> ringBuffer = nullptr;
+
+            std::atomic<float> volume = 1.f;
+            //* Only touched by the mixer, the gain at the end of the last block. It ramps towards `volume` over one
+            //* block so that volume changes do not click.
+            float gain = 1.f;
+            //* Only touched by the mixer, fades the voice out when it is stopped and around seeks
+            float envelope = 1.f;
+            std::atomic<bool> flush = false;
+            std::atomic<bool> drained = false;
+            //* Set by the mixer once a stopped voice faded out, it is not read from again
+            std::atomic<bool> faded = false;
+        };
         struct PlayingSound
         {
-            AudioDevice playbackDevice;
+            std::vector<std::shared_ptr<Voice>> outputs;
 
             struct
             {
-                std::atomic<ma_device *> device;
                 std::atomic<ma_decoder *> decoder;
+                std::atomic<ma_audio_buffer *> audioBuffer;
             } raw;
 
+            //* Set when playing from the cache, keeps the frames `raw.audioBuffer` points to alive
+            std::shared_ptr<const PcmCache::Entry> pcm;
+            //* Keeps the file `raw.decoder` reads from mapped, unset if it reads the file itself
+            std::shared_ptr<const MappedFile> mapping;
+            //* Only touched by the decoder thread, collects the decoded frames of a cacheable clip
+            std::shared_ptr<PcmCache::Entry> capture;
+            std::string cacheKey;
+
             std::uint64_t length = 0;
             std::uint64_t lengthInMs = 0;
             std::uint64_t readFrames = 0;
             std::uint64_t sampleRate = 0;
+            //* Brings the sound to `Settings::loudnessTarget`, applied by the mixers on top of the volume of a voice
+            float normalization = 1.f;
 
             std::atomic<bool> paused = false;
             std::atomic<bool> repeat = false;
@@ -41,6 +85,19 @@ namespace Soundux
             std::atomic<std::uint64_t> seekTo = 0;
             std::atomic<std::uint64_t> readInMs = 0;
 
+            //* Handshake between the decoder thread (producer) and the mixers (consumers)
+            std::atomic<bool> endOfStream = false;
+            std::atomic<std::uint64_t> seekedTo = 0;
+            //* Set by the first mixer that notices every output drained, so the finish is only reported once
+            std::atomic<bool> finished = false;
+            //* Set when the sound was stopped, its voices fade out and it is released once all of them are silent
+            std::atomic<bool> stopping = false;
+            //* Increases with every play and retrigger, the oldest sound has the lowest value
+            std::atomic<std::uint64_t> started = 0;
+            //* The trace of the trigger that started the sound, `traced` is set once its first frames were mixed
+            std::atomic<std::uint64_t> trace = 0;
+            std::atomic<bool> traced = false;
+
             Sound sound;
             std::uint32_t id;
             std::uint64_t buffer = 0;
@@ -49,25 +106,135 @@ namespace Soundux
             PlayingSound(const PlayingSound &);
             PlayingSound &operator=(const PlayingSound &other);
         };
+        //* Emitted from the audio callback, has to stay trivially copyable
+        struct SoundProgress
+        {
+            std::uint32_t id;
+            std::uint64_t readInMs;
+            bool paused;
+        };
         class Audio
         {
-            sxl::var_guard<std::map<std::uint32_t, std::shared_ptr<PlayingSound>>, std::recursive_mutex> playingSounds;
+            friend class Mixer;
 
-            void onFinished(PlayingSound);
+          public:
+            //* Sounds waiting to be preloaded, once full the least urgent ones are dropped
+            static constexpr std::size_t maxPreloads = 256;
+            //* Normalization never raises the true peak of a sound above this (in dBTP)
+            static constexpr float peakCeiling = -1.5F;
+            //* A stopped sound is released after this even if a mixer never finished fading it out
+            static constexpr std::chrono::milliseconds fadeTimeout{250};
+            //* A new sound only gets this many periods of its outputs decoded before it starts, the decoder thread
+            //* fills the rest of its ring buffers
+            static constexpr std::uint32_t primedPeriods = 3;
+
+          private:
+            struct RetiredSound
+            {
+                std::shared_ptr<PlayingSound> sound;
+                std::chrono::steady_clock::time_point since;
+            };
+
+            ma_context context;
+            bool contextInitialized = false;
+
+            sxl::var_guard<std::vector<AudioDevice>, std::recursive_mutex> devices;
+#if defined(__linux__)
+            std::optional<AudioDevice> nullSink;
+#endif
+            AudioDevice defaultPlayback;
+            //* Bumped by `invalidateDevices`, a refresh is repeated if it changed while the refresh ran
+            std::atomic<std::uint64_t> deviceGeneration = 0;
+            //* Set while a refresh is queued or running, there is never more than one
+            std::atomic<bool> refreshQueued = false;
+
+            sxl::var_guard<std::map<std::string, std::shared_ptr<Mixer>>, std::recursive_mutex> mixers;
+            SoundRegistry playingSounds;
+
+            std::mutex decoderMutex;
+            std::thread decoderThread;
+            std::mutex decoderWakeMutex;
+            std::condition_variable decoderCv;
+            //* Guarded by `decoderWakeMutex`, so that a wake up while the decoder is busy is not lost
+            bool decoderWoken = false;
+            std::atomic<bool> decoderRunning = false;
+
+            std::thread preloadThread;
+            std::mutex preloadMutex;
+            std::condition_variable preloadCv;
+            std::deque<Objects::Sound> preloads;
+
+            std::thread reclaimThread;
+            std::mutex retiredMutex;
+            std::condition_variable retiredCv;
+            std::vector<RetiredSound> retired;
+            //* Held while retired sounds are released, so that no mixer is destroyed underneath the reclaimer
+            std::mutex reclaimMutex;
+
+            std::thread progressThread;
+            BoundedQueue<SoundProgress, 256> progress;
+
+            PcmCache cache;
+            FileMappings mappings;
+            std::vector<float> decodeBuffer;
+
+            std::uint32_t channels = 0;
+            std::uint32_t sampleRate = 0;
+            std::atomic<std::uint64_t> playCount = 0;
+
+            void decode();
+            void reportProgress();
+            void runPreloads();
+            void runReclaimer();
+            //* Decodes the whole sound into the cache, as long as that does not evict anything
+            void warm(const Objects::Sound &);
+            ma_result openDecoder(const Objects::Sound &, ma_decoder *, std::shared_ptr<const MappedFile> &mapping,
+                                  std::uint32_t channels, std::uint32_t sampleRate);
+            std::uint64_t getLength(const Objects::Sound &, ma_decoder *, std::uint32_t sampleRate);
+            void wakeDecoder();
+            //* Decodes at most `limit` frames into the ring buffers of the sound, using `buffer` as scratch space
+            void fill(PlayingSound &, std::vector<float> &buffer,
+                      std::uint32_t limit = std::numeric_limits<std::uint32_t>::max());
+            void release(PlayingSound &);
+            //* Hands a sound that was removed from `playingSounds` to the reclaimer, its voices start fading out
+            void retire(std::shared_ptr<PlayingSound>);
+            //* Releases the retired sounds that are silent, or every retired sound if `force` is set
+            void reclaim(bool force);
+            void refreshDevices();
+            std::shared_ptr<Mixer> getMixer(const AudioDevice &);
+
+            std::optional<PlayingSound> start(const Objects::Sound &, const std::vector<AudioDevice> &);
+            //* Seeks a sound that is already playing on the same outputs back to the start
+            std::optional<PlayingSound> retrigger(const Objects::Sound &, const std::vector<AudioDevice> &);
+            //* Stops sounds until a new one fits into `Settings::maxPolyphony`, returns false if it may not be stolen
+            bool makeRoom(std::vector<std::shared_ptr<PlayingSound>> &stolen);
+
+            void onFinished(std::uint32_t);
             void onSoundSeeked(PlayingSound *, std::uint64_t);
             void onSoundProgressed(PlayingSound *, std::uint64_t);
 
-            static void data_callback(ma_device *device, void *output, const void *input, std::uint32_t frameCount);
-
           public:
             std::optional<PlayingSound> pause(const std::uint32_t &);
             std::optional<PlayingSound> resume(const std::uint32_t &);
             std::optional<PlayingSound> repeat(const std::uint32_t &, bool);
             std::optional<PlayingSound> seek(const std::uint32_t &, std::uint64_t);
-            std::optional<PlayingSound> play(const Objects::Sound &, const std::optional<AudioDevice> & = std::nullopt);
+            std::optional<PlayingSound> setLocalVolume(const std::uint32_t &, float);
+            std::optional<PlayingSound> setRemoteVolume(const std::uint32_t &, float);
+            //* Decodes the sound once and plays it on the default device as well as on every remote device. Once
+            //* `Settings::maxPolyphony` sounds are playing another one is stopped first.
+            std::optional<PlayingSound> play(const Objects::Sound &, const std::vector<AudioDevice> & = {});
 
+            //* Returns the cached device list, it is refreshed in the background once `invalidateDevices` is called
             std::vector<AudioDevice> getAudioDevices();
+            AudioDevice getDefaultPlayback();
+#if defined(__linux__)
+            std::optional<AudioDevice> getNullSink();
+#endif
+            std::vector<OutputLatency> getLatencies();
+            std::vector<MixerHealth> getHealth();
             std::vector<Objects::PlayingSound> getPlayingSounds();
+            std::optional<Objects::PlayingSound> getPlayingSound(std::uint32_t);
+            std::size_t getPlayingCount();
 
 #if defined(_WIN32)
             std::optional<AudioDevice> getAudioDevice(const std::string &);
@@ -76,13 +243,18 @@ namespace Soundux
             void setup();
             void destroy();
 
+            void setCacheBudget(std::size_t);
+            //* Decodes the sounds into the cache on a low priority thread, `urgent` ones are decoded before the others
+            void preload(const std::vector<Objects::Sound> &, bool urgent = false);
+            //* Sample rate every sound is decoded to, 0 until the first output was opened
+            std::uint32_t getSampleRate();
+
+            //* Only fade the sounds out and return right away, they are released in the background
             void stopAll();
             bool stop(const std::uint32_t &);
 
-#if defined(__linux__)
-            std::optional<AudioDevice> nullSink;
-#endif
-            AudioDevice defaultPlayback;
+            //* Called by the audio backends whenever an output was added, removed or the default output changed
+            void invalidateDevices();
         };
     } // namespace Objects
 } // namespace Soundux
\ No newline at end of file
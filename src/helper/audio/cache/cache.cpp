@@ -0,0 +1,78 @@
+#include "cache.hpp"
+#include <core/objects/objects.hpp>
+
+namespace Soundux::Objects
+{
+    std::string PcmCache::getKey(const Sound &sound, std::uint32_t channels, std::uint32_t sampleRate)
+    {
+        return sound.path.get() + ":" + std::to_string(sound.modifiedDate) + ":" + std::to_string(channels) + ":" +
+               std::to_string(sampleRate);
+    }
+    bool PcmCache::fits(std::uint64_t length, std::uint32_t channels)
+    {
+        std::lock_guard lock(mutex);
+        //* Only short clips are worth keeping, a single entry may use at most a quarter of the budget
+        return length > 0 && length * channels * sizeof(float) <= budget / 4;
+    }
+    bool PcmCache::hasRoom(std::uint64_t length, std::uint32_t channels)
+    {
+        std::lock_guard lock(mutex);
+        auto bytes = length * channels * sizeof(float);
+        return length > 0 && bytes <= budget / 4 && size + bytes <= budget;
+    }
+    bool PcmCache::contains(const std::string &key)
+    {
+        std::lock_guard lock(mutex);
+        return index.find(key) != index.end();
+    }
+    std::shared_ptr<const PcmCache::Entry> PcmCache::get(const std::string &key)
+    {
+        std::lock_guard lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end())
+        {
+            return nullptr;
+        }
+
+        items.splice(items.begin(), items, it->second);
+        return it->second->second;
+    }
+    void PcmCache::insert(const std::string &key, std::shared_ptr<const Entry> entry)
+    {
+        std::lock_guard lock(mutex);
+        if (index.find(key) != index.end())
+        {
+            return;
+        }
+
+        size += entry->frames.size() * sizeof(float);
+        items.emplace_front(key, std::move(entry));
+        index.emplace(key, items.begin());
+
+        evict();
+    }
+    void PcmCache::evict()
+    {
+        while (size > budget && !items.empty())
+        {
+            auto &last = items.back();
+
+            size -= last.second->frames.size() * sizeof(float);
+            index.erase(last.first);
+            items.pop_back();
+        }
+    }
+    void PcmCache::setBudget(std::size_t newBudget)
+    {
+        std::lock_guard lock(mutex);
+        budget = newBudget;
+        evict();
+    }
+    void PcmCache::clear()
+    {
+        std::lock_guard lock(mutex);
+        index.clear();
+        items.clear();
+        size = 0;
+    }
+} // namespace Soundux::Objects
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        struct Sound;
+
+        //* Fully decoded clips (f32, in the format of the mixer they were decoded for), evicted least-recently-used
+        class PcmCache
+        {
+          public:
+            struct Entry
+            {
+                std::vector<float> frames;
+                std::uint32_t channels = 0;
+                std::uint32_t sampleRate = 0;
+                std::uint64_t length = 0;
+            };
+
+          private:
+            using Item = std::pair<std::string, std::shared_ptr<const Entry>>;
+
+            std::mutex mutex;
+            std::list<Item> items;
+            std::unordered_map<std::string, std::list<Item>::iterator> index;
+
+            std::size_t size = 0;
+            std::size_t budget = 0;
+
+            void evict();
+
+          public:
+            static std::string getKey(const Sound &, std::uint32_t channels, std::uint32_t sampleRate);
+
+            bool fits(std::uint64_t length, std::uint32_t channels);
+            //* Same as `fits`, but also requires the clip to fit into the budget without evicting anything
+            bool hasRoom(std::uint64_t length, std::uint32_t channels);
+            //* Unlike `get` this does not count as a use
+            bool contains(const std::string &);
+            std::shared_ptr<const Entry> get(const std::string &);
+            void insert(const std::string &, std::shared_ptr<const Entry>);
+
+            void setBudget(std::size_t);
+            void clear();
+        };
+    } // namespace Objects
+} // namespace Soundux
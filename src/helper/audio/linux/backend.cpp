@@ -25,6 +25,9 @@ namespace Soundux::Objects
                     {
                         return instance;
                     }
+
+                    //* Unloads whatever modules were loaded before the failure
+                    pulseInstance->destroy();
                 }
                 else
                 {
@@ -36,6 +39,7 @@ namespace Soundux::Objects
             {
                 backend = Enums::BackendType::PipeWire;
                 Globals::gSettings.audioBackend = backend;
+                Globals::gConfigSaver.onSettingsChanged(Globals::gSettings);
             }
         }
 
@@ -50,7 +54,21 @@ namespace Soundux::Objects
 
         Fancy::fancy.logTime().failure() << "Failed to create AudioBackend instance" << std::endl;
         Globals::gSettings.audioBackend = Enums::BackendType::None;
+        Globals::gConfigSaver.onSettingsChanged(Globals::gSettings);
         return nullptr;
     }
+    void AudioBackend::setAppsChangedCallback(AppsChanged callback)
+    {
+        std::lock_guard lock(appsChangedMutex);
+        appsChanged = std::move(callback);
+    }
+    void AudioBackend::onAppsChanged(Enums::AppType type)
+    {
+        std::lock_guard lock(appsChangedMutex);
+        if (appsChanged)
+        {
+            appsChanged(type);
+        }
+    }
 } // namespace Soundux::Objects
 #endif
\ No newline at end of file
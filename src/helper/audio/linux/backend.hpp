@@ -1,7 +1,10 @@
 #pragma once
 #if defined(__linux__)
 #include <core/enums/enums.hpp>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -14,6 +17,7 @@ namespace Soundux
         {
             std::string name;
             std::string application;
+            std::uint32_t pid = 0;
 
             virtual ~RecordingApp() = default;
         };
@@ -21,18 +25,32 @@ namespace Soundux
         {
             std::string name;
             std::string application;
+            std::uint32_t pid = 0;
 
             virtual ~PlaybackApp() = default;
         };
 
         class AudioBackend
         {
+          public:
+            using AppsChanged = std::function<void(Enums::AppType)>;
+
+          private:
+            std::mutex appsChangedMutex;
+            AppsChanged appsChanged;
+
           protected:
             virtual bool setup() = 0;
             AudioBackend() = default;
 
+            //* Has to be called by the backends whenever an app came, went or changed its name
+            void onAppsChanged(Enums::AppType);
+
           public:
+            virtual ~AudioBackend() = default;
             static std::shared_ptr<AudioBackend> createInstance(Enums::BackendType);
+            //* The callback is called from the thread of the backend and must not call back into it
+            void setAppsChangedCallback(AppsChanged);
 
           public:
             virtual void destroy() = 0;
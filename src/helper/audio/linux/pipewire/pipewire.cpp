@@ -1,119 +1,270 @@
 #if defined(__linux__)
 #include "pipewire.hpp"
 #include "forward.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <core/global/globals.hpp>
 #include <fancy.hpp>
+#include <iterator>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <stdexcept>
+#include <tuple>
 
 namespace Soundux::Objects
 {
+    //* The loop lock is recursive, so public functions can call each other
+    class LoopLock
+    {
+        pw_thread_loop *loop;
+
+      public:
+        explicit LoopLock(pw_thread_loop *loop) : loop(loop)
+        {
+            PipeWireApi::thread_loop_lock(loop);
+        }
+        ~LoopLock()
+        {
+            PipeWireApi::thread_loop_unlock(loop);
+        }
+        LoopLock(const LoopLock &) = delete;
+        LoopLock &operator=(const LoopLock &) = delete;
+    };
+
+    const pw_node_events PipeWire::nodeEvents = [] {
+        pw_node_events events = {};
+        events.version = PW_VERSION_NODE_EVENTS;
+        events.info = [](void *data, const pw_node_info *info) {
+            reinterpret_cast<PipeWire *>(data)->onNodeInfo(info);
+        };
+        return events;
+    }();
+    const pw_port_events PipeWire::portEvents = [] {
+        pw_port_events events = {};
+        events.version = PW_VERSION_PORT_EVENTS;
+        events.info = [](void *data, const pw_port_info *info) {
+            reinterpret_cast<PipeWire *>(data)->onPortInfo(info);
+        };
+        return events;
+    }();
+    const pw_metadata_events PipeWire::metadataEvents = [] {
+        pw_metadata_events events = {};
+        events.version = PW_VERSION_METADATA_EVENTS;
+        events.property = [](void *data, [[maybe_unused]] std::uint32_t id, const char *key,
+                             [[maybe_unused]] const char *type, const char *value) -> int {
+            reinterpret_cast<PipeWire *>(data)->onMetadataProperty(key, value);
+            return 0;
+        };
+        return events;
+    }();
+
     void PipeWire::sync()
     {
-        spa_hook coreListener;
-        int pending = 0;
+        auto ticket = ++syncsIssued;
+        pw_core_sync(core, PW_ID_CORE, 0); // NOLINT
+
+        //* Round trips are answered in order, so counting them is enough
+        while (connected && ticket > syncsDone)
+        {
+            PipeWireApi::thread_loop_wait(loop);
+        }
+    }
+    void PipeWire::commit()
+    {
+        if (pendingObjects.empty())
+        {
+            return;
+        }
 
-        pw_core_events coreEvents = {};
-        coreEvents.version = PW_VERSION_CORE_EVENTS;
-        coreEvents.done = [](void *data, uint32_t id, int seq) {
-            auto *info = reinterpret_cast<std::pair<PipeWire *, int *> *>(data);
-            if (info)
+        sync();
+
+        for (auto &pending : pendingObjects)
+        {
+            spa_hook_remove(&pending->listener);
+            if (!pending->settled)
             {
-                if (id == PW_ID_CORE && seq == *info->second)
-                {
-                    *info->second = -1;
-                    PipeWireApi::main_loop_quit(info->first->loop);
-                }
+                pending->id.set_value(std::nullopt);
             }
-        };
-        coreEvents.error = [](void *data, std::uint32_t id, int seq, int res, const char *message) {
-            auto *info = reinterpret_cast<std::pair<PipeWire *, int *> *>(data);
-            if (info)
+        }
+        pendingObjects.clear();
+    }
+
+    void PipeWire::onNodeInfo(const pw_node_info *info)
+    {
+        if (!info || !info->props)
+        {
+            return;
+        }
+
+        auto node = nodes.find(info->id);
+        if (node == nodes.end())
+        {
+            return;
+        }
+
+        auto &self = node->second;
+        auto previous = std::make_tuple(self.name, self.applicationBinary, self.pid, self.isMonitor);
+
+        if (const auto *pid = spa_dict_lookup(info->props, "application.process.id"); pid)
+        {
+            auto previous = self.pid;
+            self.pid = std::stol(pid);
+
+            //* So that the icon is already there once the output picker is opened
+            if (Globals::gIcons && self.pid != previous)
             {
-                if (id == PW_ID_CORE && seq == *info->second)
-                {
-                    Fancy::fancy.logTime()
-                        << "Core Failure - Seq " << seq << " - Res " << res << ": " << message << std::endl;
+                Globals::gIcons->prefetch(static_cast<int>(self.pid));
+            }
+        }
+        if (const auto *monitor = spa_dict_lookup(info->props, "stream.monitor"); monitor)
+        {
+            self.isMonitor = true;
+        }
 
-                    *info->second = -1;
-                    PipeWireApi::main_loop_quit(info->first->loop);
+        //* Yes this is swapped. (For compatibility reasons)
+        if (const auto *appName = spa_dict_lookup(info->props, "application.name"); appName)
+        {
+            self.name = appName;
+        }
+        if (const auto *binary = spa_dict_lookup(info->props, "application.process.binary");
+            binary && self.applicationBinary != binary)
+        {
+            if (auto previous = nodesByBinary.find(self.applicationBinary); previous != nodesByBinary.end())
+            {
+                previous->second.erase(self.id);
+                if (previous->second.empty())
+                {
+                    nodesByBinary.erase(previous);
                 }
             }
-        };
 
-        auto data = std::make_pair(this, &pending);
-        pw_core_add_listener(core, &coreListener, &coreEvents, &data); // NOLINT
+            self.applicationBinary = binary;
+            nodesByBinary[self.applicationBinary].emplace(self.id);
+        }
 
-        pending = pw_core_sync(core, PW_ID_CORE, 0); // NOLINT
-        while (pending != -1)
+        if (previous != std::tie(self.name, self.applicationBinary, self.pid, self.isMonitor))
         {
-            PipeWireApi::main_loop_run(loop);
+            notifyApps(self);
+        }
+    }
+    void PipeWire::notifyApps(const Node &node)
+    {
+        if (!node.inputs.empty())
+        {
+            onAppsChanged(Enums::AppType::Recording);
+        }
+        if (!node.outputs.empty())
+        {
+            onAppsChanged(Enums::AppType::Playback);
         }
-
-        spa_hook_remove(&coreListener);
     }
 
-    void PipeWire::onNodeInfo(const pw_node_info *info)
+    void PipeWire::indexPort(const Port &port)
     {
-        if (info && (~nodes).find(info->id) != (~nodes).end())
+        if (auto node = nodes.find(port.parentNode); node != nodes.end())
         {
-            auto &self = (~nodes).at(info->id);
+            auto &target = port.direction == SPA_DIRECTION_INPUT ? node->second.inputs : node->second.outputs;
+            target.emplace(port.side, port.id);
 
-            if (const auto *pid = spa_dict_lookup(info->props, "application.process.id"); pid)
+            //* The first port makes the node show up as an app
+            if (target.size() == 1)
             {
-                self.pid = std::stol(pid);
-            }
-            if (const auto *monitor = spa_dict_lookup(info->props, "stream.monitor"); monitor)
-            {
-                self.isMonitor = true;
+                onAppsChanged(port.direction == SPA_DIRECTION_INPUT ? Enums::AppType::Recording
+                                                                    : Enums::AppType::Playback);
             }
+        }
+        else if (port.parentNode == sinkNode)
+        {
+            auto &target = port.direction == SPA_DIRECTION_INPUT ? sinkInputs : sinkOutputs;
+            target.emplace(port.side, port.id);
+        }
+        else if (port.parentNode == sourceNode && port.direction == SPA_DIRECTION_INPUT)
+        {
+            sourceInputs.emplace(port.side, port.id);
+        }
+    }
 
-            //* Yes this is swapped. (For compatibility reasons)
-            if (const auto *appName = spa_dict_lookup(info->props, "application.name"); appName)
+    void PipeWire::unindexPort(const Port &port)
+    {
+        auto remove = [&port](std::multimap<Side, std::uint32_t> &from) {
+            auto [begin, end] = from.equal_range(port.side);
+            for (auto it = begin; it != end; it++)
             {
-                self.name = appName;
+                if (it->second == port.id)
+                {
+                    from.erase(it);
+                    return;
+                }
             }
-            if (const auto *binary = spa_dict_lookup(info->props, "application.process.binary"); binary)
+        };
+
+        if (auto node = nodes.find(port.parentNode); node != nodes.end())
+        {
+            auto &target = port.direction == SPA_DIRECTION_INPUT ? node->second.inputs : node->second.outputs;
+            remove(target);
+
+            if (target.empty())
             {
-                self.applicationBinary = binary;
+                onAppsChanged(port.direction == SPA_DIRECTION_INPUT ? Enums::AppType::Recording
+                                                                    : Enums::AppType::Playback);
             }
         }
+        else if (port.parentNode == sinkNode)
+        {
+            remove(port.direction == SPA_DIRECTION_INPUT ? sinkInputs : sinkOutputs);
+        }
+        else if (port.parentNode == sourceNode)
+        {
+            remove(sourceInputs);
+        }
     }
 
     void PipeWire::onPortInfo(const pw_port_info *info)
     {
-        if (info && (~ports).find(info->id) != (~ports).end())
+        if (!info || !info->props)
         {
-            auto &self = (~ports).at(info->id);
-            self.direction = info->direction;
+            return;
+        }
+
+        auto port = ports.find(info->id);
+        if (port == ports.end())
+        {
+            return;
+        }
+
+        auto &self = port->second;
+        unindexPort(self);
 
-            if (const auto *nodeId = spa_dict_lookup(info->props, "node.id"); nodeId)
+        self.direction = info->direction;
+
+        if (const auto *nodeId = spa_dict_lookup(info->props, "node.id"); nodeId)
+        {
+            self.parentNode = std::stol(nodeId);
+        }
+        if (const auto *rawPortName = spa_dict_lookup(info->props, "port.name"); rawPortName && *rawPortName)
+        {
+            auto portName = std::string(rawPortName);
+
+            if (portName.back() == '1' || portName.back() == 'L')
             {
-                self.parentNode = std::stol(nodeId);
+                self.side = Side::LEFT;
             }
-            if (const auto *rawPortName = spa_dict_lookup(info->props, "port.name"); rawPortName)
+            else if (portName.back() == '2' || portName.back() == 'R')
             {
-                auto portName = std::string(rawPortName);
-
-                if (portName.back() == '1' || portName.back() == 'L')
-                {
-                    self.side = Side::LEFT;
-                }
-                else if (portName.back() == '2' || portName.back() == 'R')
-                {
-                    self.side = Side::RIGHT;
-                }
-                else if (portName.find("MONO", portName.size() - 4) != std::string::npos)
-                {
-                    self.side = Side::MONO;
-                }
+                self.side = Side::RIGHT;
             }
-            if (const auto *portAlias = spa_dict_lookup(info->props, "port.alias"); portAlias)
+            else if (portName.size() >= 4 && portName.find("MONO", portName.size() - 4) != std::string::npos)
             {
-                self.portAlias = std::string(portAlias);
+                self.side = Side::MONO;
             }
         }
+        if (const auto *portAlias = spa_dict_lookup(info->props, "port.alias"); portAlias)
+        {
+            self.portAlias = std::string(portAlias);
+        }
+
+        indexPort(self);
     }
 
     void PipeWire::onCoreInfo(const pw_core_info *info)
@@ -137,148 +288,121 @@ namespace Soundux::Objects
         }
     }
 
-    void PipeWire::onGlobalAdded(void *data, std::uint32_t id, [[maybe_unused]] std::uint32_t perms, const char *type,
-                                 [[maybe_unused]] std::uint32_t version, const spa_dict *props)
+    void PipeWire::onMetadataProperty(const char *key, const char *value)
     {
-        auto *thiz = reinterpret_cast<PipeWire *>(data);
-        if (thiz && props)
+        if (!key || !value)
         {
-            if (strcmp(type, PW_TYPE_INTERFACE_Core) == 0)
-            {
-                spa_hook listener;
-                pw_core_events events = {};
+            return;
+        }
 
-                events.info = [](void *data, const pw_core_info *info) {
-                    auto *thiz = reinterpret_cast<PipeWire *>(data);
-                    if (thiz)
-                    {
-                        thiz->onCoreInfo(info);
-                    }
-                };
-                events.version = PW_VERSION_CORE_EVENTS;
-                auto *boundCore = reinterpret_cast<pw_core *>(
-                    pw_registry_bind(thiz->registry, id, type, PW_VERSION_CORE, sizeof(PipeWire)));
+        if (strcmp(key, "default.audio.source") == 0)
+        {
+            auto parsedValue = nlohmann::json::parse(value, nullptr, false);
+            if (!parsedValue.is_discarded() && parsedValue.count("name"))
+            {
+                auto name = parsedValue["name"].get<std::string>();
 
-                if (boundCore)
+                //* Our own microphone becomes the default while `useAsDefault` is active
+                if (name.find("soundux") != std::string::npos)
                 {
-                    pw_core_add_listener(boundCore, &listener, &events, thiz); // NOLINT
-                    thiz->sync();
-                    spa_hook_remove(&listener);
-                    PipeWireApi::proxy_destroy(reinterpret_cast<pw_proxy *>(boundCore));
+                    return;
                 }
+
+                defaultMicrophone = name;
+                Fancy::fancy.logTime().message() << "Found default device: " << name << std::endl;
             }
-            if (strcmp(type, PW_TYPE_INTERFACE_Metadata) == 0)
-            {
-                spa_hook listener;
-                pw_metadata_events events = {};
+        }
+        else if (strcmp(key, "default.audio.sink") == 0)
+        {
+            Globals::gAudio.invalidateDevices();
+        }
+    }
 
-                events.property = [](void *userdata, [[maybe_unused]] std::uint32_t id, const char *key,
-                                     [[maybe_unused]] const char *type, const char *value) -> int {
-                    auto *thiz = reinterpret_cast<PipeWire *>(userdata);
-                    if (thiz && key && value)
-                    {
-                        if (strcmp(key, "default.audio.source") == 0)
-                        {
-                            auto parsedValue = nlohmann::json::parse(value, nullptr, false);
-                            if (!parsedValue.is_discarded() && parsedValue.count("name"))
-                            {
-                                auto name = parsedValue["name"].get<std::string>();
-
-                                thiz->defaultMicrophone = name;
-                                Fancy::fancy.logTime().message() << "Found default device: " << name << std::endl;
-                            }
-                        }
-                    }
-                    return 0;
-                };
+    void PipeWire::bind(std::uint32_t id, const char *type, std::uint32_t version, const void *events)
+    {
+        auto *proxy = reinterpret_cast<pw_proxy *>(pw_registry_bind(registry, id, type, version, 0));
+        if (!proxy)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to bind " << type << " " << id << std::endl;
+            return;
+        }
+
+        auto &bound = proxies[id];
+        bound.proxy = proxy;
 
-                auto *boundMetaData = reinterpret_cast<pw_metadata *>(
-                    pw_registry_bind(thiz->registry, id, type, PW_VERSION_METADATA, sizeof(PipeWire)));
+        if (strcmp(type, PW_TYPE_INTERFACE_Node) == 0)
+        {
+            pw_node_add_listener(reinterpret_cast<pw_node *>(proxy), &bound.listener, // NOLINT
+                                 reinterpret_cast<const pw_node_events *>(events), this);
+        }
+        else if (strcmp(type, PW_TYPE_INTERFACE_Port) == 0)
+        {
+            pw_port_add_listener(reinterpret_cast<pw_port *>(proxy), &bound.listener, // NOLINT
+                                 reinterpret_cast<const pw_port_events *>(events), this);
+        }
+        else if (strcmp(type, PW_TYPE_INTERFACE_Metadata) == 0)
+        {
+            pw_metadata_add_listener(reinterpret_cast<pw_metadata *>(proxy), &bound.listener, // NOLINT
+                                     reinterpret_cast<const pw_metadata_events *>(events), this);
+        }
+    }
 
-                if (boundMetaData)
+    //* Called on the loop thread, nothing in here may wait for the server
+    void PipeWire::onGlobalAdded(void *data, std::uint32_t id, [[maybe_unused]] std::uint32_t perms, const char *type,
+                                 [[maybe_unused]] std::uint32_t version, const spa_dict *props)
+    {
+        auto *thiz = reinterpret_cast<PipeWire *>(data);
+        if (thiz && props)
+        {
+            if (strcmp(type, PW_TYPE_INTERFACE_Metadata) == 0)
+            {
+                const auto *name = spa_dict_lookup(props, PW_KEY_METADATA_NAME);
+                if (name && strcmp(name, "default") == 0)
                 {
-                    pw_metadata_add_listener(boundMetaData, &listener, &events, thiz); // NOLINT
-                    thiz->sync();
-                    spa_hook_remove(&listener);
-                    PipeWireApi::proxy_destroy(reinterpret_cast<pw_proxy *>(boundMetaData));
+                    thiz->defaultMetadata = id;
                 }
+
+                thiz->bind(id, type, PW_VERSION_METADATA, &metadataEvents);
             }
             if (strcmp(type, PW_TYPE_INTERFACE_Node) == 0)
             {
                 const auto *name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+                const auto *mediaClass = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
+                if (mediaClass && strcmp(mediaClass, "Audio/Sink") == 0)
+                {
+                    thiz->sinks.emplace(id);
+                    Globals::gAudio.invalidateDevices();
+                }
+
                 if (name && strstr(name, "soundux"))
                 {
+                    if (strcmp(name, "soundux_sink") == 0)
+                    {
+                        thiz->sinkNode = id;
+                    }
+                    else if (strcmp(name, "soundux_microphone") == 0)
+                    {
+                        thiz->sourceNode = id;
+                    }
+
                     return;
                 }
 
                 Node node;
                 node.id = id;
-                node.rawName = name;
+                node.rawName = name ? name : "";
 
-                spa_hook listener;
-                pw_node_events events = {};
-
-                events.info = [](void *data, const pw_node_info *info) {
-                    auto *thiz = reinterpret_cast<PipeWire *>(data);
-                    if (thiz)
-                    {
-                        thiz->onNodeInfo(info);
-                    }
-                };
-                events.version = PW_VERSION_NODE_EVENTS;
-                auto *boundNode = reinterpret_cast<pw_node *>(
-                    pw_registry_bind(thiz->registry, id, type, PW_VERSION_NODE, sizeof(PipeWire)));
-
-                if (boundNode)
-                {
-                    thiz->nodes->emplace(id, node);
-                    pw_node_add_listener(boundNode, &listener, &events, thiz); // NOLINT
-                    thiz->sync();
-                    spa_hook_remove(&listener);
-                    PipeWireApi::proxy_destroy(reinterpret_cast<pw_proxy *>(boundNode));
-                }
+                thiz->nodesByName[node.rawName] = id;
+                thiz->nodes.emplace(id, std::move(node));
+                thiz->bind(id, type, PW_VERSION_NODE, &nodeEvents);
             }
             if (strcmp(type, PW_TYPE_INTERFACE_Port) == 0)
             {
                 Port port;
                 port.id = id;
 
-                spa_hook listener;
-                pw_port_events events = {};
-
-                events.info = [](void *data, const pw_port_info *info) {
-                    auto *thiz = reinterpret_cast<PipeWire *>(data);
-                    if (thiz)
-                    {
-                        thiz->onPortInfo(info);
-                    }
-                };
-                events.version = PW_VERSION_PORT_EVENTS;
-
-                auto *boundPort =
-                    reinterpret_cast<pw_port *>(pw_registry_bind(thiz->registry, id, type, version, sizeof(PipeWire)));
-
-                if (boundPort)
-                {
-                    thiz->ports->emplace(id, port);
-                    pw_port_add_listener(boundPort, &listener, &events, thiz); // NOLINT
-                    thiz->sync();
-                    spa_hook_remove(&listener);
-                    PipeWireApi::proxy_destroy(reinterpret_cast<pw_proxy *>(boundPort));
-
-                    auto scopedNodes = thiz->nodes.scoped();
-                    auto scopedPorts = thiz->ports.scoped();
-                    if (scopedPorts->find(id) != scopedPorts->end())
-                    {
-                        auto &port = scopedPorts->at(id);
-                        if (port.parentNode > 0 && scopedNodes->find(port.parentNode) != scopedNodes->end())
-                        {
-                            auto &node = scopedNodes->at(port.parentNode);
-                            node.ports.emplace(id, port);
-                            scopedPorts->erase(id);
-                        }
-                    }
-                }
+                thiz->ports.emplace(id, port);
+                thiz->bind(id, type, version, &portEvents);
             }
         }
     }
@@ -288,16 +412,64 @@ namespace Soundux::Objects
         auto *thiz = reinterpret_cast<PipeWire *>(data);
         if (thiz)
         {
-            auto scopedNodes = thiz->nodes.scoped();
-            if (scopedNodes->find(id) != scopedNodes->end())
+            if (auto proxy = thiz->proxies.find(id); proxy != thiz->proxies.end())
+            {
+                spa_hook_remove(&proxy->second.listener);
+                PipeWireApi::proxy_destroy(proxy->second.proxy);
+                thiz->proxies.erase(proxy);
+            }
+
+            if (auto port = thiz->ports.find(id); port != thiz->ports.end())
             {
-                scopedNodes->erase(id);
+                thiz->unindexPort(port->second);
+                thiz->ports.erase(port);
             }
 
-            auto scopedPorts = thiz->ports.scoped();
-            if (scopedPorts->find(id) != scopedPorts->end())
+            if (auto node = thiz->nodes.find(id); node != thiz->nodes.end())
             {
-                scopedPorts->erase(id);
+                if (auto byName = thiz->nodesByName.find(node->second.rawName);
+                    byName != thiz->nodesByName.end() && byName->second == id)
+                {
+                    thiz->nodesByName.erase(byName);
+                }
+                if (auto byBinary = thiz->nodesByBinary.find(node->second.applicationBinary);
+                    byBinary != thiz->nodesByBinary.end())
+                {
+                    byBinary->second.erase(id);
+                    if (byBinary->second.empty())
+                    {
+                        thiz->nodesByBinary.erase(byBinary);
+                    }
+                }
+
+                //* Ports are removed before their node, but the node may go first when the server goes away
+                for (const auto *ports : {&node->second.inputs, &node->second.outputs})
+                {
+                    for (const auto &[side, port] : *ports)
+                    {
+                        thiz->ports.erase(port);
+                    }
+                }
+
+                thiz->notifyApps(node->second);
+                thiz->nodes.erase(node);
+            }
+
+            if (thiz->sinks.erase(id) > 0)
+            {
+                Globals::gAudio.invalidateDevices();
+            }
+            if (thiz->sinkNode == id)
+            {
+                thiz->sinkNode.reset();
+            }
+            if (thiz->sourceNode == id)
+            {
+                thiz->sourceNode.reset();
+            }
+            if (thiz->defaultMetadata == id)
+            {
+                thiz->defaultMetadata.reset();
             }
         }
     }
@@ -310,24 +482,77 @@ namespace Soundux::Objects
         }
 
         PipeWireApi::init(nullptr, nullptr);
-        loop = PipeWireApi::main_loop_new(nullptr);
+        loop = PipeWireApi::thread_loop_new("soundux-pipewire", nullptr);
         if (!loop)
         {
-            Fancy::fancy.logTime().failure() << "Failed to create main loop" << std::endl;
+            Fancy::fancy.logTime().failure() << "Failed to create thread loop" << std::endl;
             return false;
         }
-        context = PipeWireApi::context_new(PipeWireApi::main_loop_get_loop(loop), nullptr, 0);
+        context = PipeWireApi::context_new(PipeWireApi::thread_loop_get_loop(loop), nullptr, 0);
         if (!context)
         {
             Fancy::fancy.logTime().failure() << "Failed to create context" << std::endl;
+            disconnect();
+            return false;
+        }
+        if (PipeWireApi::thread_loop_start(loop) < 0)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to start thread loop" << std::endl;
+            disconnect();
+            return false;
+        }
+
+        if (!connect())
+        {
+            disconnect();
             return false;
         }
+
+        return true;
+    }
+    bool PipeWire::connect()
+    {
+        LoopLock lock(loop);
+
         core = PipeWireApi::context_connect(context, nullptr, 0);
         if (!core)
         {
             Fancy::fancy.logTime().failure() << "Failed to connect context" << std::endl;
             return false;
         }
+
+        static const pw_core_events coreEvents = [] {
+            pw_core_events events = {};
+            events.version = PW_VERSION_CORE_EVENTS;
+            events.info = [](void *data, const pw_core_info *info) {
+                reinterpret_cast<PipeWire *>(data)->onCoreInfo(info);
+            };
+            events.done = [](void *data, std::uint32_t id, [[maybe_unused]] int seq) {
+                auto *thiz = reinterpret_cast<PipeWire *>(data);
+                if (id == PW_ID_CORE)
+                {
+                    thiz->syncsDone++;
+                    PipeWireApi::thread_loop_signal(thiz->loop, false);
+                }
+            };
+            events.error = [](void *data, std::uint32_t id, int seq, int res, const char *message) {
+                auto *thiz = reinterpret_cast<PipeWire *>(data);
+                if (id == PW_ID_CORE)
+                {
+                    Fancy::fancy.logTime().failure()
+                        << "Core Failure - Seq " << seq << " - Res " << res << ": " << message << std::endl;
+
+                    if (res == -EPIPE)
+                    {
+                        thiz->connected = false;
+                        PipeWireApi::thread_loop_signal(thiz->loop, false);
+                    }
+                }
+            };
+            return events;
+        }();
+        pw_core_add_listener(core, &coreListener, &coreEvents, this); // NOLINT
+
         registry = pw_core_get_registry(core, PW_VERSION_REGISTRY, 0);
         if (!registry)
         {
@@ -335,12 +560,17 @@ namespace Soundux::Objects
             return false;
         }
 
-        registryEvents.global = onGlobalAdded;
-        registryEvents.global_remove = onGlobalRemoved;
-        registryEvents.version = PW_VERSION_REGISTRY_EVENTS;
-
+        static const pw_registry_events registryEvents = [] {
+            pw_registry_events events = {};
+            events.version = PW_VERSION_REGISTRY_EVENTS;
+            events.global = onGlobalAdded;
+            events.global_remove = onGlobalRemoved;
+            return events;
+        }();
         pw_registry_add_listener(registry, &registryListener, &registryEvents, this); // NOLINT
 
+        //* The first round trip announces every global, the second one delivers the info of everything bound by then
+        sync();
         sync();
 
         if (defaultMicrophone.empty())
@@ -348,165 +578,304 @@ namespace Soundux::Objects
             Fancy::fancy.logTime().warning() << "Failed to retrieve default microphone" << std::endl;
         }
 
-        return createNullSink();
+        if (!createNullSink())
+        {
+            return false;
+        }
+
+        if (createVirtualSource())
+        {
+            //* Wait for the ports of both nodes
+            sync();
+            sync();
+            linkVirtualSource();
+        }
+
+        return true;
     }
 
     void PipeWire::destroy()
     {
-        PipeWireApi::proxy_destroy(reinterpret_cast<pw_proxy *>(registry));
-        PipeWireApi::core_disconnect(core);
-        PipeWireApi::context_destroy(context);
-        PipeWireApi::main_loop_destroy(loop);
+        revertDefault();
+        disconnect();
     }
-
-    bool PipeWire::createNullSink()
+    void PipeWire::disconnect()
     {
-        pw_properties *props = PipeWireApi::properties_new(nullptr, nullptr);
+        if (!loop)
+        {
+            return;
+        }
 
-        PipeWireApi::properties_set(props, PW_KEY_MEDIA_CLASS, "Audio/Sink");
-        PipeWireApi::properties_set(props, PW_KEY_NODE_NAME, "soundux_sink");
-        PipeWireApi::properties_set(props, PW_KEY_FACTORY_NAME, "support.null-audio-sink");
+        //* Stopping joins the loop thread, so none of the listeners can run while they are removed
+        PipeWireApi::thread_loop_stop(loop);
 
-        auto *proxy = reinterpret_cast<pw_proxy *>(
-            pw_core_create_object(core, "adapter", PW_TYPE_INTERFACE_Node, PW_VERSION_NODE, &props->dict, 0));
+        for (auto &[id, proxy] : proxies)
+        {
+            spa_hook_remove(&proxy.listener);
+            PipeWireApi::proxy_destroy(proxy.proxy);
+        }
+        proxies.clear();
 
-        if (!proxy)
+        for (auto &pending : pendingObjects)
         {
-            Fancy::fancy.logTime().failure() << "Failed to create null sink node" << std::endl;
-            PipeWireApi::properties_free(props);
-            return false;
+            spa_hook_remove(&pending->listener);
+            if (!pending->settled)
+            {
+                pending->id.set_value(std::nullopt);
+            }
         }
+        pendingObjects.clear();
 
-        spa_hook listener;
-        bool success = false;
-        pw_proxy_events linkEvent = {};
-        linkEvent.version = PW_VERSION_PROXY_EVENTS;
-        linkEvent.bound = [](void *data, [[maybe_unused]] std::uint32_t id) { *reinterpret_cast<bool *>(data) = true; };
-        linkEvent.error = [](void *data, [[maybe_unused]] int a, [[maybe_unused]] int b, const char *message) {
-            Fancy::fancy.logTime().failure() << "Failed to create null sink: " << message << std::endl;
-            *reinterpret_cast<bool *>(data) = false;
-        };
+        //* The listeners are added right after their objects are created, so they exist whenever the object does
+        if (registry)
+        {
+            spa_hook_remove(&registryListener);
+            PipeWireApi::proxy_destroy(reinterpret_cast<pw_proxy *>(registry));
+        }
+        if (core)
+        {
+            spa_hook_remove(&coreListener);
+            PipeWireApi::core_disconnect(core);
+        }
+        if (context)
+        {
+            PipeWireApi::context_destroy(context);
+        }
+        PipeWireApi::thread_loop_destroy(loop);
 
-        PipeWireApi::proxy_add_listener(proxy, &listener, &linkEvent, &success);
-        sync();
+        registry = nullptr;
+        core = nullptr;
+        context = nullptr;
+        loop = nullptr;
+    }
+    PipeWire::~PipeWire()
+    {
+        disconnect();
+    }
+
+    std::future<std::optional<std::uint32_t>> PipeWire::createObject(const char *factory, const char *type,
+                                                                     std::uint32_t version, pw_properties *props)
+    {
+        auto pending = std::make_unique<PendingObject>();
+        auto rtn = pending->id.get_future();
 
-        spa_hook_remove(&listener);
+        pending->proxy =
+            reinterpret_cast<pw_proxy *>(pw_core_create_object(core, factory, type, version, &props->dict, 0));
         PipeWireApi::properties_free(props);
 
-        return success;
-    }
+        if (!pending->proxy)
+        {
+            pending->id.set_value(std::nullopt);
+            return rtn;
+        }
 
-    bool PipeWire::deleteLink(std::uint32_t id)
-    {
-        pw_registry_destroy(registry, id); // NOLINT
-        sync();
+        static const pw_proxy_events events = [] {
+            pw_proxy_events events = {};
+            events.version = PW_VERSION_PROXY_EVENTS;
+            events.bound = [](void *data, std::uint32_t id) {
+                auto *pending = reinterpret_cast<PendingObject *>(data);
+                if (!pending->settled)
+                {
+                    pending->settled = true;
+                    pending->id.set_value(id);
+                }
+            };
+            events.error = [](void *data, [[maybe_unused]] int seq, [[maybe_unused]] int res, const char *message) {
+                auto *pending = reinterpret_cast<PendingObject *>(data);
+                Fancy::fancy.logTime().warning() << "Failed to create object: " << message << std::endl;
 
-        return true;
+                if (!pending->settled)
+                {
+                    pending->settled = true;
+                    pending->id.set_value(std::nullopt);
+                }
+            };
+            return events;
+        }();
+
+        PipeWireApi::proxy_add_listener(pending->proxy, &pending->listener, &events, pending.get());
+        pendingObjects.emplace_back(std::move(pending));
+
+        return rtn;
     }
 
-    std::optional<int> PipeWire::linkPorts(std::uint32_t in, std::uint32_t out)
+    bool PipeWire::createNullSink()
     {
+        LoopLock lock(loop);
         pw_properties *props = PipeWireApi::properties_new(nullptr, nullptr);
 
-        PipeWireApi::properties_set(props, PW_KEY_APP_NAME, "soundux");
-        PipeWireApi::properties_setf(props, PW_KEY_LINK_INPUT_PORT, "%u", in);
-        PipeWireApi::properties_setf(props, PW_KEY_LINK_OUTPUT_PORT, "%u", out);
+        PipeWireApi::properties_set(props, PW_KEY_MEDIA_CLASS, "Audio/Sink");
+        PipeWireApi::properties_set(props, PW_KEY_NODE_NAME, "soundux_sink");
+        PipeWireApi::properties_set(props, PW_KEY_FACTORY_NAME, "support.null-audio-sink");
 
-        auto *proxy = reinterpret_cast<pw_proxy *>(
-            pw_core_create_object(core, "link-factory", PW_TYPE_INTERFACE_Link, PW_VERSION_LINK, &props->dict, 0));
+        auto sink = createObject("adapter", PW_TYPE_INTERFACE_Node, PW_VERSION_NODE, props);
+        commit();
 
-        if (!proxy)
+        if (!sink.get())
         {
-            Fancy::fancy.logTime().warning() << "Failed to create link from " << in << " to " << out << std::endl;
-            PipeWireApi::properties_free(props);
-            return std::nullopt;
+            Fancy::fancy.logTime().failure() << "Failed to create null sink node" << std::endl;
+            return false;
         }
 
-        spa_hook listener;
-        std::optional<std::uint32_t> result;
+        return true;
+    }
+
+    bool PipeWire::createVirtualSource()
+    {
+        LoopLock lock(loop);
+        pw_properties *props = PipeWireApi::properties_new(nullptr, nullptr);
 
-        pw_proxy_events linkEvent = {};
-        linkEvent.version = PW_VERSION_PROXY_EVENTS;
-        linkEvent.bound = [](void *data, std::uint32_t id) {
-            *reinterpret_cast<std::optional<std::uint32_t> *>(data) = id;
-        };
-        linkEvent.error = [](void *data, [[maybe_unused]] int a, [[maybe_unused]] int b, const char *message) {
-            Fancy::fancy.logTime().warning() << "Failed to create link: " << message << std::endl;
-            *reinterpret_cast<std::optional<std::uint32_t> *>(data) = std::nullopt;
-        };
+        PipeWireApi::properties_set(props, PW_KEY_MEDIA_CLASS, "Audio/Source/Virtual");
+        PipeWireApi::properties_set(props, PW_KEY_NODE_NAME, "soundux_microphone");
+        PipeWireApi::properties_set(props, PW_KEY_NODE_DESCRIPTION, "Soundux Microphone");
+        PipeWireApi::properties_set(props, PW_KEY_FACTORY_NAME, "support.null-audio-sink");
+        PipeWireApi::properties_set(props, "audio.position", "FL,FR");
 
-        PipeWireApi::proxy_add_listener(proxy, &listener, &linkEvent, &result);
-        sync();
+        auto source = createObject("adapter", PW_TYPE_INTERFACE_Node, PW_VERSION_NODE, props);
+        commit();
 
-        spa_hook_remove(&listener);
-        PipeWireApi::properties_free(props);
+        if (!source.get())
+        {
+            Fancy::fancy.logTime().warning() << "Failed to create virtual microphone" << std::endl;
+            return false;
+        }
 
-        return result;
+        return true;
     }
 
-    std::vector<std::shared_ptr<RecordingApp>> PipeWire::getRecordingApps()
+    void PipeWire::linkVirtualSource()
     {
-        sync();
-        std::vector<std::shared_ptr<RecordingApp>> rtn;
-
-        auto scopedNodes = nodes.scoped();
-        for (const auto &[nodeId, node] : *scopedNodes)
+        LoopLock lock(loop);
+        for (const auto &id : sourceLinks)
         {
-            if (!node.name.empty() && !node.isMonitor)
+            deleteLink(id);
+        }
+        sourceLinks.clear();
+
+        std::vector<std::future<std::optional<std::uint32_t>>> links;
+
+        //* Mono outputs feed both channels
+        auto link = [&](const std::multimap<Side, std::uint32_t> &outputs) {
+            for (const auto &[side, input] : sourceInputs)
             {
-                bool hasInput = false;
-                for (const auto &[portId, port] : node.ports)
+                if (side == Side::UNDEFINED)
+                {
+                    continue;
+                }
+
+                for (const auto &value : {side, Side::MONO})
                 {
-                    if (port.direction == SPA_DIRECTION_INPUT)
+                    auto [begin, end] = outputs.equal_range(value);
+                    for (auto it = begin; it != end; it++)
+                    {
+                        links.emplace_back(linkPorts(input, it->second));
+                    }
+
+                    if (side == Side::MONO)
                     {
-                        hasInput = true;
                         break;
                     }
                 }
+            }
+        };
 
-                if (hasInput)
-                {
-                    PipeWireRecordingApp app;
-                    app.pid = node.pid;
-                    app.nodeId = nodeId;
-                    app.name = node.name;
-                    app.application = node.applicationBinary;
-                    rtn.emplace_back(std::make_shared<PipeWireRecordingApp>(app));
-                }
+        link(sinkOutputs);
+        if (auto microphone = nodesByName.find(defaultMicrophone); microphone != nodesByName.end())
+        {
+            link(nodes.at(microphone->second).outputs);
+        }
+
+        commit();
+
+        for (auto &future : links)
+        {
+            if (auto id = future.get(); id)
+            {
+                sourceLinks.emplace_back(*id);
             }
         }
 
-        return rtn;
+        if (sourceLinks.empty())
+        {
+            Fancy::fancy.logTime().warning() << "Failed to link the virtual microphone" << std::endl;
+        }
     }
 
-    std::vector<std::shared_ptr<PlaybackApp>> PipeWire::getPlaybackApps()
+    bool PipeWire::setDefaultSource(const std::string &name)
     {
+        auto metadata = defaultMetadata ? proxies.find(*defaultMetadata) : proxies.end();
+        if (metadata == proxies.end())
+        {
+            Fancy::fancy.logTime().failure() << "Could not find the default metadata" << std::endl;
+            return false;
+        }
+
+        auto value = nlohmann::json{{"name", name}}.dump();
+        auto *proxy = reinterpret_cast<pw_metadata *>(metadata->second.proxy);
+
+        //* Without a value the choice is left to the session manager again
+        pw_metadata_set_property(proxy, PW_ID_CORE, "default.configured.audio.source", // NOLINT
+                                 name.empty() ? nullptr : "Spa:String:JSON", name.empty() ? nullptr : value.c_str());
         sync();
-        std::vector<std::shared_ptr<PlaybackApp>> rtn;
 
-        auto scopedNodes = nodes.scoped();
-        for (const auto &[nodeId, node] : *scopedNodes)
+        return true;
+    }
+
+    void PipeWire::deleteLink(std::uint32_t id)
+    {
+        pw_registry_destroy(registry, id); // NOLINT
+    }
+
+    std::future<std::optional<std::uint32_t>> PipeWire::linkPorts(std::uint32_t in, std::uint32_t out)
+    {
+        pw_properties *props = PipeWireApi::properties_new(nullptr, nullptr);
+
+        PipeWireApi::properties_set(props, PW_KEY_APP_NAME, "soundux");
+        PipeWireApi::properties_setf(props, PW_KEY_LINK_INPUT_PORT, "%u", in);
+        PipeWireApi::properties_setf(props, PW_KEY_LINK_OUTPUT_PORT, "%u", out);
+
+        return createObject("link-factory", PW_TYPE_INTERFACE_Link, PW_VERSION_LINK, props);
+    }
+
+    std::vector<std::future<std::optional<std::uint32_t>>> PipeWire::linkToSink(const Node &node,
+                                                                              spa_direction direction)
+    {
+        //* Input ports of the node are fed by the outputs of the sink and the other way around
+        const auto &nodePorts = direction == SPA_DIRECTION_INPUT ? node.inputs : node.outputs;
+        const auto &sinkPorts = direction == SPA_DIRECTION_INPUT ? sinkOutputs : sinkInputs;
+
+        std::vector<std::future<std::optional<std::uint32_t>>> rtn;
+        for (const auto &[side, sinkPort] : sinkPorts)
         {
-            if (!node.name.empty() && !node.isMonitor)
+            if (side == Side::UNDEFINED)
             {
-                bool hasOutput = false;
-                for (const auto &[portId, port] : node.ports)
+                continue;
+            }
+
+            auto link = [&](std::uint32_t nodePort) {
+                if (direction == SPA_DIRECTION_INPUT)
                 {
-                    if (port.direction == SPA_DIRECTION_OUTPUT)
-                    {
-                        hasOutput = true;
-                        break;
-                    }
+                    rtn.emplace_back(linkPorts(nodePort, sinkPort));
                 }
+                else
+                {
+                    rtn.emplace_back(linkPorts(sinkPort, nodePort));
+                }
+            };
 
-                if (hasOutput)
+            auto [begin, end] = nodePorts.equal_range(side);
+            for (auto it = begin; it != end; it++)
+            {
+                link(it->second);
+            }
+
+            //* Mono ports of the node are linked to both sides
+            if (side != Side::MONO)
+            {
+                auto [monoBegin, monoEnd] = nodePorts.equal_range(Side::MONO);
+                for (auto it = monoBegin; it != monoEnd; it++)
                 {
-                    PipeWirePlaybackApp app;
-                    app.pid = node.pid;
-                    app.nodeId = nodeId;
-                    app.name = node.name;
-                    app.application = node.applicationBinary;
-                    rtn.emplace_back(std::make_shared<PipeWirePlaybackApp>(app));
+                    link(it->second);
                 }
             }
         }
@@ -514,94 +883,147 @@ namespace Soundux::Objects
         return rtn;
     }
 
-    std::shared_ptr<PlaybackApp> PipeWire::getPlaybackApp(const std::string &app)
+    std::vector<std::shared_ptr<RecordingApp>> PipeWire::getRecordingApps()
     {
-        auto scopedNodes = nodes.scoped();
-        for (const auto &[nodeId, node] : *scopedNodes)
+        LoopLock lock(loop);
+        std::vector<std::shared_ptr<RecordingApp>> rtn;
+
+        for (const auto &[nodeId, node] : nodes)
         {
-            if (node.applicationBinary == app)
+            if (!node.name.empty() && !node.isMonitor && !node.inputs.empty())
             {
-                PipeWirePlaybackApp app;
+                PipeWireRecordingApp app;
                 app.pid = node.pid;
                 app.nodeId = nodeId;
                 app.name = node.name;
                 app.application = node.applicationBinary;
-                return std::make_shared<PipeWirePlaybackApp>(app);
+                rtn.emplace_back(std::make_shared<PipeWireRecordingApp>(app));
             }
         }
 
-        return nullptr;
+        return rtn;
     }
 
-    std::shared_ptr<RecordingApp> PipeWire::getRecordingApp(const std::string &app)
+    std::vector<std::shared_ptr<PlaybackApp>> PipeWire::getPlaybackApps()
     {
-        auto scopedNodes = nodes.scoped();
-        for (const auto &[nodeId, node] : *scopedNodes)
+        LoopLock lock(loop);
+        std::vector<std::shared_ptr<PlaybackApp>> rtn;
+
+        for (const auto &[nodeId, node] : nodes)
         {
-            if (node.applicationBinary == app)
+            if (!node.name.empty() && !node.isMonitor && !node.outputs.empty())
             {
-                PipeWireRecordingApp app;
+                PipeWirePlaybackApp app;
                 app.pid = node.pid;
                 app.nodeId = nodeId;
                 app.name = node.name;
                 app.application = node.applicationBinary;
-                return std::make_shared<PipeWireRecordingApp>(app);
+                rtn.emplace_back(std::make_shared<PipeWirePlaybackApp>(app));
             }
         }
 
+        return rtn;
+    }
+
+    std::shared_ptr<PlaybackApp> PipeWire::getPlaybackApp(const std::string &app)
+    {
+        LoopLock lock(loop);
+        if (auto ids = nodesByBinary.find(app); ids != nodesByBinary.end() && !ids->second.empty())
+        {
+            const auto &node = nodes.at(*ids->second.begin());
+
+            PipeWirePlaybackApp app;
+            app.pid = node.pid;
+            app.nodeId = node.id;
+            app.name = node.name;
+            app.application = node.applicationBinary;
+            return std::make_shared<PipeWirePlaybackApp>(app);
+        }
+
+        return nullptr;
+    }
+
+    std::shared_ptr<RecordingApp> PipeWire::getRecordingApp(const std::string &app)
+    {
+        LoopLock lock(loop);
+        if (auto ids = nodesByBinary.find(app); ids != nodesByBinary.end() && !ids->second.empty())
+        {
+            const auto &node = nodes.at(*ids->second.begin());
+
+            PipeWireRecordingApp app;
+            app.pid = node.pid;
+            app.nodeId = node.id;
+            app.name = node.name;
+            app.application = node.applicationBinary;
+            return std::make_shared<PipeWireRecordingApp>(app);
+        }
+
         return nullptr;
     }
 
     bool PipeWire::useAsDefault()
     {
-        // TODO(pipewire): Find a way to connect the output to the microphone
-        Fancy::fancy.logTime().warning() << "Fix Me: useAsDefault() is not yet implemented on pipewire" << std::endl;
-        return false;
+        LoopLock lock(loop);
+        if (!sourceNode)
+        {
+            Fancy::fancy.logTime().failure() << "Could not set default source, virtual microphone is missing"
+                                             << std::endl;
+            return false;
+        }
+
+        //* The default microphone may have changed since the links were made
+        linkVirtualSource();
+
+        auto previous = previousMicrophone.value_or(defaultMicrophone);
+        if (!setDefaultSource("soundux_microphone"))
+        {
+            return false;
+        }
+
+        previousMicrophone = previous;
+        return true;
     }
 
     bool PipeWire::revertDefault()
     {
-        // TODO(pipewire): Delete link created by `useAsDefault`
-        Fancy::fancy.logTime().warning() << "Fix Me: revertDefault() is not yet implemented on pipewire" << std::endl;
+        LoopLock lock(loop);
+        if (!previousMicrophone)
+        {
+            return true;
+        }
+
+        if (!setDefaultSource(*previousMicrophone))
+        {
+            return false;
+        }
+
+        previousMicrophone.reset();
         return true;
     }
 
     bool PipeWire::muteInput(bool state)
     {
         // TODO(pipewire): Research if it's possible to mute the device instead of the node.
-        auto copy = nodes.copy();
-        for (const auto &node : copy)
+        LoopLock lock(loop);
+
+        if (auto node = nodesByName.find(defaultMicrophone); node != nodesByName.end())
         {
-            if (node.second.rawName == defaultMicrophone)
+            if (auto proxy = proxies.find(node->second); proxy != proxies.end())
             {
-                auto *boundNode = reinterpret_cast<pw_node *>(pw_registry_bind(
-                    registry, node.second.id, PW_TYPE_INTERFACE_Node, PW_VERSION_NODE, sizeof(PipeWire)));
-
-                if (boundNode)
-                {
-                    char buffer[1024];
-                    spa_pod_builder b;
-                    spa_pod_builder_init(&b, buffer, sizeof(buffer));
-
-                    spa_pod_frame f[1];
-                    spa_pod *param{};
-
-                    spa_pod_builder_push_object(&b, &f[0], SPA_TYPE_OBJECT_Props, SPA_PARAM_Props);
-                    spa_pod_builder_add(&b, SPA_PROP_mute, SPA_POD_Bool(state), 0);
+                auto *boundNode = reinterpret_cast<pw_node *>(proxy->second.proxy);
 
-                    param = static_cast<spa_pod *>(spa_pod_builder_pop(&b, &f[0]));
-                    if (pw_node_set_param(boundNode, SPA_PARAM_Props, 0, param) < 0) // NOLINT
-                    {
-                        return false;
-                    }
+                char buffer[1024];
+                spa_pod_builder b;
+                spa_pod_builder_init(&b, buffer, sizeof(buffer));
 
-                    PipeWireApi::proxy_destroy(reinterpret_cast<pw_proxy *>(boundNode));
-                    sync();
+                spa_pod_frame f[1];
+                spa_pod *param{};
 
-                    return true;
-                }
+                spa_pod_builder_push_object(&b, &f[0], SPA_TYPE_OBJECT_Props, SPA_PARAM_Props);
+                spa_pod_builder_add(&b, SPA_PROP_mute, SPA_POD_Bool(state), 0);
 
-                break;
+                param = static_cast<spa_pod *>(spa_pod_builder_pop(&b, &f[0]));
+                return pw_node_set_param(boundNode, SPA_PARAM_Props, 0, param) >= 0; // NOLINT
             }
         }
 
@@ -610,6 +1032,7 @@ namespace Soundux::Objects
 
     bool PipeWire::inputSoundTo(std::shared_ptr<RecordingApp> app)
     {
+        LoopLock lock(loop);
         if (!app)
         {
             Fancy::fancy.logTime().warning() << "Invalid app" << std::endl;
@@ -627,44 +1050,31 @@ namespace Soundux::Objects
             return false;
         }
 
-        bool success = false;
-        auto nodes = this->nodes.copy();
-        auto ports = this->ports.copy();
-
         if (!soundInputLinks.count(app->application))
         {
             soundInputLinks.emplace(app->application, std::vector<std::uint32_t>{});
         }
 
-        for (const auto &[nodeId, node] : nodes)
+        std::vector<std::future<std::optional<std::uint32_t>>> links;
+        if (auto ids = nodesByBinary.find(app->application); ids != nodesByBinary.end())
         {
-            if (node.applicationBinary != app->application)
-                continue;
+            for (const auto &id : ids->second)
+            {
+                auto requested = linkToSink(nodes.at(id), SPA_DIRECTION_INPUT);
+                std::move(requested.begin(), requested.end(), std::back_inserter(links));
+            }
+        }
+
+        //* Every link of the app is created with a single round trip
+        commit();
 
-            for (const auto &[portId, port] : ports)
+        bool success = false;
+        for (auto &link : links)
+        {
+            if (auto id = link.get(); id)
             {
-                if (port.direction == SPA_DIRECTION_OUTPUT && port.portAlias.find("soundux") != std::string::npos)
-                {
-                    for (const auto &[nodePortId, nodePort] : node.ports)
-                    {
-                        if (nodePort.direction == SPA_DIRECTION_INPUT)
-                        {
-                            if (nodePort.side == Side::UNDEFINED || port.side == Side::UNDEFINED)
-                                continue;
-
-                            if (nodePort.side == port.side || nodePort.side == Side::MONO)
-                            {
-                                auto link = linkPorts(nodePortId, portId);
-
-                                if (link)
-                                {
-                                    success = true;
-                                    soundInputLinks.at(app->application).emplace_back(*link);
-                                }
-                            }
-                        }
-                    }
-                }
+                success = true;
+                soundInputLinks.at(app->application).emplace_back(*id);
             }
         }
 
@@ -678,6 +1088,7 @@ namespace Soundux::Objects
 
     bool PipeWire::stopSoundInput()
     {
+        LoopLock lock(loop);
         for (const auto &[appBinary, links] : soundInputLinks)
         {
             for (const auto &id : links)
@@ -686,12 +1097,14 @@ namespace Soundux::Objects
             }
         }
         soundInputLinks.clear();
+        sync();
 
         return true;
     }
 
     bool PipeWire::passthroughFrom(std::shared_ptr<PlaybackApp> app)
     {
+        LoopLock lock(loop);
         if (!app)
         {
             Fancy::fancy.logTime().warning() << "Invalid app" << std::endl;
@@ -705,44 +1118,31 @@ namespace Soundux::Objects
             return false;
         }
 
-        bool success = false;
-        auto nodes = this->nodes.copy();
-        auto ports = this->ports.copy();
-
         if (!passthroughLinks.count(app->application))
         {
             passthroughLinks.emplace(app->application, std::vector<std::uint32_t>{});
         }
 
-        for (const auto &[nodeId, node] : nodes)
+        std::vector<std::future<std::optional<std::uint32_t>>> links;
+        if (auto ids = nodesByBinary.find(app->application); ids != nodesByBinary.end())
         {
-            if (node.applicationBinary != app->application)
-                continue;
+            for (const auto &id : ids->second)
+            {
+                auto requested = linkToSink(nodes.at(id), SPA_DIRECTION_OUTPUT);
+                std::move(requested.begin(), requested.end(), std::back_inserter(links));
+            }
+        }
 
-            for (const auto &[portId, port] : ports)
+        //* Every link of the app is created with a single round trip
+        commit();
+
+        bool success = false;
+        for (auto &link : links)
+        {
+            if (auto id = link.get(); id)
             {
-                if (port.direction == SPA_DIRECTION_INPUT && port.portAlias.find("soundux") != std::string::npos)
-                {
-                    for (const auto &[nodePortId, nodePort] : node.ports)
-                    {
-                        if (nodePort.side == Side::UNDEFINED || port.side == Side::UNDEFINED)
-                            continue;
-
-                        if (nodePort.direction == SPA_DIRECTION_OUTPUT)
-                        {
-                            if (nodePort.side == port.side || nodePort.side == Side::MONO)
-                            {
-                                auto link = linkPorts(portId, nodePortId);
-
-                                if (link)
-                                {
-                                    success = true;
-                                    passthroughLinks.at(app->application).emplace_back(*link);
-                                }
-                            }
-                        }
-                    }
-                }
+                success = true;
+                passthroughLinks.at(app->application).emplace_back(*id);
             }
         }
 
@@ -756,6 +1156,7 @@ namespace Soundux::Objects
 
     std::set<std::string> PipeWire::currentlyInputApps()
     {
+        LoopLock lock(loop);
         std::set<std::string> rtn;
         for (const auto &[app, links] : soundInputLinks)
         {
@@ -766,6 +1167,7 @@ namespace Soundux::Objects
     }
     std::set<std::string> PipeWire::currentlyPassedThrough()
     {
+        LoopLock lock(loop);
         std::set<std::string> rtn;
         for (const auto &[app, links] : passthroughLinks)
         {
@@ -777,6 +1179,7 @@ namespace Soundux::Objects
 
     bool PipeWire::stopPassthrough(const std::string &app)
     {
+        LoopLock lock(loop);
         if (passthroughLinks.find(app) != passthroughLinks.end())
         {
             for (const auto &id : passthroughLinks.at(app))
@@ -785,6 +1188,7 @@ namespace Soundux::Objects
             }
 
             passthroughLinks.erase(app);
+            sync();
         }
         else
         {
@@ -796,6 +1200,7 @@ namespace Soundux::Objects
 
     bool PipeWire::stopAllPassthrough()
     {
+        LoopLock lock(loop);
         for (const auto &[appBinary, links] : passthroughLinks)
         {
             for (const auto &id : links)
@@ -805,6 +1210,8 @@ namespace Soundux::Objects
         }
 
         passthroughLinks.clear();
+        sync();
+
         return true;
     }
 } // namespace Soundux::Objects
@@ -1,8 +1,12 @@
 #if defined(__linux__)
 #include "../backend.hpp"
+#include <future>
 #include <map>
+#include <memory>
 #include <optional>
-#include <var_guard.hpp>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 #include <pipewire/extensions/metadata.h>
 #include <pipewire/global.h>
@@ -42,22 +46,23 @@ namespace Soundux
         {
             std::uint32_t id;
             std::string name;
-            std::uint32_t pid;
+            std::uint32_t pid = 0;
             std::string rawName;
             bool isMonitor = false;
             std::string applicationBinary;
-            std::map<std::uint32_t, Port> ports;
+
+            //* Ids of the ports of this node
+            std::multimap<Side, std::uint32_t> inputs;
+            std::multimap<Side, std::uint32_t> outputs;
         };
 
         struct PipeWirePlaybackApp : public PlaybackApp
         {
-            std::uint32_t pid;
             std::uint32_t nodeId;
             ~PipeWirePlaybackApp() override = default;
         };
         struct PipeWireRecordingApp : public RecordingApp
         {
-            std::uint32_t pid;
             std::uint32_t nodeId;
             ~PipeWireRecordingApp() override = default;
         };
@@ -67,33 +72,101 @@ namespace Soundux
             friend class AudioBackend;
 
           private:
-            pw_core *core;
-            pw_main_loop *loop;
-            pw_context *context;
-            pw_registry *registry;
+            //* Bound to a global for as long as it exists, so that changes arrive without asking for them
+            struct Proxy
+            {
+                pw_proxy *proxy;
+                spa_hook listener;
+            };
+            //* An object that was requested from the server, settled by the next `commit`
+            struct PendingObject
+            {
+                pw_proxy *proxy;
+                spa_hook listener;
+                bool settled = false;
+                std::promise<std::optional<std::uint32_t>> id;
+            };
+
+            pw_core *core = nullptr;
+            pw_thread_loop *loop = nullptr;
+            pw_context *context = nullptr;
+            pw_registry *registry = nullptr;
             std::uint32_t version = 0;
             std::string defaultMicrophone;
 
+            spa_hook coreListener;
             spa_hook registryListener;
-            pw_registry_events registryEvents;
 
-          private:
-            sxl::var_guard<std::map<std::uint32_t, Node>> nodes;
-            sxl::var_guard<std::map<std::uint32_t, Port>> ports;
+            //* Listeners keep a pointer to their events, so these have to outlive every proxy
+            static const pw_node_events nodeEvents;
+            static const pw_port_events portEvents;
+            static const pw_metadata_events metadataEvents;
+
+            //* Everything below is only touched from the loop thread or while the loop is locked
+            bool connected = true;
+            std::uint64_t syncsIssued = 0;
+            std::uint64_t syncsDone = 0;
+
+            std::map<std::uint32_t, Proxy> proxies;
+            std::vector<std::unique_ptr<PendingObject>> pendingObjects;
+
+            std::map<std::uint32_t, Node> nodes;
+            std::unordered_map<std::uint32_t, Port> ports;
+            std::set<std::uint32_t> sinks;
+
+            std::unordered_map<std::string, std::set<std::uint32_t>> nodesByBinary;
+            std::unordered_map<std::string, std::uint32_t> nodesByName;
+            //* The nodes created by us are not tracked as apps, only their ports are
+            std::optional<std::uint32_t> sinkNode;
+            std::optional<std::uint32_t> sourceNode;
+            std::multimap<Side, std::uint32_t> sinkInputs;
+            std::multimap<Side, std::uint32_t> sinkOutputs;
+            std::multimap<Side, std::uint32_t> sourceInputs;
+
+            //* Feed the virtual microphone with the monitor of the sink and the real microphone
+            std::vector<std::uint32_t> sourceLinks;
+            std::optional<std::uint32_t> defaultMetadata;
+            //* Set while the virtual microphone is the default source
+            std::optional<std::string> previousMicrophone;
+
+            void indexPort(const Port &);
+            void unindexPort(const Port &);
+            //* Nodes with input ports are listed as recording apps, those with output ports as playback apps
+            void notifyApps(const Node &);
+            //* Requests a link between every matching pair of ports of the node and the soundux sink
+            std::vector<std::future<std::optional<std::uint32_t>>> linkToSink(const Node &, spa_direction);
 
+          private:
             void onNodeInfo(const pw_node_info *);
             void onPortInfo(const pw_port_info *);
             void onCoreInfo(const pw_core_info *);
+            void onMetadataProperty(const char *, const char *);
 
           private:
             std::map<std::string, std::vector<std::uint32_t>> soundInputLinks;
             std::map<std::string, std::vector<std::uint32_t>> passthroughLinks;
 
           private:
+            //* Waits for one round trip, the loop has to be locked
             void sync();
+            //* Waits for every requested object with a single round trip
+            void commit();
+            void bind(std::uint32_t, const char *, std::uint32_t, const void *);
+
+            //* Connects to the server and creates our nodes, fails without leaving any listener behind
+            bool connect();
+            //* Removes every listener and destroys the core, context and loop, the loop must not be locked
+            void disconnect();
+
             bool createNullSink();
-            bool deleteLink(std::uint32_t);
-            std::optional<int> linkPorts(std::uint32_t, std::uint32_t);
+            bool createVirtualSource();
+            void linkVirtualSource();
+            bool setDefaultSource(const std::string &);
+            void deleteLink(std::uint32_t);
+            //* The link is only requested, its id is known after the next `commit`
+            std::future<std::optional<std::uint32_t>> linkPorts(std::uint32_t, std::uint32_t);
+            std::future<std::optional<std::uint32_t>> createObject(const char *, const char *, std::uint32_t,
+                                                                   pw_properties *);
 
             static void onGlobalRemoved(void *, std::uint32_t);
             static void onGlobalAdded(void *, std::uint32_t, std::uint32_t, const char *, std::uint32_t,
@@ -104,6 +177,7 @@ namespace Soundux
 
           public:
             PipeWire() = default;
+            ~PipeWire() override;
             void destroy() override;
 
             bool useAsDefault() override;
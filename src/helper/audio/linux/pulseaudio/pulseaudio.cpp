@@ -8,6 +8,52 @@
 
 namespace Soundux::Objects
 {
+    class LoopLock
+    {
+        pa_threaded_mainloop *mainloop;
+
+      public:
+        explicit LoopLock(pa_threaded_mainloop *mainloop) : mainloop(mainloop)
+        {
+            PulseApi::threaded_mainloop_lock(mainloop);
+        }
+        ~LoopLock()
+        {
+            PulseApi::threaded_mainloop_unlock(mainloop);
+        }
+        LoopLock(const LoopLock &) = delete;
+        LoopLock &operator=(const LoopLock &) = delete;
+    };
+
+    static void prefetchIcon(pa_proplist *properties)
+    {
+        if (const auto *pid = PulseApi::proplist_gets(properties, "application.process.id"); pid)
+        {
+            Globals::gIcons->prefetch(std::stoi(pid));
+        }
+    }
+    static bool isApplication(const char *driver, pa_proplist *properties)
+    {
+        return driver && std::strcmp(driver, "protocol-native.c") == 0 &&
+               PulseApi::proplist_gets(properties, "application.process.id") &&
+               PulseApi::proplist_gets(properties, "application.process.binary");
+    }
+    template <typename T, typename Info> static std::shared_ptr<T> makeApp(const Info *info)
+    {
+        auto app = std::make_shared<T>();
+        const auto *name = PulseApi::proplist_gets(info->proplist, "application.name");
+
+        app->id = info->index;
+        app->name = name ? name : "";
+        app->pid = std::stoi(PulseApi::proplist_gets(info->proplist, "application.process.id"));
+        app->application = PulseApi::proplist_gets(info->proplist, "application.process.binary");
+
+        return app;
+    }
+    template <typename T> static bool isSameApp(const T &first, const T &second)
+    {
+        return first.name == second.name && first.application == second.application && first.pid == second.pid;
+    }
     bool PulseAudio::setup()
     {
         if (!PulseApi::setup())
@@ -15,44 +61,68 @@ namespace Soundux::Objects
             return false;
         }
 
-        mainloop = PulseApi::mainloop_new();
-        mainloopApi = PulseApi::mainloop_get_api(mainloop);
+        mainloop = PulseApi::threaded_mainloop_new();
+        mainloopApi = PulseApi::threaded_mainloop_get_api(mainloop);
         context = PulseApi::context_new(mainloopApi, "soundux");
-        PulseApi::context_connect(context, nullptr, pa_context_flags::PA_CONTEXT_NOFLAGS, nullptr);
 
-        auto data = std::make_pair(false, false);
+        if (PulseApi::threaded_mainloop_start(mainloop) < 0)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to start pulseaudio mainloop" << std::endl;
+            disconnect();
+            return false;
+        }
+
+        if (!connect())
+        {
+            disconnect();
+            return false;
+        }
+
+        return true;
+    }
+    bool PulseAudio::connect()
+    {
+        LoopLock lock(mainloop);
+
+        std::pair<pa_threaded_mainloop *, std::optional<bool>> data(mainloop, std::nullopt);
         PulseApi::context_set_state_callback(
             context,
             [](pa_context *context, void *userData) {
                 auto state = PulseApi::context_get_state(context);
-                auto *data = reinterpret_cast<std::pair<bool, bool> *>(userData);
-
-                if (!data)
-                {
-                    return;
-                }
+                auto *data = reinterpret_cast<std::pair<pa_threaded_mainloop *, std::optional<bool>> *>(userData);
 
                 if (state == PA_CONTEXT_FAILED)
                 {
                     Fancy::fancy.logTime().failure() << "Failed to connect to pulseaudio" << std::endl;
-                    data->first = true;
                     data->second = false;
                 }
                 else if (state == PA_CONTEXT_READY)
                 {
                     Fancy::fancy.logTime().message() << "PulseAudio is ready!" << std::endl;
-                    data->first = true;
                     data->second = true;
                 }
+
+                PulseApi::threaded_mainloop_signal(data->first, 0);
             },
             &data);
+        PulseApi::context_connect(context, nullptr, pa_context_flags::PA_CONTEXT_NOFLAGS, nullptr);
+
+        while (!data.second)
+        {
+            PulseApi::threaded_mainloop_wait(mainloop);
+        }
 
-        while (!data.first)
+        //* `data` does not outlive this function
+        PulseApi::context_set_state_callback(context, nullptr, nullptr);
+
+        if (!*data.second)
         {
-            PulseApi::mainloop_iterate(mainloop, true, nullptr);
+            return false;
         }
 
-        if (!data.second)
+        //* Checked before anything is loaded or subscribed, pipewire-pulse is handled by the native backend
+        fetchDefaultSource();
+        if (serverName.empty() || isRunningPipeWire())
         {
             return false;
         }
@@ -60,87 +130,214 @@ namespace Soundux::Objects
         unloadLeftOvers();
         fetchDefaultSource();
 
-        return !(defaultSource.empty() || serverName.empty() || isRunningPipeWire());
+        PulseApi::context_set_subscribe_callback(
+            context,
+            []([[maybe_unused]] pa_context *ctx, pa_subscription_event_type_t event, std::uint32_t index,
+               void *userData) { reinterpret_cast<PulseAudio *>(userData)->onSubscriptionEvent(event, index); },
+            this);
+        await(PulseApi::context_subscribe(
+            context,
+            static_cast<pa_subscription_mask_t>(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SERVER |
+                                                PA_SUBSCRIPTION_MASK_SINK_INPUT |
+                                                PA_SUBSCRIPTION_MASK_SOURCE_OUTPUT),
+            nullptr, nullptr));
+
+        //* Subscribed first, so that no app can slip through between the listing and the subscription
+        fetchApps();
+
+        return !defaultSource.empty();
     }
-    bool PulseAudio::loadModules()
+    void PulseAudio::onSubscriptionEvent(pa_subscription_event_type_t event, std::uint32_t index)
     {
-        auto playbackApps = getPlaybackApps();
-        auto recordingApps = getRecordingApps();
+        auto facility = event & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+        auto type = event & PA_SUBSCRIPTION_EVENT_TYPE_MASK;
 
-        await(PulseApi::context_load_module(
-            context, "module-null-sink",
-            "sink_name=soundux_sink rate=44100 sink_properties=device.description=soundux_sink",
-            []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
-                if (static_cast<int>(id) < 0)
-                {
-                    Fancy::fancy.logTime().failure() << "Failed to load null sink" << std::endl;
-                }
-                else
-                {
-                    *reinterpret_cast<std::optional<std::uint32_t> *>(userData) = id;
-                }
-            },
-            &nullSink));
-
-        await(PulseApi::context_load_module(
-            context, "module-loopback",
-            ("rate=44100 source=" + defaultSource + " sink=soundux_sink sink_dont_move=true source_dont_move=true")
-                .c_str(),
-            []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
-                if (static_cast<int>(id) < 0)
-                {
-                    Fancy::fancy.logTime().failure() << "Failed to load loopback" << std::endl;
-                }
-                else
+        if (facility == PA_SUBSCRIPTION_EVENT_SINK || facility == PA_SUBSCRIPTION_EVENT_SERVER)
+        {
+            //* A sink came or went or the default sink changed
+            Globals::gAudio.invalidateDevices();
+        }
+        else if (facility == PA_SUBSCRIPTION_EVENT_SINK_INPUT)
+        {
+            if (type == PA_SUBSCRIPTION_EVENT_REMOVE)
+            {
+                std::unique_lock lock(appMutex);
+                if (playbackApps.erase(index))
                 {
-                    *reinterpret_cast<std::optional<std::uint32_t> *>(userData) = id;
+                    lock.unlock();
+                    onAppsChanged(Enums::AppType::Playback);
                 }
-            },
-            &loopBack));
+                return;
+            }
 
-        await(PulseApi::context_load_module(
-            context, "module-null-sink",
-            "sink_name=soundux_sink_passthrough rate=44100 sink_properties=device.description=soundux_sink_passthrough",
-            []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
-                if (static_cast<int>(id) < 0)
-                {
-                    Fancy::fancy.logTime().failure() << "Failed to load passthrough null sink" << std::endl;
-                }
-                else
+            //* Runs on the mainloop thread, so the operation can not be awaited here
+            PulseApi::operation_unref(PulseApi::context_get_sink_input_info(
+                context, index,
+                []([[maybe_unused]] pa_context *ctx, const pa_sink_input_info *info, [[maybe_unused]] int eol,
+                   void *userData) { reinterpret_cast<PulseAudio *>(userData)->onSinkInput(info); },
+                this));
+        }
+        else if (facility == PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT)
+        {
+            if (type == PA_SUBSCRIPTION_EVENT_REMOVE)
+            {
+                std::unique_lock lock(appMutex);
+                if (recordingApps.erase(index))
                 {
-                    *reinterpret_cast<std::optional<std::uint32_t> *>(userData) = id;
+                    lock.unlock();
+                    onAppsChanged(Enums::AppType::Recording);
                 }
-            },
-            &passthrough));
+                return;
+            }
 
-        await(PulseApi::context_load_module(
-            context, "module-loopback",
-            "source=soundux_sink_passthrough.monitor sink=soundux_sink source_dont_move=true",
-            []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
-                if (static_cast<int>(id) < 0)
-                {
-                    Fancy::fancy.logTime().failure() << "Failed to load passthrough sink" << std::endl;
-                }
-                else
-                {
-                    *reinterpret_cast<std::optional<std::uint32_t> *>(userData) = id;
-                }
-            },
-            &passthroughSink));
+            PulseApi::operation_unref(PulseApi::context_get_source_output_info(
+                context, index,
+                []([[maybe_unused]] pa_context *ctx, const pa_source_output_info *info, [[maybe_unused]] int eol,
+                   void *userData) { reinterpret_cast<PulseAudio *>(userData)->onSourceOutput(info); },
+                this));
+        }
+    }
+    void PulseAudio::onSinkInput(const pa_sink_input_info *info)
+    {
+        if (!info)
+        {
+            return;
+        }
 
-        await(PulseApi::context_load_module(
-            context, "module-loopback", "source=soundux_sink_passthrough.monitor source_dont_move=true",
-            []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
-                if (static_cast<int>(id) < 0)
-                {
-                    Fancy::fancy.logTime().failure() << "Failed to load passthrough loopback" << std::endl;
-                }
-                else
-                {
-                    *reinterpret_cast<std::optional<std::uint32_t> *>(userData) = id;
-                }
-            },
-            &passthroughLoopBack));
+        std::unique_lock lock(appMutex);
+        auto previous = playbackApps.find(info->index);
+
+        if (!isApplication(info->driver, info->proplist))
+        {
+            if (previous != playbackApps.end())
+            {
+                playbackApps.erase(previous);
+                lock.unlock();
+                onAppsChanged(Enums::AppType::Playback);
+            }
+            return;
+        }
+
+        auto app = makeApp<PulsePlaybackApp>(info);
+        app->sink = info->sink;
+
+        //* Most changes are volume changes, those are of no interest to the frontend
+        auto isNew = previous == playbackApps.end();
+        auto changed = isNew || !isSameApp(*previous->second, *app);
+
+        playbackApps[info->index] = std::move(app);
+        lock.unlock();
+
+        //* So that the icon is already there once the output picker is opened
+        if (isNew && Globals::gIcons)
+        {
+            prefetchIcon(info->proplist);
+        }
+        if (changed)
+        {
+            onAppsChanged(Enums::AppType::Playback);
+        }
+    }
+    void PulseAudio::onSourceOutput(const pa_source_output_info *info)
+    {
+        if (!info)
+        {
+            return;
+        }
+
+        std::unique_lock lock(appMutex);
+        auto previous = recordingApps.find(info->index);
+
+        if (!isApplication(info->driver, info->proplist) ||
+            (info->resample_method && std::strcmp(info->resample_method, "peaks") == 0))
+        {
+            if (previous != recordingApps.end())
+            {
+                recordingApps.erase(previous);
+                lock.unlock();
+                onAppsChanged(Enums::AppType::Recording);
+            }
+            return;
+        }
+
+        auto app = makeApp<PulseRecordingApp>(info);
+        app->source = info->source;
+
+        auto isNew = previous == recordingApps.end();
+        auto changed = isNew || !isSameApp(*previous->second, *app);
+
+        recordingApps[info->index] = std::move(app);
+        lock.unlock();
+
+        if (isNew && Globals::gIcons)
+        {
+            prefetchIcon(info->proplist);
+        }
+        if (changed)
+        {
+            onAppsChanged(Enums::AppType::Recording);
+        }
+    }
+    void PulseAudio::fetchApps()
+    {
+        await({PulseApi::context_get_sink_input_info_list(
+                   context,
+                   []([[maybe_unused]] pa_context *ctx, const pa_sink_input_info *info, [[maybe_unused]] int eol,
+                      void *userData) { reinterpret_cast<PulseAudio *>(userData)->onSinkInput(info); },
+                   this),
+               PulseApi::context_get_source_output_info_list(
+                   context,
+                   []([[maybe_unused]] pa_context *ctx, const pa_source_output_info *info, [[maybe_unused]] int eol,
+                      void *userData) { reinterpret_cast<PulseAudio *>(userData)->onSourceOutput(info); },
+                   this)});
+    }
+    bool PulseAudio::loadModules()
+    {
+        auto originalPlayback = getPlaybackApps();
+        auto originalRecording = getRecordingApps();
+
+        LoopLock lock(mainloop);
+
+        auto onLoaded = []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
+            if (static_cast<int>(id) >= 0)
+            {
+                *reinterpret_cast<std::optional<std::uint32_t> *>(userData) = id;
+            }
+        };
+
+        //* The server handles the requests of a connection in order, so the loopbacks see the null sinks that were
+        //* requested before them and everything is done in a single round trip
+        auto rate = "rate=" + std::to_string(sampleRate);
+        auto nullSinkArguments = rate + " sink_name=soundux_sink sink_properties=device.description=soundux_sink";
+        auto passthroughArguments =
+            rate + " sink_name=soundux_sink_passthrough sink_properties=device.description=soundux_sink_passthrough";
+        auto loopBackArguments =
+            rate + " source=" + defaultSource + " sink=soundux_sink sink_dont_move=true source_dont_move=true";
+        await({
+            PulseApi::context_load_module(context, "module-null-sink", nullSinkArguments.c_str(), onLoaded,
+                                          &nullSink),
+            PulseApi::context_load_module(context, "module-null-sink", passthroughArguments.c_str(), onLoaded,
+                                          &passthrough),
+            PulseApi::context_load_module(context, "module-loopback", loopBackArguments.c_str(), onLoaded, &loopBack),
+            PulseApi::context_load_module(context, "module-loopback",
+                                          "source=soundux_sink_passthrough.monitor sink=soundux_sink "
+                                          "source_dont_move=true",
+                                          onLoaded, &passthroughSink),
+            PulseApi::context_load_module(context, "module-loopback",
+                                          "source=soundux_sink_passthrough.monitor source_dont_move=true", onLoaded,
+                                          &passthroughLoopBack),
+        });
+
+        if (!nullSink)
+            Fancy::fancy.logTime().failure() << "Failed to load null sink" << std::endl;
+        if (!passthrough)
+            Fancy::fancy.logTime().failure() << "Failed to load passthrough null sink" << std::endl;
+        if (!loopBack)
+            Fancy::fancy.logTime().failure() << "Failed to load loopback" << std::endl;
+        if (!passthroughSink)
+            Fancy::fancy.logTime().failure() << "Failed to load passthrough sink" << std::endl;
+        if (!passthroughLoopBack)
+            Fancy::fancy.logTime().failure() << "Failed to load passthrough loopback" << std::endl;
 
         fetchLoopBackSinkId();
 
@@ -150,8 +347,8 @@ namespace Soundux::Objects
             return false;
         }
 
-        fixPlaybackApps(playbackApps);
-        fixRecordingApps(recordingApps);
+        fixPlaybackApps(originalPlayback);
+        fixRecordingApps(originalRecording);
 
         return true;
     }
@@ -161,26 +358,83 @@ namespace Soundux::Objects
         stopSoundInput();
         stopAllPassthrough();
 
-        if (nullSink)
-            await(PulseApi::context_unload_module(context, *nullSink, nullptr, nullptr));
-        if (loopBack)
-            await(PulseApi::context_unload_module(context, *loopBack, nullptr, nullptr));
-        if (loopBackSink)
-            await(PulseApi::context_unload_module(context, *loopBackSink, nullptr, nullptr));
+        {
+            LoopLock lock(mainloop);
+            std::vector<pa_operation *> operations;
+
+            for (const auto &module :
+                 {nullSink, loopBack, loopBackSink, passthrough, passthroughSink, passthroughLoopBack})
+            {
+                if (module)
+                {
+                    operations.emplace_back(PulseApi::context_unload_module(context, *module, nullptr, nullptr));
+                }
+            }
+
+            for (auto *operation : operations)
+            {
+                await(operation);
+            }
 
-        if (passthrough)
-            await(PulseApi::context_unload_module(context, *passthrough, nullptr, nullptr));
-        if (passthroughSink)
-            await(PulseApi::context_unload_module(context, *passthroughSink, nullptr, nullptr));
-        if (passthroughLoopBack)
-            await(PulseApi::context_unload_module(context, *passthroughLoopBack, nullptr, nullptr));
+        }
+
+        disconnect();
+    }
+    void PulseAudio::disconnect()
+    {
+        if (!mainloop)
+        {
+            return;
+        }
+
+        //* Stopping joins the mainloop thread, so no callback can run once the context is gone
+        PulseApi::threaded_mainloop_stop(mainloop);
+
+        if (context)
+        {
+            PulseApi::context_set_subscribe_callback(context, nullptr, nullptr);
+            PulseApi::context_set_state_callback(context, nullptr, nullptr);
+            PulseApi::context_disconnect(context);
+            PulseApi::context_unref(context);
+        }
+
+        PulseApi::threaded_mainloop_free(mainloop);
+
+        context = nullptr;
+        mainloop = nullptr;
+        mainloopApi = nullptr;
+    }
+    PulseAudio::~PulseAudio()
+    {
+        disconnect();
     }
     void PulseAudio::await(pa_operation *operation)
     {
-        std::lock_guard lock(operationMutex);
-        while (PulseApi::operation_get_state(operation) != PA_OPERATION_DONE)
+        if (!operation)
         {
-            PulseApi::mainloop_iterate(mainloop, true, nullptr);
+            return;
+        }
+
+        //* Callbacks of the operations do not know about the mainloop, so we wake up once the state changes instead
+        PulseApi::operation_set_state_callback(
+            operation,
+            []([[maybe_unused]] pa_operation *operation, void *userData) {
+                PulseApi::threaded_mainloop_signal(reinterpret_cast<pa_threaded_mainloop *>(userData), 0);
+            },
+            mainloop);
+
+        while (PulseApi::operation_get_state(operation) == PA_OPERATION_RUNNING)
+        {
+            PulseApi::threaded_mainloop_wait(mainloop);
+        }
+
+        PulseApi::operation_unref(operation);
+    }
+    void PulseAudio::await(std::initializer_list<pa_operation *> operations)
+    {
+        for (auto *operation : operations)
+        {
+            await(operation);
         }
     }
     void PulseAudio::fetchDefaultSource()
@@ -192,6 +446,7 @@ namespace Soundux::Objects
                 {
                     reinterpret_cast<PulseAudio *>(userData)->defaultSource = info->default_source_name;
                     reinterpret_cast<PulseAudio *>(userData)->serverName = info->server_name;
+                    reinterpret_cast<PulseAudio *>(userData)->sampleRate = info->sample_spec.rate;
                 }
             },
             this));
@@ -222,7 +477,8 @@ namespace Soundux::Objects
                     if (std::string(info->argument).find("soundux") != std::string::npos)
                     {
                         auto *thiz = reinterpret_cast<PulseAudio *>(userData);
-                        PulseApi::context_unload_module(thiz->context, info->index, nullptr, nullptr);
+                        PulseApi::operation_unref(
+                            PulseApi::context_unload_module(thiz->context, info->index, nullptr, nullptr));
                         Fancy::fancy.logTime().success() << "Unloaded left over module " << info->index << std::endl;
                     }
                 }
@@ -231,63 +487,43 @@ namespace Soundux::Objects
     }
     std::vector<std::shared_ptr<PlaybackApp>> PulseAudio::getPlaybackApps()
     {
+        std::lock_guard lock(appMutex);
+
         std::vector<std::shared_ptr<PlaybackApp>> rtn;
-        await(PulseApi::context_get_sink_input_info_list(
-            context,
-            []([[maybe_unused]] pa_context *ctx, const pa_sink_input_info *info, [[maybe_unused]] int eol,
-               void *userData) {
-                if (info && info->driver && std::strcmp(info->driver, "protocol-native.c") == 0)
-                {
-                    PulsePlaybackApp app;
-
-                    app.id = info->index;
-                    app.sink = info->sink;
-                    app.name = PulseApi::proplist_gets(info->proplist, "application.name");
-                    app.pid = std::stoi(PulseApi::proplist_gets(info->proplist, "application.process.id"));
-                    app.application = PulseApi::proplist_gets(info->proplist, "application.process.binary");
-                    reinterpret_cast<decltype(rtn) *>(userData)->emplace_back(std::make_shared<PulsePlaybackApp>(app));
-                }
-            },
-            &rtn));
+        rtn.reserve(playbackApps.size());
+
+        for (const auto &[id, app] : playbackApps)
+        {
+            rtn.emplace_back(app);
+        }
 
         return rtn;
     }
     std::vector<std::shared_ptr<RecordingApp>> PulseAudio::getRecordingApps()
     {
-        std::vector<std::shared_ptr<RecordingApp>> rtn;
-        await(PulseApi::context_get_source_output_info_list(
-            context,
-            []([[maybe_unused]] pa_context *ctx, const pa_source_output_info *info, [[maybe_unused]] int eol,
-               void *userData) {
-                if (info && info->driver && std::strcmp(info->driver, "protocol-native.c") == 0)
-                {
-                    if (info->resample_method && std::strcmp(info->resample_method, "peaks") == 0)
-                    {
-                        return;
-                    }
+        std::lock_guard lock(appMutex);
 
-                    PulseRecordingApp app;
+        std::vector<std::shared_ptr<RecordingApp>> rtn;
+        rtn.reserve(recordingApps.size());
 
-                    app.id = info->index;
-                    app.source = info->source;
-                    app.name = PulseApi::proplist_gets(info->proplist, "application.name");
-                    app.pid = std::stoi(PulseApi::proplist_gets(info->proplist, "application.process.id"));
-                    app.application = PulseApi::proplist_gets(info->proplist, "application.process.binary");
-                    reinterpret_cast<decltype(rtn) *>(userData)->emplace_back(std::make_shared<PulseRecordingApp>(app));
-                }
-            },
-            &rtn));
+        for (const auto &[id, app] : recordingApps)
+        {
+            rtn.emplace_back(app);
+        }
 
         return rtn;
     }
     bool PulseAudio::useAsDefault()
     {
+        LoopLock lock(mainloop);
+
         if (!defaultSource.empty())
         {
             await(PulseApi::context_unload_module(context, *loopBack, nullptr, nullptr));
 
             await(PulseApi::context_load_module(
-                context, "module-loopback", ("rate=44100 source=" + defaultSource + " sink=soundux_sink").c_str(),
+                context, "module-loopback",
+                ("rate=" + std::to_string(sampleRate) + " source=" + defaultSource + " sink=soundux_sink").c_str(),
                 []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
                     if (static_cast<int>(id) < 0)
                     {
@@ -328,6 +564,8 @@ namespace Soundux::Objects
     }
     bool PulseAudio::revertDefault()
     {
+        LoopLock lock(mainloop);
+
         if (!defaultSource.empty() && loopBack)
         {
             await(PulseApi::context_unload_module(context, *loopBack, nullptr, nullptr));
@@ -336,7 +574,8 @@ namespace Soundux::Objects
 
             await(PulseApi::context_load_module(
                 context, "module-loopback",
-                ("rate=44100 source=" + defaultSource + " sink=soundux_sink sink_dont_move=true source_dont_move=true")
+                ("rate=" + std::to_string(sampleRate) + " source=" + defaultSource +
+                 " sink=soundux_sink sink_dont_move=true source_dont_move=true")
                     .c_str(),
                 []([[maybe_unused]] pa_context *m, std::uint32_t id, void *userData) {
                     auto *pair = reinterpret_cast<decltype(result) *>(userData);
@@ -370,6 +609,8 @@ namespace Soundux::Objects
     }
     bool PulseAudio::passthroughFrom(std::shared_ptr<PlaybackApp> app)
     {
+        LoopLock lock(mainloop);
+
         if (movedPassthroughApplications.count(app->application))
         {
             Fancy::fancy.logTime().message()
@@ -415,6 +656,8 @@ namespace Soundux::Objects
     }
     bool PulseAudio::stopAllPassthrough()
     {
+        LoopLock lock(mainloop);
+
         bool success = true;
         for (const auto &[movedAppBinary, originalSource] : movedPassthroughApplications)
         {
@@ -447,6 +690,8 @@ namespace Soundux::Objects
     }
     bool PulseAudio::stopPassthrough(const std::string &app)
     {
+        LoopLock lock(mainloop);
+
         if (movedPassthroughApplications.find(app) != movedPassthroughApplications.end())
         {
             bool success = true;
@@ -481,6 +726,8 @@ namespace Soundux::Objects
     }
     bool PulseAudio::inputSoundTo(std::shared_ptr<RecordingApp> app)
     {
+        LoopLock lock(mainloop);
+
         if (!app)
         {
             Fancy::fancy.logTime().warning() << "Tried to input sound to non existant app" << std::endl;
@@ -522,6 +769,8 @@ namespace Soundux::Objects
     }
     bool PulseAudio::stopSoundInput()
     {
+        LoopLock lock(mainloop);
+
         bool success = true;
 
         for (const auto &[movedAppBinary, originalSink] : movedApplications)
@@ -627,6 +876,8 @@ namespace Soundux::Objects
     }
     bool PulseAudio::muteInput(bool state)
     {
+        LoopLock lock(mainloop);
+
         bool success = false;
 
         await(PulseApi::context_set_sink_input_mute(
@@ -647,19 +898,23 @@ namespace Soundux::Objects
     bool PulseAudio::switchOnConnectPresent()
     {
         bool isPresent = false;
-        await(PulseApi::context_get_module_info_list(
-            context,
-            []([[maybe_unused]] pa_context *ctx, const pa_module_info *info, [[maybe_unused]] int eol, void *userData) {
-                if (info && info->name)
-                {
-                    if (std::string(info->name).find("switch-on-connect") != std::string::npos)
+        {
+            LoopLock lock(mainloop);
+            await(PulseApi::context_get_module_info_list(
+                context,
+                []([[maybe_unused]] pa_context *ctx, const pa_module_info *info, [[maybe_unused]] int eol,
+                   void *userData) {
+                    if (info && info->name)
                     {
-                        *reinterpret_cast<bool *>(userData) = true;
-                        Fancy::fancy.logTime().warning() << "Switch on connect found: " << info->index << std::endl;
+                        if (std::string(info->name).find("switch-on-connect") != std::string::npos)
+                        {
+                            *reinterpret_cast<bool *>(userData) = true;
+                            Fancy::fancy.logTime().warning() << "Switch on connect found: " << info->index << std::endl;
+                        }
                     }
-                }
-            },
-            &isPresent));
+                },
+                &isPresent));
+        }
 
         if (isPresent)
         {
@@ -674,25 +929,32 @@ namespace Soundux::Objects
 
     void PulseAudio::unloadSwitchOnConnect()
     {
-        await(PulseApi::context_get_module_info_list(
-            context,
-            []([[maybe_unused]] pa_context *ctx, const pa_module_info *info, [[maybe_unused]] int eol,
-               [[maybe_unused]] void *userData) {
-                if (info && info->name)
-                {
-                    if (std::string(info->name).find("switch-on-connect") != std::string::npos)
+        bool unloaded = false;
+        {
+            LoopLock lock(mainloop);
+            await(PulseApi::context_get_module_info_list(
+                context,
+                []([[maybe_unused]] pa_context *ctx, const pa_module_info *info, [[maybe_unused]] int eol,
+                   void *userData) {
+                    if (info && info->name)
                     {
-                        Fancy::fancy.logTime().message() << "Unloading: " << info->index << std::endl;
-                        PulseApi::context_unload_module(ctx, info->index, nullptr, nullptr);
-
-                        if (Globals::gGui)
+                        if (std::string(info->name).find("switch-on-connect") != std::string::npos)
                         {
-                            Globals::gGui->onSwitchOnConnectDetected(false);
+                            Fancy::fancy.logTime().message() << "Unloading: " << info->index << std::endl;
+                            PulseApi::operation_unref(
+                                PulseApi::context_unload_module(ctx, info->index, nullptr, nullptr));
+                            *reinterpret_cast<bool *>(userData) = true;
                         }
                     }
-                }
-            },
-            nullptr));
+                },
+                &unloaded));
+        }
+
+        //* The callbacks run on the mainloop thread, the gui is notified from ours
+        if (unloaded && Globals::gGui)
+        {
+            Globals::gGui->onSwitchOnConnectDetected(false);
+        }
     }
     bool PulseAudio::isRunningPipeWire()
     {
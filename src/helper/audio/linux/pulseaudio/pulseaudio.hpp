@@ -1,6 +1,7 @@
 #if defined(__linux__)
 #include "../backend.hpp"
 #include "forward.hpp"
+#include <initializer_list>
 #include <map>
 #include <mutex>
 #include <optional>
@@ -12,7 +13,6 @@ namespace Soundux
         struct PulsePlaybackApp : public PlaybackApp
         {
             std::uint32_t id;
-            std::uint32_t pid;
             std::uint32_t sink;
 
             ~PulsePlaybackApp() override = default;
@@ -21,7 +21,6 @@ namespace Soundux
         struct PulseRecordingApp : public RecordingApp
         {
             std::uint32_t id;
-            std::uint32_t pid;
             std::uint32_t source;
 
             ~PulseRecordingApp() override = default;
@@ -32,9 +31,9 @@ namespace Soundux
             friend class AudioBackend;
 
           private:
-            pa_context *context;
-            pa_mainloop *mainloop;
-            pa_mainloop_api *mainloopApi;
+            pa_context *context = nullptr;
+            pa_threaded_mainloop *mainloop = nullptr;
+            pa_mainloop_api *mainloopApi = nullptr;
 
             //* ~= The modules we create =~
             std::optional<std::uint32_t> nullSink;
@@ -48,16 +47,35 @@ namespace Soundux
 
             std::string serverName;
             std::string defaultSource;
+            //* The default rate of the server, our sinks use it so that the server does not have to resample
+            std::uint32_t sampleRate = 44100;
 
             std::map<std::string, std::uint32_t> movedApplications;
             std::map<std::string, std::uint32_t> movedPassthroughApplications;
 
-            std::mutex operationMutex;
+            //* Kept up to date by the subscription, so that the apps can be listed without a round trip
+            std::mutex appMutex;
+            std::map<std::uint32_t, std::shared_ptr<PulsePlaybackApp>> playbackApps;
+            std::map<std::uint32_t, std::shared_ptr<PulseRecordingApp>> recordingApps;
 
+            //* Everything below expects the mainloop to be locked
             void unloadLeftOvers();
             void fetchDefaultSource();
             void fetchLoopBackSinkId();
+            void fetchApps();
+
+            void onSinkInput(const pa_sink_input_info *);
+            void onSourceOutput(const pa_source_output_info *);
+            void onSubscriptionEvent(pa_subscription_event_type_t, std::uint32_t);
+
             void await(pa_operation *);
+            //* The operations are already issued, so they are processed by the server back to back
+            void await(std::initializer_list<pa_operation *>);
+
+            //* Connects the context and subscribes to it, fails on pipewire-pulse before anything is changed
+            bool connect();
+            //* Disconnects and frees the context and mainloop, has to be called without holding the lock
+            void disconnect();
 
             void fixPlaybackApps(const std::vector<std::shared_ptr<PlaybackApp>> &);
             void fixRecordingApps(const std::vector<std::shared_ptr<RecordingApp>> &);
@@ -66,6 +84,8 @@ namespace Soundux
             bool setup() override;
 
           public:
+            ~PulseAudio() override;
+
             //! Is not ran by default to avoid problems with switch-on-connect
             bool loadModules();
 
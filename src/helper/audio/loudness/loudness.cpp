@@ -0,0 +1,201 @@
+#include "loudness.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Soundux::Objects
+{
+    static constexpr double pi = 3.14159265358979323846;
+
+    LoudnessMeter::LoudnessMeter(std::uint32_t channels, std::uint32_t sampleRate)
+        : channels(channels), stepSize(std::max<std::uint64_t>(sampleRate / 10, 1))
+    {
+        //* The K-weighting filters of BS.1770 are specified for 48kHz, these are the analog prototypes they were
+        //* derived from so that they can be used at any rate
+        {
+            auto K = std::tan(pi * 1681.974450955533 / sampleRate);
+            auto Q = 0.7071752369554196;
+            auto Vh = std::pow(10., 3.999843853973347 / 20.);
+            auto Vb = std::pow(Vh, 0.4996667741545416);
+            auto a0 = 1. + K / Q + K * K;
+
+            shelf = {(Vh + Vb * K / Q + K * K) / a0, 2. * (K * K - Vh) / a0, (Vh - Vb * K / Q + K * K) / a0,
+                     2. * (K * K - 1.) / a0, (1. - K / Q + K * K) / a0};
+        }
+        {
+            auto K = std::tan(pi * 38.13547087602444 / sampleRate);
+            auto Q = 0.5003270373238773;
+            auto a0 = 1. + K / Q + K * K;
+
+            highPass = {1., -2., 1., 2. * (K * K - 1.) / a0, (1. - K / Q + K * K) / a0};
+        }
+
+        //* Surround channels are weighted by +1.5dB and the LFE channel is not counted at all
+        if (channels == 5 || channels == 6)
+        {
+            auto lfe = channels == 6 ? 1 : 0;
+            this->channels[3].weight = lfe ? 0. : 1.41;
+            this->channels[3 + lfe].weight = 1.41;
+            this->channels[4 + lfe].weight = 1.41;
+        }
+
+        //* Windowed sinc interpolation between the two samples in the middle of the history
+        for (std::size_t phase = 0; oversampling > phase; phase++)
+        {
+            float sum = 0;
+            for (std::size_t tap = 0; taps > tap; tap++)
+            {
+                auto x = static_cast<double>(tap) - static_cast<double>(taps / 2 - 1) -
+                         static_cast<double>(phase) / oversampling;
+                auto sinc = x == 0 ? 1. : std::sin(pi * x) / (pi * x);
+                auto window = .42 + .5 * std::cos(pi * x / (taps / 2.)) + .08 * std::cos(2. * pi * x / (taps / 2.));
+
+                phases[phase][tap] = static_cast<float>(sinc * window);
+                sum += phases[phase][tap];
+            }
+            for (auto &coefficient : phases[phase])
+            {
+                coefficient /= sum;
+            }
+        }
+    }
+    float LoudnessMeter::interpolate(const Channel &channel) const
+    {
+        float rtn = 0;
+        for (std::size_t phase = 1; oversampling > phase; phase++)
+        {
+            float value = 0;
+            for (std::size_t tap = 0; taps > tap; tap++)
+            {
+                value += phases[phase][tap] * channel.history[(channel.position + tap) % taps];
+            }
+            rtn = std::max(rtn, std::abs(value));
+        }
+
+        return rtn;
+    }
+    void LoudnessMeter::process(const float *frames, std::uint64_t count)
+    {
+        for (std::uint64_t frame = 0; count > frame; frame++)
+        {
+            for (std::size_t i = 0; channels.size() > i; i++)
+            {
+                auto &channel = channels[i];
+                auto sample = frames[frame * channels.size() + i];
+
+                channel.history[channel.position] = sample;
+                channel.position = (channel.position + 1) % taps;
+                peak = std::max({peak, std::abs(sample), interpolate(channel)});
+
+                //* Transposed direct form II
+                double x = sample;
+                auto y = shelf.b0 * x + channel.shelf[0];
+                channel.shelf[0] = shelf.b1 * x - shelf.a1 * y + channel.shelf[1];
+                channel.shelf[1] = shelf.b2 * x - shelf.a2 * y;
+
+                x = y;
+                y = highPass.b0 * x + channel.highPass[0];
+                channel.highPass[0] = highPass.b1 * x - highPass.a1 * y + channel.highPass[1];
+                channel.highPass[1] = highPass.b2 * x - highPass.a2 * y;
+
+                channel.energy += y * y;
+            }
+
+            if (++stepFrames == stepSize)
+            {
+                finishStep();
+            }
+        }
+    }
+    void LoudnessMeter::finishStep()
+    {
+        double energy = 0;
+        for (auto &channel : channels)
+        {
+            energy += channel.weight * channel.energy;
+            channel.energy = 0;
+        }
+
+        steps[stepCount % steps.size()] = energy / static_cast<double>(stepSize);
+        stepFrames = 0;
+        stepCount++;
+
+        if (stepCount >= steps.size())
+        {
+            double sum = 0;
+            for (const auto &step : steps)
+            {
+                sum += step;
+            }
+            blocks.emplace_back(sum / static_cast<double>(steps.size()));
+        }
+    }
+    static double toLufs(double energy)
+    {
+        return -0.691 + 10. * std::log10(energy);
+    }
+    std::optional<double> LoudnessMeter::getIntegrated() const
+    {
+        if (blocks.empty())
+        {
+            auto frames = stepCount * stepSize + stepFrames;
+            double energy = 0;
+
+            for (std::size_t i = 0; stepCount > i; i++)
+            {
+                energy += steps[i] * static_cast<double>(stepSize);
+            }
+            for (const auto &channel : channels)
+            {
+                energy += channel.weight * channel.energy;
+            }
+
+            if (frames == 0 || energy <= 0)
+            {
+                return std::nullopt;
+            }
+
+            energy /= static_cast<double>(frames);
+            if (toLufs(energy) <= absoluteGate)
+            {
+                return std::nullopt;
+            }
+
+            return toLufs(energy);
+        }
+
+        auto gated = [this](double threshold) -> std::optional<double> {
+            double sum = 0;
+            std::size_t count = 0;
+
+            for (const auto &block : blocks)
+            {
+                if (block > 0 && toLufs(block) > threshold)
+                {
+                    sum += block;
+                    count++;
+                }
+            }
+
+            if (count == 0)
+            {
+                return std::nullopt;
+            }
+
+            return sum / static_cast<double>(count);
+        };
+
+        auto absolute = gated(absoluteGate);
+        if (!absolute)
+        {
+            return std::nullopt;
+        }
+
+        auto relative = gated(std::max(absoluteGate, toLufs(*absolute) + relativeGate));
+        return toLufs(relative ? *relative : *absolute);
+    }
+    double LoudnessMeter::getTruePeak() const
+    {
+        //* Silence would be -inf, which does not survive a round trip through json
+        return 20. * std::log10(std::max(static_cast<double>(peak), 1e-9));
+    }
+} // namespace Soundux::Objects
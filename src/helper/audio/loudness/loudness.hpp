@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Integrated loudness (EBU R128 / ITU-R BS.1770-4) and true peak of a whole clip, fed block by block
+        class LoudnessMeter
+        {
+          public:
+            //* Below this a block does not count towards the integrated loudness
+            static constexpr double absoluteGate = -70;
+            //* ...and neither do blocks this far below the loudness of the blocks that passed the absolute gate
+            static constexpr double relativeGate = -10;
+
+          private:
+            struct Biquad
+            {
+                double b0, b1, b2, a1, a2;
+            };
+            struct Channel
+            {
+                double weight = 1;
+                //* State of the two K-weighting stages
+                std::array<double, 2> shelf{};
+                std::array<double, 2> highPass{};
+                double energy = 0;
+
+                //* The last samples, for the interpolation of the true peak
+                std::array<float, 12> history{};
+                std::size_t position = 0;
+            };
+
+            static constexpr std::size_t oversampling = 4;
+            static constexpr std::size_t taps = 12;
+
+            Biquad shelf{};
+            Biquad highPass{};
+            std::array<std::array<float, taps>, oversampling> phases{};
+
+            std::vector<Channel> channels;
+
+            //* Frames per 100ms step, a gating block is made of the last four steps
+            std::uint64_t stepSize;
+            std::uint64_t stepFrames = 0;
+            std::uint64_t stepCount = 0;
+            std::array<double, 4> steps{};
+            //* Mean square of every 400ms block, the blocks overlap by 75%
+            std::vector<double> blocks;
+
+            float peak = 0;
+
+            void finishStep();
+            float interpolate(const Channel &) const;
+
+          public:
+            LoudnessMeter(std::uint32_t channels, std::uint32_t sampleRate);
+
+            //* `frames` are interleaved
+            void process(const float *frames, std::uint64_t count);
+
+            //* In LUFS, empty if no block passed the gates. Clips shorter than one block are measured as a whole.
+            std::optional<double> getIntegrated() const;
+            //* In dBTP
+            double getTruePeak() const;
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -0,0 +1,219 @@
+#include "mapping.hpp"
+#include <algorithm>
+#include <fancy.hpp>
+
+#if defined(__linux__)
+#include <array>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#include <array>
+#include <helper/misc/misc.hpp>
+#endif
+
+namespace Soundux::Objects
+{
+#if defined(__linux__)
+    //* Network and FUSE filesystems report I/O errors through SIGBUS, so only these are trusted
+    static bool isLocalFilesystem(int fd)
+    {
+        static constexpr std::array<decltype(statfs::f_type), 8> local = {
+            0xEF53,     // ext2/3/4
+            0x58465342, // xfs
+            0x9123683E, // btrfs
+            0xF2F52010, // f2fs
+            0x2FC12FC1, // zfs
+            0xCA451A4E, // bcachefs
+            0x01021994, // tmpfs
+            0x3153464A, // jfs
+        };
+
+        struct statfs info
+        {
+        };
+        if (fstatfs(fd, &info) != 0)
+        {
+            return false;
+        }
+
+        return std::find(local.begin(), local.end(), info.f_type) != local.end();
+    }
+    bool MappedFile::map(const std::string &path)
+    {
+        auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info
+        {
+        };
+        if (fstat(fd, &info) != 0 || info.st_size <= 0 || !isLocalFilesystem(fd))
+        {
+            close(fd);
+            return false;
+        }
+
+        auto length = static_cast<std::size_t>(info.st_size);
+        auto *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (view == MAP_FAILED) // NOLINT
+        {
+            Fancy::fancy.logTime().warning() << "Failed to map " << path << ": " << errno << std::endl;
+            return false;
+        }
+
+        //* Starts reading the whole file in the background so that the decoder does not wait on a slow disk
+        madvise(view, length, MADV_WILLNEED);
+
+        data = view;
+        size = length;
+
+        return true;
+    }
+    MappedFile::~MappedFile()
+    {
+        if (data)
+        {
+            munmap(const_cast<void *>(data), size);
+        }
+    }
+#elif defined(_WIN32)
+    static bool isLocalDrive(const std::wstring &path)
+    {
+        std::array<wchar_t, MAX_PATH + 1> volume{};
+        if (!GetVolumePathNameW(path.c_str(), volume.data(), static_cast<DWORD>(volume.size())))
+        {
+            return false;
+        }
+
+        auto type = GetDriveTypeW(volume.data());
+        return type == DRIVE_FIXED || type == DRIVE_RAMDISK;
+    }
+    bool MappedFile::map(const std::string &path)
+    {
+        auto widePath = Helpers::widen(path);
+        if (!isLocalDrive(widePath))
+        {
+            return false;
+        }
+
+        auto *file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) // NOLINT
+        {
+            return false;
+        }
+
+        LARGE_INTEGER length{};
+        if (!GetFileSizeEx(file, &length) || length.QuadPart <= 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        auto *mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+
+        if (!mapping)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to map " << path << ": " << GetLastError() << std::endl;
+            return false;
+        }
+
+        //* The view keeps the mapping alive
+        auto *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+
+        if (!view)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to map " << path << ": " << GetLastError() << std::endl;
+            return false;
+        }
+
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+        //* Same as MADV_WILLNEED
+        WIN32_MEMORY_RANGE_ENTRY range{view, static_cast<SIZE_T>(length.QuadPart)};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+
+        data = view;
+        size = static_cast<std::size_t>(length.QuadPart);
+
+        return true;
+    }
+    MappedFile::~MappedFile()
+    {
+        if (data)
+        {
+            UnmapViewOfFile(data);
+        }
+    }
+#endif
+    std::shared_ptr<const MappedFile> MappedFile::open(const std::string &path)
+    {
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+        if (ec)
+        {
+            return nullptr;
+        }
+
+        auto rtn = std::shared_ptr<MappedFile>(new MappedFile()); // NOLINT
+        if (!rtn->map(path))
+        {
+            return nullptr;
+        }
+
+        rtn->modified = modified;
+        return rtn;
+    }
+    const void *MappedFile::getData() const
+    {
+        return data;
+    }
+    std::size_t MappedFile::getSize() const
+    {
+        return size;
+    }
+    std::filesystem::file_time_type MappedFile::getModified() const
+    {
+        return modified;
+    }
+
+    std::shared_ptr<const MappedFile> FileMappings::get(const std::string &path)
+    {
+        std::lock_guard lock(mutex);
+
+        if (auto existing = mappings.find(path); existing != mappings.end())
+        {
+            std::error_code ec;
+            auto modified = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+
+            if (auto mapping = existing->second.lock(); mapping && !ec && mapping->getModified() == modified)
+            {
+                return mapping;
+            }
+        }
+
+        //* Drop what nobody plays from anymore, so the map does not grow with every sound that was ever played
+        for (auto it = mappings.begin(); it != mappings.end();)
+        {
+            it = it->second.expired() ? mappings.erase(it) : std::next(it);
+        }
+
+        auto mapping = MappedFile::open(path);
+        if (mapping)
+        {
+            mappings[path] = mapping;
+        }
+
+        return mapping;
+    }
+} // namespace Soundux::Objects
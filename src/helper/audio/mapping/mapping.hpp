@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Read-only view of a whole file, decoders read straight from the page cache without any syscalls.
+        //! Reading a page that can not be loaded anymore raises SIGBUS (EXCEPTION_IN_PAGE_ERROR on windows), which
+        //! happens if the file is truncated or a network share goes away while it is mapped. Only files on local disks
+        //! are mapped for that reason, a file that is truncated while a sound plays from it can still crash.
+        class MappedFile
+        {
+            const void *data = nullptr;
+            std::size_t size = 0;
+            std::filesystem::file_time_type modified;
+
+            MappedFile() = default;
+            bool map(const std::string &path);
+
+          public:
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+            ~MappedFile();
+
+            //* Returns nullptr if the file can not or should not be mapped, the caller should fall back to reading it
+            static std::shared_ptr<const MappedFile> open(const std::string &path);
+
+            const void *getData() const;
+            std::size_t getSize() const;
+            //* Modification time of the file at the time it was mapped
+            std::filesystem::file_time_type getModified() const;
+        };
+
+        //* Hands out one mapping per file for as long as any sound still plays from it
+        class FileMappings
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::weak_ptr<const MappedFile>> mappings;
+
+          public:
+            //* A mapping is only reused while the file was not changed since
+            std::shared_ptr<const MappedFile> get(const std::string &path);
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -0,0 +1,265 @@
+#include "metadata.hpp"
+#include <core/config/config.hpp>
+#include <core/global/globals.hpp>
+#include <core/objects/objects.hpp>
+#include <fancy.hpp>
+#include <filesystem>
+#include <fstream>
+#include <helper/audio/loudness/loudness.hpp>
+#include <helper/audio/waveform/waveform.hpp>
+#include <helper/json/bindings.hpp>
+#include <helper/misc/misc.hpp>
+#include <miniaudio.h>
+
+namespace Soundux::Objects
+{
+    std::string MetadataIndex::getPath()
+    {
+        return (std::filesystem::path(Config::path).parent_path() / "metadata.json").u8string();
+    }
+    std::optional<Metadata> MetadataIndex::read(const Sound &sound)
+    {
+        ma_decoder decoder;
+        auto config = ma_decoder_config_init(ma_format_f32, 0, 0);
+
+#if defined(_WIN32)
+        auto res = ma_decoder_init_file_w(Helpers::widen(sound.path).c_str(), &config, &decoder);
+#else
+        auto res = ma_decoder_init_file(sound.path.c_str(), &config, &decoder);
+#endif
+
+        if (res != MA_SUCCESS)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to read metadata of " << sound.path << std::endl;
+            return std::nullopt;
+        }
+
+        Metadata metadata;
+        metadata.modifiedDate = sound.modifiedDate;
+        metadata.channels = decoder.outputChannels;
+        metadata.sampleRate = decoder.outputSampleRate;
+
+        ma_uint64 length{};
+        ma_decoder_get_length_in_pcm_frames(&decoder, &length);
+        ma_decoder_uninit(&decoder);
+
+        metadata.length = length;
+        if (metadata.sampleRate > 0)
+        {
+            metadata.lengthInMs = static_cast<std::uint64_t>(static_cast<double>(metadata.length) /
+                                                             static_cast<double>(metadata.sampleRate) * 1000);
+        }
+
+        return metadata;
+    }
+    std::optional<Metadata> MetadataIndex::get(const Sound &sound)
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = entries.find(sound.path); it != entries.end() && it->second.modifiedDate == sound.modifiedDate)
+        {
+            return it->second;
+        }
+
+        return std::nullopt;
+    }
+    void MetadataIndex::index(const std::vector<Sound> &sounds)
+    {
+        for (const auto &sound : sounds)
+        {
+            if (get(sound))
+            {
+                continue;
+            }
+
+            if (auto metadata = read(sound); metadata)
+            {
+                std::lock_guard lock(mutex);
+                entries[sound.path] = *metadata;
+                dirty = true;
+            }
+        }
+
+        analyze(sounds);
+    }
+    void MetadataIndex::analyze(const std::vector<Sound> &sounds)
+    {
+        {
+            std::lock_guard lock(analyzeMutex);
+            for (const auto &sound : sounds)
+            {
+                if (auto metadata = get(sound); !metadata || !metadata->analyzed || !metadata->hasWaveform)
+                {
+                    if (queued.emplace(sound.path).second)
+                    {
+                        analyzeQueue.emplace_back(sound);
+                    }
+                }
+            }
+        }
+
+        analyzeCv.notify_one();
+    }
+    bool MetadataIndex::measure(const Sound &sound, Metadata &metadata)
+    {
+        ma_decoder decoder;
+        auto config = ma_decoder_config_init(ma_format_f32, 0, 0);
+
+#if defined(_WIN32)
+        auto res = ma_decoder_init_file_w(Helpers::widen(sound.path).c_str(), &config, &decoder);
+#else
+        auto res = ma_decoder_init_file(sound.path.c_str(), &config, &decoder);
+#endif
+
+        if (res != MA_SUCCESS)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to analyze loudness of " << sound.path << std::endl;
+            //* There is no point in trying again until the file changes
+            metadata.analyzed = true;
+            metadata.hasWaveform = true;
+            return true;
+        }
+
+        LoudnessMeter meter(decoder.outputChannels, decoder.outputSampleRate);
+        WaveformBuilder waveform(metadata.length, decoder.outputChannels);
+
+        constexpr ma_uint64 chunk = 4096;
+        std::vector<float> buffer(chunk * decoder.outputChannels);
+
+        while (!stop)
+        {
+            ma_uint64 readFrames{};
+            ma_data_source_read_pcm_frames(&decoder, buffer.data(), chunk, &readFrames);
+            meter.process(buffer.data(), readFrames);
+            waveform.process(buffer.data(), readFrames);
+
+            if (readFrames < chunk)
+            {
+                break;
+            }
+        }
+
+        ma_decoder_uninit(&decoder);
+        if (stop)
+        {
+            return false;
+        }
+
+        metadata.analyzed = true;
+        metadata.hasWaveform = waveform.finish().save(sound);
+
+        if (auto loudness = meter.getIntegrated(); loudness)
+        {
+            metadata.loudness = static_cast<float>(*loudness);
+            metadata.truePeak = static_cast<float>(meter.getTruePeak());
+        }
+
+        return true;
+    }
+    void MetadataIndex::runAnalyzer()
+    {
+        Helpers::lowerThreadPriority();
+
+        while (true)
+        {
+            std::optional<Sound> sound;
+            {
+                std::unique_lock lock(analyzeMutex);
+                analyzeCv.wait(lock, [this] { return !analyzeQueue.empty() || stop; });
+
+                if (stop)
+                {
+                    break;
+                }
+
+                sound = std::move(analyzeQueue.front());
+                analyzeQueue.pop_front();
+                queued.erase(sound->path);
+            }
+
+            auto metadata = get(*sound);
+            if (metadata && metadata->analyzed && metadata->hasWaveform)
+            {
+                continue;
+            }
+            if (!metadata && !(metadata = read(*sound)))
+            {
+                continue;
+            }
+
+            if (!measure(*sound, *metadata))
+            {
+                break;
+            }
+
+            std::lock_guard lock(mutex);
+            entries[sound->path] = *metadata;
+            dirty = true;
+        }
+    }
+    void MetadataIndex::setup()
+    {
+        analyzer = std::thread([this] { runAnalyzer(); });
+    }
+    void MetadataIndex::destroy()
+    {
+        {
+            //* Locked so that the analyzer can not miss the notification between checking `stop` and waiting
+            std::lock_guard lock(analyzeMutex);
+            stop = true;
+        }
+
+        analyzeCv.notify_all();
+        if (analyzer.joinable())
+        {
+            analyzer.join();
+        }
+    }
+    void MetadataIndex::load()
+    {
+        try
+        {
+            auto path = getPath();
+            if (!std::filesystem::exists(path))
+            {
+                return;
+            }
+
+            std::ifstream stream(path);
+            auto json = nlohmann::json::parse(stream, nullptr, false);
+
+            if (json.is_discarded())
+            {
+                Fancy::fancy.logTime().warning() << "Metadata index seems corrupted, it will be rebuilt" << std::endl;
+                return;
+            }
+
+            std::lock_guard lock(mutex);
+            entries = json.get<std::unordered_map<std::string, Metadata>>();
+        }
+        catch (const std::exception &e)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to read metadata index: " << e.what() << std::endl;
+        }
+    }
+    void MetadataIndex::save()
+    {
+        if (!dirty)
+        {
+            return;
+        }
+
+        try
+        {
+            std::lock_guard lock(mutex);
+
+            if (Helpers::writeFileAtomically(getPath(), nlohmann::json(entries).dump()))
+            {
+                dirty = false;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to write metadata index: " << e.what() << std::endl;
+        }
+    }
+} // namespace Soundux::Objects
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        struct Sound;
+
+        //* Native format and length of a file, as reported by the decoder
+        struct Metadata
+        {
+            std::uint64_t modifiedDate = 0;
+
+            std::uint32_t channels = 0;
+            std::uint32_t sampleRate = 0;
+            std::uint64_t length = 0;
+            std::uint64_t lengthInMs = 0;
+
+            //* Set once the whole file was decoded, `loudness` stays empty for silent files
+            bool analyzed = false;
+            //* Whether `Waveform::save` succeeded, entries analyzed before waveforms existed are analyzed again
+            bool hasWaveform = false;
+            //* Integrated loudness in LUFS and true peak in dBTP
+            std::optional<float> loudness;
+            std::optional<float> truePeak;
+        };
+
+        //* Persistent cache of `Metadata` keyed by path, an entry is only valid as long as the modification date matches.
+        //* Filled from the background after a tab was scanned, so that playing a sound never needs a length scan.
+        class MetadataIndex
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string, Metadata> entries;
+            std::atomic<bool> dirty = false;
+
+            std::thread analyzer;
+            std::mutex analyzeMutex;
+            std::condition_variable analyzeCv;
+            std::deque<Sound> analyzeQueue;
+            //* Paths of the queued sounds
+            std::unordered_set<std::string> queued;
+            std::atomic<bool> stop = false;
+
+            static std::optional<Metadata> read(const Sound &);
+            //* Measures the loudness and stores the waveform. Decodes the whole file, so it only runs on the low
+            //* priority analyzer thread. Returns false if it was interrupted by `destroy`.
+            bool measure(const Sound &, Metadata &);
+            void runAnalyzer();
+
+          public:
+            static std::string getPath();
+
+            std::optional<Metadata> get(const Sound &);
+            //* Decodes the header of every sound that is not indexed yet and queues their analysis
+            void index(const std::vector<Sound> &);
+            //* Measures the loudness and computes the waveform of every sound that was not analyzed yet in the
+            //* background
+            void analyze(const std::vector<Sound> &);
+
+            void setup();
+            void destroy();
+
+            void load();
+            void save();
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -0,0 +1,156 @@
+#include "kernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOUNDUX_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SOUNDUX_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Soundux::Objects::Kernels
+{
+    static void mixConstant(float *target, const float *source, std::size_t samples, float gain)
+    {
+        std::size_t i = 0;
+#if defined(SOUNDUX_SSE2)
+        auto factor = _mm_set1_ps(gain);
+        for (; samples >= i + 8; i += 8)
+        {
+            auto first = _mm_add_ps(_mm_loadu_ps(target + i), _mm_mul_ps(_mm_loadu_ps(source + i), factor));
+            auto second = _mm_add_ps(_mm_loadu_ps(target + i + 4), _mm_mul_ps(_mm_loadu_ps(source + i + 4), factor));
+            _mm_storeu_ps(target + i, first);
+            _mm_storeu_ps(target + i + 4, second);
+        }
+#elif defined(SOUNDUX_NEON)
+        auto factor = vdupq_n_f32(gain);
+        for (; samples >= i + 8; i += 8)
+        {
+            vst1q_f32(target + i, vmlaq_f32(vld1q_f32(target + i), vld1q_f32(source + i), factor));
+            vst1q_f32(target + i + 4, vmlaq_f32(vld1q_f32(target + i + 4), vld1q_f32(source + i + 4), factor));
+        }
+#endif
+        for (; samples > i; i++)
+        {
+            target[i] += source[i] * gain;
+        }
+    }
+    static void mixRamp(float *target, const float *source, std::size_t samples, float from, float to)
+    {
+        //* The gain moves per sample rather than per frame, the difference between the channels of a frame is
+        //* well below what can be heard
+        auto step = (to - from) / static_cast<float>(samples);
+        std::size_t i = 0;
+#if defined(SOUNDUX_SSE2)
+        auto gain = _mm_add_ps(_mm_set1_ps(from), _mm_mul_ps(_mm_set_ps(3, 2, 1, 0), _mm_set1_ps(step)));
+        auto increment = _mm_set1_ps(step * 4);
+        for (; samples >= i + 4; i += 4)
+        {
+            _mm_storeu_ps(target + i, _mm_add_ps(_mm_loadu_ps(target + i), _mm_mul_ps(_mm_loadu_ps(source + i), gain)));
+            gain = _mm_add_ps(gain, increment);
+        }
+#elif defined(SOUNDUX_NEON)
+        const float offsets[] = {0, 1, 2, 3};
+        auto gain = vmlaq_f32(vdupq_n_f32(from), vld1q_f32(offsets), vdupq_n_f32(step));
+        auto increment = vdupq_n_f32(step * 4);
+        for (; samples >= i + 4; i += 4)
+        {
+            vst1q_f32(target + i, vmlaq_f32(vld1q_f32(target + i), vld1q_f32(source + i), gain));
+            gain = vaddq_f32(gain, increment);
+        }
+#endif
+        for (; samples > i; i++)
+        {
+            target[i] += source[i] * (from + step * static_cast<float>(i));
+        }
+    }
+    void mix(float *target, const float *source, std::size_t samples, float from, float to)
+    {
+        if (samples == 0)
+        {
+            return;
+        }
+
+        if (from == to)
+        {
+            mixConstant(target, source, samples, from);
+        }
+        else
+        {
+            mixRamp(target, source, samples, from, to);
+        }
+    }
+    static float peakOf(const float *frame, std::uint32_t channels)
+    {
+        float peak = 0;
+        for (std::uint32_t channel = 0; channels > channel; channel++)
+        {
+            peak = std::max(peak, std::fabs(frame[channel]));
+        }
+        return peak;
+    }
+    void limit(float *buffer, std::size_t frames, std::uint32_t channels, float threshold, float release,
+               float &gain)
+    {
+        std::size_t frame = 0;
+
+        //* Most blocks never get close to the threshold, those are left alone after a single pass
+        if (gain == 1.F)
+        {
+            auto samples = frames * channels;
+            std::size_t i = 0;
+            float peak = 0;
+#if defined(SOUNDUX_SSE2)
+            auto mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            auto peaks = _mm_setzero_ps();
+            for (; samples >= i + 4; i += 4)
+            {
+                peaks = _mm_max_ps(peaks, _mm_and_ps(_mm_loadu_ps(buffer + i), mask));
+            }
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, peaks);
+            peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif defined(SOUNDUX_NEON)
+            auto peaks = vdupq_n_f32(0);
+            for (; samples >= i + 4; i += 4)
+            {
+                peaks = vmaxq_f32(peaks, vabsq_f32(vld1q_f32(buffer + i)));
+            }
+            float lanes[4];
+            vst1q_f32(lanes, peaks);
+            peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+            for (; samples > i; i++)
+            {
+                peak = std::max(peak, std::fabs(buffer[i]));
+            }
+
+            if (threshold >= peak)
+            {
+                return;
+            }
+        }
+
+        for (; frames > frame; frame++)
+        {
+            auto *current = buffer + frame * channels;
+            auto peak = peakOf(current, channels);
+
+            auto target = threshold < peak ? threshold / peak : 1.F;
+            gain = target < gain ? target : gain + (target - gain) * release;
+
+            //* Snap back once the reduction is inaudible so that the fast path above is taken again
+            if (gain > .9999F && target == 1.F)
+            {
+                gain = 1.F;
+            }
+
+            for (std::uint32_t channel = 0; channels > channel; channel++)
+            {
+                current[channel] *= gain;
+            }
+        }
+    }
+} // namespace Soundux::Objects::Kernels
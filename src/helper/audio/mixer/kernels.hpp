@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Inner loops of the mixer, vectorised with SSE2 or NEON when the target has them
+        namespace Kernels
+        {
+            //* Adds `source * gain` to `target`, the gain moves linearly from `from` to `to` over the block
+            void mix(float *target, const float *source, std::size_t samples, float from, float to);
+
+            //* Peak limiter with instant attack, `gain` carries the gain reduction from one block to the next.
+            //* `release` is the share of the distance back to unity gain that is recovered per frame.
+            void limit(float *buffer, std::size_t frames, std::uint32_t channels, float threshold, float release,
+                       float &gain);
+        } // namespace Kernels
+    } // namespace Objects
+} // namespace Soundux
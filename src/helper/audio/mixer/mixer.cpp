@@ -0,0 +1,382 @@
+#include "mixer.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <core/global/globals.hpp>
+#include <fancy.hpp>
+#include <helper/audio/audio.hpp>
+#include <thread>
+
+namespace Soundux::Objects
+{
+    bool Mixer::setup(ma_context *context, const AudioDevice &playbackDevice, std::uint32_t channels,
+                      std::uint32_t sampleRate, Enums::LatencyProfile latencyProfile)
+    {
+        auto config = ma_device_config_init(ma_device_type_playback);
+
+        config.pUserData = this;
+        config.dataCallback = data_callback;
+        config.sampleRate = sampleRate;
+        config.playback.format = ma_format_f32;
+        config.playback.channels = channels;
+        config.playback.pDeviceID = &playbackDevice.raw.id;
+        //* Only used for outputs that do not natively run at the rate of the first one
+        config.resampling.algorithm = ma_resample_algorithm_linear;
+        config.resampling.linear.lpfOrder = MA_MAX_FILTER_ORDER;
+
+        switch (latencyProfile)
+        {
+        case Enums::LatencyProfile::Conservative:
+            config.performanceProfile = ma_performance_profile_conservative;
+            config.periodSizeInMilliseconds = 25;
+            config.periods = 3;
+            break;
+        case Enums::LatencyProfile::Low:
+            config.performanceProfile = ma_performance_profile_low_latency;
+            config.periodSizeInMilliseconds = 10;
+            config.periods = 2;
+            break;
+        case Enums::LatencyProfile::UltraLow:
+            config.performanceProfile = ma_performance_profile_low_latency;
+            config.periodSizeInMilliseconds = 3;
+            config.periods = 2;
+            break;
+        }
+
+        for (auto &voice : voices)
+        {
+            voice = nullptr;
+        }
+
+        if (ma_device_init(context, &config, &device) != MA_SUCCESS)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to create mixer for " << playbackDevice.name << std::endl;
+            return false;
+        }
+
+        name = playbackDevice.name;
+        configure(device.playback.channels, device.sampleRate);
+        initialized = true;
+
+        auto latency = getLatency();
+        Fancy::fancy.logTime().message() << "Mixer for " << name << " runs at " << latency.sampleRate << "Hz with "
+                                         << latency.periods << " periods of " << latency.periodSizeInFrames
+                                         << " frames (" << latency.latencyInMs << "ms)" << std::endl;
+
+        if (ma_device_start(&device) != MA_SUCCESS)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to start mixer for " << playbackDevice.name << std::endl;
+            destroy();
+            return false;
+        }
+
+        return true;
+    }
+    void Mixer::setupOffline(std::uint32_t channels, std::uint32_t sampleRate)
+    {
+        for (auto &voice : voices)
+        {
+            voice = nullptr;
+        }
+
+        name = "offline";
+        configure(channels, sampleRate);
+    }
+    void Mixer::configure(std::uint32_t channels, std::uint32_t sampleRate)
+    {
+        this->sampleRate = sampleRate;
+        this->channels = channels;
+        limiterGain = 1.F;
+        limiterRelease =
+            static_cast<float>(1 - std::exp(-1000 / (limiterReleaseInMs * static_cast<double>(this->sampleRate))));
+        fadeStep = static_cast<float>(std::min(1000 / (fadeInMs * static_cast<double>(this->sampleRate)), 1.));
+    }
+    void Mixer::destroy()
+    {
+        if (initialized)
+        {
+            ma_device_uninit(&device);
+            initialized = false;
+        }
+    }
+    Mixer::~Mixer()
+    {
+        destroy();
+    }
+    bool Mixer::add(Voice *newVoice)
+    {
+        newVoice->gain = newVoice->volume * newVoice->sound->normalization;
+
+        for (auto &voice : voices)
+        {
+            Voice *expected = nullptr;
+            if (voice.compare_exchange_strong(expected, newVoice))
+            {
+                return true;
+            }
+        }
+
+        Fancy::fancy.logTime().warning() << "Mixer " << name << " has no free voice left" << std::endl;
+        return false;
+    }
+    void Mixer::remove(Voice *oldVoice)
+    {
+        for (auto &voice : voices)
+        {
+            Voice *expected = oldVoice;
+            voice.compare_exchange_strong(expected, nullptr);
+        }
+
+        //* The epoch is odd while a callback is rendering, wait for that callback to let go of the voice
+        auto current = epoch.load();
+        if (current % 2 != 0)
+        {
+            while (epoch.load() == current)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+    void Mixer::mix(Voice *voice, float *output, std::uint32_t frameCount)
+    {
+        auto *sound = voice->sound;
+        auto *ringBuffer = voice->ringBuffer.load();
+        if (!ringBuffer || voice->faded)
+        {
+            return;
+        }
+
+        auto from = voice->gain;
+        auto to = voice->volume.load(std::memory_order_relaxed) * sound->normalization;
+        voice->gain = to;
+
+        //* A stopped sound and the frames buffered before a seek fade out, the frames after a seek fade back in
+        const bool stopping = sound->stopping;
+        const bool fadingOut = stopping || voice->flush;
+        const auto envelope = voice->envelope;
+        const auto settled = fadingOut ? 0.F : 1.F;
+        const auto fadeFrames = static_cast<std::uint32_t>(std::ceil(std::abs(settled - envelope) / fadeStep));
+
+        auto envelopeAt = [&](std::uint32_t frame) {
+            if (frame >= fadeFrames)
+            {
+                return settled;
+            }
+
+            auto change = fadeStep * static_cast<float>(frame);
+            return fadingOut ? std::max(envelope - change, 0.F) : std::min(envelope + change, 1.F);
+        };
+        auto gainAt = [&](std::uint32_t frame) {
+            return (from + (to - from) * static_cast<float>(frame) / static_cast<float>(frameCount)) *
+                   envelopeAt(frame);
+        };
+
+        std::uint32_t mixed = 0;
+        //* Nothing after the end of a fade out belongs to this voice anymore
+        auto limit = fadingOut ? std::min(frameCount, fadeFrames) : frameCount;
+
+        while (mixed < limit)
+        {
+            void *buffer{};
+            ma_uint32 frames = limit - mixed;
+
+            //* The gain is ramped linearly between the ends of a chunk, so a chunk must not span the end of a fade
+            if (fadeFrames > mixed)
+            {
+                frames = std::min(frames, fadeFrames - mixed);
+            }
+
+            if (ma_pcm_rb_acquire_read(ringBuffer, &frames, &buffer) != MA_SUCCESS || frames == 0)
+            {
+                break;
+            }
+
+            auto *source = reinterpret_cast<const float *>(buffer);
+            auto *target = output + static_cast<std::size_t>(mixed) * channels;
+
+            Kernels::mix(target, source, static_cast<std::size_t>(frames) * channels, gainAt(mixed),
+                         gainAt(mixed + frames));
+
+            ma_pcm_rb_commit_read(ringBuffer, frames);
+            mixed += frames;
+        }
+
+        voice->envelope = envelopeAt(mixed);
+
+        //* A fade out also ends early when there is nothing left to fade
+        if (fadingOut && (voice->envelope <= 0 || ma_pcm_rb_available_read(ringBuffer) == 0))
+        {
+            if (stopping)
+            {
+                voice->envelope = 0;
+                voice->faded = true;
+                return;
+            }
+
+            if (voice->isLocal && mixed > 0)
+            {
+                Globals::gAudio.onSoundProgressed(sound, mixed);
+            }
+
+            ma_pcm_rb_seek_read(ringBuffer, ma_pcm_rb_available_read(ringBuffer));
+            voice->envelope = 0;
+            if (voice->isLocal)
+            {
+                Globals::gAudio.onSoundSeeked(sound, sound->seekedTo);
+            }
+            voice->flush = false;
+
+            return;
+        }
+
+        if (mixed < frameCount && !sound->endOfStream && !sound->shouldSeek && !voice->flush)
+        {
+            health.shortFrames.fetch_add(frameCount - mixed, std::memory_order_relaxed);
+            starved = true;
+        }
+
+        auto available = ma_pcm_rb_available_read(ringBuffer);
+        if (auto size = available + ma_pcm_rb_available_write(ringBuffer); size > 0)
+        {
+            lowestFill = std::min(lowestFill, static_cast<float>(available) / static_cast<float>(size));
+        }
+
+        if (voice->isLocal && mixed > 0)
+        {
+            Globals::gAudio.onSoundProgressed(sound, mixed);
+        }
+        if (mixed > 0 && !sound->traced.load(std::memory_order_relaxed) && !sound->traced.exchange(true))
+        {
+            Globals::gTracer.mark(sound->trace, TracePoint::FirstCallback);
+        }
+
+        if (mixed < frameCount && sound->endOfStream && !sound->repeat && !sound->shouldSeek &&
+            ma_pcm_rb_available_read(ringBuffer) == 0)
+        {
+            voice->drained = true;
+
+            //* The sound is only finished once every output has played all of it
+            for (const auto &other : sound->outputs)
+            {
+                if (!other->drained)
+                {
+                    return;
+                }
+            }
+
+            if (!sound->finished.exchange(true) &&
+                !Globals::gQueue.post_unique(reinterpret_cast<std::uintptr_t>(sound),
+                                             [id = sound->id] { Globals::gAudio.onFinished(id); }))
+            {
+                sound->finished = false;
+            }
+        }
+    }
+    void Mixer::render(float *output, std::uint32_t frameCount)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        lowestFill = 1;
+        starved = false;
+
+        epoch++;
+        std::fill_n(output, static_cast<std::size_t>(frameCount) * channels, 0.f);
+
+        for (auto &voice : voices)
+        {
+            auto *current = voice.load();
+            if (!current)
+            {
+                continue;
+            }
+
+            if (!current->sound->paused)
+            {
+                mix(current, output, frameCount);
+            }
+            else if (current->sound->stopping)
+            {
+                //* A paused sound is silent already, there is nothing to fade
+                current->faded = true;
+            }
+        }
+
+        Kernels::limit(output, frameCount, channels, limiterThreshold, limiterRelease, limiterGain);
+        epoch++;
+
+        auto took = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+        auto budget = static_cast<double>(frameCount) / static_cast<double>(std::max(sampleRate, 1u)) * 1e9;
+        auto bucket = std::min<std::size_t>(static_cast<std::size_t>(static_cast<double>(took) / budget * 4),
+                                            health.durations.size() - 1);
+
+        health.callbacks.fetch_add(1, std::memory_order_relaxed);
+        health.durations[bucket].fetch_add(1, std::memory_order_relaxed);
+        if (took > health.longestInNs.load(std::memory_order_relaxed))
+        {
+            health.longestInNs.store(took, std::memory_order_relaxed);
+        }
+        if (starved)
+        {
+            health.underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        health.bufferFill.store(lowestFill, std::memory_order_relaxed);
+    }
+    void Mixer::data_callback(ma_device *device, void *output, [[maybe_unused]] const void *input,
+                              std::uint32_t frameCount)
+    {
+        auto *mixer = reinterpret_cast<Mixer *>(device->pUserData);
+        if (mixer)
+        {
+            mixer->render(reinterpret_cast<float *>(output), frameCount);
+        }
+    }
+    OutputLatency Mixer::getLatency() const
+    {
+        OutputLatency latency;
+        latency.name = name;
+
+        if (initialized)
+        {
+            latency.periods = device.playback.internalPeriods;
+            latency.sampleRate = device.playback.internalSampleRate;
+            latency.periodSizeInFrames = device.playback.internalPeriodSizeInFrames;
+
+            if (latency.sampleRate > 0)
+            {
+                latency.latencyInMs = static_cast<double>(latency.periodSizeInFrames) * latency.periods /
+                                      static_cast<double>(latency.sampleRate) * 1000;
+            }
+        }
+
+        return latency;
+    }
+    MixerHealth Mixer::getHealth() const
+    {
+        MixerHealth rtn;
+        rtn.name = name;
+        rtn.callbacks = health.callbacks.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; rtn.durations.size() > i; i++)
+        {
+            rtn.durations[i] = health.durations[i].load(std::memory_order_relaxed);
+        }
+        rtn.longestInUs = static_cast<double>(health.longestInNs.load(std::memory_order_relaxed)) / 1000;
+        rtn.shortFrames = health.shortFrames.load(std::memory_order_relaxed);
+        rtn.underruns = health.underruns.load(std::memory_order_relaxed);
+        rtn.bufferFill = health.bufferFill.load(std::memory_order_relaxed);
+
+        return rtn;
+    }
+    const std::string &Mixer::getName() const
+    {
+        return name;
+    }
+    std::uint32_t Mixer::getChannels() const
+    {
+        return channels;
+    }
+    std::uint32_t Mixer::getSampleRate() const
+    {
+        return sampleRate;
+    }
+} // namespace Soundux::Objects
@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <core/enums/enums.hpp>
+#include <cstdint>
+#include <miniaudio.h>
+#include <string>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        struct Voice;
+        struct AudioDevice;
+
+        struct OutputLatency
+        {
+            std::string name;
+            std::uint32_t periods = 0;
+            std::uint32_t sampleRate = 0;
+            std::uint32_t periodSizeInFrames = 0;
+            double latencyInMs = 0;
+        };
+
+        //* Counters of the audio callback since the mixer was created
+        struct MixerHealth
+        {
+            std::string name;
+            std::uint64_t callbacks = 0;
+            //* Callbacks by the share of the period they took: below 25%, 50%, 75%, 100% and overruns
+            std::array<std::uint64_t, 5> durations{};
+            double longestInUs = 0;
+            //* Frames a voice could not deliver in time, and the callbacks in which that happened
+            std::uint64_t shortFrames = 0;
+            std::uint64_t underruns = 0;
+            //* How full the ring buffer of the emptiest voice was in the last callback, 0 to 1
+            float bufferFill = 1;
+        };
+
+        //* One long-lived playback stream per output, sums every voice that has been added to it.
+        class Mixer
+        {
+          public:
+            //* Twice the sounds that may play at once, stopped sounds keep their voice until they faded out
+            static constexpr std::size_t maxVoices = 128;
+            //* The sum of many voices is limited to this peak instead of clipping
+            static constexpr float limiterThreshold = .98F;
+            static constexpr double limiterReleaseInMs = 100;
+            //* Length of the fade when a sound is stopped and of both fades around a seek
+            static constexpr double fadeInMs = 5;
+
+          private:
+            ma_device device;
+            bool initialized = false;
+
+            std::string name;
+            std::uint32_t channels = 0;
+            std::uint32_t sampleRate = 0;
+
+            std::atomic<std::uint64_t> epoch = 0;
+            std::array<std::atomic<Voice *>, maxVoices> voices{};
+
+            float limiterGain = 1.F;
+            float limiterRelease = 0;
+            //* How much the envelope of a voice changes per frame while it fades
+            float fadeStep = 1;
+
+            //* Only written by the audio callback, with relaxed atomics
+            struct
+            {
+                std::atomic<std::uint64_t> callbacks = 0;
+                std::array<std::atomic<std::uint64_t>, 5> durations{};
+                std::atomic<std::uint64_t> longestInNs = 0;
+                std::atomic<std::uint64_t> shortFrames = 0;
+                std::atomic<std::uint64_t> underruns = 0;
+                std::atomic<float> bufferFill = 1;
+            } health;
+
+            //* Lowest ring buffer fill of the current callback, only touched by the callback
+            float lowestFill = 1;
+            bool starved = false;
+
+            void configure(std::uint32_t channels, std::uint32_t sampleRate);
+            void mix(Voice *, float *, std::uint32_t);
+            static void data_callback(ma_device *device, void *output, const void *input, std::uint32_t frameCount);
+
+          public:
+            Mixer() = default;
+            Mixer(const Mixer &) = delete;
+            Mixer &operator=(const Mixer &) = delete;
+            ~Mixer();
+
+            //* `channels` and `sampleRate` may be 0 to use the native format of the device
+            bool setup(ma_context *, const AudioDevice &, std::uint32_t channels, std::uint32_t sampleRate,
+                       Enums::LatencyProfile);
+            //* Only sets the format, for rendering without an output (e.g. in benchmarks)
+            void setupOffline(std::uint32_t channels, std::uint32_t sampleRate);
+            void destroy();
+
+            bool add(Voice *);
+            void remove(Voice *);
+
+            //* Fills `output` (interleaved f32, `getChannels()` channels) with the sum of all active voices
+            void render(float *output, std::uint32_t frameCount);
+
+            //* The period size and count that the backend actually agreed to
+            OutputLatency getLatency() const;
+            MixerHealth getHealth() const;
+            const std::string &getName() const;
+            std::uint32_t getChannels() const;
+            std::uint32_t getSampleRate() const;
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -0,0 +1,85 @@
+#include "registry.hpp"
+#include <helper/audio/audio.hpp>
+
+namespace Soundux::Objects
+{
+    std::uint32_t SoundRegistry::getIndex(std::uint32_t handle)
+    {
+        return (handle - 1) % capacity;
+    }
+    std::uint32_t SoundRegistry::reserve()
+    {
+        for (std::uint32_t i = 0; capacity > i; i++)
+        {
+            auto &slot = slots[i];
+
+            bool expected = false;
+            if (slot.used.compare_exchange_strong(expected, true))
+            {
+                auto generation = slot.generation++;
+                return generation * capacity + i + 1;
+            }
+        }
+
+        return 0;
+    }
+    void SoundRegistry::publish(std::uint32_t handle, std::shared_ptr<PlayingSound> sound)
+    {
+        std::atomic_store(&slots[getIndex(handle)].sound, std::move(sound));
+        size++;
+    }
+    std::shared_ptr<PlayingSound> SoundRegistry::remove(std::uint32_t handle)
+    {
+        if (handle == 0)
+        {
+            return nullptr;
+        }
+
+        auto &slot = slots[getIndex(handle)];
+        auto current = std::atomic_load(&slot.sound);
+
+        if (current && current->id == handle && std::atomic_compare_exchange_strong(&slot.sound, &current, {}))
+        {
+            size--;
+            slot.used = false;
+
+            return current;
+        }
+
+        return nullptr;
+    }
+    std::shared_ptr<PlayingSound> SoundRegistry::get(std::uint32_t handle) const
+    {
+        if (handle == 0)
+        {
+            return nullptr;
+        }
+
+        auto current = std::atomic_load(&slots[getIndex(handle)].sound);
+        if (current && current->id == handle)
+        {
+            return current;
+        }
+
+        return nullptr;
+    }
+    std::vector<std::shared_ptr<PlayingSound>> SoundRegistry::snapshot() const
+    {
+        std::vector<std::shared_ptr<PlayingSound>> rtn;
+        rtn.reserve(size);
+
+        for (const auto &slot : slots)
+        {
+            if (auto sound = std::atomic_load(&slot.sound); sound)
+            {
+                rtn.emplace_back(std::move(sound));
+            }
+        }
+
+        return rtn;
+    }
+    std::size_t SoundRegistry::count() const
+    {
+        return size;
+    }
+} // namespace Soundux::Objects
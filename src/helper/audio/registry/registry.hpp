@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        struct PlayingSound;
+
+        //* Fixed set of slots for the sounds that are currently playing, lookups and removals never wait on the engine.
+        //* A handle encodes the slot as well as a per-slot generation, so stale handles never match a newer sound.
+        //! The slots are read with `std::atomic_load`, which guards shared pointers with a small internal lock. The
+        //! registry must therefore not be used from the audio callback, the mixers only ever see their voices.
+        class SoundRegistry
+        {
+          public:
+            static constexpr std::uint32_t capacity = 64;
+
+          private:
+            struct Slot
+            {
+                std::atomic<bool> used = false;
+                std::atomic<std::uint32_t> generation = 0;
+                std::shared_ptr<PlayingSound> sound;
+            };
+
+            std::array<Slot, capacity> slots;
+            std::atomic<std::size_t> size = 0;
+
+            static std::uint32_t getIndex(std::uint32_t);
+
+          public:
+            //* Returns 0 if every slot is taken
+            std::uint32_t reserve();
+            void publish(std::uint32_t, std::shared_ptr<PlayingSound>);
+            //* Clears the slot and returns the sound, only one caller will ever get the sound for a handle
+            std::shared_ptr<PlayingSound> remove(std::uint32_t);
+
+            std::shared_ptr<PlayingSound> get(std::uint32_t) const;
+            std::vector<std::shared_ptr<PlayingSound>> snapshot() const;
+
+            std::size_t count() const;
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -0,0 +1,208 @@
+#include "waveform.hpp"
+#include <algorithm>
+#include <cmath>
+#include <core/config/config.hpp>
+#include <core/objects/objects.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <helper/misc/misc.hpp>
+#include <iterator>
+#include <sstream>
+
+namespace Soundux::Objects
+{
+    //* Bumped whenever the layout of the files changes
+    static constexpr std::uint32_t version = 1;
+    static constexpr char magic[4] = {'S', 'X', 'W', 'F'};
+
+    template <typename T> static void write(std::string &target, const T &value)
+    {
+        target.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    template <typename T> static bool read(const std::string &source, std::size_t &offset, T &value)
+    {
+        if (source.size() < offset + sizeof(T))
+        {
+            return false;
+        }
+
+        std::memcpy(&value, source.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    const Waveform::Level *Waveform::getLevel(std::size_t buckets) const
+    {
+        if (levels.empty())
+        {
+            return nullptr;
+        }
+
+        //* Levels are ordered from the finest to the coarsest
+        auto level = std::find_if(levels.rbegin(), levels.rend(),
+                                  [&](const auto &item) { return item.peaks.size() / 2 >= buckets; });
+
+        return level != levels.rend() ? &*level : &levels.front();
+    }
+    std::string Waveform::getPath(const Sound &sound)
+    {
+        std::stringstream name;
+        name << std::hex << std::hash<std::string>{}(sound.path) << ".peaks";
+
+        return (std::filesystem::path(Config::path).parent_path() / "waveforms" / name.str()).u8string();
+    }
+    std::optional<Waveform> Waveform::load(const Sound &sound)
+    {
+        std::ifstream stream(getPath(sound), std::ios::binary);
+        if (!stream)
+        {
+            return std::nullopt;
+        }
+
+        std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+        std::size_t offset = sizeof(magic);
+        if (content.size() < offset || std::memcmp(content.data(), magic, sizeof(magic)) != 0)
+        {
+            return std::nullopt;
+        }
+
+        std::uint32_t fileVersion{};
+        std::uint64_t modifiedDate{};
+        std::uint32_t pathLength{};
+
+        if (!read(content, offset, fileVersion) || fileVersion != version || !read(content, offset, modifiedDate) ||
+            modifiedDate != sound.modifiedDate || !read(content, offset, pathLength) ||
+            content.size() < offset + pathLength || content.compare(offset, pathLength, sound.path) != 0)
+        {
+            return std::nullopt;
+        }
+        offset += pathLength;
+
+        std::uint32_t count{};
+        if (!read(content, offset, count))
+        {
+            return std::nullopt;
+        }
+
+        Waveform waveform;
+        for (std::uint32_t i = 0; count > i; i++)
+        {
+            Level level{};
+            std::uint32_t buckets{};
+
+            if (!read(content, offset, level.framesPerBucket) || !read(content, offset, buckets) ||
+                content.size() < offset + static_cast<std::size_t>(buckets) * 2)
+            {
+                return std::nullopt;
+            }
+
+            level.peaks.resize(static_cast<std::size_t>(buckets) * 2);
+            std::memcpy(level.peaks.data(), content.data() + offset, level.peaks.size());
+            offset += level.peaks.size();
+
+            waveform.levels.emplace_back(std::move(level));
+        }
+
+        return waveform;
+    }
+    bool Waveform::save(const Sound &sound) const
+    {
+        std::string content(magic, sizeof(magic));
+        write(content, version);
+        write(content, sound.modifiedDate);
+        write(content, static_cast<std::uint32_t>(sound.path.size()));
+        content += sound.path;
+
+        write(content, static_cast<std::uint32_t>(levels.size()));
+        for (const auto &level : levels)
+        {
+            write(content, level.framesPerBucket);
+            write(content, static_cast<std::uint32_t>(level.peaks.size() / 2));
+            content.append(reinterpret_cast<const char *>(level.peaks.data()), level.peaks.size());
+        }
+
+        return Helpers::writeFileAtomically(getPath(sound), content);
+    }
+
+    WaveformBuilder::WaveformBuilder(std::uint64_t length, std::uint32_t channels) : channels(channels)
+    {
+        level.framesPerBucket = minFramesPerBucket;
+        while (length / level.framesPerBucket > maxBuckets)
+        {
+            level.framesPerBucket *= 2;
+        }
+
+        level.peaks.reserve(static_cast<std::size_t>(length / level.framesPerBucket + 1) * 2);
+    }
+    static std::int8_t quantize(float value)
+    {
+        return static_cast<std::int8_t>(std::lround(std::clamp(value, -1.F, 1.F) * 127.F));
+    }
+    void WaveformBuilder::flush()
+    {
+        level.peaks.emplace_back(quantize(min));
+        level.peaks.emplace_back(quantize(max));
+
+        min = 0;
+        max = 0;
+        frames = 0;
+    }
+    void WaveformBuilder::process(const float *samples, std::uint64_t count)
+    {
+        for (std::uint64_t frame = 0; count > frame; frame++)
+        {
+            const auto *begin = samples + frame * channels;
+            auto [low, high] = std::minmax_element(begin, begin + channels);
+
+            min = std::min(min, *low);
+            max = std::max(max, *high);
+
+            if (++frames == level.framesPerBucket)
+            {
+                flush();
+            }
+        }
+    }
+    Waveform WaveformBuilder::finish()
+    {
+        if (frames > 0)
+        {
+            flush();
+        }
+
+        Waveform waveform;
+        waveform.levels.emplace_back(std::move(level));
+
+        //* Every coarser level merges two neighbouring buckets of the previous one
+        while (waveform.levels.back().peaks.size() / 2 >= minBuckets * 2)
+        {
+            const auto &finer = waveform.levels.back();
+
+            Waveform::Level coarser;
+            coarser.framesPerBucket = finer.framesPerBucket * 2;
+            coarser.peaks.reserve(finer.peaks.size() / 2 + 2);
+
+            for (std::size_t i = 0; finer.peaks.size() > i; i += 4)
+            {
+                auto low = finer.peaks[i];
+                auto high = finer.peaks[i + 1];
+
+                //* The last bucket has no neighbour if there is an odd amount of them
+                if (finer.peaks.size() > i + 2)
+                {
+                    low = std::min(low, finer.peaks[i + 2]);
+                    high = std::max(high, finer.peaks[i + 3]);
+                }
+
+                coarser.peaks.emplace_back(low);
+                coarser.peaks.emplace_back(high);
+            }
+
+            waveform.levels.emplace_back(std::move(coarser));
+        }
+
+        return waveform;
+    }
+} // namespace Soundux::Objects
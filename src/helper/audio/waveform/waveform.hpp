@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        struct Sound;
+
+        //* A level of a `Waveform` as it is sent to the frontend, `peaks` holds the min/max pairs as base64
+        struct WaveformPeaks
+        {
+            std::uint32_t sampleRate;
+            std::uint32_t framesPerBucket;
+            std::string peaks;
+        };
+
+        //* Min/max summary of a clip over all channels at several resolutions, each level has half the buckets of the
+        //* one before. Values are quantized to 8 bit, so even the finest level of a long clip only takes 128kB.
+        struct Waveform
+        {
+            struct Level
+            {
+                std::uint32_t framesPerBucket;
+                //* Minimum and maximum of every bucket, scaled to [-127, 127]
+                std::vector<std::int8_t> peaks;
+            };
+
+            std::vector<Level> levels;
+
+            //* The coarsest level that still has at least `buckets` buckets, or the finest one
+            const Level *getLevel(std::size_t buckets) const;
+
+            static std::string getPath(const Sound &);
+            //* Empty if there is none or it belongs to an older version of the file
+            static std::optional<Waveform> load(const Sound &);
+            bool save(const Sound &) const;
+        };
+
+        class WaveformBuilder
+        {
+          public:
+            //* The finest level uses buckets of at least this many frames
+            static constexpr std::uint32_t minFramesPerBucket = 256;
+            static constexpr std::size_t maxBuckets = 65536;
+            //* No level with less buckets than this is stored
+            static constexpr std::size_t minBuckets = 128;
+
+          private:
+            Waveform::Level level;
+            std::uint32_t channels;
+
+            float min = 0;
+            float max = 0;
+            std::uint32_t frames = 0;
+
+            void flush();
+
+          public:
+            //* `length` only has to be an estimate, it decides how many frames go into a bucket
+            WaveformBuilder(std::uint64_t length, std::uint32_t channels);
+
+            //* `samples` are interleaved
+            void process(const float *samples, std::uint64_t count);
+            Waveform finish();
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -3,7 +3,6 @@
 #include <Shlwapi.h>
 #include <algorithm>
 #include <core/global/globals.hpp>
-#include <endpointvolume.h>
 #include <fancy.hpp>
 #include <functiondiscoverykeys_devpkey.h>
 #include <helper/misc/misc.hpp>
@@ -39,6 +38,86 @@ namespace Soundux
                 guid = Helpers::narrow(guidProp.pwszVal);
             }
             std::transform(guid.begin(), guid.end(), guid.begin(), [](char c) { return tolower(c); });
+            store->Release();
+        }
+        RecordingDevice::RecordingDevice(IMMDevice *device) : Device(device)
+        {
+            IAudioEndpointVolume *volume = nullptr;
+            if (FAILED(device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_INPROC_SERVER, nullptr,
+                                        reinterpret_cast<void **>(&volume))))
+            {
+                Fancy::fancy.logTime().warning() << "Failed to get endpoint volume of " << name << std::endl;
+                return;
+            }
+
+            endpointVolume =
+                std::shared_ptr<IAudioEndpointVolume>(volume, [](IAudioEndpointVolume *ptr) { ptr->Release(); });
+        }
+        ULONG DeviceNotifier::AddRef()
+        {
+            return ++references;
+        }
+        ULONG DeviceNotifier::Release()
+        {
+            auto remaining = --references;
+            if (remaining == 0)
+            {
+                delete this;
+            }
+            return remaining;
+        }
+        HRESULT DeviceNotifier::QueryInterface(REFIID riid, void **object)
+        {
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(IMMNotificationClient))
+            {
+                AddRef();
+                *object = static_cast<IMMNotificationClient *>(this);
+                return S_OK;
+            }
+
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        HRESULT DeviceNotifier::OnDeviceAdded([[maybe_unused]] LPCWSTR deviceId)
+        {
+            changed = true;
+            Globals::gAudio.invalidateDevices();
+            return S_OK;
+        }
+        HRESULT DeviceNotifier::OnDeviceRemoved([[maybe_unused]] LPCWSTR deviceId)
+        {
+            changed = true;
+            Globals::gAudio.invalidateDevices();
+            return S_OK;
+        }
+        HRESULT DeviceNotifier::OnDeviceStateChanged([[maybe_unused]] LPCWSTR deviceId, [[maybe_unused]] DWORD state)
+        {
+            changed = true;
+            Globals::gAudio.invalidateDevices();
+            return S_OK;
+        }
+        HRESULT DeviceNotifier::OnPropertyValueChanged([[maybe_unused]] LPCWSTR deviceId,
+                                                       [[maybe_unused]] const PROPERTYKEY key)
+        {
+            //* The name, the GUID or the "Listen to this device" state may have changed
+            changed = true;
+            return S_OK;
+        }
+        HRESULT DeviceNotifier::OnDefaultDeviceChanged(EDataFlow flow, [[maybe_unused]] ERole role,
+                                                       [[maybe_unused]] LPCWSTR deviceId)
+        {
+            if (flow == eRender)
+            {
+                Globals::gAudio.invalidateDevices();
+            }
+            return S_OK;
+        }
+        WinSound::~WinSound()
+        {
+            if (enumerator && notifier)
+            {
+                enumerator->UnregisterEndpointNotificationCallback(notifier.get());
+            }
         }
         bool WinSound::setup()
         {
@@ -50,6 +129,14 @@ namespace Soundux
                 enumerator = std::shared_ptr<IMMDeviceEnumerator>(
                     rawEnumerator, [](IMMDeviceEnumerator *enumPtr) { enumPtr->Release(); });
 
+                notifier = std::shared_ptr<DeviceNotifier>(new DeviceNotifier,
+                                                           [](DeviceNotifier *ptr) { ptr->Release(); });
+                if (FAILED(enumerator->RegisterEndpointNotificationCallback(notifier.get())))
+                {
+                    Fancy::fancy.logTime().warning() << "Failed to register device notifications" << std::endl;
+                    notifier.reset();
+                }
+
                 IMMDevice *defaultDevice = nullptr;
                 enumerator->GetDefaultAudioEndpoint(eCapture, eMultimedia, &defaultDevice);
                 defaultRecordingDevice = RecordingDevice(defaultDevice);
@@ -100,15 +187,7 @@ namespace Soundux
         }
         bool RecordingDevice::isMuted() const
         {
-            if (!device)
-            {
-                Fancy::fancy.logTime().failure() << "Failed to get mute state, device was invalid" << std::endl;
-                return false;
-            }
-
-            IAudioEndpointVolume *endpointVolume = nullptr;
-            if (FAILED(device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_INPROC_SERVER, nullptr,
-                                        reinterpret_cast<void **>(&endpointVolume))))
+            if (!endpointVolume)
             {
                 Fancy::fancy.logTime().warning() << "Failed to get muted state of " << name << std::endl;
                 return false;
@@ -146,22 +225,13 @@ namespace Soundux
         }
         bool RecordingDevice::mute(bool state) const
         {
-            if (!device)
-            {
-                Fancy::fancy.logTime().failure() << "Failed to set mute state, device was invalid" << std::endl;
-                return false;
-            }
-
-            IAudioEndpointVolume *endpointVolume = nullptr;
-            if (FAILED(device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_INPROC_SERVER, nullptr,
-                                        reinterpret_cast<void **>(&endpointVolume))))
+            if (!endpointVolume)
             {
                 Fancy::fancy.logTime().warning() << "Failed to set mute state for " << name << std::endl;
                 return false;
             }
 
-            endpointVolume->SetMute(state, nullptr);
-            return true;
+            return !FAILED(endpointVolume->SetMute(state, nullptr));
         }
         bool RecordingDevice::listenToDevice(bool state) const
         {
@@ -276,57 +346,79 @@ namespace Soundux
 
             return nullptr;
         }
-        std::vector<RecordingDevice> WinSound::getRecordingDevices()
+        template <typename T> std::vector<T> WinSound::enumerate(EDataFlow flow)
         {
+            std::vector<T> rtn;
+
             IMMDeviceCollection *devices = nullptr;
-            enumerator->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, &devices);
+            if (FAILED(enumerator->EnumAudioEndpoints(flow, DEVICE_STATE_ACTIVE, &devices)))
+            {
+                Fancy::fancy.logTime().warning() << "Failed to enumerate audio endpoints" << std::endl;
+                return rtn;
+            }
 
             std::uint32_t deviceCount = 0;
             devices->GetCount(&deviceCount);
 
-            std::vector<RecordingDevice> rtn;
             for (std::uint32_t i = 0; deviceCount > i; i++)
             {
                 IMMDevice *device = nullptr;
                 devices->Item(i, &device);
 
-                rtn.emplace_back(RecordingDevice(device));
+                rtn.emplace_back(T(device));
             }
 
+            devices->Release();
             return rtn;
         }
-        std::vector<PlaybackDevice> WinSound::getPlaybackDevices()
+        void WinSound::refreshDevices()
         {
-            IMMDeviceCollection *devices = nullptr;
-            enumerator->EnumAudioEndpoints(eRender, DEVICE_STATE_ACTIVE, &devices);
+            //* Without notifications the devices have to be enumerated on every lookup
+            if (notifier && !notifier->changed.exchange(false))
+            {
+                return;
+            }
 
-            std::uint32_t deviceCount = 0;
-            devices->GetCount(&deviceCount);
+            playbackDevices = enumerate<PlaybackDevice>(eRender);
+            recordingDevices = enumerate<RecordingDevice>(eCapture);
 
-            std::vector<PlaybackDevice> rtn;
-            for (std::uint32_t i = 0; deviceCount > i; i++)
+            playbackByGuid.clear();
+            for (std::size_t i = 0; playbackDevices.size() > i; i++)
             {
-                IMMDevice *device = nullptr;
-                devices->Item(i, &device);
+                playbackByGuid.emplace(playbackDevices[i].getGUID(), i);
+            }
 
-                rtn.emplace_back(PlaybackDevice(device));
+            recordingByGuid.clear();
+            for (std::size_t i = 0; recordingDevices.size() > i; i++)
+            {
+                recordingByGuid.emplace(recordingDevices[i].getGUID(), i);
             }
+        }
+        std::vector<RecordingDevice> WinSound::getRecordingDevices()
+        {
+            std::lock_guard lock(deviceMutex);
+            refreshDevices();
 
-            return rtn;
+            return recordingDevices;
+        }
+        std::vector<PlaybackDevice> WinSound::getPlaybackDevices()
+        {
+            std::lock_guard lock(deviceMutex);
+            refreshDevices();
+
+            return playbackDevices;
         }
         std::optional<RecordingDevice> WinSound::getRecordingDevice(const std::string &guid)
         {
             std::string lowerGuid = guid;
             std::transform(lowerGuid.begin(), lowerGuid.end(), lowerGuid.begin(), [](char c) { return tolower(c); });
 
-            for (auto &device : getRecordingDevices())
-            {
-                std::string deviceGuid = device.getGUID();
+            std::lock_guard lock(deviceMutex);
+            refreshDevices();
 
-                if (lowerGuid == deviceGuid)
-                {
-                    return device;
-                }
+            if (auto device = recordingByGuid.find(lowerGuid); device != recordingByGuid.end())
+            {
+                return recordingDevices[device->second];
             }
 
             return std::nullopt;
@@ -335,14 +427,13 @@ namespace Soundux
         {
             std::string lowerGuid = guid;
             std::transform(lowerGuid.begin(), lowerGuid.end(), lowerGuid.begin(), [](char c) { return tolower(c); });
-            for (const auto &device : getPlaybackDevices())
-            {
-                std::string deviceGuid = device.getGUID();
 
-                if (lowerGuid == deviceGuid)
-                {
-                    return device;
-                }
+            std::lock_guard lock(deviceMutex);
+            refreshDevices();
+
+            if (auto device = playbackByGuid.find(lowerGuid); device != playbackByGuid.end())
+            {
+                return playbackDevices[device->second];
             }
 
             return std::nullopt;
@@ -1,9 +1,13 @@
 #pragma once
 #if defined(_WIN32)
+#include <atomic>
+#include <endpointvolume.h>
 #include <fancy.hpp>
 #include <mmdeviceapi.h>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /*
@@ -47,8 +51,12 @@ namespace Soundux
 
         class RecordingDevice : public Device
         {
+            //* Activated once, so that muting is a single call
+            std::shared_ptr<IAudioEndpointVolume> endpointVolume;
+
           public:
-            using Device::Device;
+            RecordingDevice() = default;
+            RecordingDevice(IMMDevice *);
 
             bool isMuted() const;
             bool isListeningToDevice() const;
@@ -59,13 +67,46 @@ namespace Soundux
             bool playbackThrough(const PlaybackDevice &) const;
         };
 
+        //* Forwards endpoint changes to the audio engine so it can refresh its cached device list
+        class DeviceNotifier : public IMMNotificationClient
+        {
+            std::atomic<ULONG> references = 1;
+
+          public:
+            //* Set on every endpoint change, the devices of `WinSound` are enumerated again once it is set
+            std::atomic<bool> changed = true;
+
+            ULONG STDMETHODCALLTYPE AddRef() override;
+            ULONG STDMETHODCALLTYPE Release() override;
+            HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void **) override;
+
+            HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR) override;
+            HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR) override;
+            HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR, DWORD) override;
+            HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR, const PROPERTYKEY) override;
+            HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow, ERole, LPCWSTR) override;
+        };
+
         class WinSound
         {
             bool setup();
             std::shared_ptr<IMMDeviceEnumerator> enumerator;
+            std::shared_ptr<DeviceNotifier> notifier;
             std::optional<RecordingDevice> defaultRecordingDevice;
 
+            std::mutex deviceMutex;
+            std::vector<PlaybackDevice> playbackDevices;
+            std::vector<RecordingDevice> recordingDevices;
+            //* Lower case GUID → index into the devices above
+            std::unordered_map<std::string, std::size_t> playbackByGuid;
+            std::unordered_map<std::string, std::size_t> recordingByGuid;
+
+            //* Has to be called with `deviceMutex` held
+            void refreshDevices();
+            template <typename T> std::vector<T> enumerate(EDataFlow);
+
           public:
+            ~WinSound();
             static std::shared_ptr<WinSound> createInstance();
 
             bool isVBCableProperlySetup();
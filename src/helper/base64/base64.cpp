@@ -29,6 +29,9 @@
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   Altered for Soundux: base64_encode writes into a pre-sized buffer and uses
+   SSSE3 on x86 CPUs that support it.
+
 */
 
 #include "base64.hpp"
@@ -36,6 +39,11 @@
 #include <algorithm>
 #include <stdexcept>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_SSSE3
+#include <immintrin.h>
+#endif
+
 //
 // Depending on the url parameter in base64_chars, one of
 // two sets of base64 characters needs to be chosen.
@@ -116,6 +124,54 @@ template <typename String> static std::string encode(String s, bool url)
     return base64_encode(reinterpret_cast<const unsigned char *>(s.data()), s.length(), url);
 }
 
+#if defined(BASE64_SSSE3)
+//
+// Encodes 12 bytes into 16 characters per iteration, see
+// http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+// Reads 16 bytes per iteration, so it stops while at least 16 bytes are left.
+// Returns the number of bytes that were encoded.
+//
+__attribute__((target("ssse3"))) static size_t encode_ssse3(unsigned char const *in, size_t in_len, char *out,
+                                                            bool url)
+{
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shift_lut =
+        _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                      '0' - 52, '0' - 52, static_cast<char>((url ? '-' : '+') - 62),
+                      static_cast<char>((url ? '_' : '/') - 63), 'A', 0, 0);
+
+    size_t pos = 0;
+    for (; pos + 16 <= in_len; pos += 12, out += 16)
+    {
+        __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos));
+        input = _mm_shuffle_epi8(input, shuffle);
+
+        // Split every 3 bytes into four 6 bit indices
+        const __m128i t0 = _mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(input, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        // Map each index to the offset of its range of characters
+        __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+        result = _mm_add_epi8(_mm_shuffle_epi8(shift_lut, result), indices);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), result);
+    }
+
+    return pos;
+}
+
+static bool has_ssse3()
+{
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+#endif
+
 std::string base64_encode(unsigned char const *bytes_to_encode, size_t in_len, bool url)
 {
 
@@ -134,41 +190,43 @@ std::string base64_encode(unsigned char const *bytes_to_encode, size_t in_len, b
     //
     const char *base64_chars_ = base64_chars[url];
 
-    std::string ret;
-    ret.reserve(len_encoded);
+    std::string ret(len_encoded, '\0');
+    char *out = &ret[0];
 
-    unsigned int pos = 0;
+    size_t pos = 0;
 
-    while (pos < in_len)
+#if defined(BASE64_SSSE3)
+    if (has_ssse3())
     {
-        ret.push_back(base64_chars_[(bytes_to_encode[pos + 0] & 0xfc) >> 2]);
-
-        if (pos + 1 < in_len)
-        {
-            ret.push_back(
-                base64_chars_[((bytes_to_encode[pos + 0] & 0x03) << 4) + ((bytes_to_encode[pos + 1] & 0xf0) >> 4)]);
+        pos = encode_ssse3(bytes_to_encode, in_len, out, url);
+        out += pos / 3 * 4;
+    }
+#endif
 
-            if (pos + 2 < in_len)
-            {
-                ret.push_back(
-                    base64_chars_[((bytes_to_encode[pos + 1] & 0x0f) << 2) + ((bytes_to_encode[pos + 2] & 0xc0) >> 6)]);
-                ret.push_back(base64_chars_[bytes_to_encode[pos + 2] & 0x3f]);
-            }
-            else
-            {
-                ret.push_back(base64_chars_[(bytes_to_encode[pos + 1] & 0x0f) << 2]);
-                ret.push_back(trailing_char);
-            }
-        }
-        else
-        {
+    for (; pos + 3 <= in_len; pos += 3, out += 4)
+    {
+        const unsigned int block = (bytes_to_encode[pos] << 16) | (bytes_to_encode[pos + 1] << 8) |
+                                   bytes_to_encode[pos + 2];
 
-            ret.push_back(base64_chars_[(bytes_to_encode[pos + 0] & 0x03) << 4]);
-            ret.push_back(trailing_char);
-            ret.push_back(trailing_char);
-        }
+        out[0] = base64_chars_[(block >> 18) & 0x3f];
+        out[1] = base64_chars_[(block >> 12) & 0x3f];
+        out[2] = base64_chars_[(block >> 6) & 0x3f];
+        out[3] = base64_chars_[block & 0x3f];
+    }
 
-        pos += 3;
+    if (pos + 1 == in_len)
+    {
+        out[0] = base64_chars_[(bytes_to_encode[pos + 0] & 0xfc) >> 2];
+        out[1] = base64_chars_[(bytes_to_encode[pos + 0] & 0x03) << 4];
+        out[2] = trailing_char;
+        out[3] = trailing_char;
+    }
+    else if (pos + 2 == in_len)
+    {
+        out[0] = base64_chars_[(bytes_to_encode[pos + 0] & 0xfc) >> 2];
+        out[1] = base64_chars_[((bytes_to_encode[pos + 0] & 0x03) << 4) + ((bytes_to_encode[pos + 1] & 0xf0) >> 4)];
+        out[2] = base64_chars_[(bytes_to_encode[pos + 1] & 0x0f) << 2];
+        out[3] = trailing_char;
     }
 
     return ret;
@@ -1,12 +1,15 @@
 #if defined(__linux__)
 #include "icons.hpp"
+#include <core/global/globals.hpp>
 #include <dlfcn.h>
 #include <fancy.hpp>
 #include <filesystem>
 #include <fstream>
 #include <helper/base64/base64.hpp>
+#include <helper/misc/misc.hpp>
+#include <iterator>
 #include <optional>
-#include <regex>
+#include <sstream>
 
 namespace Soundux::Objects
 {
@@ -29,108 +32,279 @@ namespace Soundux::Objects
 
         return true;
     }
+    bool IconFetcher::ensureLoaded()
+    {
+        if (!loaded)
+        {
+            loaded = setup();
+            if (!*loaded)
+            {
+                Fancy::fancy.logTime().failure() << "Could not setup IconFetcher, only cached icons are shown"
+                                                 << std::endl;
+            }
+        }
+
+        return *loaded;
+    }
     std::shared_ptr<IconFetcher> IconFetcher::createInstance()
     {
-        auto instance = std::shared_ptr<IconFetcher>(new IconFetcher()); // NOLINT
+        return std::shared_ptr<IconFetcher>(new IconFetcher()); // NOLINT
+    }
+    std::string IconFetcher::getKey(int pid)
+    {
+        std::error_code ec;
+        auto binary = std::filesystem::read_symlink("/proc/" + std::to_string(pid) + "/exe", ec);
 
-        if (instance->setup())
+        if (ec || binary.empty())
         {
-            return instance;
+            //* Can't be persisted, the pid will belong to another process eventually
+            return "pid:" + std::to_string(pid);
         }
 
-        Fancy::fancy.logTime().failure() << "Could not create IconFetcher instance" << std::endl;
-        return nullptr;
+        return binary.u8string();
+    }
+    std::string IconFetcher::getCachePath(const std::string &key)
+    {
+        std::stringstream name;
+        name << std::hex << std::hash<std::string>{}(key) << ".png";
+
+        return (std::filesystem::path(Config::path).parent_path() / "icons" / name.str()).u8string();
     }
-    std::optional<int> IconFetcher::getPpid(int pid)
+    std::optional<std::string> IconFetcher::lookup(const std::string &key)
     {
-        std::filesystem::path path("/proc/" + std::to_string(pid));
-        if (std::filesystem::exists(path))
         {
-            auto statusFile = path / "status";
-            if (std::filesystem::exists(statusFile) && std::filesystem::is_regular_file(statusFile))
+            std::lock_guard lock(mutex);
+            if (auto entry = cache.find(key); entry != cache.end())
             {
-                static const std::regex pidRegex(R"(PPid:(\ +|\t)(\d+))");
-                std::ifstream statusStream(statusFile);
+                recent.splice(recent.begin(), recent, entry->second.position);
+                return entry->second.icon;
+            }
+        }
+
+        if (key.front() != '/')
+        {
+            return std::nullopt;
+        }
+
+        std::error_code ec;
+        auto path = getCachePath(key);
+
+        auto cachedAt = std::filesystem::last_write_time(path, ec);
+        if (ec)
+        {
+            return std::nullopt;
+        }
+
+        //* The application was updated since, its icon may have changed
+        if (auto updatedAt = std::filesystem::last_write_time(key, ec); !ec && updatedAt > cachedAt)
+        {
+            return std::nullopt;
+        }
+
+        std::ifstream stream(path, std::ios::binary);
+        std::string png((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
 
-                std::string line;
-                std::smatch match;
-                while (std::getline(statusStream, line))
+        if (png.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto icon = base64_encode(png, false);
+        remember(key, icon);
+
+        return icon;
+    }
+    void IconFetcher::remember(const std::string &key, const std::string &icon)
+    {
+        std::lock_guard lock(mutex);
+        misses.erase(key);
+
+        if (auto entry = cache.find(key); entry != cache.end())
+        {
+            entry->second.icon = icon;
+            recent.splice(recent.begin(), recent, entry->second.position);
+        }
+        else
+        {
+            recent.push_front(key);
+            cache.emplace(key, Entry{icon, recent.begin()});
+        }
+
+        while (cache.size() > maxEntries)
+        {
+            cache.erase(recent.back());
+            recent.pop_back();
+        }
+    }
+    std::string IconFetcher::store(const std::string &key, const std::string &png)
+    {
+        auto icon = base64_encode(png, false);
+        remember(key, icon);
+
+        if (key.front() == '/')
+        {
+            Globals::gQueue.push_unique(std::hash<std::string>{}("icon:" + key), [path = getCachePath(key), png] {
+                std::error_code ec;
+                std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+                if (ec || !Helpers::writeFileAtomically(path, png))
                 {
-                    if (std::regex_search(line, match, pidRegex))
-                    {
-                        if (match[2].matched)
-                        {
-                            return std::stoi(match[2]);
-                        }
-                    }
+                    Fancy::fancy.logTime().warning() << "Failed to write icon cache " << path << std::endl;
                 }
-
-                Fancy::fancy.logTime().warning() << "Failed to find ppid of " >> pid << std::endl;
-                return std::nullopt;
-            }
+            });
         }
 
-        Fancy::fancy.logTime().warning() << "Failed to find ppid of " >> pid << ", process does not exist" << std::endl;
-        return std::nullopt;
+        return icon;
     }
-    std::optional<std::string> IconFetcher::getIcon(int pid, bool recursive)
+    static std::optional<std::string> encode(LibWnck::Window *window)
     {
-        if (cache.find(pid) != cache.end())
+        auto *icon = LibWnck::getWindowIcon(window);
+        if (!icon)
         {
-            return cache.at(pid);
+            return std::nullopt;
         }
 
-        LibWnck::forceUpdate(screen);
-        auto *windows = LibWnck::getScreenWindows(screen);
+        gchar *buffer = nullptr;
+        gsize size = 0;
+        GError *error = nullptr;
 
-        for (auto *item = windows; item != nullptr; item = item->next)
+        if (gdk_pixbuf_save_to_buffer(icon, &buffer, &size, "png", &error, NULL) != TRUE)
         {
-            auto *window = reinterpret_cast<LibWnck::Window *>(item->data);
-            auto _pid = LibWnck::getWindowPID(window);
+            Fancy::fancy.logTime().warning() << "Failed to save icon to buffer, error: " << error->message << "("
+                                             << error->code << ")" << std::endl;
+            g_error_free(error);
+            return std::nullopt;
+        }
+
+        std::string rtn(buffer, size);
+        g_free(buffer);
+
+        return rtn;
+    }
+    std::unordered_map<int, std::string> IconFetcher::getIcons(const std::vector<int> &pids)
+    {
+        std::unordered_map<int, std::string> rtn;
+        std::vector<std::pair<int, std::string>> missing;
 
-            if (pid == _pid)
+        auto now = std::chrono::steady_clock::now();
+        for (const auto &pid : pids)
+        {
+            if (rtn.find(pid) != rtn.end())
             {
-                auto *icon = LibWnck::getWindowIcon(window);
+                continue;
+            }
 
-                gsize size = 4096;
-                auto *iconBuff = new gchar[size];
+            auto key = getKey(pid);
+            if (auto icon = lookup(key); icon)
+            {
+                rtn.emplace(pid, std::move(*icon));
+                continue;
+            }
 
-                GError *error = nullptr;
-                if (gdk_pixbuf_save_to_buffer(icon, &iconBuff, &size, "png", &error, NULL) != TRUE)
+            {
+                std::lock_guard lock(mutex);
+                if (auto miss = misses.find(key); miss != misses.end() && now - miss->second < retryDelay)
                 {
-                    Fancy::fancy.logTime().warning() << "Failed to save icon to buffer, error: " << error->message
-                                                     << "(" << error->code << ")" << std::endl;
-                    delete[] iconBuff;
-                    return std::nullopt;
+                    continue;
                 }
+            }
+
+            missing.emplace_back(pid, std::move(key));
+        }
+
+        if (missing.empty() || !ensureLoaded())
+        {
+            return rtn;
+        }
+
+        LibWnck::forceUpdate(screen);
 
-                auto base64 = base64_encode(reinterpret_cast<const unsigned char *>(iconBuff), size, false);
-                delete[] iconBuff;
+        std::unordered_map<int, LibWnck::Window *> windows;
+        for (auto *item = LibWnck::getScreenWindows(screen); item != nullptr; item = item->next)
+        {
+            auto *window = reinterpret_cast<LibWnck::Window *>(item->data);
+            windows.emplace(LibWnck::getWindowPID(window), window);
+        }
 
-                if (cache.find(pid) == cache.end())
+        for (const auto &[pid, key] : missing)
+        {
+            //* Helper processes (e.g. of browsers) usually don't have a window of their own
+            auto window = windows.find(pid);
+            auto current = std::optional<int>(pid);
+
+            for (std::size_t depth = 0; window == windows.end() && maxAncestors > depth; depth++)
+            {
+                current = Helpers::getParentPid(*current);
+                if (!current || *current <= 1)
                 {
-                    cache.insert({pid, base64});
+                    break;
                 }
 
-                return base64;
+                window = windows.find(*current);
             }
-        }
 
-        if (recursive)
-        {
-            auto parentProcess = getPpid(pid);
-            if (parentProcess)
+            if (window != windows.end())
             {
-                auto recursiveResult = getIcon(*parentProcess, false);
-                if (recursiveResult)
+                if (auto png = encode(window->second); png)
                 {
-                    return recursiveResult;
+                    rtn.emplace(pid, store(key, *png));
+                    continue;
                 }
             }
+
+            std::lock_guard lock(mutex);
+            misses[key] = now;
+        }
+
+        return rtn;
+    }
+    std::optional<std::string> IconFetcher::getIcon(int pid)
+    {
+        auto icons = getIcons({pid});
+        if (auto icon = icons.find(pid); icon != icons.end())
+        {
+            return std::move(icon->second);
         }
 
-        Fancy::fancy.logTime().warning() << "Could not find proccess with id " >> pid << std::endl;
+        Fancy::fancy.logTime().warning() << "Could not find icon of process with id " >> pid << std::endl;
         return std::nullopt;
     }
+    void IconFetcher::prefetch(int pid)
+    {
+        {
+            std::lock_guard lock(mutex);
+            queued.emplace_back(pid);
+
+            if (prefetchScheduled)
+            {
+                return;
+            }
+            prefetchScheduled = true;
+        }
+
+        g_idle_add(
+            [](gpointer data) -> gboolean {
+                auto *instance = reinterpret_cast<std::weak_ptr<IconFetcher> *>(data);
+                if (auto fetcher = instance->lock(); fetcher)
+                {
+                    fetcher->flushPrefetch();
+                }
+
+                delete instance;
+                return G_SOURCE_REMOVE;
+            },
+            new std::weak_ptr<IconFetcher>(weak_from_this()));
+    }
+    void IconFetcher::flushPrefetch()
+    {
+        std::vector<int> pids;
+        {
+            std::lock_guard lock(mutex);
+            pids.swap(queued);
+            prefetchScheduled = false;
+        }
+
+        getIcons(pids);
+    }
 } // namespace Soundux::Objects
 #endif
\ No newline at end of file
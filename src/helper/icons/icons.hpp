@@ -1,30 +1,76 @@
 #if defined(__linux__)
 #pragma once
 #include "forward.hpp"
-#include <map>
+#include <chrono>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Soundux
 {
     namespace Objects
     {
-        class IconFetcher
+        //* Icons are cached by the binary of the application, in memory and as png files next to the config. LibWnck
+        //* shares the display with the UI, so everything that touches it has to run on the main thread. It is only
+        //* loaded once an icon is not found in the cache.
+        class IconFetcher : public std::enable_shared_from_this<IconFetcher>
         {
-            LibWnck::Screen *screen;
-            std::map<int, std::string> cache;
+          public:
+            static constexpr std::size_t maxEntries = 128;
+            //* Applications without a window are not looked up again for this long
+            static constexpr auto retryDelay = std::chrono::seconds(30);
+            //* How far up the process tree a window is searched for
+            static constexpr std::size_t maxAncestors = 3;
+
+          private:
+            struct Entry
+            {
+                std::string icon;
+                std::list<std::string>::iterator position;
+            };
+
+            LibWnck::Screen *screen = nullptr;
+            //* Only touched by the main thread, empty until LibWnck was needed for the first time
+            std::optional<bool> loaded;
+
+            std::mutex mutex;
+            std::unordered_map<std::string, Entry> cache;
+            //* Most recently used first
+            std::list<std::string> recent;
+            std::unordered_map<std::string, std::chrono::steady_clock::time_point> misses;
+
+            std::vector<int> queued;
+            bool prefetchScheduled = false;
 
           private:
             IconFetcher() = default;
 
             bool setup();
-            std::optional<int> getPpid(int pid);
+            bool ensureLoaded();
+
+            static std::string getKey(int pid);
+            static std::string getCachePath(const std::string &key);
+
+            std::optional<std::string> lookup(const std::string &key);
+            void remember(const std::string &key, const std::string &icon);
+            std::string store(const std::string &key, const std::string &png);
+            void flushPrefetch();
 
           public:
             static std::shared_ptr<IconFetcher> createInstance();
-            std::optional<std::string> getIcon(int pid, bool recursive = true);
+
+            //* Has to be called from the main thread
+            std::optional<std::string> getIcon(int pid);
+            //* Same as `getIcon`, but only enumerates the windows once for all icons that are not cached yet
+            std::unordered_map<int, std::string> getIcons(const std::vector<int> &pids);
+
+            //* May be called from any thread, the icon is looked up once the main thread is idle
+            void prefetch(int pid);
         };
     } // namespace Objects
 } // namespace Soundux
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,138 @@
+#include "ipc.hpp"
+#include <charconv>
+#include <core/global/globals.hpp>
+#include <optional>
+#include <ui/impl/headless/headless.hpp>
+#include <vector>
+
+namespace Soundux::Objects
+{
+    static std::vector<std::string_view> split(std::string_view request)
+    {
+        std::vector<std::string_view> rtn;
+        while (!request.empty())
+        {
+            auto start = request.find_first_not_of(" \t\r");
+            if (start == std::string_view::npos)
+            {
+                break;
+            }
+
+            auto end = request.find_first_of(" \t\r", start);
+            rtn.emplace_back(request.substr(start, end - start));
+
+            request.remove_prefix(end == std::string_view::npos ? request.size() : end);
+        }
+
+        return rtn;
+    }
+    template <typename T> static std::optional<T> parse(std::string_view text)
+    {
+        T rtn{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), rtn);
+
+        if (error != std::errc() || end != text.data() + text.size())
+        {
+            return std::nullopt;
+        }
+
+        return rtn;
+    }
+    static std::string reply(const std::optional<PlayingSound> &sound)
+    {
+        if (!sound)
+        {
+            return "error failed";
+        }
+
+        return "ok " + std::to_string(sound->id);
+    }
+    std::string IpcServer::handle(std::string_view request)
+    {
+        auto arguments = split(request);
+        if (arguments.empty())
+        {
+            return "error empty-request";
+        }
+
+        auto &gui = Globals::gGui;
+        const auto &command = arguments[0];
+
+        if (command == "ping")
+        {
+            return "ok";
+        }
+        if (command == "stopall")
+        {
+            gui->stopSounds();
+            return "ok";
+        }
+        if (command == "list")
+        {
+            std::string rtn = "ok";
+            for (const auto &sound : Globals::gAudio.getPlayingSounds())
+            {
+                rtn += " " + std::to_string(sound.id) + ":" + std::to_string(sound.sound.id) + ":" +
+                       std::to_string(sound.readInMs) + "/" + std::to_string(sound.lengthInMs);
+            }
+
+            return rtn;
+        }
+        if (command == "quit")
+        {
+            if (auto *headless = dynamic_cast<Headless *>(gui.get()); headless)
+            {
+                headless->stop();
+                return "ok";
+            }
+
+            return "error not-headless";
+        }
+
+        if (arguments.size() < 2)
+        {
+            return "error missing-argument";
+        }
+
+        auto id = parse<std::uint32_t>(arguments[1]);
+        if (!id)
+        {
+            return "error bad-argument";
+        }
+
+        if (command == "play")
+        {
+            auto sound = gui->playSound(*id);
+            if (sound)
+            {
+                gui->onSoundPlayed(*sound);
+            }
+
+            return reply(sound);
+        }
+        if (command == "stop")
+        {
+            return gui->stopSound(*id) ? "ok" : "error failed";
+        }
+        if (command == "pause")
+        {
+            return reply(gui->pauseSound(*id));
+        }
+        if (command == "resume")
+        {
+            return reply(gui->resumeSound(*id));
+        }
+        if (command == "seek")
+        {
+            auto position = arguments.size() > 2 ? parse<std::uint64_t>(arguments[2]) : std::nullopt;
+            if (!position)
+            {
+                return "error bad-argument";
+            }
+
+            return reply(gui->seekSound(*id, *position));
+        }
+
+        return "error unknown-command";
+    }
+} // namespace Soundux::Objects
@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Lets other programs trigger sounds without going through the UI. Requests are single lines on a Unix socket
+        //* (`$XDG_RUNTIME_DIR/soundux.sock`) or a named pipe (`\\.\pipe\soundux`), every request is answered with a
+        //* single line that starts with either "ok" or "error". See `handle` for the requests.
+        class IpcServer
+        {
+          public:
+            //* Clients that send longer lines are disconnected
+            static constexpr std::size_t maxLineLength = 256;
+            static constexpr std::size_t maxClients = 16;
+
+          private:
+            struct Native;
+            std::unique_ptr<Native> native;
+
+            std::thread thread;
+            std::atomic<bool> running = false;
+
+            void run();
+
+          public:
+            IpcServer();
+            ~IpcServer();
+
+            bool setup();
+            void destroy();
+
+            static std::string getPath();
+
+            //* `play <sound id>`, `stop <id>`, `stopall`, `pause <id>`, `resume <id>`, `seek <id> <ms>`, `list`,
+            //* `ping` and, in headless mode, `quit`. Except for `play` every id is the id of a playing sound.
+            std::string handle(std::string_view request);
+        };
+    } // namespace Objects
+} // namespace Soundux
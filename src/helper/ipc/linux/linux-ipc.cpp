@@ -0,0 +1,226 @@
+#if defined(__linux__)
+#include "../ipc.hpp"
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fancy.hpp>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Soundux::Objects
+{
+    struct IpcServer::Native
+    {
+        int listener = -1;
+        int wakeup = -1;
+        std::string path;
+    };
+
+    IpcServer::IpcServer() : native(std::make_unique<Native>()) {}
+    IpcServer::~IpcServer()
+    {
+        destroy();
+    }
+    std::string IpcServer::getPath()
+    {
+        if (const auto *runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime) // NOLINT
+        {
+            return std::string(runtime) + "/soundux.sock";
+        }
+
+        return "/tmp/soundux-" + std::to_string(getuid()) + ".sock";
+    }
+    bool IpcServer::setup()
+    {
+        if (running)
+        {
+            return true;
+        }
+
+        native->path = getPath();
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (native->path.size() >= sizeof(address.sun_path))
+        {
+            Fancy::fancy.logTime().failure() << "IPC socket path " << native->path << " is too long" << std::endl;
+            return false;
+        }
+        std::memcpy(address.sun_path, native->path.c_str(), native->path.size() + 1);
+
+        native->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        native->wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+        if (native->listener < 0 || native->wakeup < 0)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to create IPC socket: " << errno << std::endl;
+            destroy();
+            return false;
+        }
+
+        //* Only one instance can run at a time, so whatever is left there belongs to a previous run
+        unlink(native->path.c_str());
+
+        //* Nobody but the user may trigger sounds
+        auto previous = umask(0077);
+        auto bound = bind(native->listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+        umask(previous);
+
+        if (!bound || listen(native->listener, static_cast<int>(maxClients)) != 0)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to listen on " << native->path << ": " << errno << std::endl;
+            destroy();
+            return false;
+        }
+
+        running = true;
+        thread = std::thread([this] { run(); });
+
+        Fancy::fancy.logTime().message() << "Listening for IPC requests on " << native->path << std::endl;
+        return true;
+    }
+    void IpcServer::run()
+    {
+        struct Client
+        {
+            int fd;
+            std::string buffer;
+        };
+
+        std::vector<Client> clients;
+        std::vector<pollfd> fds;
+        std::array<char, 1024> chunk{};
+
+        auto disconnect = [&](std::size_t index) {
+            close(clients[index].fd);
+            clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(index));
+        };
+
+        while (running)
+        {
+            fds.clear();
+            fds.push_back({native->wakeup, POLLIN, 0});
+            fds.push_back({native->listener, POLLIN, 0});
+            for (const auto &client : clients)
+            {
+                fds.push_back({client.fd, POLLIN, 0});
+            }
+
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                Fancy::fancy.logTime().failure() << "Failed to poll IPC socket: " << errno << std::endl;
+                break;
+            }
+
+            if ((fds[0].revents & POLLIN) != 0)
+            {
+                break;
+            }
+
+            //* Walk backwards, so that disconnecting a client does not shift the ones that are still to be handled
+            for (auto i = clients.size(); i-- > 0;)
+            {
+                auto events = fds[i + 2].revents;
+                if (events == 0)
+                {
+                    continue;
+                }
+
+                auto &client = clients[i];
+                auto read = recv(client.fd, chunk.data(), chunk.size(), 0);
+                if (read <= 0)
+                {
+                    if (read < 0 && (errno == EAGAIN || errno == EINTR))
+                    {
+                        continue;
+                    }
+
+                    disconnect(i);
+                    continue;
+                }
+
+                client.buffer.append(chunk.data(), static_cast<std::size_t>(read));
+
+                bool failed = false;
+                for (auto end = client.buffer.find('\n'); end != std::string::npos; end = client.buffer.find('\n'))
+                {
+                    auto response = handle(std::string_view(client.buffer).substr(0, end)) + "\n";
+                    client.buffer.erase(0, end + 1);
+
+                    if (send(client.fd, response.data(), response.size(), MSG_NOSIGNAL) < 0)
+                    {
+                        failed = true;
+                        break;
+                    }
+                }
+
+                if (failed || client.buffer.size() > maxLineLength)
+                {
+                    disconnect(i);
+                }
+            }
+
+            if ((fds[1].revents & POLLIN) != 0)
+            {
+                auto fd = accept4(native->listener, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd >= 0)
+                {
+                    if (clients.size() >= maxClients)
+                    {
+                        Fancy::fancy.logTime().warning() << "Too many IPC clients, refusing another one" << std::endl;
+                        close(fd);
+                    }
+                    else
+                    {
+                        clients.push_back({fd, {}});
+                    }
+                }
+            }
+        }
+
+        for (const auto &client : clients)
+        {
+            close(client.fd);
+        }
+    }
+    void IpcServer::destroy()
+    {
+        if (running)
+        {
+            running = false;
+
+            std::uint64_t value = 1;
+            if (write(native->wakeup, &value, sizeof(value)) < 0)
+            {
+                Fancy::fancy.logTime().warning() << "Failed to wake up IPC thread: " << errno << std::endl;
+            }
+
+            thread.join();
+            unlink(native->path.c_str());
+        }
+
+        if (native->listener >= 0)
+        {
+            close(native->listener);
+            native->listener = -1;
+        }
+        if (native->wakeup >= 0)
+        {
+            close(native->wakeup);
+            native->wakeup = -1;
+        }
+    }
+} // namespace Soundux::Objects
+#endif
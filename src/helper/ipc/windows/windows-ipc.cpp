@@ -0,0 +1,118 @@
+#if defined(_WIN32)
+#include "../ipc.hpp"
+#include <Windows.h>
+#include <array>
+#include <fancy.hpp>
+#include <helper/misc/misc.hpp>
+
+namespace Soundux::Objects
+{
+    struct IpcServer::Native
+    {
+        std::wstring path;
+    };
+
+    IpcServer::IpcServer() : native(std::make_unique<Native>()) {}
+    IpcServer::~IpcServer()
+    {
+        destroy();
+    }
+    std::string IpcServer::getPath()
+    {
+        return R"(\\.\pipe\soundux)";
+    }
+    bool IpcServer::setup()
+    {
+        if (running)
+        {
+            return true;
+        }
+
+        native->path = Helpers::widen(getPath());
+        running = true;
+        thread = std::thread([this] { run(); });
+
+        Fancy::fancy.logTime().message() << "Listening for IPC requests on " << getPath() << std::endl;
+        return true;
+    }
+    void IpcServer::run()
+    {
+        std::array<char, 1024> chunk{};
+
+        //* Clients are served one after another, a request is answered long before the next client would notice
+        while (running)
+        {
+            auto *pipe = CreateNamedPipeW(native->path.c_str(), PIPE_ACCESS_DUPLEX,
+                                          PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                          1, 4096, 4096, 0, nullptr);
+
+            if (pipe == INVALID_HANDLE_VALUE) // NOLINT
+            {
+                Fancy::fancy.logTime().failure() << "Failed to create named pipe: " << GetLastError() << std::endl;
+                return;
+            }
+
+            if (!ConnectNamedPipe(pipe, nullptr) && GetLastError() != ERROR_PIPE_CONNECTED)
+            {
+                CloseHandle(pipe);
+                continue;
+            }
+
+            std::string buffer;
+            while (running)
+            {
+                DWORD read = 0;
+                if (!ReadFile(pipe, chunk.data(), static_cast<DWORD>(chunk.size()), &read, nullptr) || read == 0)
+                {
+                    break;
+                }
+
+                buffer.append(chunk.data(), read);
+
+                bool failed = false;
+                for (auto end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n'))
+                {
+                    auto response = handle(std::string_view(buffer).substr(0, end)) + "\n";
+                    buffer.erase(0, end + 1);
+
+                    DWORD written = 0;
+                    if (!WriteFile(pipe, response.data(), static_cast<DWORD>(response.size()), &written, nullptr))
+                    {
+                        failed = true;
+                        break;
+                    }
+                }
+
+                if (failed || buffer.size() > maxLineLength)
+                {
+                    break;
+                }
+            }
+
+            FlushFileBuffers(pipe);
+            DisconnectNamedPipe(pipe);
+            CloseHandle(pipe);
+        }
+    }
+    void IpcServer::destroy()
+    {
+        if (!running)
+        {
+            return;
+        }
+
+        running = false;
+
+        //* Unblocks a pending ConnectNamedPipe or ReadFile
+        CancelSynchronousIo(thread.native_handle());
+        auto *client = CreateFileW(native->path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0,
+                                   nullptr);
+        if (client != INVALID_HANDLE_VALUE) // NOLINT
+        {
+            CloseHandle(client);
+        }
+
+        thread.join();
+    }
+} // namespace Soundux::Objects
+#endif
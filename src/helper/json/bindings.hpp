@@ -1,5 +1,6 @@
 #pragma once
 #include <core/global/globals.hpp>
+#include <helper/audio/waveform/waveform.hpp>
 #include <helper/audio/windows/winsound.hpp>
 #include <helper/version/check.hpp>
 #include <nlohmann/json.hpp>
@@ -18,6 +19,15 @@ namespace Soundux
             static const bool value = sizeof(test(reinterpret_cast<std::decay_t<T> *>(0))) == sizeof(std::uint16_t);
         };
     } // namespace traits
+
+    namespace Objects
+    {
+        //* Serializes only what the frontend needs to update an object it already received in full
+        template <typename T> struct Lean
+        {
+            const T &value;
+        };
+    } // namespace Objects
 } // namespace Soundux
 
 namespace nlohmann
@@ -43,6 +53,28 @@ namespace nlohmann
             }
         }
     }; // namespace nlohmann
+    template <> struct adl_serializer<Soundux::Objects::SharedString>
+    {
+        static void to_json(json &j, const Soundux::Objects::SharedString &obj)
+        {
+            j = obj.get();
+        }
+        static void from_json(const json &j, Soundux::Objects::SharedString &obj)
+        {
+            obj = j.get<std::string>();
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::KeyCombination>
+    {
+        static void to_json(json &j, const Soundux::Objects::KeyCombination &obj)
+        {
+            j = obj.toVector();
+        }
+        static void from_json(const json &j, Soundux::Objects::KeyCombination &obj)
+        {
+            obj = j.get<std::vector<int>>();
+        }
+    };
     template <> struct adl_serializer<Soundux::Objects::Sound>
     {
         static void to_json(json &j, const Soundux::Objects::Sound &obj)
@@ -50,8 +82,8 @@ namespace nlohmann
             j = {
                 {"name", obj.name},
                 {"hotkeys", obj.hotkeys},
-                {"hotkeySequence",
-                 Soundux::Globals::gHotKeys.getKeySequence(obj.hotkeys)}, //* For frontend and config readability
+                //* For frontend and config readability
+                {"hotkeySequence", Soundux::Globals::gHotKeys.getKeySequence(obj.hotkeys.toVector())},
                 {"id", obj.id},
                 {"path", obj.path},
                 {"isFavorite", obj.isFavorite},
@@ -99,6 +131,97 @@ namespace nlohmann
             j.at("isDefault").get_to(obj.isDefault);
         }
     };
+    template <> struct adl_serializer<Soundux::Objects::OutputLatency>
+    {
+        static void to_json(json &j, const Soundux::Objects::OutputLatency &obj)
+        {
+            j = {
+                {"name", obj.name},
+                {"periods", obj.periods},
+                {"sampleRate", obj.sampleRate},
+                {"latencyInMs", obj.latencyInMs},
+                {"periodSizeInFrames", obj.periodSizeInFrames},
+            };
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::MixerHealth>
+    {
+        static void to_json(json &j, const Soundux::Objects::MixerHealth &obj)
+        {
+            j = {
+                {"name", obj.name},
+                {"callbacks", obj.callbacks},
+                {"durations", obj.durations},
+                {"underruns", obj.underruns},
+                {"bufferFill", obj.bufferFill},
+                {"shortFrames", obj.shortFrames},
+                {"longestInUs", obj.longestInUs},
+            };
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::TraceSummary>
+    {
+        static void to_json(json &j, const Soundux::Objects::TraceSummary &obj)
+        {
+            j = {
+                {"point", obj.point},
+                {"count", obj.count},
+                {"p50InMs", obj.p50InMs},
+                {"p99InMs", obj.p99InMs},
+            };
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::WaveformPeaks>
+    {
+        static void to_json(json &j, const Soundux::Objects::WaveformPeaks &obj)
+        {
+            j = {
+                {"peaks", obj.peaks},
+                {"sampleRate", obj.sampleRate},
+                {"framesPerBucket", obj.framesPerBucket},
+            };
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::Metadata>
+    {
+        static void to_json(json &j, const Soundux::Objects::Metadata &obj)
+        {
+            j = {
+                {"length", obj.length},
+                {"channels", obj.channels},
+                {"sampleRate", obj.sampleRate},
+                {"lengthInMs", obj.lengthInMs},
+                {"modifiedDate", obj.modifiedDate},
+                {"analyzed", obj.analyzed},
+                {"hasWaveform", obj.hasWaveform},
+                {"loudness", obj.loudness},
+                {"truePeak", obj.truePeak},
+            };
+        }
+        static void from_json(const json &j, Soundux::Objects::Metadata &obj)
+        {
+            j.at("length").get_to(obj.length);
+            j.at("channels").get_to(obj.channels);
+            j.at("sampleRate").get_to(obj.sampleRate);
+            j.at("lengthInMs").get_to(obj.lengthInMs);
+            j.at("modifiedDate").get_to(obj.modifiedDate);
+
+            //* Not present in indexes written before the loudness analysis
+            if (j.find("analyzed") != j.end())
+            {
+                j.at("analyzed").get_to(obj.analyzed);
+                if (!j.at("loudness").is_null())
+                {
+                    obj.loudness = j.at("loudness").get<float>();
+                    obj.truePeak = j.at("truePeak").get<float>();
+                }
+            }
+            if (j.find("hasWaveform") != j.end())
+            {
+                j.at("hasWaveform").get_to(obj.hasWaveform);
+            }
+        }
+    };
     template <> struct adl_serializer<Soundux::Objects::PlayingSound>
     {
         static void to_json(json &j, const Soundux::Objects::PlayingSound &obj)
@@ -123,6 +246,29 @@ namespace nlohmann
             obj.readInMs.store(j.at("readInMs").get<std::uint64_t>());
         }
     };
+    template <> struct adl_serializer<Soundux::Objects::Lean<Soundux::Objects::PlayingSound>>
+    {
+        static void to_json(json &j, const Soundux::Objects::Lean<Soundux::Objects::PlayingSound> &obj)
+        {
+            const auto &sound = obj.value;
+            j = {
+                {"sound", {{"id", sound.sound.id}, {"name", sound.sound.name}}},
+                {"id", sound.id},
+                {"paused", sound.paused.load()},
+                {"repeat", sound.repeat.load()},
+                {"lengthInMs", sound.lengthInMs},
+                {"readInMs", sound.readInMs.load()},
+            };
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::Download>
+    {
+        static void to_json(json &j, const Soundux::Objects::Download &obj)
+        {
+            j = {{"id", obj.id},     {"url", obj.url},       {"eta", obj.eta},           {"file", obj.file},
+                 {"path", obj.path}, {"status", obj.status}, {"progress", obj.progress}};
+        }
+    };
     template <> struct adl_serializer<Soundux::Objects::Settings>
     {
         static void to_json(json &j, const Soundux::Objects::Settings &obj)
@@ -138,8 +284,21 @@ namespace nlohmann
                 {"localVolume", obj.localVolume},
                 {"remoteVolume", obj.remoteVolume},
                 {"audioBackend", obj.audioBackend},
+                {"uiUpdateRate", obj.uiUpdateRate},
+                {"maxDownloads", obj.maxDownloads},
+                {"importFormat", obj.importFormat},
+                {"normalizeImports", obj.normalizeImports},
+                {"routingIdleTimeout", obj.routingIdleTimeout},
+                {"maxPolyphony", obj.maxPolyphony},
+                {"voiceStealing", obj.voiceStealing},
+                {"restartOnRetrigger", obj.restartOnRetrigger},
+                {"preloadSounds", obj.preloadSounds},
+                {"loudnessTarget", obj.loudnessTarget},
+                {"normalizeLoudness", obj.normalizeLoudness},
                 {"deleteToTrash", obj.deleteToTrash},
                 {"pushToTalkKeys", obj.pushToTalkKeys},
+                {"pcmCacheBudget", obj.pcmCacheBudget},
+                {"latencyProfile", obj.latencyProfile},
                 {"tabHotkeysOnly", obj.tabHotkeysOnly},
                 {"minimizeToTray", obj.minimizeToTray},
                 {"allowOverlapping", obj.allowOverlapping},
@@ -185,8 +344,21 @@ namespace nlohmann
             get_to_safe(j, "syncVolumes", obj.syncVolumes);
             get_to_safe(j, "audioBackend", obj.audioBackend);
             get_to_safe(j, "remoteVolume", obj.remoteVolume);
+            get_to_safe(j, "uiUpdateRate", obj.uiUpdateRate);
+            get_to_safe(j, "maxDownloads", obj.maxDownloads);
+            get_to_safe(j, "importFormat", obj.importFormat);
+            get_to_safe(j, "normalizeImports", obj.normalizeImports);
+            get_to_safe(j, "routingIdleTimeout", obj.routingIdleTimeout);
+            get_to_safe(j, "maxPolyphony", obj.maxPolyphony);
+            get_to_safe(j, "voiceStealing", obj.voiceStealing);
+            get_to_safe(j, "restartOnRetrigger", obj.restartOnRetrigger);
+            get_to_safe(j, "preloadSounds", obj.preloadSounds);
+            get_to_safe(j, "loudnessTarget", obj.loudnessTarget);
+            get_to_safe(j, "normalizeLoudness", obj.normalizeLoudness);
             get_to_safe(j, "deleteToTrash", obj.deleteToTrash);
             get_to_safe(j, "pushToTalkKeys", obj.pushToTalkKeys);
+            get_to_safe(j, "pcmCacheBudget", obj.pcmCacheBudget);
+            get_to_safe(j, "latencyProfile", obj.latencyProfile);
             get_to_safe(j, "minimizeToTray", obj.minimizeToTray);
             get_to_safe(j, "tabHotkeysOnly", obj.tabHotkeysOnly);
             get_to_safe(j, "allowOverlapping", obj.allowOverlapping);
@@ -225,16 +397,43 @@ namespace nlohmann
             j = {{"height", obj.height},
                  {"width", obj.width},
                  {"tabs", obj.tabs},
-                 {"soundIdCounter", obj.soundIdCounter}};
+                 {"soundIdCounter", obj.soundIdCounter.load()}};
         }
         static void from_json(const json &j, Soundux::Objects::Data &obj)
         {
-            j.at("soundIdCounter").get_to(obj.soundIdCounter);
+            obj.soundIdCounter = j.at("soundIdCounter").get<std::uint32_t>();
             j.at("height").get_to(obj.height);
             j.at("width").get_to(obj.width);
             j.at("tabs").get_to(obj.tabs);
         }
     };
+    template <> struct adl_serializer<Soundux::Objects::SoundOp>
+    {
+        static void to_json(json &j, const Soundux::Objects::SoundOp &obj)
+        {
+            j = {{"kind", obj.kind}, {"tab", obj.tab}, {"id", obj.id}};
+            if (obj.sound)
+            {
+                j["position"] = obj.position;
+                j["sound"] = *obj.sound;
+            }
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::TabChanges>
+    {
+        static void to_json(json &j, const Soundux::Objects::TabChanges &obj)
+        {
+            j = {{"since", obj.since},   {"revision", obj.revision}, {"full", obj.full},
+                 {"layout", obj.layout}, {"tabs", obj.tabs},         {"sounds", obj.sounds}};
+        }
+    };
+    template <> struct adl_serializer<Soundux::Objects::SoundPage>
+    {
+        static void to_json(json &j, const Soundux::Objects::SoundPage &obj)
+        {
+            j = {{"tab", obj.tab}, {"offset", obj.offset}, {"total", obj.total}, {"sounds", obj.sounds}};
+        }
+    };
     template <> struct adl_serializer<Soundux::Objects::Config>
     {
         static void to_json(json &j, const Soundux::Objects::Config &obj)
@@ -18,6 +18,17 @@
 #include <Windows.h>
 #include <shellapi.h>
 #include <stringapiset.h>
+#elif defined(__linux__)
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
 #endif
 
 namespace Soundux
@@ -76,6 +87,77 @@ namespace Soundux
         WideCharToMultiByte(65001, 0, s.c_str(), -1, &out[0], wsz, nullptr, nullptr);
         return out;
     }
+#endif
+#if defined(__linux__)
+    static std::optional<int> readParentPid(int pid)
+    {
+        std::array<char, 32> path{};
+        std::snprintf(path.data(), path.size(), "/proc/%d/stat", pid);
+
+        auto fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+
+        //* Everything up to the ppid fits, even with the longest possible process name
+        std::array<char, 128> buffer{};
+        auto length = read(fd, buffer.data(), buffer.size() - 1);
+        close(fd);
+
+        if (length <= 0)
+        {
+            return std::nullopt;
+        }
+
+        //* The format is "pid (comm) state ppid ...", comm may contain spaces and parentheses
+        const auto *end = buffer.data() + length;
+        const auto *cursor = static_cast<const char *>(memrchr(buffer.data(), ')', static_cast<std::size_t>(length)));
+        if (!cursor || end - cursor < 5)
+        {
+            return std::nullopt;
+        }
+        cursor += 4;
+
+        int ppid = 0;
+        if (std::from_chars(cursor, end, ppid).ec != std::errc{})
+        {
+            return std::nullopt;
+        }
+
+        return ppid;
+    }
+    std::optional<int> Helpers::getParentPid(int pid)
+    {
+        //* Pids are reused, so entries only stay valid for a short while
+        static constexpr auto lifetime = std::chrono::seconds(5);
+        static constexpr std::size_t maxEntries = 1024;
+
+        static std::mutex mutex;
+        static std::unordered_map<int, std::pair<int, std::chrono::steady_clock::time_point>> cache;
+
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard lock(mutex);
+            if (auto entry = cache.find(pid); entry != cache.end() && now - entry->second.second < lifetime)
+            {
+                return entry->second.first;
+            }
+        }
+
+        auto ppid = readParentPid(pid);
+        if (ppid)
+        {
+            std::lock_guard lock(mutex);
+            if (cache.size() >= maxEntries)
+            {
+                cache.clear();
+            }
+            cache[pid] = {*ppid, now};
+        }
+
+        return ppid;
+    }
 #endif
     bool Helpers::deleteFile(const std::string &path, bool trash)
     {
@@ -158,6 +240,85 @@ namespace Soundux
         }
 
         return true;
+#endif
+    }
+    //* Makes sure the content of `path` reached the disk, otherwise a crash after the rename may leave an empty file
+    static bool syncFile(const std::filesystem::path &path)
+    {
+#if defined(_WIN32)
+        auto *handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        auto rtn = FlushFileBuffers(handle) != 0;
+        CloseHandle(handle);
+        return rtn;
+#else
+        auto fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        auto rtn = fsync(fd) == 0;
+        close(fd);
+        return rtn;
+#endif
+    }
+    bool Helpers::writeFileAtomically(const std::string &path, const std::string &content)
+    {
+#if defined(_WIN32)
+        std::filesystem::path target = widen(path);
+#else
+        std::filesystem::path target = path;
+#endif
+        auto temporary = target;
+        temporary += ".tmp";
+
+        std::error_code ec;
+        std::filesystem::create_directories(target.parent_path(), ec);
+
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+        stream.close();
+
+        if (!stream || !syncFile(temporary))
+        {
+            Fancy::fancy.logTime().failure() << "Failed to write " << path << std::endl;
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+
+        std::filesystem::rename(temporary, target, ec);
+        if (ec)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to replace " << path << " error: " << ec.message() << "("
+                                             << ec.value() << ")" << std::endl;
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+
+#if !defined(_WIN32)
+        //* The rename itself is only durable once the directory entry is written
+        if (auto fd = open(target.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); fd >= 0)
+        {
+            fsync(fd);
+            close(fd);
+        }
+#endif
+
+        return true;
+    }
+    void Helpers::lowerThreadPriority()
+    {
+#if defined(_WIN32)
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+        //* On linux the nice value is per thread
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
 #endif
     }
 } // namespace Soundux
\ No newline at end of file
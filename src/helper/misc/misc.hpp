@@ -10,8 +10,16 @@ namespace Soundux
 #if defined(_WIN32)
         std::wstring widen(const std::string &);
         std::string narrow(const std::wstring &);
+#endif
+#if defined(__linux__)
+        //* Reads the parent of `pid` from /proc without allocating, results are cached for a few seconds
+        std::optional<int> getParentPid(int pid);
 #endif
         bool deleteFile(const std::string &, bool = true);
+        //* Writes to a temporary file next to `path` and renames it, so `path` never contains a partial write
+        bool writeFileAtomically(const std::string &path, const std::string &content);
+        //* Lets the calling thread only run when nothing else wants the cpu, for background work like preloading
+        void lowerThreadPriority();
 
         bool run(const std::string &);
         std::pair<std::string, bool> getResultCompact(const std::string &);
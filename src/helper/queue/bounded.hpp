@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Fixed-capacity multi-producer multi-consumer queue (Vyukov), push and pop never lock or allocate.
+        //* `Capacity` has to be a power of two.
+        template <typename T, std::size_t Capacity> class BoundedQueue
+        {
+            static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+            struct Cell
+            {
+                std::atomic<std::size_t> sequence;
+                T data;
+            };
+
+            alignas(64) std::array<Cell, Capacity> cells;
+            alignas(64) std::atomic<std::size_t> head = 0;
+            alignas(64) std::atomic<std::size_t> tail = 0;
+
+          public:
+            BoundedQueue()
+            {
+                for (std::size_t i = 0; Capacity > i; i++)
+                {
+                    cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+            BoundedQueue(const BoundedQueue &) = delete;
+            BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+            //* Returns false if the queue is full
+            bool push(T item)
+            {
+                auto position = tail.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    auto &cell = cells[position & (Capacity - 1)];
+                    auto sequence = cell.sequence.load(std::memory_order_acquire);
+                    auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                    if (difference == 0)
+                    {
+                        if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            cell.data = std::move(item);
+                            cell.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (difference < 0)
+                    {
+                        return false;
+                    }
+                    else
+                    {
+                        position = tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+            //* Only a snapshot, may be off while other threads push or pop
+            std::size_t size() const
+            {
+                auto first = head.load(std::memory_order_relaxed);
+                auto last = tail.load(std::memory_order_relaxed);
+
+                return last > first ? last - first : 0;
+            }
+            std::optional<T> pop()
+            {
+                auto position = head.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    auto &cell = cells[position & (Capacity - 1)];
+                    auto sequence = cell.sequence.load(std::memory_order_acquire);
+                    auto difference =
+                        static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+                    if (difference == 0)
+                    {
+                        if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            T item = std::move(cell.data);
+                            cell.sequence.store(position + Capacity, std::memory_order_release);
+                            return item;
+                        }
+                    }
+                    else if (difference < 0)
+                    {
+                        return std::nullopt;
+                    }
+                    else
+                    {
+                        position = head.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -1,23 +1,98 @@
 #include "queue.hpp"
+#include <algorithm>
+#include <helper/misc/misc.hpp>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
 
 namespace Soundux::Objects
 {
+#if defined(_WIN32)
+    struct Queue::Native
+    {
+        HANDLE semaphore = CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr);
+
+        Native() = default;
+        Native(const Native &) = delete;
+        Native &operator=(const Native &) = delete;
+        ~Native()
+        {
+            CloseHandle(semaphore);
+        }
+
+        void post()
+        {
+            ReleaseSemaphore(semaphore, 1, nullptr);
+        }
+        void wait()
+        {
+            WaitForSingleObject(semaphore, INFINITE);
+        }
+    };
+#else
+    struct Queue::Native
+    {
+        sem_t semaphore{};
+
+        Native()
+        {
+            sem_init(&semaphore, 0, 0);
+        }
+        Native(const Native &) = delete;
+        Native &operator=(const Native &) = delete;
+        ~Native()
+        {
+            sem_destroy(&semaphore);
+        }
+
+        //* Async-signal-safe, only enters the kernel if the waker is asleep
+        void post()
+        {
+            sem_post(&semaphore);
+        }
+        void wait()
+        {
+            while (sem_wait(&semaphore) != 0 && errno == EINTR)
+            {
+            }
+        }
+    };
+#endif
+
+    void Queue::drainIntake()
+    {
+        while (auto task = intake.pop())
+        {
+            if (keys.emplace(task->key).second)
+            {
+                queue.emplace_back(std::move(*task));
+            }
+        }
+    }
     void Queue::handle()
     {
         std::unique_lock lock(queueMutex);
         while (!stop)
         {
-            cv.wait(lock, [&]() { return !queue.empty() || stop; });
-            while (!queue.empty())
+            drainIntake();
+            if (queue.empty())
             {
-                auto front = std::move(*queue.begin());
+                cv.wait(lock, [this] { return stop || !queue.empty() || intake.size() > 0; });
+                continue;
+            }
 
-                lock.unlock();
-                front.second();
-                lock.lock();
+            auto task = std::move(queue.front());
+            queue.pop_front();
 
-                queue.erase(front.first);
-            }
+            lock.unlock();
+            task.function();
+            lock.lock();
+
+            keys.erase(task.key);
         }
     }
 
@@ -25,27 +100,92 @@ namespace Soundux::Objects
     {
         {
             std::lock_guard lock(queueMutex);
-            if (queue.find(id) != queue.end())
+            if (!keys.emplace(id).second)
             {
                 return;
             }
-        }
 
-        std::unique_lock lock(queueMutex);
-        queue.emplace(id, std::move(function));
-        lock.unlock();
+            queue.push_back({id, std::move(function)});
+        }
 
         cv.notify_one();
     }
+    bool Queue::post_unique(std::uint64_t id, std::function<void()> function)
+    {
+        if (!intake.push({id, std::move(function)}))
+        {
+            return false;
+        }
+
+        //* Posts that arrive before the waker cleared the flag are picked up by the worker it wakes
+        if (!posted.exchange(true, std::memory_order_acq_rel))
+        {
+            native->post();
+        }
+
+        return true;
+    }
+    void Queue::wake()
+    {
+        while (true)
+        {
+            native->wait();
+            if (stop)
+            {
+                break;
+            }
+
+            posted.store(false, std::memory_order_release);
+
+            //* Taking the lock makes sure that a worker is either waiting already or will see the intake
+            {
+                std::lock_guard lock(queueMutex);
+            }
+            cv.notify_one();
+        }
+    }
+    void Queue::discardPosts()
+    {
+        while (intake.pop())
+        {
+        }
+    }
+    std::size_t Queue::getBacklog()
+    {
+        std::lock_guard lock(queueMutex);
+        return queue.size() + intake.size();
+    }
 
-    Queue::Queue()
+    Queue::Queue() : Queue(std::clamp(std::thread::hardware_concurrency(), 2u, 4u), false) {}
+    Queue::Queue(unsigned int workerCount, bool lowPriority) : native(std::make_unique<Native>())
     {
-        handler = std::thread([this] { handle(); });
+        waker = std::thread([this] { wake(); });
+        for (unsigned int i = 0; workerCount > i; i++)
+        {
+            workers.emplace_back([this, lowPriority] {
+                if (lowPriority)
+                {
+                    Helpers::lowerThreadPriority();
+                }
+                handle();
+            });
+        }
     }
     Queue::~Queue()
     {
-        stop = true;
+        {
+            std::lock_guard lock(queueMutex);
+            stop = true;
+        }
         cv.notify_all();
-        handler.join();
+        native->post();
+
+        waker.join();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        discardPosts();
     }
-} // namespace Soundux::Objects
\ No newline at end of file
+} // namespace Soundux::Objects
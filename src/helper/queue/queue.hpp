@@ -1,32 +1,69 @@
 #pragma once
+#include "bounded.hpp"
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
-#include <map>
-#include <queue>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
 namespace Soundux
 {
     namespace Objects
     {
+        //* Runs tasks on a small pool of workers. A task is dropped if a task with the same key is still pending or
+        //* running, so there is never more than one task per key in flight and tasks of a key run in push order.
         class Queue
         {
-            std::map<std::uint64_t, std::function<void()>> queue;
+            struct Task
+            {
+                std::uint64_t key = 0;
+                std::function<void()> function;
+            };
+
+            std::deque<Task> queue;
+            std::unordered_set<std::uint64_t> keys;
             std::mutex queueMutex;
 
+            //* Filled by `post_unique`, moved into `queue` by the workers
+            BoundedQueue<Task, 256> intake;
+            //* Set by `post_unique`, cleared by the waker before it wakes a worker
+            std::atomic<bool> posted = false;
+
+            //* Semaphore that `post_unique` signals, the waker thread turns it into a notification of `cv`
+            struct Native;
+            std::unique_ptr<Native> native;
+            std::thread waker;
+
             std::condition_variable cv;
-            std::atomic<bool> stop;
-            std::thread handler;
+            std::atomic<bool> stop = false;
+            std::vector<std::thread> workers;
 
           private:
             void handle();
+            void wake();
+            void drainIntake();
 
           public:
             Queue();
+            //* `lowPriority` workers only run when nothing else wants the cpu
+            Queue(unsigned int workerCount, bool lowPriority);
             ~Queue();
 
             void push_unique(std::uint64_t, std::function<void()>);
+            //* Never locks or blocks, meant to be called from the audio callback. Keep the function small enough to
+            //* not allocate (a capture of a few words). Returns false if the intake is full.
+            //* Only the first post after the waker ran signals its semaphore, which never blocks either.
+            bool post_unique(std::uint64_t, std::function<void()>);
+            //* Drops everything that was posted but not picked up by a worker yet
+            void discardPosts();
+
+            //* Tasks that are waiting for a worker
+            std::size_t getBacklog();
         };
     } // namespace Objects
-} // namespace Soundux
\ No newline at end of file
+} // namespace Soundux
@@ -0,0 +1,191 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <core/global/globals.hpp>
+#include <map>
+#include <nlohmann/json.hpp>
+
+namespace Soundux::Objects
+{
+    Tracer::Scope::Scope(TracePoint point)
+    {
+        if (active != 0)
+        {
+            Globals::gTracer.mark(active, point);
+            return;
+        }
+
+        if (Globals::gTracer.isEnabled())
+        {
+            active = ++Globals::gTracer.nextTrace;
+            owner = true;
+
+            Globals::gTracer.record(active, point);
+        }
+    }
+    Tracer::Scope::~Scope()
+    {
+        if (owner)
+        {
+            active = 0;
+        }
+    }
+    void Tracer::enable(bool state)
+    {
+        enabled = state;
+    }
+    bool Tracer::isEnabled() const
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    void Tracer::record(std::uint64_t trace, TracePoint point)
+    {
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+
+        auto index = head.fetch_add(1, std::memory_order_relaxed);
+        auto &event = events[index % capacity];
+
+        event.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        event.trace.store(trace, std::memory_order_relaxed);
+        event.time.store(time, std::memory_order_relaxed);
+        event.point.store(point, std::memory_order_relaxed);
+
+        event.sequence.store(index * 2 + 2, std::memory_order_release);
+    }
+    std::vector<Tracer::Record> Tracer::collect() const
+    {
+        std::vector<Record> rtn;
+        rtn.reserve(capacity);
+
+        for (const auto &event : events)
+        {
+            auto before = event.sequence.load(std::memory_order_acquire);
+            Record item{event.trace.load(std::memory_order_relaxed), event.time.load(std::memory_order_relaxed),
+                        event.point.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            //* Skip slots that were never written or were overwritten while we read them
+            if (before == 0 || before % 2 != 0 || event.sequence.load(std::memory_order_relaxed) != before)
+            {
+                continue;
+            }
+
+            rtn.emplace_back(item);
+        }
+
+        std::sort(rtn.begin(), rtn.end(), [](const auto &first, const auto &second) {
+            return first.trace != second.trace ? first.trace < second.trace : first.time < second.time;
+        });
+
+        return rtn;
+    }
+    std::string Tracer::exportChrome() const
+    {
+        auto records = collect();
+        std::int64_t origin = 0;
+        if (!records.empty())
+        {
+            origin = std::min_element(records.begin(), records.end(), [](const auto &first, const auto &second) {
+                         return first.time < second.time;
+                     })->time;
+        }
+
+        auto toUs = [origin](std::int64_t time) { return static_cast<double>(time - origin) / 1000; };
+
+        auto events = nlohmann::json::array();
+        for (std::size_t i = 0; records.size() > i; i++)
+        {
+            const auto &item = records[i];
+            nlohmann::json event = {{"name", getName(item.point)}, {"pid", 0}, {"tid", item.trace}, {"cat", "trigger"}};
+
+            //* Every stage is shown as a span from the previous stage of the same trace
+            if (i > 0 && records[i - 1].trace == item.trace)
+            {
+                event["ph"] = "X";
+                event["ts"] = toUs(records[i - 1].time);
+                event["dur"] = toUs(item.time) - toUs(records[i - 1].time);
+            }
+            else
+            {
+                event["ph"] = "i";
+                event["s"] = "t";
+                event["ts"] = toUs(item.time);
+            }
+
+            events.emplace_back(std::move(event));
+        }
+
+        return nlohmann::json{{"traceEvents", events}, {"displayTimeUnit", "ms"}}.dump();
+    }
+    std::vector<TraceSummary> Tracer::summarize() const
+    {
+        auto records = collect();
+
+        //* A point may be marked more than once per trace (e.g. by several outputs), only the first one counts
+        std::map<TracePoint, std::vector<double>> latencies;
+        for (std::size_t start = 0; records.size() > start;)
+        {
+            auto end = start;
+            std::vector<TracePoint> seen;
+
+            for (; records.size() > end && records[end].trace == records[start].trace; end++)
+            {
+                if (end == start || std::find(seen.begin(), seen.end(), records[end].point) != seen.end())
+                {
+                    continue;
+                }
+
+                seen.emplace_back(records[end].point);
+                latencies[records[end].point].emplace_back(
+                    static_cast<double>(records[end].time - records[start].time) / 1e6);
+            }
+
+            start = end;
+        }
+
+        auto percentile = [](const std::vector<double> &values, double share) {
+            auto index = static_cast<std::size_t>(share * static_cast<double>(values.size() - 1) + .5);
+            return values[index];
+        };
+
+        std::vector<TraceSummary> rtn;
+        for (auto &[point, values] : latencies)
+        {
+            std::sort(values.begin(), values.end());
+
+            TraceSummary summary;
+            summary.point = getName(point);
+            summary.count = values.size();
+            summary.p50InMs = percentile(values, .5);
+            summary.p99InMs = percentile(values, .99);
+
+            rtn.emplace_back(summary);
+        }
+
+        return rtn;
+    }
+    const char *Tracer::getName(TracePoint point)
+    {
+        switch (point)
+        {
+        case TracePoint::HotkeyReceived:
+            return "HotkeyReceived";
+        case TracePoint::PlayRequested:
+            return "PlayRequested";
+        case TracePoint::DecoderOpened:
+            return "DecoderOpened";
+        case TracePoint::VoicesAdded:
+            return "VoicesAdded";
+        case TracePoint::FirstCallback:
+            return "FirstCallback";
+        case TracePoint::RoutingDone:
+            return "RoutingDone";
+        }
+
+        return "Unknown";
+    }
+} // namespace Soundux::Objects
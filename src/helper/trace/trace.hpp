@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* The stages of a single trigger, in the order they usually happen
+        enum class TracePoint : std::uint8_t
+        {
+            HotkeyReceived,
+            PlayRequested,
+            DecoderOpened,
+            VoicesAdded,
+            FirstCallback,
+            RoutingDone,
+        };
+
+        struct TraceSummary
+        {
+            std::string point;
+            std::size_t count = 0;
+            //* Measured from the first point of the trace
+            double p50InMs = 0;
+            double p99InMs = 0;
+        };
+
+        //* Records the stages of every trigger into a fixed ring buffer, safe to use from the audio callback. While
+        //* tracing is disabled no trace is started, so every mark is a single branch.
+        class Tracer
+        {
+          public:
+            static constexpr std::size_t capacity = 4096;
+
+            //* Starts a trace on this thread, or marks `point` on the trace that is already running on it
+            class Scope
+            {
+                bool owner = false;
+
+              public:
+                explicit Scope(TracePoint point);
+                Scope(const Scope &) = delete;
+                Scope &operator=(const Scope &) = delete;
+                ~Scope();
+            };
+
+          private:
+            struct Event
+            {
+                //* Odd while the event is written
+                std::atomic<std::uint64_t> sequence = 0;
+                std::atomic<std::uint64_t> trace = 0;
+                std::atomic<std::int64_t> time = 0;
+                std::atomic<TracePoint> point = TracePoint::HotkeyReceived;
+            };
+            struct Record
+            {
+                std::uint64_t trace;
+                std::int64_t time;
+                TracePoint point;
+            };
+
+            static inline thread_local std::uint64_t active = 0;
+
+            std::atomic<bool> enabled = false;
+            std::atomic<std::uint64_t> nextTrace = 0;
+            std::atomic<std::uint64_t> head = 0;
+            std::array<Event, capacity> events;
+
+            void record(std::uint64_t trace, TracePoint point);
+            //* Sorted by trace and time
+            std::vector<Record> collect() const;
+
+          public:
+            void enable(bool);
+            bool isEnabled() const;
+
+            //* The trace running on this thread, 0 if there is none
+            static std::uint64_t current()
+            {
+                return active;
+            }
+
+            void mark(std::uint64_t trace, TracePoint point)
+            {
+                if (trace != 0)
+                {
+                    record(trace, point);
+                }
+            }
+
+            //* Chrome trace event format, every trace is shown as its own thread
+            std::string exportChrome() const;
+            std::vector<TraceSummary> summarize() const;
+
+            static const char *getName(TracePoint);
+        };
+    } // namespace Objects
+} // namespace Soundux
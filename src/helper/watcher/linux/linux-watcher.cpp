@@ -0,0 +1,150 @@
+#if defined(__linux__)
+#include "../watcher.hpp"
+#include <array>
+#include <fancy.hpp>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace Soundux::Objects
+{
+    struct Watcher::Native
+    {
+        int fd = -1;
+        std::mutex mutex;
+        std::map<int, std::string> directories;
+    };
+
+    Watcher::Watcher() : native(std::make_unique<Native>()) {}
+    Watcher::~Watcher()
+    {
+        destroy();
+    }
+    bool Watcher::setup(Callback newCallback)
+    {
+        if (running)
+        {
+            return true;
+        }
+
+        native->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (native->fd < 0)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to initialize inotify" << std::endl;
+            return false;
+        }
+
+        callback = std::move(newCallback);
+        running = true;
+        thread = std::thread([this] { run(); });
+
+        return true;
+    }
+    void Watcher::destroy()
+    {
+        if (running)
+        {
+            running = false;
+            thread.join();
+        }
+
+        if (native->fd >= 0)
+        {
+            close(native->fd);
+            native->fd = -1;
+        }
+
+        std::lock_guard lock(native->mutex);
+        native->directories.clear();
+    }
+    bool Watcher::watch(const std::string &directory)
+    {
+        if (native->fd < 0)
+        {
+            return false;
+        }
+
+        //* IN_CLOSE_WRITE instead of IN_CREATE so that files are only picked up once they were written completely
+        auto wd = inotify_add_watch(native->fd, directory.c_str(),
+                                    IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+        if (wd < 0)
+        {
+            Fancy::fancy.logTime().warning() << "Failed to watch " << directory << std::endl;
+            return false;
+        }
+
+        std::lock_guard lock(native->mutex);
+        native->directories[wd] = directory;
+
+        return true;
+    }
+    void Watcher::unwatch(const std::string &directory)
+    {
+        std::lock_guard lock(native->mutex);
+        for (auto it = native->directories.begin(); it != native->directories.end(); it++)
+        {
+            if (it->second == directory)
+            {
+                inotify_rm_watch(native->fd, it->first);
+                native->directories.erase(it);
+                break;
+            }
+        }
+    }
+    void Watcher::poll()
+    {
+        pollfd pfd{native->fd, POLLIN, 0};
+        if (::poll(&pfd, 1, 100) <= 0 || !(pfd.revents & POLLIN))
+        {
+            return;
+        }
+
+        alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+        while (true)
+        {
+            auto length = read(native->fd, buffer.data(), buffer.size());
+            if (length <= 0)
+            {
+                break;
+            }
+
+            for (auto *ptr = buffer.data(); buffer.data() + length > ptr;)
+            {
+                const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                //* Events were dropped by the kernel, we can not tell which directories they belonged to
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    std::lock_guard lock(native->mutex);
+                    for (const auto &directory : native->directories)
+                    {
+                        onOverflow(directory.second);
+                    }
+                    continue;
+                }
+
+                //* Events of directories (like a sub folder being created) are not of interest
+                if (event->len == 0 || (event->mask & IN_ISDIR))
+                {
+                    continue;
+                }
+
+                std::string directory;
+                {
+                    std::lock_guard lock(native->mutex);
+                    if (auto it = native->directories.find(event->wd); it != native->directories.end())
+                    {
+                        directory = it->second;
+                    }
+                }
+
+                if (!directory.empty())
+                {
+                    onEvent(directory, event->name);
+                }
+            }
+        }
+    }
+} // namespace Soundux::Objects
+#endif
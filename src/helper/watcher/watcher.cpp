@@ -0,0 +1,60 @@
+#include "watcher.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace Soundux::Objects
+{
+    void Watcher::run()
+    {
+        while (running)
+        {
+            poll();
+            flush();
+        }
+    }
+    void Watcher::onEvent(const std::string &directory, std::string file)
+    {
+        std::replace(file.begin(), file.end(), '\\', '/');
+
+        std::lock_guard lock(pendingMutex);
+        pending[directory].emplace(directory + "/" + file);
+        lastEvent = std::chrono::steady_clock::now();
+    }
+    void Watcher::onOverflow(const std::string &directory)
+    {
+        std::lock_guard lock(pendingMutex);
+        overflowed.emplace(directory);
+        lastEvent = std::chrono::steady_clock::now();
+    }
+    void Watcher::flush(bool force)
+    {
+        std::map<std::string, std::set<std::string>> events;
+        {
+            std::lock_guard lock(pendingMutex);
+            if ((pending.empty() && overflowed.empty()) ||
+                (!force && std::chrono::steady_clock::now() - lastEvent < 250ms))
+            {
+                return;
+            }
+
+            events.swap(pending);
+
+            //* The rescan picks up the pending files as well
+            for (const auto &directory : overflowed)
+            {
+                events[directory].clear();
+            }
+            overflowed.clear();
+        }
+
+        if (callback)
+        {
+            for (const auto &[directory, files] : events)
+            {
+                callback(directory, files);
+            }
+        }
+    }
+} // namespace Soundux::Objects
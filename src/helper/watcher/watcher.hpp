@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Watches the tab directories (not recursively) and reports the files that were added, changed, removed or
+        //* renamed. Events are collected until a directory has been quiet for a moment, so a download or a copy of many
+        //* files is reported once.
+        class Watcher
+        {
+          public:
+            //* Directory as it was passed to `watch`, and the full paths (forward slashes) of the touched files. The files
+            //* are empty if events were lost, in which case the whole directory has to be rescanned.
+            using Callback = std::function<void(const std::string &, const std::set<std::string> &)>;
+
+          private:
+            struct Native;
+            std::unique_ptr<Native> native;
+
+            Callback callback;
+            std::thread thread;
+            std::atomic<bool> running = false;
+
+            std::mutex pendingMutex;
+            std::map<std::string, std::set<std::string>> pending;
+            std::set<std::string> overflowed;
+            std::chrono::steady_clock::time_point lastEvent;
+
+            void run();
+            void poll();
+            void flush(bool force = false);
+            void onEvent(const std::string &directory, std::string file);
+            void onOverflow(const std::string &directory);
+
+          public:
+            Watcher();
+            ~Watcher();
+
+            bool setup(Callback);
+            void destroy();
+
+            bool watch(const std::string &);
+            void unwatch(const std::string &);
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -0,0 +1,220 @@
+#if defined(_WIN32)
+#include "../watcher.hpp"
+#include <Windows.h>
+#include <algorithm>
+#include <array>
+#include <fancy.hpp>
+#include <helper/misc/misc.hpp>
+#include <vector>
+
+namespace Soundux::Objects
+{
+    namespace
+    {
+        struct Directory
+        {
+            std::string path;
+            HANDLE handle = INVALID_HANDLE_VALUE;
+            OVERLAPPED overlapped{};
+            alignas(DWORD) std::array<char, 16 * 1024> buffer;
+        };
+    } // namespace
+
+    //* Overlapped reads have to be issued and cancelled by the thread that waits on them, so `watch` and `unwatch`
+    //* only queue requests and wake up the watcher thread
+    struct Watcher::Native
+    {
+        HANDLE wakeup = nullptr;
+
+        std::mutex mutex;
+        std::vector<std::string> toAdd;
+        std::vector<std::string> toRemove;
+
+        std::vector<std::unique_ptr<Directory>> directories;
+        bool warnedAboutLimit = false;
+    };
+
+    static bool request(Directory &directory)
+    {
+        return ReadDirectoryChangesW(directory.handle, directory.buffer.data(),
+                                     static_cast<DWORD>(directory.buffer.size()), FALSE,
+                                     FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr,
+                                     &directory.overlapped, nullptr);
+    }
+    static void release(Directory &directory)
+    {
+        CancelIoEx(directory.handle, &directory.overlapped);
+
+        DWORD transferred{};
+        GetOverlappedResult(directory.handle, &directory.overlapped, &transferred, TRUE);
+
+        CloseHandle(directory.overlapped.hEvent);
+        CloseHandle(directory.handle);
+    }
+
+    Watcher::Watcher() : native(std::make_unique<Native>()) {}
+    Watcher::~Watcher()
+    {
+        destroy();
+    }
+    bool Watcher::setup(Callback newCallback)
+    {
+        if (running)
+        {
+            return true;
+        }
+
+        native->wakeup = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!native->wakeup)
+        {
+            Fancy::fancy.logTime().failure() << "Failed to create watcher event" << std::endl;
+            return false;
+        }
+
+        callback = std::move(newCallback);
+        running = true;
+        thread = std::thread([this] { run(); });
+
+        return true;
+    }
+    void Watcher::destroy()
+    {
+        if (running)
+        {
+            running = false;
+            SetEvent(native->wakeup);
+            thread.join();
+        }
+
+        for (auto &directory : native->directories)
+        {
+            release(*directory);
+        }
+        native->directories.clear();
+
+        if (native->wakeup)
+        {
+            CloseHandle(native->wakeup);
+            native->wakeup = nullptr;
+        }
+    }
+    bool Watcher::watch(const std::string &directory)
+    {
+        if (!native->wakeup)
+        {
+            return false;
+        }
+
+        {
+            std::lock_guard lock(native->mutex);
+            native->toAdd.emplace_back(directory);
+        }
+
+        SetEvent(native->wakeup);
+        return true;
+    }
+    void Watcher::unwatch(const std::string &directory)
+    {
+        {
+            std::lock_guard lock(native->mutex);
+            native->toRemove.emplace_back(directory);
+        }
+
+        SetEvent(native->wakeup);
+    }
+    void Watcher::poll()
+    {
+        {
+            std::lock_guard lock(native->mutex);
+            for (const auto &path : native->toRemove)
+            {
+                auto it = std::find_if(native->directories.begin(), native->directories.end(),
+                                       [&](const auto &item) { return item->path == path; });
+                if (it != native->directories.end())
+                {
+                    release(**it);
+                    native->directories.erase(it);
+                }
+            }
+            for (const auto &path : native->toAdd)
+            {
+                auto directory = std::make_unique<Directory>();
+                directory->path = path;
+                directory->handle = CreateFileW(Helpers::widen(path).c_str(), FILE_LIST_DIRECTORY,
+                                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                                OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                                                nullptr);
+
+                if (directory->handle == INVALID_HANDLE_VALUE)
+                {
+                    Fancy::fancy.logTime().warning() << "Failed to watch " << path << std::endl;
+                    continue;
+                }
+
+                directory->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+                if (!request(*directory))
+                {
+                    Fancy::fancy.logTime().warning() << "Failed to watch " << path << std::endl;
+                    CloseHandle(directory->overlapped.hEvent);
+                    CloseHandle(directory->handle);
+                    continue;
+                }
+
+                native->directories.emplace_back(std::move(directory));
+            }
+
+            native->toAdd.clear();
+            native->toRemove.clear();
+        }
+
+        std::vector<HANDLE> handles{native->wakeup};
+        for (const auto &directory : native->directories)
+        {
+            if (handles.size() == MAXIMUM_WAIT_OBJECTS)
+            {
+                if (!native->warnedAboutLimit)
+                {
+                    Fancy::fancy.logTime().warning()
+                        << "Too many directories to watch, some tabs will not be updated" << std::endl;
+                    native->warnedAboutLimit = true;
+                }
+                break;
+            }
+            handles.emplace_back(directory->overlapped.hEvent);
+        }
+
+        auto result = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, 100);
+        if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + handles.size())
+        {
+            return;
+        }
+
+        auto &directory = *native->directories.at(result - WAIT_OBJECT_0 - 1);
+
+        DWORD transferred{};
+        if (!GetOverlappedResult(directory.handle, &directory.overlapped, &transferred, FALSE) ||
+            transferred == 0)
+        {
+            //* The buffer overflowed, so the changes are unknown
+            onOverflow(directory.path);
+        }
+        else
+        {
+            for (auto *ptr = directory.buffer.data();;)
+            {
+                const auto *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(ptr);
+                onEvent(directory.path, Helpers::narrow(std::wstring(info->FileName, info->FileNameLength / 2)));
+
+                if (info->NextEntryOffset == 0)
+                {
+                    break;
+                }
+                ptr += info->NextEntryOffset;
+            }
+        }
+
+        ResetEvent(directory.overlapped.hEvent);
+        request(directory);
+    }
+} // namespace Soundux::Objects
+#endif
@@ -1,4 +1,5 @@
 #include "youtube-dl.hpp"
+#include <algorithm>
 #include <core/global/globals.hpp>
 #include <fancy.hpp>
 #include <helper/misc/misc.hpp>
@@ -9,7 +10,109 @@ namespace Soundux::Objects
     const std::regex YoutubeDl::urlRegex(
         R"(https?:\/\/(www\.)?[-a-zA-Z0-9@:%._\+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b([-a-zA-Z0-9()@:%_\+.~#?&\/\/=]*))");
 
-    void YoutubeDl::setup()
+    //* Parses lines like `[download]  42.5% of 3.20MiB at 1.05MiB/s ETA 00:02`
+    static bool parseProgress(std::string_view line, float &progress, std::string &eta)
+    {
+        auto percent = line.find('%');
+        auto etaStart = line.find("ETA ", percent);
+        if (percent == std::string_view::npos || etaStart == std::string_view::npos)
+        {
+            return false;
+        }
+
+        auto start = percent;
+        while (start > 0 && ((line[start - 1] >= '0' && line[start - 1] <= '9') || line[start - 1] == '.' ||
+                             line[start - 1] == ','))
+        {
+            start--;
+        }
+
+        float value = 0, scale = 0;
+        bool digits = false;
+        for (auto i = start; percent > i; i++)
+        {
+            if (line[i] == '.' || line[i] == ',')
+            {
+                scale = 1;
+                continue;
+            }
+
+            digits = true;
+            if (scale > 0)
+            {
+                scale /= 10;
+                value += static_cast<float>(line[i] - '0') * scale;
+            }
+            else
+            {
+                value = value * 10 + static_cast<float>(line[i] - '0');
+            }
+        }
+
+        if (!digits)
+        {
+            return false;
+        }
+
+        auto rest = line.substr(etaStart + 4);
+        rest = rest.substr(0, rest.find_last_not_of(" \t") + 1);
+
+        progress = value;
+        eta.assign(rest);
+
+        return true;
+    }
+
+    //* Imports are decoded by miniaudio, which only reads mp3, flac and wav. Lossless imports are converted to the
+    //* rate of the outputs so that playing them neither decodes mp3 frames nor resamples.
+    static std::string getImportArguments()
+    {
+        const auto format = Globals::gSettings.importFormat;
+        if (format == Enums::ImportFormat::Mp3 && !Globals::gSettings.normalizeImports)
+        {
+            return "--extract-audio --audio-format mp3";
+        }
+
+        std::string rtn = "--extract-audio --audio-format ";
+        switch (format)
+        {
+        case Enums::ImportFormat::Flac:
+            rtn += "flac";
+            break;
+        case Enums::ImportFormat::Wav:
+            rtn += "wav";
+            break;
+        default:
+            rtn += "mp3";
+            break;
+        }
+
+        //* loudnorm resamples to 192kHz, so the rate is always set when normalizing
+        auto sampleRate = Globals::gAudio.getSampleRate();
+        if (sampleRate == 0 && Globals::gSettings.normalizeImports)
+        {
+            sampleRate = 48000;
+        }
+
+        std::string postprocessor;
+        if (sampleRate > 0)
+        {
+            postprocessor += "-ar " + std::to_string(sampleRate);
+        }
+        if (Globals::gSettings.normalizeImports)
+        {
+            postprocessor += " -af loudnorm=I=-16:TP=-1.5:LRA=11";
+        }
+
+        if (!postprocessor.empty())
+        {
+            rtn += " --postprocessor-args \"" + postprocessor + "\"";
+        }
+
+        return rtn;
+    }
+
+    static bool probe()
     {
         TinyProcessLib::Process ytdlVersion(
             "youtube-dl --version", "", []([[maybe_unused]] const char *message, [[maybe_unused]] std::size_t size) {},
@@ -18,15 +121,21 @@ namespace Soundux::Objects
             "ffmpeg -version", "", []([[maybe_unused]] const char *message, [[maybe_unused]] std::size_t size) {},
             []([[maybe_unused]] const char *message, [[maybe_unused]] std::size_t size) {});
 
-        isAvailable = ytdlVersion.get_exit_status() == 0 && ffmpegVersion.get_exit_status() == 0;
-        if (!isAvailable)
+        auto rtn = ytdlVersion.get_exit_status() == 0 && ffmpegVersion.get_exit_status() == 0;
+        if (!rtn)
         {
             Fancy::fancy.logTime().warning() << "youtube-dl or ffmpeg is not available!" << std::endl;
         }
+
+        return rtn;
+    }
+    void YoutubeDl::setup()
+    {
+        isAvailable = std::async(std::launch::async, probe).share();
     }
     std::optional<nlohmann::json> YoutubeDl::getInfo(const std::string &url) const
     {
-        if (!isAvailable)
+        if (!available())
         {
             return std::nullopt;
         }
@@ -37,6 +146,15 @@ namespace Soundux::Objects
             return std::nullopt;
         }
 
+        {
+            std::lock_guard lock(infoMutex);
+            if (auto cached = infoIndex.find(url); cached != infoIndex.end())
+            {
+                infos.splice(infos.begin(), infos, cached->second);
+                return cached->second->second;
+            }
+        }
+
         auto [result, success] = Helpers::getResultCompact("youtube-dl -i -j \"" + url + "\"");
         if (success)
         {
@@ -62,6 +180,19 @@ namespace Soundux::Objects
                 j["uploader"] = json.at("uploader");
             }
 
+            std::lock_guard lock(infoMutex);
+            if (infoIndex.find(url) == infoIndex.end())
+            {
+                infos.emplace_front(url, j);
+                infoIndex.emplace(url, infos.begin());
+
+                if (infos.size() > maxCachedInfos)
+                {
+                    infoIndex.erase(infos.back().first);
+                    infos.pop_back();
+                }
+            }
+
             return j;
         }
 
@@ -69,76 +200,303 @@ namespace Soundux::Objects
         Globals::gGui->onError(Enums::ErrorCode::YtdlInformationUnknown);
         return std::nullopt;
     }
-    bool YoutubeDl::download(const std::string &url)
+    std::optional<std::uint32_t> YoutubeDl::download(const std::string &url, Callback onFinished)
     {
-        if (!isAvailable)
+        if (!available())
         {
             Globals::gGui->onError(Enums::ErrorCode::YtdlNotFound);
-            return false;
-        }
-
-        if (currentDownload)
-        {
-            killDownload();
+            return std::nullopt;
         }
 
         if (!std::regex_match(url, urlRegex))
         {
             Fancy::fancy.logTime().warning() << "Bad url " >> url << std::endl;
             Globals::gGui->onError(Enums::ErrorCode::YtdlInvalidUrl);
-            return false;
+            return std::nullopt;
+        }
+
+        auto path = Globals::gData.getTabPath(Globals::gSettings.selectedTab);
+        if (!path)
+        {
+            Globals::gGui->onError(Enums::ErrorCode::TabDoesNotExist);
+            return std::nullopt;
+        }
+
+        Download download;
+        {
+            std::lock_guard lock(mutex);
+            if (stop)
+            {
+                return std::nullopt;
+            }
+
+            download.id = ++nextId;
+            download.url = url;
+            download.path = *path;
+
+            jobs.emplace(download.id, Job{download, std::move(onFinished), nullptr, false, {}});
+            queue.emplace_back(download.id);
+
+            auto limit = std::max<std::size_t>(Globals::gSettings.maxDownloads, 1);
+            if (limit > workers.size())
+            {
+                workers.emplace_back([this] { work(); });
+            }
+        }
+        cv.notify_one();
+
+        Fancy::fancy.logTime().message() << "Queued download " << download.id << " of " >> url << std::endl;
+        Globals::gGui->onDownloadProgressed(download);
+
+        return download.id;
+    }
+    void YoutubeDl::work()
+    {
+        std::unique_lock lock(mutex);
+        while (true)
+        {
+            cv.wait(lock, [this] {
+                auto limit = std::max<std::size_t>(Globals::gSettings.maxDownloads, 1);
+                return stop || (!queue.empty() && limit > running);
+            });
+
+            if (stop)
+            {
+                return;
+            }
+
+            auto id = queue.front();
+            queue.pop_front();
+            running++;
+
+            lock.unlock();
+            run(id);
+            lock.lock();
+
+            running--;
+            cv.notify_one();
+        }
+    }
+    void YoutubeDl::run(std::uint32_t id)
+    {
+        std::string command;
+        {
+            std::lock_guard lock(mutex);
+            auto &job = jobs.at(id);
+            job.download.status = Enums::DownloadStatus::Running;
+
+            command = "youtube-dl --newline --no-mtime " + getImportArguments() + " \"" + job.download.url +
+                      "\" -o \"" + job.download.path + "/%(title)s.%(ext)s\"";
         }
 
-        auto currentTab = Globals::gData.getTab(Globals::gSettings.selectedTab);
+        auto process = std::make_shared<TinyProcessLib::Process>(
+            command, "", [this, id, line = std::string()](const char *data, std::size_t size) mutable {
+                //* Chunks do not have to end on a line break
+                for (std::size_t i = 0; size > i; i++)
+                {
+                    if (data[i] == '\n' || data[i] == '\r')
+                    {
+                        onOutput(id, line);
+                        line.clear();
+                    }
+                    else
+                    {
+                        line += data[i];
+                    }
+                }
+            });
+
+        bool cancelled = false;
+        {
+            std::lock_guard lock(mutex);
+            auto &job = jobs.at(id);
+            job.process = process;
+            cancelled = job.cancelled;
+        }
+
+        if (cancelled)
+        {
+            process->kill();
+        }
+
+        Fancy::fancy.logTime().success() << "Started download " << id << std::endl;
+        auto status = process->get_exit_status();
+
+        std::unique_lock lock(mutex);
+        auto &job = jobs.at(id);
+        job.process.reset();
 
-        if (currentTab)
+        if (job.cancelled)
         {
-            if (currentDownload)
+            lock.unlock();
+            Fancy::fancy.logTime().message() << "Cancelled download " << id << ", process exited with " << status
+                                             << std::endl;
+            finish(id, Enums::DownloadStatus::Cancelled);
+            return;
+        }
+
+        lock.unlock();
+        if (status != 0)
+        {
+            Fancy::fancy.logTime().warning() << "Download " << id << " failed with " << status << std::endl;
+        }
+        finish(id, status == 0 ? Enums::DownloadStatus::Finished : Enums::DownloadStatus::Failed);
+    }
+    void YoutubeDl::onOutput(std::uint32_t id, std::string_view line)
+    {
+        static constexpr std::string_view destination = "[ffmpeg] Destination: ";
+        if (line.substr(0, destination.size()) == destination)
+        {
+            std::lock_guard lock(mutex);
+            jobs.at(id).download.file = line.substr(destination.size());
+            return;
+        }
+
+        float progress = 0;
+        std::string eta;
+        if (!parseProgress(line, progress, eta))
+        {
+            return;
+        }
+
+        Download download;
+        {
+            std::lock_guard lock(mutex);
+            auto &job = jobs.at(id);
+            job.download.progress = progress;
+            job.download.eta = std::move(eta);
+
+            auto now = std::chrono::steady_clock::now();
+            if (progress < 100 && now - job.lastProgress < progressInterval)
             {
-                currentDownload->kill();
-                currentDownload.reset();
+                return;
             }
 
-            currentDownload.emplace("youtube-dl --extract-audio --audio-format mp3 --no-mtime \"" + url + "\" -o \"" +
-                                        currentTab->path + "/%(title)s.%(ext)s" + "\"",
-                                    "", [](const char *rawData, std::size_t dataLen) {
-                                        std::string data(rawData, dataLen);
-                                        static const std::regex progressRegex(R"(([0-9.,]+)%.*(ETA (.+)))");
+            job.lastProgress = now;
+            download = job.download;
+        }
+
+        Globals::gGui->onDownloadProgressed(download);
+    }
+    void YoutubeDl::finish(std::uint32_t id, Enums::DownloadStatus status)
+    {
+        Download download;
+        Callback onFinished;
+        {
+            std::lock_guard lock(mutex);
+            auto &job = jobs.at(id);
+            job.download.status = status;
+            if (status == Enums::DownloadStatus::Finished)
+            {
+                job.download.progress = 100;
+                job.download.eta.clear();
+            }
 
-                                        std::smatch match;
-                                        if (std::regex_search(data, match, progressRegex))
-                                        {
-                                            if (match[1].matched && match[3].matched)
-                                            {
-                                                Globals::gGui->onDownloadProgressed(std::stof(match[1]), match[3]);
-                                            }
-                                        }
-                                    });
+            download = job.download;
+            onFinished = std::move(job.onFinished);
 
-            Fancy::fancy.logTime().success() << "Started download of " >> url << std::endl;
-            auto rtn = currentDownload->get_exit_status() == 0;
-            currentDownload.reset();
-            return rtn;
+            finished.emplace_back(id);
+            while (finished.size() > maxFinished)
+            {
+                jobs.erase(finished.front());
+                finished.pop_front();
+            }
+        }
+
+        if (Globals::gGui)
+        {
+            if (status == Enums::DownloadStatus::Finished && !download.file.empty())
+            {
+                Globals::gGui->onFilesChanged(download.path, {download.file});
+            }
+
+            Globals::gGui->onDownloadProgressed(download);
+        }
+        if (onFinished)
+        {
+            onFinished(download);
+        }
+    }
+    bool YoutubeDl::cancel(std::uint32_t id)
+    {
+        std::unique_lock lock(mutex);
+
+        auto job = jobs.find(id);
+        if (job == jobs.end() || (job->second.download.status != Enums::DownloadStatus::Queued &&
+                                  job->second.download.status != Enums::DownloadStatus::Running))
+        {
+            return false;
+        }
+
+        if (auto queued = std::find(queue.begin(), queue.end(), id); queued != queue.end())
+        {
+            queue.erase(queued);
+            job->second.cancelled = true;
+
+            lock.unlock();
+            finish(id, Enums::DownloadStatus::Cancelled);
+            return true;
+        }
+
+        //* A job that was just taken from the queue is killed as soon as its process exists
+        job->second.cancelled = true;
+        if (auto process = job->second.process; process)
+        {
+            process->kill();
         }
 
-        Globals::gGui->onError(Enums::ErrorCode::TabDoesNotExist);
-        return false;
+        return true;
     }
     void YoutubeDl::killDownload()
     {
-        if (currentDownload)
+        std::vector<std::uint32_t> ids;
+        {
+            std::lock_guard lock(mutex);
+            for (const auto &[id, job] : jobs)
+            {
+                ids.emplace_back(id);
+            }
+        }
+
+        for (const auto &id : ids)
+        {
+            cancel(id);
+        }
+    }
+    std::vector<Download> YoutubeDl::getDownloads()
+    {
+        std::lock_guard lock(mutex);
+
+        std::vector<Download> rtn;
+        rtn.reserve(jobs.size());
+
+        for (const auto &[id, job] : jobs)
+        {
+            rtn.emplace_back(job.download);
+        }
+
+        return rtn;
+    }
+    void YoutubeDl::destroy()
+    {
+        killDownload();
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+
+        for (auto &worker : workers)
         {
-            int status = -1;
-            while (!currentDownload->try_get_exit_status(status))
+            if (worker.joinable())
             {
-                currentDownload->kill();
+                worker.join();
             }
-            currentDownload.reset();
-            Fancy::fancy.logTime().success() << "Killing download, process exited with " >> status << std::endl;
         }
+        workers.clear();
     }
     bool YoutubeDl::available() const
     {
-        return isAvailable;
+        return isAvailable.valid() && isAvailable.get();
     }
 } // namespace Soundux::Objects
\ No newline at end of file
@@ -1,26 +1,107 @@
 #pragma once
+#include <chrono>
+#include <condition_variable>
+#include <core/enums/enums.hpp>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
 #include <json.hpp>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <process.hpp>
 #include <regex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace Soundux
 {
     namespace Objects
     {
+        struct Download
+        {
+            std::uint32_t id;
+            std::string url;
+            //* The tab that was selected when the download was queued
+            std::string path;
+            //* The imported file, known once youtube-dl converted it
+            std::string file;
+
+            Enums::DownloadStatus status = Enums::DownloadStatus::Queued;
+            float progress = 0;
+            std::string eta;
+        };
+
+        //* Downloads are queued and run on their own threads, at most `Settings::maxDownloads` at a time
         class YoutubeDl
         {
-            bool isAvailable = false;
+          public:
+            using Callback = std::function<void(const Download &)>;
+            //* Finished downloads that are kept around for `getDownloads`
+            static constexpr std::size_t maxFinished = 32;
+            //* Progress of a single download is reported at most this often
+            static constexpr auto progressInterval = std::chrono::milliseconds(250);
+            static constexpr std::size_t maxCachedInfos = 64;
+
+          private:
+            struct Job
+            {
+                Download download;
+                Callback onFinished;
+                std::shared_ptr<TinyProcessLib::Process> process;
+                bool cancelled = false;
+                std::chrono::steady_clock::time_point lastProgress;
+            };
+
+            //* Probing spawns youtube-dl and ffmpeg, so it runs in the background and is only waited for on first use
+            std::shared_future<bool> isAvailable;
             static const std::regex urlRegex;
-            std::optional<TinyProcessLib::Process> currentDownload;
+
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool stop = false;
+
+            std::uint32_t nextId = 0;
+            std::map<std::uint32_t, Job> jobs;
+            std::deque<std::uint32_t> queue;
+            std::deque<std::uint32_t> finished;
+
+            std::size_t running = 0;
+            std::vector<std::thread> workers;
+
+            mutable std::mutex infoMutex;
+            //* Most recently used first
+            mutable std::list<std::pair<std::string, nlohmann::json>> infos;
+            mutable std::unordered_map<std::string, decltype(infos)::iterator> infoIndex;
+
+            void work();
+            void run(std::uint32_t id);
+            void finish(std::uint32_t id, Enums::DownloadStatus status);
+            void onOutput(std::uint32_t id, std::string_view line);
 
           public:
+            //* Returns right away, see `available`
             void setup();
-            void killDownload();
+            //* Cancels all downloads and waits for the workers
+            void destroy();
+            //* Blocks until the availability check that `setup` started has finished
             bool available() const;
-            bool download(const std::string &);
+            //* Results are cached by url
             std::optional<nlohmann::json> getInfo(const std::string &) const;
+
+            //* Queues a download into the selected tab and returns right away, `onFinished` is called from the worker
+            std::optional<std::uint32_t> download(const std::string &url, Callback onFinished = nullptr);
+            bool cancel(std::uint32_t id);
+            //* Cancels every queued and running download
+            void killDownload();
+
+            std::vector<Download> getDownloads();
         };
     } // namespace Objects
-} // namespace Soundux
\ No newline at end of file
+} // namespace Soundux
@@ -1,11 +1,17 @@
 #include <backward.hpp>
+#include <chrono>
 #include <core/enums/enums.hpp>
 #include <core/global/globals.hpp>
 #include <fancy.hpp>
+#include <future>
+#include <ui/impl/headless/headless.hpp>
 #include <ui/impl/webview/webview.hpp>
 
 #if defined(__linux__)
 #include <helper/audio/linux/backend.hpp>
+#if __has_include(<X11/Xlib.h>)
+#include <X11/Xlib.h>
+#endif
 #endif
 
 #if defined(_WIN32)
@@ -20,6 +26,11 @@ int __stdcall WinMain([[maybe_unused]] HINSTANCE hInstrance, [[maybe_unused]] HI
 int main(int argc, char **arguments)
 #endif
 {
+#if defined(__linux__) && __has_include(<X11/Xlib.h>)
+    //* Has to be the very first Xlib call of the process, the hotkeys use their display from several threads
+    XInitThreads();
+#endif
+
     using namespace Soundux::Globals; // NOLINT
     using namespace Soundux::Objects; // NOLINT
     using namespace Soundux::Enums;   // NOLINT
@@ -64,6 +75,8 @@ int main(int argc, char **arguments)
         Fancy::fancy.message() << "Soundux usage" << std::endl;
         Fancy::fancy.message() << "  -h --help        description of launch arguments" << std::endl;
         Fancy::fancy.message() << "  --hidden         start application hidden to taskbar" << std::endl;
+        Fancy::fancy.message() << "  --headless       run without a window, sounds are played through hotkeys and IPC"
+                               << std::endl;
         Fancy::fancy.message() << "  --reset-mutex    fix 'Another instance is already running! error'" << std::endl;
         return 0;
     }
@@ -86,29 +99,75 @@ int main(int argc, char **arguments)
                                          << std::endl;
     }
 
-    gConfig.load();
-    gData.set(gConfig.data);
-    gSettings = gConfig.settings;
+    auto headless = std::find(args.begin(), args.end(), "--headless") != args.end();
+
+    auto startup = std::chrono::steady_clock::now();
+    auto measure = [](const char *step, const auto &function) {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+
+        auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+        Fancy::fancy.logTime().message() << "Startup: " << step << " took " << took.count() << "ms" << std::endl;
+    };
+
+    measure("config", [] {
+        gConfig.load();
+        gData.set(std::move(gConfig.data));
+        gSettings = gConfig.settings;
+        gMetadata.load();
+        gMetadata.setup();
+    });
 
 #if defined(__linux__)
-    gIcons = IconFetcher::createInstance();
-    gAudioBackend = AudioBackend::createInstance(gSettings.audioBackend);
+    //* Only allocates, LibWnck is loaded once the first icon is needed. Nothing shows icons without a window.
+    if (!headless)
+    {
+        gIcons = IconFetcher::createInstance();
+    }
 #elif defined(_WIN32)
-    gWinSound = WinSound::createInstance();
+    //* Has to stay on this thread, it initializes COM for it
+    measure("windows audio", [] { gWinSound = WinSound::createInstance(); });
 #endif
 
-    gAudio.setup();
-    gYtdl.setup();
+    //* Started before the audio backend, which may change the settings if it has to fall back to another one
+    gConfigSaver.setup(gSettings);
 
+    //* The audio setup does not depend on anything the UI needs until `Window::setup`, so it runs in parallel to
+    //* the creation of the window. The backend has to come first, it creates the sink that `Audio` opens.
+    auto audio = std::async(std::launch::async, [&measure] {
 #if defined(__linux__)
-    if (gAudioBackend && gSettings.audioBackend == BackendType::PulseAudio && gConfig.settings.useAsDefaultDevice)
+        measure("audio backend", [] {
+            gAudioBackend = AudioBackend::createInstance(gSettings.audioBackend);
+            if (gAudioBackend && gSettings.audioBackend == BackendType::PulseAudio &&
+                gSettings.useAsDefaultDevice)
+            {
+                gAudioBackend->useAsDefault();
+            }
+        });
+#endif
+        measure("audio", [] { gAudio.setup(); });
+    });
+
+    gYtdl.setup();
+
+    if (headless)
     {
-        gAudioBackend->useAsDefault();
+        gGui = std::make_unique<Soundux::Objects::Headless>();
     }
-#endif
+    else
+    {
+        measure("window", [] { gGui = std::make_unique<Soundux::Objects::WebView>(); });
+    }
+
+    measure("waiting for audio", [&audio] { audio.wait(); });
+    measure("ui", [] { gGui->setup(); });
+    gIpc.setup();
 
-    gGui = std::make_unique<Soundux::Objects::WebView>();
-    gGui->setup();
+    Fancy::fancy.logTime().message() << "Startup took "
+                                     << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                            std::chrono::steady_clock::now() - startup)
+                                            .count()
+                                     << "ms" << std::endl;
 
     if (std::find(args.begin(), args.end(), "--hidden") == args.end())
     {
@@ -127,6 +186,8 @@ int main(int argc, char **arguments)
 
     gGui->mainLoop();
 
+    gIpc.destroy();
+    gYtdl.destroy();
     gAudio.destroy();
 #if defined(__linux__)
     if (gAudioBackend)
@@ -134,9 +195,10 @@ int main(int argc, char **arguments)
         gAudioBackend->destroy();
     }
 #endif
-    gConfig.data.set(gData);
-    gConfig.settings = gSettings;
-    gConfig.save();
+    gConfigSaver.onSettingsChanged(gSettings);
+    gConfigSaver.destroy();
+    gMetadata.destroy();
+    gMetadata.save();
 
     return 0;
 }
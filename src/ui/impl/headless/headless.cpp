@@ -0,0 +1,97 @@
+#include "headless.hpp"
+#include <csignal>
+#include <fancy.hpp>
+
+#if defined(__linux__)
+#include <glib-unix.h>
+#include <glib.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+namespace Soundux::Objects
+{
+#if defined(_WIN32)
+    static Headless *instance = nullptr;
+#endif
+
+    void Headless::setup()
+    {
+        Window::setup();
+
+#if defined(__linux__)
+        loop = g_main_loop_new(nullptr, FALSE);
+
+        auto quit = [](gpointer data) -> gboolean {
+            Fancy::fancy.logTime().message() << "Received signal, exiting" << std::endl;
+            g_main_loop_quit(reinterpret_cast<GMainLoop *>(data));
+            return G_SOURCE_CONTINUE;
+        };
+
+        g_unix_signal_add(SIGINT, quit, loop);
+        g_unix_signal_add(SIGTERM, quit, loop);
+#elif defined(_WIN32)
+        instance = this;
+        SetConsoleCtrlHandler(
+            []([[maybe_unused]] DWORD type) -> BOOL {
+                instance->stop();
+                return TRUE;
+            },
+            TRUE);
+#endif
+
+        Fancy::fancy.logTime().message() << "Running headless" << std::endl;
+    }
+    void Headless::show() {}
+    void Headless::mainLoop()
+    {
+#if defined(__linux__)
+        g_main_loop_run(loop);
+        g_main_loop_unref(loop);
+        loop = nullptr;
+#else
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [this] { return stopped; });
+#endif
+        Fancy::fancy.logTime().message() << "Headless mode exited" << std::endl;
+    }
+    void Headless::stop()
+    {
+#if defined(__linux__)
+        if (loop)
+        {
+            g_main_loop_quit(loop);
+        }
+#else
+        {
+            std::lock_guard lock(mutex);
+            stopped = true;
+        }
+        cv.notify_all();
+#endif
+    }
+    void Headless::onAdminRequired()
+    {
+        Fancy::fancy.logTime().warning() << "Administrator rights are required" << std::endl;
+    }
+    void Headless::onSettingsChanged() {}
+    void Headless::onSwitchOnConnectDetected(bool state)
+    {
+        if (state)
+        {
+            Fancy::fancy.logTime().warning() << "module-switch-on-connect is loaded" << std::endl;
+        }
+    }
+    void Headless::onError(const Enums::ErrorCode &error)
+    {
+        Fancy::fancy.logTime().failure() << "Error " << static_cast<int>(error) << std::endl;
+    }
+    void Headless::onSoundProgressed([[maybe_unused]] const SoundProgress &progress) {}
+    void Headless::onDownloadProgressed([[maybe_unused]] const Download &download) {}
+#if defined(__linux__)
+    void Headless::onOutputsChanged([[maybe_unused]] const std::vector<std::shared_ptr<IconRecordingApp>> &outputs) {}
+    void Headless::onPlaybackChanged([[maybe_unused]] const std::vector<std::shared_ptr<IconPlaybackApp>> &playback)
+    {
+    }
+#endif
+} // namespace Soundux::Objects
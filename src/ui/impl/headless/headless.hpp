@@ -0,0 +1,45 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <ui/ui.hpp>
+
+#if defined(__linux__)
+typedef struct _GMainLoop GMainLoop; // NOLINT
+#endif
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Runs without any UI, sounds are played through hotkeys and the IPC server. Only logs what a UI would show.
+        class Headless : public Window
+        {
+#if defined(__linux__)
+            //* The backends and the app list schedule their work on the default main context
+            GMainLoop *loop = nullptr;
+#else
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool stopped = false;
+#endif
+
+          public:
+            void show() override;
+            void setup() override;
+            void mainLoop() override;
+            //* May be called from any thread
+            void stop();
+
+            void onAdminRequired() override;
+            void onSettingsChanged() override;
+            void onSwitchOnConnectDetected(bool state) override;
+            void onError(const Enums::ErrorCode &error) override;
+            void onSoundProgressed(const SoundProgress &progress) override;
+            void onDownloadProgressed(const Download &download) override;
+#if defined(__linux__)
+            void onOutputsChanged(const std::vector<std::shared_ptr<IconRecordingApp>> &outputs) override;
+            void onPlaybackChanged(const std::vector<std::shared_ptr<IconPlaybackApp>> &playback) override;
+#endif
+        };
+    } // namespace Objects
+} // namespace Soundux
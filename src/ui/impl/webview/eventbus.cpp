@@ -0,0 +1,152 @@
+#include "eventbus.hpp"
+
+namespace Soundux::Objects
+{
+    //* Called with `[[function, [arguments...]], ...]`
+    static constexpr auto dispatcher = "(events => events.forEach(([name, args]) => window[name](...args)))";
+
+    EventBus::~EventBus()
+    {
+        destroy();
+    }
+    void EventBus::setup(std::shared_ptr<Webview::Window> window, std::uint32_t framesPerSecond)
+    {
+        webview = std::move(window);
+        rate = framesPerSecond;
+
+        if (!running)
+        {
+            running = true;
+            flusher = std::thread([this] { run(); });
+        }
+    }
+    void EventBus::destroy()
+    {
+        if (running)
+        {
+            running = false;
+            cv.notify_all();
+            flusher.join();
+        }
+    }
+    void EventBus::setRate(std::uint32_t framesPerSecond)
+    {
+        rate = framesPerSecond;
+        cv.notify_all();
+    }
+    void EventBus::run()
+    {
+        std::unique_lock lock(mutex);
+        while (running)
+        {
+            auto framesPerSecond = rate.load();
+            if (framesPerSecond == 0)
+            {
+                cv.wait(lock, [this] { return !running || !pending.empty() || rate != 0; });
+            }
+            else
+            {
+                cv.wait_for(lock, std::chrono::milliseconds(1000 / framesPerSecond), [this] { return !running; });
+            }
+
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+    void EventBus::emit(const std::string &function, nlohmann::json arguments)
+    {
+        {
+            std::lock_guard lock(mutex);
+            pending.push_back({std::nullopt, function, std::move(arguments), nullptr});
+        }
+
+        if (rate == 0)
+        {
+            cv.notify_one();
+        }
+    }
+    void EventBus::emit(std::uint64_t key, const std::string &function, nlohmann::json arguments)
+    {
+        {
+            std::lock_guard lock(mutex);
+            if (auto it = index.find(key); it != index.end())
+            {
+                pending[it->second].arguments = std::move(arguments);
+                pending[it->second].provider = nullptr;
+                return;
+            }
+
+            index.emplace(key, pending.size());
+            pending.push_back({key, function, std::move(arguments), nullptr});
+        }
+
+        if (rate == 0)
+        {
+            cv.notify_one();
+        }
+    }
+    void EventBus::emit(std::uint64_t key, const std::string &function, std::function<nlohmann::json()> provider)
+    {
+        {
+            std::lock_guard lock(mutex);
+            if (auto it = index.find(key); it != index.end())
+            {
+                pending[it->second].provider = std::move(provider);
+                return;
+            }
+
+            index.emplace(key, pending.size());
+            pending.push_back({key, function, nullptr, std::move(provider)});
+        }
+
+        if (rate == 0)
+        {
+            cv.notify_one();
+        }
+    }
+    void EventBus::discard(std::uint64_t key)
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = index.find(key); it != index.end())
+        {
+            pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(it->second));
+            index.clear();
+
+            for (std::size_t i = 0; pending.size() > i; i++)
+            {
+                if (pending[i].key)
+                {
+                    index.emplace(*pending[i].key, i);
+                }
+            }
+        }
+    }
+    void EventBus::flush()
+    {
+        std::vector<Event> events;
+        {
+            std::lock_guard lock(mutex);
+            events.swap(pending);
+            index.clear();
+        }
+
+        if (events.empty() || !webview)
+        {
+            return;
+        }
+
+        auto batch = nlohmann::json::array();
+        for (auto &event : events)
+        {
+            if (event.provider)
+            {
+                event.arguments = event.provider();
+            }
+
+            batch.push_back(nlohmann::json::array({std::move(event.function), std::move(event.arguments)}));
+        }
+
+        webview->callFunction<void>(Webview::JavaScriptFunction(dispatcher, batch));
+    }
+} // namespace Soundux::Objects
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <webview.hpp>
+
+namespace Soundux
+{
+    namespace Objects
+    {
+        //* Collects calls to `window.<function>` and hands all of them to the frontend in a single evaluation per frame
+        class EventBus
+        {
+            struct Event
+            {
+                std::optional<std::uint64_t> key;
+                std::string function;
+                nlohmann::json arguments;
+                std::function<nlohmann::json()> provider;
+            };
+
+            std::mutex mutex;
+            std::vector<Event> pending;
+            std::unordered_map<std::uint64_t, std::size_t> index;
+
+            std::thread flusher;
+            std::condition_variable cv;
+            std::atomic<bool> running = false;
+            std::atomic<std::uint32_t> rate = 30;
+
+            std::shared_ptr<Webview::Window> webview;
+
+            void run();
+
+          public:
+            EventBus() = default;
+            EventBus(const EventBus &) = delete;
+            EventBus &operator=(const EventBus &) = delete;
+            ~EventBus();
+
+            void setup(std::shared_ptr<Webview::Window>, std::uint32_t);
+            void destroy();
+
+            //* Frames per second, 0 flushes every event right away
+            void setRate(std::uint32_t);
+
+            void emit(const std::string &function, nlohmann::json arguments);
+            //* Replaces the pending event with the same key instead of queueing another one
+            void emit(std::uint64_t key, const std::string &function, nlohmann::json arguments);
+            //* Same as the keyed `emit`, but the arguments are only created by `provider` once the event is flushed
+            void emit(std::uint64_t key, const std::string &function, std::function<nlohmann::json()> provider);
+            void discard(std::uint64_t key);
+
+            void flush();
+        };
+    } // namespace Objects
+} // namespace Soundux
@@ -19,15 +19,25 @@
 
 namespace Soundux::Objects
 {
-    void WebView::setup()
-    {
-        Window::setup();
+    //* Sound ids only use the lower 32 bits, so this can never clash with a progress event
+    static constexpr std::uint64_t downloadEvent = std::uint64_t{1} << 32;
+    static constexpr std::uint64_t tabChangesEvent = downloadEvent + 1;
+    static constexpr std::uint64_t outputsEvent = downloadEvent + 2;
+    static constexpr std::uint64_t playbackEvent = downloadEvent + 3;
+    //* Every download has its own key above this one
+    static constexpr std::uint64_t downloadJobEvent = std::uint64_t{2} << 32;
 
+    WebView::WebView()
+    {
         webview =
             std::make_shared<Webview::Window>("Soundux", Soundux::Globals::gData.width, Soundux::Globals::gData.height);
         webview->setTitle("Soundux");
         webview->enableDevTools(std::getenv("SOUNDUX_DEBUG") != nullptr);    // NOLINT
         webview->enableContextMenu(std::getenv("SOUNDUX_DEBUG") != nullptr); // NOLINT
+    }
+    void WebView::setup()
+    {
+        Window::setup();
 
 #ifdef _WIN32
         char rawPath[MAX_PATH];
@@ -60,6 +70,7 @@ namespace Soundux::Objects
 
         exposeFunctions();
         fetchTranslations();
+        events.setup(webview, Globals::gSettings.uiUpdateRate);
 
         webview->setCloseCallback([this]() { return onClose(); });
         webview->setResizeCallback([this](int width, int height) { onResize(width, height); });
@@ -89,7 +100,27 @@ namespace Soundux::Objects
 #endif
         }));
         webview->expose(Webview::Function("addTab", [this]() { return (addTab()); }));
-        webview->expose(Webview::Function("getTabs", []() { return Globals::gData.getTabs(); }));
+        webview->expose(Webview::Function("getTabs", []() {
+            auto rtn = nlohmann::json::array();
+            Globals::gData.visitTabs([&](const Tab &tab) { rtn.push_back(tab); });
+            return rtn;
+        }));
+        webview->expose(Webview::Function("getTabList", []() {
+            auto rtn = nlohmann::json::array();
+            Globals::gData.visitTabs([&](const Tab &tab) {
+                rtn.push_back({{"id", tab.id},
+                               {"name", tab.name},
+                               {"path", tab.path},
+                               {"sortMode", tab.sortMode},
+                               {"soundCount", tab.sounds.size()}});
+            });
+            return rtn;
+        }));
+        webview->expose(Webview::Function("getTabChanges", [this](std::uint64_t since) {
+            auto changes = Globals::gData.getChangesSince(since);
+            pushedRevision = changes.revision;
+            return changes;
+        }));
         webview->expose(Webview::Function("playSound", [this](std::uint32_t id) { return playSound(id); }));
         webview->expose(Webview::Function("stopSound", [this](std::uint32_t id) { return stopSound(id); }));
         webview->expose(Webview::Function(
@@ -125,6 +156,9 @@ namespace Soundux::Objects
         webview->expose(Webview::Function("requestHotkey", [](bool state) { Globals::gHotKeys.shouldNotify(state); }));
         webview->expose(Webview::Function(
             "setHotkey", [this](std::uint32_t id, const std::vector<int> &keys) { return setHotkey(id, keys); }));
+        webview->expose(Webview::Function("preloadSound", [this](std::uint32_t id) { preloadSound(id); }));
+        webview->expose(Webview::Function(
+            "getWaveform", [this](std::uint32_t id, std::size_t buckets) { return getWaveform(id, buckets); }));
         webview->expose(Webview::Function("getHotkeySequence", [this](const std::vector<int> &keys) {
             return Globals::gHotKeys.getKeySequence(keys);
         }));
@@ -132,6 +166,10 @@ namespace Soundux::Objects
         webview->expose(Webview::Function("refreshTab", [this](std::uint32_t id) { return refreshTab(id); }));
         webview->expose(Webview::Function(
             "setSortMode", [this](std::uint32_t id, Enums::SortMode sortMode) { return setSortMode(id, sortMode); }));
+        webview->expose(Webview::Function("getTabSounds",
+                                          [this](std::uint32_t id, std::size_t offset, std::size_t limit) {
+                                              return getTabSounds(id, offset, limit);
+                                          }));
         webview->expose(Webview::Function(
             "moveTabs", [this](const std::vector<int> &newOrder) { return changeTabOrder(newOrder); }));
         webview->expose(Webview::Function("markFavorite", [this](const std::uint32_t &id, bool favorite) {
@@ -139,6 +177,9 @@ namespace Soundux::Objects
             return Globals::gData.getFavoriteIds();
         }));
         webview->expose(Webview::Function("getFavorites", [this] { return Globals::gData.getFavoriteIds(); }));
+        webview->expose(Webview::Function("searchSounds", [](const std::string &query, std::size_t limit) {
+            return Globals::gData.searchSounds(query, limit);
+        }));
         webview->expose(Webview::Function("isYoutubeDLAvailable", []() { return Globals::gYtdl.available(); }));
         webview->expose(
             Webview::AsyncFunction("getYoutubeDLInfo", [this](Webview::Promise promise, const std::string &url) {
@@ -146,15 +187,21 @@ namespace Soundux::Objects
             }));
         webview->expose(
             Webview::AsyncFunction("startYoutubeDLDownload", [this](Webview::Promise promise, const std::string &url) {
-                promise.resolve(Globals::gYtdl.download(url));
+                auto id = Globals::gYtdl.download(url, [promise](const Download &download) {
+                    promise.resolve(download.status == Enums::DownloadStatus::Finished);
+                });
+
+                if (!id)
+                {
+                    promise.resolve(false);
+                }
             }));
-        webview->expose(Webview::AsyncFunction("stopYoutubeDLDownload", [this](Webview::Promise promise) {
-            std::thread killDownload([promise, this] {
-                Globals::gYtdl.killDownload();
-                promise.discard();
-            });
-            killDownload.detach();
-        }));
+        webview->expose(Webview::Function("queueYoutubeDLDownload",
+                                          [](const std::string &url) { return Globals::gYtdl.download(url); }));
+        webview->expose(Webview::Function("cancelYoutubeDLDownload",
+                                          [](std::uint32_t id) { return Globals::gYtdl.cancel(id); }));
+        webview->expose(Webview::Function("getYoutubeDLDownloads", [] { return Globals::gYtdl.getDownloads(); }));
+        webview->expose(Webview::Function("stopYoutubeDLDownload", [] { Globals::gYtdl.killDownload(); }));
         webview->expose(Webview::Function("getSystemInfo", []() -> std::string { return SystemInfo::getSummary(); }));
         webview->expose(Webview::AsyncFunction(
             "updateCheck", [this](Webview::Promise promise) { promise.resolve(VersionCheck::getStatus()); }));
@@ -169,6 +216,24 @@ namespace Soundux::Objects
                                               return setCustomRemoteVolume(id, volume);
                                           }));
         webview->expose(Webview::Function("toggleSoundPlayback", [this]() { return toggleSoundPlayback(); }));
+        webview->expose(Webview::Function("getOutputLatencies", []() { return Globals::gAudio.getLatencies(); }));
+        webview->expose(Webview::Function("setTracing", [](bool state) { Globals::gTracer.enable(state); }));
+        webview->expose(Webview::Function("getTraceSummary", []() { return Globals::gTracer.summarize(); }));
+        webview->expose(Webview::Function("exportTrace", []() { return Globals::gTracer.exportChrome(); }));
+        if (std::getenv("SOUNDUX_DEBUG") != nullptr) // NOLINT
+        {
+            webview->expose(Webview::Function("getAudioHealth", []() {
+                return nlohmann::json{{"mixers", Globals::gAudio.getHealth()},
+                                      {"queueBacklog", Globals::gQueue.getBacklog()}};
+            }));
+        }
+        webview->expose(Webview::Function("getSoundMetadata", [](std::uint32_t id) -> std::optional<Metadata> {
+            if (auto sound = Globals::gData.getSound(id); sound)
+            {
+                return Globals::gMetadata.get(*sound);
+            }
+            return std::nullopt;
+        }));
 
 #if !defined(__linux__)
         webview->expose(Webview::Function("getOutputs", [this]() { return getOutputs(); }));
@@ -178,10 +243,10 @@ namespace Soundux::Objects
             ShellExecuteA(nullptr, nullptr, url.c_str(), nullptr, nullptr, SW_SHOW);
         }));
         webview->expose(Webview::Function("openFolder", [](const std::uint32_t &id) {
-            auto tab = Globals::gData.getTab(id);
-            if (tab)
+            auto path = Globals::gData.getTabPath(id);
+            if (path)
             {
-                ShellExecuteW(nullptr, nullptr, Helpers::widen(tab->path).c_str(), nullptr, nullptr, SW_SHOWNORMAL);
+                ShellExecuteW(nullptr, nullptr, Helpers::widen(*path).c_str(), nullptr, nullptr, SW_SHOWNORMAL);
             }
             else
             {
@@ -246,12 +311,12 @@ namespace Soundux::Objects
             }
         }));
         webview->expose(Webview::Function("openFolder", [](const std::uint32_t &id) {
-            auto tab = Globals::gData.getTab(id);
-            if (tab)
+            auto path = Globals::gData.getTabPath(id);
+            if (path)
             {
-                if (system(("xdg-open \"" + tab->path + "\"").c_str()) != 0) // NOLINT
+                if (system(("xdg-open \"" + *path + "\"").c_str()) != 0) // NOLINT
                 {
-                    Fancy::fancy.logTime().warning() << "Failed to open folder " << tab->path << std::endl;
+                    Fancy::fancy.logTime().warning() << "Failed to open folder " << *path << std::endl;
                 }
             }
             else
@@ -296,6 +361,7 @@ namespace Soundux::Objects
     {
         Globals::gData.width = width;
         Globals::gData.height = height;
+        Globals::gConfigSaver.onDataChanged();
     }
     void WebView::fetchTranslations()
     {
@@ -314,30 +380,24 @@ namespace Soundux::Objects
 
                 auto future = std::make_shared<std::future<void>>();
                 *future = std::async(std::launch::async, [future, this] {
-                    translations.settings = webview
-                                                ->callFunction<std::string>(Webview::JavaScriptFunction(
-                                                    "window.getTranslation", "settings.title"))
-                                                .get();
-                    translations.tabHotkeys = webview
-                                                  ->callFunction<std::string>(Webview::JavaScriptFunction(
-                                                      "window.getTranslation", "settings.tabHotkeysOnly"))
-                                                  .get();
-                    translations.muteDuringPlayback = webview
-                                                          ->callFunction<std::string>(Webview::JavaScriptFunction(
-                                                              "window.getTranslation", "settings.muteDuringPlayback"))
-                                                          .get();
-                    translations.show = webview
-                                            ->callFunction<std::string>(
-                                                Webview::JavaScriptFunction("window.getTranslation", "tray.show"))
-                                            .get();
-                    translations.hide = webview
-                                            ->callFunction<std::string>(
-                                                Webview::JavaScriptFunction("window.getTranslation", "tray.hide"))
-                                            .get();
-                    translations.exit = webview
-                                            ->callFunction<std::string>(
-                                                Webview::JavaScriptFunction("window.getTranslation", "tray.exit"))
-                                            .get();
+                    //* One round trip instead of one per string
+                    static const std::vector<std::string> keys = {
+                        "settings.title", "settings.tabHotkeysOnly", "settings.muteDuringPlayback",
+                        "tray.show",      "tray.hide",               "tray.exit",
+                    };
+
+                    auto values = webview
+                                      ->callFunction<std::vector<std::string>>(Webview::JavaScriptFunction(
+                                          "((keys) => keys.map((key) => window.getTranslation(key)))", keys))
+                                      .get();
+                    values.resize(keys.size());
+
+                    translations.settings = values[0];
+                    translations.tabHotkeys = values[1];
+                    translations.muteDuringPlayback = values[2];
+                    translations.show = values[3];
+                    translations.hide = values[4];
+                    translations.exit = values[5];
 
                     setupTray();
                 });
@@ -381,6 +441,7 @@ namespace Soundux::Objects
     void WebView::mainLoop()
     {
         webview->run();
+        events.destroy();
         if (tray)
         {
             tray->exit();
@@ -394,29 +455,67 @@ namespace Soundux::Objects
         {
             hotkeySequence += Globals::gHotKeys.getKeyName(key) + " + ";
         }
-        webview->callFunction<void>(Webview::JavaScriptFunction(
-            "window.hotkeyReceived", hotkeySequence.substr(0, hotkeySequence.length() - 3), keys));
+        events.emit("hotkeyReceived",
+                    nlohmann::json::array({hotkeySequence.substr(0, hotkeySequence.length() - 3), keys}));
     }
     void WebView::onSoundFinished(const PlayingSound &sound)
     {
         Window::onSoundFinished(sound);
-        if (sound.playbackDevice.isDefault)
-        {
-            webview->callFunction<void>(Webview::JavaScriptFunction("window.finishSound", sound));
-        }
+
+        events.discard(sound.id);
+        events.emit("finishSound", nlohmann::json::array({sound}));
+    }
+    void WebView::pushTabChanges()
+    {
+        //* Collapses every change until the next flush into a single change set
+        events.emit(tabChangesEvent, "applyTabChanges", [this] {
+            auto changes = Globals::gData.getChangesSince(pushedRevision);
+            pushedRevision = changes.revision;
+
+            return nlohmann::json::array({changes});
+        });
+    }
+    void WebView::onTabChanged([[maybe_unused]] const Tab &tab)
+    {
+        pushTabChanges();
+    }
+    void WebView::onTabSoundsChanged([[maybe_unused]] const Tab &tab,
+                                     [[maybe_unused]] const std::vector<Sound> &changed,
+                                     [[maybe_unused]] const std::vector<std::uint32_t> &removed)
+    {
+        //* `mergeTabContent` logged the changed and removed sounds one by one, so only those are sent
+        pushTabChanges();
     }
     void WebView::onSoundPlayed(const PlayingSound &sound)
     {
         webview->callFunction<void>(Webview::JavaScriptFunction("window.onSoundPlayed", sound));
     }
-    void WebView::onSoundProgressed(const PlayingSound &sound)
+    void WebView::onSoundProgressed(const SoundProgress &progress)
+    {
+        if (auto sound = Globals::gAudio.getPlayingSound(progress.id); sound)
+        {
+            sound->paused = progress.paused;
+            sound->readInMs = progress.readInMs;
+
+            events.emit(progress.id, "updateSound", nlohmann::json::array({Lean<PlayingSound>{*sound}}));
+        }
+    }
+    void WebView::onDownloadProgressed(const Download &download)
+    {
+        //* The first two arguments are kept for frontends that only know a single download
+        events.emit(downloadJobEvent + download.id, "downloadProgressed",
+                    nlohmann::json::array({download.progress, download.eta, download}));
+    }
+#if defined(__linux__)
+    void WebView::onOutputsChanged(const std::vector<std::shared_ptr<IconRecordingApp>> &outputs)
     {
-        webview->callFunction<void>(Webview::JavaScriptFunction("window.updateSound", sound));
+        events.emit(outputsEvent, "outputsChanged", nlohmann::json::array({outputs}));
     }
-    void WebView::onDownloadProgressed(float progress, const std::string &eta)
+    void WebView::onPlaybackChanged(const std::vector<std::shared_ptr<IconPlaybackApp>> &playback)
     {
-        webview->callFunction<void>(Webview::JavaScriptFunction("window.downloadProgressed", progress, eta));
+        events.emit(playbackEvent, "playbackChanged", nlohmann::json::array({playback}));
     }
+#endif
     void WebView::onError(const Enums::ErrorCode &error)
     {
         webview->callFunction<void>(Webview::JavaScriptFunction("window.onError", static_cast<std::uint8_t>(error)));
@@ -424,6 +523,7 @@ namespace Soundux::Objects
     Settings WebView::changeSettings(Settings newSettings)
     {
         auto rtn = Window::changeSettings(newSettings);
+        events.setRate(rtn.uiUpdateRate);
         tray->update();
 
         return rtn;
@@ -1,4 +1,7 @@
 #pragma once
+#include "eventbus.hpp"
+#include <atomic>
+#include <cstdint>
 #include <tray.hpp>
 #include <ui/ui.hpp>
 #include <webview.hpp>
@@ -12,6 +15,11 @@ namespace Soundux
           private:
             std::shared_ptr<Tray::Tray> tray;
             std::shared_ptr<Webview::Window> webview;
+            EventBus events;
+
+            //* Revision of the last change set the frontend received
+            std::atomic<std::uint64_t> pushedRevision = 0;
+            void pushTabChanges();
 
             bool onClose();
             void exposeFunctions();
@@ -24,6 +32,9 @@ namespace Soundux
             Settings changeSettings(Settings newSettings) override;
 
           public:
+            //* Only creates the window, which does not depend on anything else and can happen during the audio setup
+            WebView();
+
             void show() override;
             void setup() override;
             void mainLoop() override;
@@ -34,9 +45,16 @@ namespace Soundux
             void onSettingsChanged() override;
             void onSwitchOnConnectDetected(bool state) override;
             void onError(const Enums::ErrorCode &error) override;
+            void onTabChanged(const Tab &tab) override;
+            void onTabSoundsChanged(const Tab &tab, const std::vector<Sound> &changed,
+                                    const std::vector<std::uint32_t> &removed) override;
             void onSoundPlayed(const PlayingSound &sound) override;
-            void onSoundProgressed(const PlayingSound &sound) override;
-            void onDownloadProgressed(float progress, const std::string &eta) override;
+            void onSoundProgressed(const SoundProgress &progress) override;
+            void onDownloadProgressed(const Download &download) override;
+#if defined(__linux__)
+            void onOutputsChanged(const std::vector<std::shared_ptr<IconRecordingApp>> &outputs) override;
+            void onPlaybackChanged(const std::vector<std::shared_ptr<IconPlaybackApp>> &playback) override;
+#endif
         };
     } // namespace Objects
 } // namespace Soundux
\ No newline at end of file
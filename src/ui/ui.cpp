@@ -1,31 +1,239 @@
 #include "ui.hpp"
+#include <algorithm>
 #include <core/global/globals.hpp>
 #include <cstdint>
 #include <fancy.hpp>
 #include <filesystem>
+#include <iterator>
+#if defined(__linux__)
+#include <gdk/gdk.h>
+#endif
 #include <helper/audio/linux/backend.hpp>
 #include <helper/audio/linux/pipewire/pipewire.hpp>
 #include <helper/audio/linux/pulseaudio/pulseaudio.hpp>
+#include <helper/base64/base64.hpp>
 #include <helper/misc/misc.hpp>
 #include <nfd.hpp>
 #include <optional>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Soundux::Objects
 {
+    //* Returns the sound for a directory entry if it is a supported audio file, id and user settings are left empty
+    static std::optional<Sound> readSound(const std::filesystem::path &directory,
+                                          const std::filesystem::directory_entry &entry)
+    {
+        std::filesystem::path file = entry;
+        if (entry.is_symlink())
+        {
+            file = std::filesystem::read_symlink(entry);
+            if (file.has_relative_path())
+            {
+                file = std::filesystem::canonical(directory / file);
+            }
+        }
+
+        auto extension = file.extension().u8string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return std::tolower(c); });
+        if (extension != ".mp3" && extension != ".wav" && extension != ".flac")
+        {
+            return std::nullopt;
+        }
+
+        Sound sound;
+
+        std::error_code ec;
+        auto writeTime = std::filesystem::last_write_time(file, ec);
+        if (!ec)
+        {
+            sound.modifiedDate = writeTime.time_since_epoch().count();
+        }
+        else
+        {
+            Fancy::fancy.logTime().warning() << "Failed to read lastWriteTime of " << file << std::endl;
+        }
+
+        auto path = file.u8string();
+#if defined(_WIN32)
+        std::transform(path.begin(), path.end(), path.begin(), [](char c) { return c == '\\' ? '/' : c; });
+#endif
+        sound.path = std::move(path);
+        sound.name = file.stem().u8string();
+
+        return sound;
+    }
+    static bool isSortedBefore(Enums::SortMode sortMode, const Sound &first, const Sound &second)
+    {
+        switch (sortMode)
+        {
+        case Enums::SortMode::ModifiedDate_Descending:
+            return first.modifiedDate > second.modifiedDate;
+        case Enums::SortMode::ModifiedDate_Ascending:
+            return first.modifiedDate < second.modifiedDate;
+        case Enums::SortMode::Alphabetical_Descending:
+            return first.name > second.name;
+        case Enums::SortMode::Alphabetical_Ascending:
+            return first.name < second.name;
+        }
+        return false;
+    }
+
     void Window::setup()
     {
         NFD::Init();
         Globals::gHotKeys.init();
-        for (auto &tab : Globals::gData.getTabs())
-        {
-            tab.sounds = getTabContent(tab);
-            Globals::gData.setTab(tab.id, tab);
-        }
+        Globals::gWatcher.setup([this](const std::string &directory, const std::set<std::string> &files) {
+            onFilesChanged(directory, files);
+        });
+
+        //* The tabs from the config are shown right away, every tab gets loaded and rescanned in the background and
+        //* only tabs whose content changed are sent to the frontend again
+        Globals::gData.visitTabs([this](const Tab &tab) {
+            Globals::gScanQueue.push_unique(std::hash<std::string>{}(tab.path), [this, path = tab.path] {
+                auto hydrated = Globals::gData.hydrate(path);
+                auto current = Globals::gData.getTabByPath(path);
+                if (!current)
+                {
+                    return;
+                }
+
+                if (auto updated = Globals::gData.mergeTabContent(path, getTabContent(*current)); updated)
+                {
+                    onTabChanged(*updated);
+                    Globals::gMetadata.index(updated->sounds);
+                    preloadTab(*updated);
+                }
+                else
+                {
+                    if (hydrated)
+                    {
+                        onTabChanged(*current);
+                    }
+                    Globals::gMetadata.index(current->sounds);
+                    preloadTab(*current);
+                }
+            });
+
+            Globals::gWatcher.watch(tab.path);
+        });
+
+#if defined(__linux__)
+        watchApps();
+#endif
     }
     Window::~Window()
     {
         NFD::Quit();
         Globals::gHotKeys.stop();
+        Globals::gWatcher.destroy();
+
+#if defined(__linux__)
+        if (Globals::gAudioBackend)
+        {
+            Globals::gAudioBackend->setAppsChangedCallback(nullptr);
+        }
+#endif
+    }
+    void Window::indexTab(const Tab &tab)
+    {
+        Globals::gScanQueue.push_unique(std::hash<std::string>{}("metadata:" + tab.path),
+                                        [sounds = tab.sounds] { Globals::gMetadata.index(sounds); });
+    }
+    void Window::onFilesChanged(const std::string &directory, const std::set<std::string> &files)
+    {
+        auto tab = Globals::gData.getTabByPath(directory);
+        if (!tab)
+        {
+            return;
+        }
+
+        //* Events were lost, so the whole directory is compared against the tab instead
+        if (files.empty())
+        {
+            if (auto updated = Globals::gData.mergeTabContent(directory, getTabContent(*tab)); updated)
+            {
+                onTabChanged(*updated);
+                Globals::gMetadata.index(updated->sounds);
+            }
+            return;
+        }
+
+        std::set<std::string> changed;
+        std::vector<Sound> sounds;
+        sounds.reserve(tab->sounds.size() + files.size());
+
+        for (auto &sound : tab->sounds)
+        {
+            if (files.find(sound.path) == files.end())
+            {
+                sounds.emplace_back(std::move(sound));
+            }
+        }
+
+        for (const auto &file : files)
+        {
+#if defined(_WIN32)
+            std::filesystem::path path = Helpers::widen(file);
+#else
+            std::filesystem::path path = file;
+#endif
+            std::error_code ec;
+            std::filesystem::directory_entry entry(path, ec);
+
+            if (!ec && entry.exists(ec))
+            {
+                if (auto sound = readSound(path.parent_path(), entry); sound)
+                {
+                    //* `mergeTabContent` will hand the previous id back if the sound was already known
+                    sound->id = ++Globals::gData.soundIdCounter;
+                    changed.emplace(sound->path);
+                    sounds.emplace_back(std::move(*sound));
+                }
+            }
+        }
+
+        auto sortMode = tab->sortMode;
+        std::sort(sounds.begin(), sounds.end(), [sortMode](const auto &first, const auto &second) {
+            return isSortedBefore(sortMode, first, second);
+        });
+
+        auto previous = Globals::gData.getTabByPath(directory);
+        auto updated = Globals::gData.mergeTabContent(directory, std::move(sounds));
+        if (!previous || !updated)
+        {
+            return;
+        }
+
+        std::vector<Sound> changedSounds;
+        for (const auto &sound : updated->sounds)
+        {
+            if (changed.find(sound.path) != changed.end())
+            {
+                changedSounds.emplace_back(sound);
+            }
+        }
+
+        std::unordered_set<std::uint32_t> remaining;
+        remaining.reserve(updated->sounds.size());
+        for (const auto &sound : updated->sounds)
+        {
+            remaining.emplace(sound.id);
+        }
+
+        std::vector<std::uint32_t> removed;
+        for (const auto &sound : previous->sounds)
+        {
+            if (remaining.find(sound.id) == remaining.end())
+            {
+                removed.emplace_back(sound.id);
+            }
+        }
+
+        onTabSoundsChanged(*updated, changedSounds, removed);
+        Globals::gMetadata.index(changedSounds);
     }
     std::vector<Sound> Window::getTabContent(const Tab &tab) const
     {
@@ -37,86 +245,75 @@ namespace Soundux::Objects
 
         if (std::filesystem::exists(path))
         {
+            //* Maps the path of every known sound to its position in the tab
+            std::unordered_map<std::string_view, std::size_t> known;
+            known.reserve(tab.sounds.size());
+            for (std::size_t i = 0; tab.sounds.size() > i; i++)
+            {
+                known.emplace(tab.sounds[i].path, i);
+            }
+
             std::vector<Sound> rtn;
+            std::vector<std::size_t> positions;
+            rtn.reserve(tab.sounds.size());
+
             for (const auto &entry : std::filesystem::directory_iterator(path))
             {
-                std::filesystem::path file = entry;
-                if (entry.is_symlink())
-                {
-                    file = std::filesystem::read_symlink(entry);
-                    if (file.has_relative_path())
-                    {
-                        file = std::filesystem::canonical(path / file);
-                    }
-                }
-
-                auto extension = file.extension().u8string();
-                std::transform(extension.begin(), extension.end(), extension.begin(),
-                               [](char c) { return std::tolower(c); });
-                if (extension != ".mp3" && extension != ".wav" && extension != ".flac")
+                auto file = readSound(path, entry);
+                if (!file)
                 {
                     continue;
                 }
 
-                Sound sound;
+                auto &sound = *file;
 
-                std::error_code ec;
-                auto writeTime = std::filesystem::last_write_time(file, ec);
-                if (!ec)
-                {
-                    sound.modifiedDate = writeTime.time_since_epoch().count();
-                }
-                else
+                if (auto oldSound = known.find(sound.path); oldSound != known.end())
                 {
-                    Fancy::fancy.logTime().warning() << "Failed to read lastWriteTime of " << file << std::endl;
-                }
+                    const auto &old = tab.sounds[oldSound->second];
 
-                sound.path = file.u8string();
-#if defined(_WIN32)
-                std::transform(sound.path.begin(), sound.path.end(), sound.path.begin(),
-                               [](char c) { return c == '\\' ? '/' : c; });
-#endif
-                sound.name = file.stem().u8string();
+                    sound.id = old.id;
+                    sound.hotkeys = old.hotkeys;
+                    sound.isFavorite = old.isFavorite;
+                    sound.localVolume = old.localVolume;
+                    sound.remoteVolume = old.remoteVolume;
 
-                auto oldSound = std::find_if(tab.sounds.begin(), tab.sounds.end(),
-                                             [&sound](const auto &item) { return item.path == sound.path; });
-
-                if (oldSound != tab.sounds.end())
-                {
-                    sound.id = oldSound->id;
-                    sound.hotkeys = oldSound->hotkeys;
-                    sound.isFavorite = oldSound->isFavorite;
-                    sound.localVolume = oldSound->localVolume;
-                    sound.remoteVolume = oldSound->remoteVolume;
+                    positions.emplace_back(oldSound->second);
                 }
                 else
                 {
                     sound.id = ++Globals::gData.soundIdCounter;
                 }
 
-                rtn.emplace_back(sound);
+                rtn.emplace_back(std::move(sound));
             }
 
-            switch (tab.sortMode)
+            auto sortMode = tab.sortMode;
+            auto compare = [sortMode](const Sound &first, const Sound &second) {
+                return isSortedBefore(sortMode, first, second);
+            };
+
+            //* If the directory still holds exactly the known sounds, their previous order is most likely still valid
+            if (positions.size() == rtn.size() && rtn.size() == tab.sounds.size())
             {
-            case Enums::SortMode::ModifiedDate_Descending:
-                std::sort(rtn.begin(), rtn.end(), [](const auto &first, const auto &second) {
-                    return first.modifiedDate > second.modifiedDate;
+                std::vector<bool> taken(rtn.size(), false);
+                auto isPermutation = std::all_of(positions.begin(), positions.end(), [&](auto position) {
+                    return !taken[position] && (taken[position] = true);
                 });
-                break;
-            case Enums::SortMode::ModifiedDate_Ascending:
-                std::sort(rtn.begin(), rtn.end(), [](const auto &first, const auto &second) {
-                    return first.modifiedDate < second.modifiedDate;
-                });
-                break;
-            case Enums::SortMode::Alphabetical_Descending:
-                std::sort(rtn.begin(), rtn.end(),
-                          [](const auto &first, const auto &second) { return first.name > second.name; });
-                break;
-            case Enums::SortMode::Alphabetical_Ascending:
-                std::sort(rtn.begin(), rtn.end(),
-                          [](const auto &first, const auto &second) { return first.name < second.name; });
-                break;
+
+                if (isPermutation)
+                {
+                    std::vector<Sound> ordered(rtn.size());
+                    for (std::size_t i = 0; rtn.size() > i; i++)
+                    {
+                        ordered[positions[i]] = std::move(rtn[i]);
+                    }
+                    rtn = std::move(ordered);
+                }
+            }
+
+            if (!std::is_sorted(rtn.begin(), rtn.end(), compare))
+            {
+                std::sort(rtn.begin(), rtn.end(), compare);
             }
 
             return rtn;
@@ -168,6 +365,8 @@ namespace Soundux::Objects
                     rootTab.name = std::filesystem::path(rootPath).filename().u8string();
 
                     tabs.emplace_back(Globals::gData.addTab(std::move(rootTab)));
+                    Globals::gWatcher.watch(rootPath);
+                    indexTab(tabs.back());
                 }
 
                 for (const auto &entry : std::filesystem::directory_iterator(path))
@@ -190,6 +389,8 @@ namespace Soundux::Objects
                             if (!subFolderTab.sounds.empty())
                             {
                                 tabs.emplace_back(Globals::gData.addTab(std::move(subFolderTab)));
+                                Globals::gWatcher.watch(path);
+                                indexTab(tabs.back());
                             }
                         }
                     }
@@ -206,60 +407,57 @@ namespace Soundux::Objects
 #if defined(__linux__)
     std::optional<PlayingSound> Window::playSound(const std::uint32_t &id)
     {
-        auto sound = Globals::gData.getSound(id);
+        Tracer::Scope trace(TracePoint::PlayRequested);
+        auto sound = Globals::gData.findSound(id);
         if (sound)
         {
             if (!Globals::gSettings.allowOverlapping)
             {
+                //* Keeps the input muted and routed for the next sound
+                {
+                    std::lock_guard lock(routing.mutex);
+                    routing.replacing = true;
+                }
                 stopSounds(true);
+                {
+                    std::lock_guard lock(routing.mutex);
+                    routing.replacing = false;
+                }
             }
             if (Globals::gSettings.muteDuringPlayback)
             {
-                if (Globals::gAudioBackend)
-                {
-                    if (!Globals::gAudioBackend->muteInput(true))
-                    {
-                        onError(Enums::ErrorCode::FailedToMute);
-                    }
-                }
+                setInputMuted(true);
             }
             if (!Globals::gSettings.pushToTalkKeys.empty())
             {
                 Globals::gHotKeys.pressKeys(Globals::gSettings.pushToTalkKeys);
             }
 
-            auto playingSound = Globals::gAudio.play(*sound);
-            auto remotePlayingSound = Globals::gAudio.play(*sound, Globals::gAudio.nullSink);
+            std::vector<AudioDevice> remoteDevices;
+            if (auto nullSink = Globals::gAudio.getNullSink(); nullSink)
+            {
+                remoteDevices.emplace_back(*nullSink);
+            }
+
+            auto playingSound = Globals::gAudio.play(*sound, remoteDevices);
 
-            if (playingSound && remotePlayingSound)
+            if (playingSound)
             {
-                groupedSounds->insert({playingSound->id, remotePlayingSound->id});
-                if (Globals::gSettings.outputs.empty() && playingSound)
+                if (Globals::gSettings.outputs.empty())
                 {
                     return *playingSound;
                 }
                 if (!Globals::gSettings.outputs.empty() && Globals::gAudioBackend)
                 {
-                    bool moveSuccess = false;
-                    for (const auto &outputApp : Globals::gSettings.outputs)
+                    if (!openRouting())
                     {
-                        if (Globals::gAudioBackend->inputSoundTo(Globals::gAudioBackend->getRecordingApp(outputApp)))
-                        {
-                            moveSuccess = true;
-                        }
-                    }
-
-                    if (!moveSuccess)
-                    {
-                        if (playingSound)
-                            stopSound(playingSound->id);
-                        if (remotePlayingSound)
-                            stopSound(remotePlayingSound->id);
+                        stopSound(playingSound->id);
 
                         onError(Enums::ErrorCode::FailedToMoveToSink);
                         return std::nullopt;
                     }
 
+                    Globals::gTracer.mark(Tracer::current(), TracePoint::RoutingDone);
                     return *playingSound;
                 }
             }
@@ -278,7 +476,8 @@ namespace Soundux::Objects
 #else
     std::optional<PlayingSound> Window::playSound(const std::uint32_t &id)
     {
-        auto sound = Globals::gData.getSound(id);
+        Tracer::Scope trace(TracePoint::PlayRequested);
+        auto sound = Globals::gData.findSound(id);
         if (sound)
         {
             if (!Globals::gSettings.allowOverlapping)
@@ -305,30 +504,25 @@ namespace Soundux::Objects
                 return Globals::gAudio.play(*sound);
             }
 
-            auto playingSound = Globals::gAudio.play(*sound);
-            auto playbackDevice = Globals::gAudio.getAudioDevice(Globals::gSettings.outputs.front());
-
-            if (playbackDevice && !playbackDevice->isDefault)
+            std::vector<AudioDevice> remoteDevices;
+            for (const auto &output : Globals::gSettings.outputs)
             {
-                auto remotePlayingSound = Globals::gAudio.play(*sound, playbackDevice);
-                if (playingSound && remotePlayingSound)
+                auto playbackDevice = Globals::gAudio.getAudioDevice(output);
+                if (playbackDevice && !playbackDevice->isDefault)
                 {
-                    groupedSounds->insert({playingSound->id, remotePlayingSound->id});
-                    return *playingSound;
+                    remoteDevices.emplace_back(*playbackDevice);
                 }
+            }
 
-                if (playingSound)
-                    stopSound(playingSound->id);
-
-                if (remotePlayingSound)
-                    stopSound(remotePlayingSound->id);
-
-                Fancy::fancy.logTime().failure() << "Failed to play sound " << id << std::endl;
-                onError(Enums::ErrorCode::FailedToPlay);
-                return std::nullopt;
+            auto playingSound = Globals::gAudio.play(*sound, remoteDevices);
+            if (playingSound)
+            {
+                return *playingSound;
             }
 
-            return *playingSound;
+            Fancy::fancy.logTime().failure() << "Failed to play sound " << id << std::endl;
+            onError(Enums::ErrorCode::FailedToPlay);
+            return std::nullopt;
         }
 
         Fancy::fancy.logTime().failure() << "Sound " << id << " not found" << std::endl;
@@ -338,28 +532,7 @@ namespace Soundux::Objects
 #endif
     std::optional<PlayingSound> Window::pauseSound(const std::uint32_t &id)
     {
-        std::optional<std::uint32_t> remoteSoundId;
-        if (!Globals::gSettings.outputs.empty() && !Globals::gSettings.useAsDefaultDevice)
-        {
-            auto scoped = groupedSounds.scoped();
-            if (scoped->find(id) == scoped->end())
-            {
-                if (!Globals::gSettings.outputs.empty() || !Globals::gSettings.useAsDefaultDevice)
-                {
-                    Fancy::fancy.logTime().warning() << "Failed to find remoteSound of sound " << id << std::endl;
-                }
-            }
-            else
-            {
-                remoteSoundId = scoped->at(id);
-            }
-        }
         auto playingSound = Globals::gAudio.pause(id);
-        if (remoteSoundId)
-        {
-            Globals::gAudio.pause(*remoteSoundId);
-        }
-
         if (playingSound)
         {
             return *playingSound;
@@ -371,28 +544,7 @@ namespace Soundux::Objects
     }
     std::optional<PlayingSound> Window::resumeSound(const std::uint32_t &id)
     {
-        std::optional<std::uint32_t> remoteSoundId;
-        if (!Globals::gSettings.outputs.empty() && !Globals::gSettings.useAsDefaultDevice)
-        {
-            auto scoped = groupedSounds.scoped();
-            if (scoped->find(id) == scoped->end())
-            {
-                if (!Globals::gSettings.outputs.empty() || !Globals::gSettings.useAsDefaultDevice)
-                {
-                    Fancy::fancy.logTime().warning() << "Failed to find remoteSound of sound " << id << std::endl;
-                }
-            }
-            else
-            {
-                remoteSoundId = scoped->at(id);
-            }
-        }
         auto playingSound = Globals::gAudio.resume(id);
-        if (remoteSoundId)
-        {
-            Globals::gAudio.resume(*remoteSoundId);
-        }
-
         if (playingSound)
         {
             return *playingSound;
@@ -404,28 +556,7 @@ namespace Soundux::Objects
     }
     std::optional<PlayingSound> Window::seekSound(const std::uint32_t &id, std::uint64_t seekTo)
     {
-        std::optional<std::uint32_t> remoteSoundId;
-        if (!Globals::gSettings.outputs.empty() && !Globals::gSettings.useAsDefaultDevice)
-        {
-            auto scoped = groupedSounds.scoped();
-            if (scoped->find(id) == scoped->end())
-            {
-                if (!Globals::gSettings.outputs.empty() || !Globals::gSettings.useAsDefaultDevice)
-                {
-                    Fancy::fancy.logTime().warning() << "Failed to find remoteSound of sound " << id << std::endl;
-                }
-            }
-            else
-            {
-                remoteSoundId = scoped->at(id);
-            }
-        }
         auto playingSound = Globals::gAudio.seek(id, seekTo);
-        if (remoteSoundId)
-        {
-            Globals::gAudio.seek(*remoteSoundId, seekTo);
-        }
-
         if (playingSound)
         {
             return *playingSound;
@@ -437,28 +568,7 @@ namespace Soundux::Objects
     }
     std::optional<PlayingSound> Window::repeatSound(const std::uint32_t &id, bool shouldRepeat)
     {
-        std::optional<std::uint32_t> remoteSoundId;
-        if (!Globals::gSettings.outputs.empty() && !Globals::gSettings.useAsDefaultDevice)
-        {
-            auto scoped = groupedSounds.scoped();
-            if (scoped->find(id) == scoped->end())
-            {
-                if (!Globals::gSettings.outputs.empty() || !Globals::gSettings.useAsDefaultDevice)
-                {
-                    Fancy::fancy.logTime().warning() << "Failed to find remoteSound of sound " << id << std::endl;
-                }
-            }
-            else
-            {
-                remoteSoundId = scoped->at(id);
-            }
-        }
         auto playingSound = Globals::gAudio.repeat(id, shouldRepeat);
-        if (remoteSoundId)
-        {
-            Globals::gAudio.repeat(*remoteSoundId, shouldRepeat);
-        }
-
         if (playingSound)
         {
             return *playingSound;
@@ -469,34 +579,23 @@ namespace Soundux::Objects
         onError(Enums::ErrorCode::FailedToRepeat);
         return std::nullopt;
     }
-    std::vector<Tab> Window::removeTab(const std::uint32_t &id)
+    TabChanges Window::removeTab(const std::uint32_t &id)
     {
+        if (auto path = Globals::gData.getTabPath(id); path)
+        {
+            Globals::gWatcher.unwatch(*path);
+        }
+
+        auto since = Globals::gData.getRevision();
         Globals::gData.removeTabById(id);
-        return Globals::gData.getTabs();
+
+        return Globals::gData.getChangesSince(since);
     }
     bool Window::stopSound(const std::uint32_t &id)
     {
-        std::optional<std::uint32_t> remoteSoundId;
-        if (!Globals::gSettings.outputs.empty() && !Globals::gSettings.useAsDefaultDevice)
-        {
-            auto scoped = groupedSounds.scoped();
-            if (scoped->find(id) == scoped->end())
-            {
-                Fancy::fancy.logTime().warning() << "Failed to find remoteSound of sound " << id << std::endl;
-                return false;
-            }
-
-            remoteSoundId = scoped->at(id);
-        }
-
         auto status = Globals::gAudio.stop(id);
-        if (remoteSoundId)
-        {
-            Globals::gAudio.stop(*remoteSoundId);
-            groupedSounds->erase(id);
-        }
 
-        if (Globals::gAudio.getPlayingSounds().empty())
+        if (Globals::gAudio.getPlayingCount() == 0)
         {
             onAllSoundsFinished();
         }
@@ -514,36 +613,28 @@ namespace Soundux::Objects
             Globals::gAudio.stopAll();
         }
 
-        onAllSoundsFinished();
-        groupedSounds->clear();
-
 #if defined(__linux__)
-        if (Globals::gAudioBackend)
+        //* Stopped first, so that the routes can be released once all sounds are finished
+        if (Globals::gAudioBackend && !Globals::gAudioBackend->stopAllPassthrough())
         {
-            if (!Globals::gAudioBackend->stopSoundInput())
-            {
-                onError(Enums::ErrorCode::FailedToMoveBack);
-            }
-            if (!Globals::gAudioBackend->stopAllPassthrough())
-            {
-                onError(Enums::ErrorCode::FailedToMoveBackPassthrough);
-            }
+            onError(Enums::ErrorCode::FailedToMoveBackPassthrough);
         }
 #endif
+
+        onAllSoundsFinished();
     }
     std::optional<Sound> Window::setCustomLocalVolume(const std::uint32_t &id, const std::optional<int> &localVolume)
     {
-        auto sound = Globals::gData.getSound(id);
+        auto sound = Globals::gData.updateSound(id, [&](Sound &stored) { stored.localVolume = localVolume; });
         if (sound)
         {
-            sound->get().localVolume = localVolume;
-
             for (auto &playingSound : Globals::gAudio.getPlayingSounds())
             {
-                if (playingSound.sound.id == sound->get().id && playingSound.playbackDevice.isDefault)
+                if (playingSound.sound.id == sound->id)
                 {
-                    playingSound.raw.device.load()->masterVolumeFactor =
-                        static_cast<float>(localVolume ? *localVolume : Globals::gSettings.localVolume) / 100.f;
+                    Globals::gAudio.setLocalVolume(
+                        playingSound.id,
+                        static_cast<float>(localVolume ? *localVolume : Globals::gSettings.localVolume) / 100.f);
                 }
             }
 
@@ -557,17 +648,16 @@ namespace Soundux::Objects
     }
     std::optional<Sound> Window::setCustomRemoteVolume(const std::uint32_t &id, const std::optional<int> &remoteVolume)
     {
-        auto sound = Globals::gData.getSound(id);
+        auto sound = Globals::gData.updateSound(id, [&](Sound &stored) { stored.remoteVolume = remoteVolume; });
         if (sound)
         {
-            sound->get().remoteVolume = remoteVolume;
-
             for (auto &playingSound : Globals::gAudio.getPlayingSounds())
             {
-                if (playingSound.sound.id == sound->get().id && !playingSound.playbackDevice.isDefault)
+                if (playingSound.sound.id == sound->id)
                 {
-                    playingSound.raw.device.load()->masterVolumeFactor =
-                        static_cast<float>(remoteVolume ? *remoteVolume : Globals::gSettings.remoteVolume) / 100.f;
+                    Globals::gAudio.setRemoteVolume(
+                        playingSound.id,
+                        static_cast<float>(remoteVolume ? *remoteVolume : Globals::gSettings.remoteVolume) / 100.f);
                 }
             }
 
@@ -585,25 +675,36 @@ namespace Soundux::Objects
         Globals::gSettings = settings;
 
         if ((settings.localVolume != oldSettings.localVolume || settings.remoteVolume != oldSettings.remoteVolume) &&
-            !Globals::gAudio.getPlayingSounds().empty())
+            Globals::gAudio.getPlayingCount() > 0)
         {
             for (const auto &playingSound : Globals::gAudio.getPlayingSounds())
             {
-                int newVolume = 0;
                 const auto &sound = playingSound.sound;
 
-                if (playingSound.playbackDevice.isDefault)
-                {
-                    newVolume = sound.localVolume ? *sound.localVolume : Globals::gSettings.localVolume;
-                }
-                else
-                {
-                    newVolume = sound.remoteVolume ? *sound.remoteVolume : Globals::gSettings.remoteVolume;
-                }
+                auto localVolume = sound.localVolume ? *sound.localVolume : Globals::gSettings.localVolume;
+                auto remoteVolume = sound.remoteVolume ? *sound.remoteVolume : Globals::gSettings.remoteVolume;
 
-                playingSound.raw.device.load()->masterVolumeFactor = static_cast<float>(newVolume) / 100.f;
+                Globals::gAudio.setLocalVolume(playingSound.id, static_cast<float>(localVolume) / 100.f);
+                Globals::gAudio.setRemoteVolume(playingSound.id, static_cast<float>(remoteVolume) / 100.f);
+            }
+        }
+        if (settings.pcmCacheBudget != oldSettings.pcmCacheBudget)
+        {
+            Globals::gAudio.setCacheBudget(settings.pcmCacheBudget);
+        }
+        if (settings.selectedTab != oldSettings.selectedTab ||
+            (settings.preloadSounds && !oldSettings.preloadSounds))
+        {
+            if (auto tab = Globals::gData.getTab(settings.selectedTab); tab)
+            {
+                preloadTab(*tab);
             }
         }
+        if (settings.latencyProfile != oldSettings.latencyProfile)
+        {
+            stopSounds(true);
+            Globals::gAudio.setup();
+        }
 
 #if defined(__linux__)
         if (settings.audioBackend != oldSettings.audioBackend)
@@ -612,29 +713,29 @@ namespace Soundux::Objects
 
             if (Globals::gAudioBackend)
             {
+                closeRouting();
                 Globals::gAudioBackend->destroy();
             }
+            {
+                std::lock_guard lock(routing.mutex);
+                routing.muted = false;
+            }
 
             Globals::gAudioBackend = AudioBackend::createInstance(settings.audioBackend);
             Globals::gAudio.setup();
+            watchApps();
         }
         if (Globals::gAudioBackend)
         {
-            if (!Globals::gAudio.getPlayingSounds().empty())
+            if (Globals::gAudio.getPlayingCount() > 0)
             {
                 if (settings.muteDuringPlayback && !oldSettings.muteDuringPlayback)
                 {
-                    if (!Globals::gAudioBackend->muteInput(true))
-                    {
-                        onError(Enums::ErrorCode::FailedToMute);
-                    }
+                    setInputMuted(true);
                 }
                 else if (!settings.muteDuringPlayback && oldSettings.muteDuringPlayback)
                 {
-                    if (!Globals::gAudioBackend->muteInput(false))
-                    {
-                        onError(Enums::ErrorCode::FailedToMute);
-                    }
+                    setInputMuted(false);
                 }
             }
             if (!settings.useAsDefaultDevice && oldSettings.useAsDefaultDevice)
@@ -647,10 +748,7 @@ namespace Soundux::Objects
             else if (settings.useAsDefaultDevice && !oldSettings.useAsDefaultDevice)
             {
                 Globals::gSettings.outputs.clear();
-                if (!Globals::gAudioBackend->stopSoundInput())
-                {
-                    onError(Enums::ErrorCode::FailedToMoveBack);
-                }
+                closeRouting();
                 if (!Globals::gAudioBackend->useAsDefault())
                 {
                     onError(Enums::ErrorCode::FailedToSetDefaultSource);
@@ -665,29 +763,21 @@ namespace Soundux::Objects
                                                      << std::endl;
 
                     settings.outputs = {settings.outputs.front()};
+                    Globals::gSettings.outputs = settings.outputs;
                 }
 
-                if (!Globals::gAudioBackend->stopSoundInput())
-                {
-                    onError(Enums::ErrorCode::FailedToMoveBack);
-                }
+                closeRouting();
 
-                for (const auto &outputApp : settings.outputs)
+                if (!settings.outputs.empty() && Globals::gAudio.getPlayingCount() > 0 && !openRouting())
                 {
-                    if (!settings.outputs.empty() && !Globals::gAudio.getPlayingSounds().empty())
-                    {
-                        if (!Globals::gAudioBackend->inputSoundTo(Globals::gAudioBackend->getRecordingApp(outputApp)))
-                        {
-                            onError(Enums::ErrorCode::FailedToMoveToSink);
-                        }
-                    }
+                    onError(Enums::ErrorCode::FailedToMoveToSink);
                 }
             }
         }
 #elif defined(_WIN32)
         if (Globals::gWinSound)
         {
-            if (!Globals::gAudio.getPlayingSounds().empty())
+            if (Globals::gAudio.getPlayingCount() > 0)
             {
                 if (settings.muteDuringPlayback && !oldSettings.muteDuringPlayback)
                 {
@@ -712,21 +802,40 @@ namespace Soundux::Objects
             }
         }
 #endif
+        //* Notified last, the changes above may have adjusted `gSettings` again
+        Globals::gConfigSaver.onSettingsChanged(Globals::gSettings);
         return Globals::gSettings;
     }
     void Window::onHotKeyReceived([[maybe_unused]] const std::vector<int> &keys)
     {
         Globals::gHotKeys.shouldNotify(false);
     }
+    std::optional<Tab> Window::getTabWithoutSounds(const std::uint32_t &id) const
+    {
+        Tab rtn;
+        auto found = Globals::gData.visitTab(id, [&rtn](const Tab &tab) {
+            rtn.id = tab.id;
+            rtn.name = tab.name;
+            rtn.path = tab.path;
+            rtn.sortMode = tab.sortMode;
+        });
+
+        if (found)
+        {
+            return rtn;
+        }
+
+        return std::nullopt;
+    }
     std::optional<Tab> Window::refreshTab(const std::uint32_t &id)
     {
-        auto tab = Globals::gData.getTab(id);
-        if (tab)
+        if (auto tab = getTabWithoutSounds(id); tab)
         {
             tab->sounds = getTabContent(*tab);
-            auto newTab = Globals::gData.setTab(id, *tab);
+            auto newTab = Globals::gData.setTab(id, std::move(*tab));
             if (newTab)
             {
+                indexTab(*newTab);
                 return newTab;
             }
         }
@@ -736,12 +845,11 @@ namespace Soundux::Objects
     }
     std::optional<Tab> Window::setSortMode(const std::uint32_t &id, Enums::SortMode sortMode)
     {
-        auto tab = Globals::gData.getTab(id);
-        if (tab)
+        if (auto tab = getTabWithoutSounds(id); tab)
         {
             tab->sortMode = sortMode;
             tab->sounds = getTabContent(*tab);
-            auto newTab = Globals::gData.setTab(id, *tab);
+            auto newTab = Globals::gData.setTab(id, std::move(*tab));
             if (newTab)
             {
                 return newTab;
@@ -753,143 +861,354 @@ namespace Soundux::Objects
         onError(Enums::ErrorCode::TabDoesNotExist);
         return std::nullopt;
     }
+    std::optional<SoundPage> Window::getTabSounds(const std::uint32_t &id, std::size_t offset, std::size_t limit)
+    {
+        auto page = Globals::gData.getSoundPage(id, offset, limit);
+        if (page)
+        {
+            return page;
+        }
+
+        onError(Enums::ErrorCode::TabDoesNotExist);
+        return std::nullopt;
+    }
     std::optional<Sound> Window::setHotkey(const std::uint32_t &id, const std::vector<int> &hotkeys)
     {
-        auto sound = Globals::gData.getSound(id);
+        if (!KeyCombination::fits(hotkeys))
+        {
+            Fancy::fancy.logTime().failure() << "Failed to set hotkey for sound " << id << ", hotkeys may have at most "
+                                             << KeyCombination::capacity << " keys" << std::endl;
+            onError(Enums::ErrorCode::FailedToSetHotkey);
+            return std::nullopt;
+        }
+
+        auto sound = Globals::gData.updateSound(id, [&](Sound &stored) { stored.hotkeys = hotkeys; });
         if (sound)
         {
-            sound->get().hotkeys = hotkeys;
-            return sound->get();
+            if (!hotkeys.empty())
+            {
+                Globals::gAudio.preload({*sound}, true);
+            }
+            return sound;
         }
         Fancy::fancy.logTime().failure() << "Failed to set hotkey for sound " << id << ", sound does not exist"
                                          << std::endl;
         onError(Enums::ErrorCode::FailedToSetHotkey);
         return std::nullopt;
     }
-    std::vector<Tab> Window::changeTabOrder(const std::vector<int> &newOrder)
+    void Window::preloadTab(const Tab &tab)
+    {
+        //* Sounds with a hotkey are the ones most likely to be triggered without any warning
+        std::vector<Sound> bound;
+        std::copy_if(tab.sounds.begin(), tab.sounds.end(), std::back_inserter(bound),
+                     [](const auto &sound) { return !sound.hotkeys.empty(); });
+        Globals::gAudio.preload(bound, true);
+
+        if (Globals::gData.getTabPath(Globals::gSettings.selectedTab) == tab.path)
+        {
+            auto count = std::min(tab.sounds.size(), maxTabPreloads);
+            Globals::gAudio.preload(std::vector<Sound>(tab.sounds.begin(), tab.sounds.begin() + count));
+        }
+    }
+    void Window::preloadSound(const std::uint32_t &id)
+    {
+        if (auto sound = Globals::gData.getSound(id); sound)
+        {
+            Globals::gAudio.preload({*sound}, true);
+        }
+    }
+    std::optional<WaveformPeaks> Window::getWaveform(const std::uint32_t &id, std::size_t buckets)
     {
-        std::vector<Tab> newTabs;
-        newTabs.reserve(newOrder.size());
+        auto sound = Globals::gData.getSound(id);
+        if (!sound)
+        {
+            return std::nullopt;
+        }
 
-        for (auto tabId : newOrder)
+        auto metadata = Globals::gMetadata.get(*sound);
+        auto waveform = metadata && metadata->hasWaveform ? Waveform::load(*sound) : std::nullopt;
+        if (!waveform || waveform->levels.empty())
         {
-            newTabs.emplace_back(*Globals::gData.getTab(tabId));
+            //* Does nothing if the sound is already queued, the frontend asks again later
+            Globals::gMetadata.analyze({*sound});
+            return std::nullopt;
         }
-        Globals::gData.setTabs(newTabs);
-        return Globals::gData.getTabs();
+
+        const auto *level = waveform->getLevel(buckets);
+        return WaveformPeaks{metadata->sampleRate, level->framesPerBucket,
+                             base64_encode(reinterpret_cast<const unsigned char *>(level->peaks.data()),
+                                           level->peaks.size())};
+    }
+    TabChanges Window::changeTabOrder(const std::vector<int> &newOrder)
+    {
+        auto since = Globals::gData.getRevision();
+        Globals::gData.reorderTabs(newOrder);
+
+        return Globals::gData.getChangesSince(since);
     }
 #if defined(__linux__)
-    std::vector<std::shared_ptr<IconRecordingApp>> Window::getOutputs()
+    template <typename T, typename App> static bool isSameList(const T &first, const App &second)
     {
-        //* The frontend only uses the stream name and should only show multiple streams that belong to one application
-        //* once. The backend (gPulse.getRecordingStreams()) will work with multiple instances, so we need to filter out
-        //* duplicates here.
+        return std::equal(first.begin(), first.end(), second.begin(), second.end(), [](const auto &a, const auto &b) {
+            return a->name == b->name && a->application == b->application && a->appIcon == b->appIcon;
+        });
+    }
+    //* The frontend only uses the stream name and should only show multiple streams that belong to one application
+    //* once. The backend will work with multiple instances, so we need to filter out duplicates here.
+    template <typename T, typename App>
+    static std::vector<std::shared_ptr<T>> collectApps(const std::vector<std::shared_ptr<App>> &streams,
+                                                       const std::vector<std::shared_ptr<T>> &previous)
+    {
+        std::unordered_map<std::string_view, std::shared_ptr<T>> known;
+        for (const auto &app : previous)
+        {
+            known.emplace(app->name, app);
+        }
 
-        std::vector<std::shared_ptr<IconRecordingApp>> uniqueStreams;
+        std::vector<std::shared_ptr<T>> rtn;
+        std::unordered_set<std::string_view> names;
+        std::vector<int> pids;
 
-        if (Globals::gAudioBackend)
+        for (const auto &stream : streams)
+        {
+            if (!stream || stream->application.find("soundux") != std::string::npos ||
+                !names.emplace(stream->name).second)
+            {
+                continue;
+            }
+
+            //* Entries are never modified once they were handed out, so unchanged ones are shared
+            if (auto entry = known.find(stream->name); entry != known.end() && !entry->second->appIcon.empty() &&
+                                                       entry->second->application == stream->application &&
+                                                       entry->second->pid == stream->pid)
+            {
+                rtn.emplace_back(entry->second);
+                continue;
+            }
+
+            rtn.emplace_back(std::make_shared<T>(*stream));
+            if (stream->pid > 0)
+            {
+                pids.emplace_back(static_cast<int>(stream->pid));
+            }
+        }
+
+        if (Globals::gIcons && !pids.empty())
         {
-            auto streams = Globals::gAudioBackend->getRecordingApps();
-            for (auto &stream : streams)
+            auto icons = Globals::gIcons->getIcons(pids);
+            for (auto &app : rtn)
             {
-                if (stream->application.find("soundux") != std::string::npos)
+                if (auto icon = icons.find(static_cast<int>(app->pid)); app->appIcon.empty() && icon != icons.end())
                 {
-                    continue;
+                    app->appIcon = icon->second;
                 }
+            }
+        }
+
+        return rtn;
+    }
+    void Window::watchApps()
+    {
+        if (Globals::gAudioBackend)
+        {
+            Globals::gAudioBackend->setAppsChangedCallback([this](Enums::AppType type) { onAppsChanged(type); });
+        }
 
-                auto item = std::find_if(std::begin(uniqueStreams), std::end(uniqueStreams),
-                                         [&](const auto &_stream) { return stream->name == _stream->name; });
-                if (stream && item == std::end(uniqueStreams))
+        onAppsChanged(Enums::AppType::Playback);
+        onAppsChanged(Enums::AppType::Recording);
+    }
+    void Window::onAppsChanged(Enums::AppType type)
+    {
+        std::lock_guard lock(apps.mutex);
+        (type == Enums::AppType::Playback ? apps.playbackDirty : apps.outputsDirty) = true;
+
+        //* Apps usually come and go in bursts, those are collapsed into a single update
+        if (apps.updateScheduled)
+        {
+            return;
+        }
+        apps.updateScheduled = true;
+
+        g_idle_add(
+            [](gpointer data) -> gboolean {
+                auto *thiz = reinterpret_cast<Window *>(data);
                 {
-                    auto iconStream = std::make_shared<IconRecordingApp>(*stream);
-                    if (Globals::gIcons)
-                    {
-                        if (auto pulseApp = std::dynamic_pointer_cast<PulseRecordingApp>(stream); pulseApp)
-                        {
-                            auto icon = Soundux::Globals::gIcons->getIcon(static_cast<int>(pulseApp->pid));
-                            if (icon)
-                            {
-                                iconStream->appIcon = *icon;
-                            }
-                        }
-                        else if (auto pipeWireApp = std::dynamic_pointer_cast<PipeWireRecordingApp>(stream);
-                                 pipeWireApp)
-                        {
-                            auto icon = Soundux::Globals::gIcons->getIcon(static_cast<int>(pipeWireApp->pid));
-                            if (icon)
-                            {
-                                iconStream->appIcon = *icon;
-                            }
-                        }
-                    }
+                    std::lock_guard lock(thiz->apps.mutex);
+                    thiz->apps.updateScheduled = false;
+                }
+
+                thiz->updateApps();
+                return G_SOURCE_REMOVE;
+            },
+            this);
+    }
+    void Window::updateApps()
+    {
+        bool outputsDirty = false;
+        bool playbackDirty = false;
+        std::vector<std::shared_ptr<IconRecordingApp>> outputs;
+        std::vector<std::shared_ptr<IconPlaybackApp>> playback;
+        {
+            std::lock_guard lock(apps.mutex);
+            std::swap(outputsDirty, apps.outputsDirty);
+            std::swap(playbackDirty, apps.playbackDirty);
 
-                    uniqueStreams.emplace_back(iconStream);
+            outputs = apps.outputs;
+            playback = apps.playback;
+        }
+
+        if (outputsDirty)
+        {
+            auto updated = Globals::gAudioBackend ? collectApps(Globals::gAudioBackend->getRecordingApps(), outputs)
+                                                  : decltype(outputs){};
+            if (!isSameList(updated, outputs))
+            {
+                {
+                    std::lock_guard lock(apps.mutex);
+                    apps.outputs = updated;
+                }
+                onOutputsChanged(updated);
+            }
+        }
+        if (playbackDirty)
+        {
+            auto updated = Globals::gAudioBackend ? collectApps(Globals::gAudioBackend->getPlaybackApps(), playback)
+                                                  : decltype(playback){};
+            if (!isSameList(updated, playback))
+            {
+                {
+                    std::lock_guard lock(apps.mutex);
+                    apps.playback = updated;
                 }
+                onPlaybackChanged(updated);
             }
         }
+    }
+    std::vector<std::shared_ptr<IconRecordingApp>> Window::getOutputs()
+    {
+        updateApps();
 
-        return uniqueStreams;
+        std::lock_guard lock(apps.mutex);
+        return apps.outputs;
     }
     std::vector<std::shared_ptr<IconPlaybackApp>> Window::getPlayback()
     {
-        std::vector<std::shared_ptr<IconPlaybackApp>> uniqueStreams;
+        updateApps();
 
-        if (Globals::gAudioBackend)
+        std::lock_guard lock(apps.mutex);
+        return apps.playback;
+    }
+    bool Window::openRouting()
+    {
+        std::lock_guard lock(routing.mutex);
+        routing.idleSince.reset();
+
+        if (!Globals::gAudioBackend)
         {
-            auto streams = Globals::gAudioBackend->getPlaybackApps();
+            return false;
+        }
 
-            for (auto &stream : streams)
+        if (routing.outputs != Globals::gSettings.outputs)
+        {
+            if (!routing.routed.empty() && !Globals::gAudioBackend->stopSoundInput())
             {
-                if (stream->application.find("soundux") != std::string::npos)
-                {
-                    continue;
-                }
+                onError(Enums::ErrorCode::FailedToMoveBack);
+            }
 
-                auto item = std::find_if(std::begin(uniqueStreams), std::end(uniqueStreams),
-                                         [&](const auto &_stream) { return stream->name == _stream->name; });
-                if (stream && item == std::end(uniqueStreams))
-                {
-                    auto iconStream = std::make_shared<IconPlaybackApp>(*stream);
+            routing.routed.clear();
+            routing.outputs = Globals::gSettings.outputs;
+        }
 
-                    if (Globals::gIcons)
-                    {
-                        if (auto pulseApp = std::dynamic_pointer_cast<PulsePlaybackApp>(stream); pulseApp)
-                        {
-                            auto icon = Soundux::Globals::gIcons->getIcon(static_cast<int>(pulseApp->pid));
-                            if (icon)
-                            {
-                                iconStream->appIcon = *icon;
-                            }
-                        }
-                        if (auto pipeWireApp = std::dynamic_pointer_cast<PipeWirePlaybackApp>(stream); pipeWireApp)
-                        {
-                            auto icon = Soundux::Globals::gIcons->getIcon(static_cast<int>(pipeWireApp->pid));
-                            if (icon)
-                            {
-                                iconStream->appIcon = *icon;
-                            }
-                        }
-                    }
+        //* Outputs that were not running yet are retried on every play
+        for (const auto &outputApp : routing.outputs)
+        {
+            if (!routing.routed.count(outputApp) &&
+                Globals::gAudioBackend->inputSoundTo(Globals::gAudioBackend->getRecordingApp(outputApp)))
+            {
+                routing.routed.emplace(outputApp);
+            }
+        }
 
-                    uniqueStreams.emplace_back(iconStream);
-                }
+        return !routing.routed.empty();
+    }
+    void Window::releaseRouting()
+    {
+        auto timeout = Globals::gSettings.routingIdleTimeout;
+        if (timeout == 0)
+        {
+            closeRouting();
+            return;
+        }
+
+        {
+            std::lock_guard lock(routing.mutex);
+            if (routing.routed.empty())
+            {
+                return;
+            }
+            routing.idleSince = std::chrono::steady_clock::now();
+        }
+
+        g_timeout_add(
+            timeout * 1000,
+            [](gpointer data) -> gboolean {
+                reinterpret_cast<Window *>(data)->closeRouting(true);
+                return G_SOURCE_REMOVE;
+            },
+            this);
+    }
+    void Window::closeRouting(bool idleOnly)
+    {
+        std::lock_guard lock(routing.mutex);
+        if (idleOnly)
+        {
+            //* Every release schedules a timeout, only the one of the latest release closes the routes
+            auto timeout = std::chrono::seconds(Globals::gSettings.routingIdleTimeout);
+            if (!routing.idleSince || std::chrono::steady_clock::now() - *routing.idleSince < timeout)
+            {
+                return;
             }
+            if (Globals::gAudio.getPlayingCount() > 0 ||
+                (Globals::gAudioBackend && !Globals::gAudioBackend->currentlyPassedThrough().empty()))
+            {
+                return;
+            }
+        }
+
+        routing.idleSince.reset();
+        routing.outputs.clear();
+
+        if (!routing.routed.empty() && Globals::gAudioBackend && !Globals::gAudioBackend->stopSoundInput())
+        {
+            onError(Enums::ErrorCode::FailedToMoveBack);
+        }
+        routing.routed.clear();
+    }
+    void Window::setInputMuted(bool state)
+    {
+        std::lock_guard lock(routing.mutex);
+        if (routing.muted == state || !Globals::gAudioBackend)
+        {
+            return;
         }
 
-        return uniqueStreams;
+        if (!Globals::gAudioBackend->muteInput(state))
+        {
+            onError(Enums::ErrorCode::FailedToMute);
+            return;
+        }
+
+        routing.muted = state;
     }
     bool Window::startPassthrough(const std::string &name)
     {
         bool success = true;
         if (Globals::gAudioBackend && !Globals::gSettings.outputs.empty())
         {
-            for (const auto &outputApp : Globals::gSettings.outputs)
+            if (!openRouting())
             {
-                if (!Globals::gAudioBackend->inputSoundTo(Globals::gAudioBackend->getRecordingApp(outputApp)))
-                {
-                    onError(Enums::ErrorCode::FailedToMoveToSink);
-                    success = false;
-                }
+                onError(Enums::ErrorCode::FailedToMoveToSink);
+                success = false;
             }
 
             if (success)
@@ -912,18 +1231,14 @@ namespace Soundux::Objects
     {
         if (Globals::gAudioBackend)
         {
-            if (Globals::gAudio.getPlayingSounds().empty() &&
-                Globals::gAudioBackend->currentlyPassedThrough().size() == 1)
+            if (!Globals::gAudioBackend->stopPassthrough(name))
             {
-                if (!Globals::gAudioBackend->stopSoundInput())
-                {
-                    onError(Enums::ErrorCode::FailedToMoveBack);
-                }
+                onError(Enums::ErrorCode::FailedToMoveBackPassthrough);
             }
 
-            if (!Globals::gAudioBackend->stopPassthrough(name))
+            if (Globals::gAudio.getPlayingCount() == 0 && Globals::gAudioBackend->currentlyPassedThrough().empty())
             {
-                onError(Enums::ErrorCode::FailedToMoveBackPassthrough);
+                releaseRouting();
             }
         }
     }
@@ -933,16 +1248,9 @@ namespace Soundux::Objects
         return Globals::gAudio.getAudioDevices();
     }
 #endif
-    void Window::onSoundFinished(const PlayingSound &sound)
+    void Window::onSoundFinished([[maybe_unused]] const PlayingSound &sound)
     {
-        auto scoped = groupedSounds.scoped();
-        if (scoped->find(sound.id) != scoped->end())
-        {
-            scoped->erase(sound.id);
-        }
-        scoped.unlock();
-
-        if (Globals::gAudio.getPlayingSounds().size() == 1)
+        if (Globals::gAudio.getPlayingCount() == 0)
         {
             onAllSoundsFinished();
         }
@@ -955,21 +1263,18 @@ namespace Soundux::Objects
         }
 
 #if defined(__linux__)
-        if (Globals::gAudioBackend)
+        bool replacing = false;
         {
-            if (Globals::gSettings.muteDuringPlayback)
-            {
-                if (!Globals::gAudioBackend->muteInput(false))
-                {
-                    onError(Enums::ErrorCode::FailedToMute);
-                }
-            }
+            std::lock_guard lock(routing.mutex);
+            replacing = routing.replacing;
+        }
+
+        if (Globals::gAudioBackend && !replacing)
+        {
+            setInputMuted(false);
             if (Globals::gAudioBackend->currentlyPassedThrough().empty())
             {
-                if (!Globals::gAudioBackend->stopSoundInput())
-                {
-                    onError(Enums::ErrorCode::FailedToMoveBack);
-                }
+                releaseRouting();
             }
         }
 #elif defined(_WIN32)
@@ -984,6 +1289,11 @@ namespace Soundux::Objects
             }
         }
 #endif
+    }
+    void Window::onTabChanged([[maybe_unused]] const Tab &tab) {}
+    void Window::onTabSoundsChanged([[maybe_unused]] const Tab &tab, [[maybe_unused]] const std::vector<Sound> &changed,
+                                    [[maybe_unused]] const std::vector<std::uint32_t> &removed)
+    {
     }
     void Window::onSoundPlayed([[maybe_unused]] const PlayingSound &sound)
     {
@@ -1001,7 +1311,7 @@ namespace Soundux::Objects
         auto sound = Globals::gData.getSound(id);
         if (sound)
         {
-            if (!Helpers::deleteFile(sound->get().path, Globals::gSettings.deleteToTrash))
+            if (!Helpers::deleteFile(sound->path, Globals::gSettings.deleteToTrash))
             {
                 onError(Enums::ErrorCode::FailedToDelete);
                 return false;
@@ -1025,16 +1335,15 @@ namespace Soundux::Objects
             }
         }
 
-        auto soundsCopy = groupedSounds.copy();
-        for (const auto &[local, remote] : soundsCopy)
+        for (const auto &sound : Globals::gAudio.getPlayingSounds())
         {
             if (shouldPause)
             {
-                pauseSound(local);
+                pauseSound(sound.id);
             }
             else
             {
-                resumeSound(local);
+                resumeSound(sound.id);
             }
         }
 
@@ -1045,11 +1354,13 @@ namespace Soundux::Objects
     {
         name = base.name;
         application = base.application;
+        pid = base.pid;
     }
     IconPlaybackApp::IconPlaybackApp(const PlaybackApp &base)
     {
         name = base.name;
         application = base.application;
+        pid = base.pid;
     }
 #endif
 } // namespace Soundux::Objects
\ No newline at end of file
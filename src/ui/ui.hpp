@@ -1,12 +1,19 @@
 #pragma once
+#include <core/objects/data.hpp>
 #include <core/objects/settings.hpp>
 #include <helper/audio/audio.hpp>
+#include <helper/audio/waveform/waveform.hpp>
 #if defined(__linux__)
 #include <helper/audio/linux/backend.hpp>
 #endif
+#include <helper/ytdl/youtube-dl.hpp>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <mutex>
+#include <optional>
 #include <queue>
+#include <set>
 #include <string>
 #include <var_guard.hpp>
 
@@ -32,10 +39,9 @@ namespace Soundux
         class Window
         {
             friend class Hotkeys;
+            friend class IpcServer;
 
           protected:
-            sxl::var_guard<std::map<std::uint32_t, std::uint32_t>> groupedSounds;
-
             struct
             {
                 std::string exit;
@@ -51,10 +57,57 @@ namespace Soundux
 
           protected:
             virtual std::vector<Sound> getTabContent(const Tab &) const;
+            //* Copies everything but the sounds, `Data::setTab` carries their state over to a rescan
+            std::optional<Tab> getTabWithoutSounds(const std::uint32_t &) const;
+            void indexTab(const Tab &);
+
+            //* Only the first sounds of the selected tab are preloaded, they are the ones that are visible
+            static constexpr std::size_t maxTabPreloads = 64;
+            //* Preloads the sounds of the tab that have a hotkey, and all of them if it is the selected tab
+            void preloadTab(const Tab &);
 
 #if defined(__linux__)
+            //* Deduplicated by name and annotated with their icons, only rebuilt once the backend reports a change
+            struct
+            {
+                std::mutex mutex;
+                bool outputsDirty = true;
+                bool playbackDirty = true;
+                bool updateScheduled = false;
+
+                std::vector<std::shared_ptr<IconRecordingApp>> outputs;
+                std::vector<std::shared_ptr<IconPlaybackApp>> playback;
+            } apps;
+
+            //* Has to be called again once the backend is replaced
+            void watchApps();
+            //* Has to be called from the main thread because of the icons
+            void updateApps();
+            void onAppsChanged(Enums::AppType);
+
             virtual std::vector<std::shared_ptr<IconRecordingApp>> getOutputs();
             virtual std::vector<std::shared_ptr<IconPlaybackApp>> getPlayback();
+
+            //* The outputs stay routed to soundux between plays, so that a play only has to start the audio
+            struct
+            {
+                std::mutex mutex;
+                bool muted = false;
+                //* Set while the playing sounds are stopped to make room for the next one
+                bool replacing = false;
+
+                std::vector<std::string> outputs;
+                std::set<std::string> routed;
+                std::optional<std::chrono::steady_clock::time_point> idleSince;
+            } routing;
+
+            //* Routes the configured outputs that are not routed yet, returns false if none of them is
+            bool openRouting();
+            //* Keeps the routes for `Settings::routingIdleTimeout` seconds in case another sound is played
+            void releaseRouting();
+            //* With `idleOnly` the routes are only closed if they were not used for the idle timeout
+            void closeRouting(bool idleOnly = false);
+            void setInputMuted(bool);
 #else
             virtual std::vector<AudioDevice> getOutputs();
 #endif
@@ -71,10 +124,11 @@ namespace Soundux
 
           protected:
             virtual std::vector<Tab> addTab();
-            virtual std::vector<Tab> removeTab(const std::uint32_t &);
+            virtual TabChanges removeTab(const std::uint32_t &);
             virtual std::optional<Tab> refreshTab(const std::uint32_t &);
-            virtual std::vector<Tab> changeTabOrder(const std::vector<int> &);
+            virtual TabChanges changeTabOrder(const std::vector<int> &);
             virtual std::optional<Tab> setSortMode(const std::uint32_t &, Enums::SortMode);
+            virtual std::optional<SoundPage> getTabSounds(const std::uint32_t &, std::size_t, std::size_t);
 
           protected:
             virtual bool toggleSoundPlayback();
@@ -89,6 +143,10 @@ namespace Soundux
             virtual std::optional<PlayingSound> seekSound(const std::uint32_t &, std::uint64_t);
 
             virtual std::optional<Sound> setHotkey(const std::uint32_t &, const std::vector<int> &);
+            //* Called when the sound is hovered, so that it is decoded by the time it is clicked
+            virtual void preloadSound(const std::uint32_t &);
+            //* The level of the waveform closest to `buckets`, empty until the sound was analyzed
+            virtual std::optional<WaveformPeaks> getWaveform(const std::uint32_t &, std::size_t buckets);
             virtual std::optional<Sound> setCustomLocalVolume(const std::uint32_t &, const std::optional<int> &);
             virtual std::optional<Sound> setCustomRemoteVolume(const std::uint32_t &, const std::optional<int> &);
 
@@ -104,9 +162,19 @@ namespace Soundux
             virtual void onSoundPlayed(const PlayingSound &);
             virtual void onError(const Enums::ErrorCode &) = 0;
             virtual void onSoundFinished(const PlayingSound &);
+            virtual void onTabChanged(const Tab &);
+            //* Also called for finished downloads, so that they are usable before the watcher notices them
+            virtual void onFilesChanged(const std::string &, const std::set<std::string> &);
+            //* Only the sounds that were added or changed and the ids of the removed ones
+            virtual void onTabSoundsChanged(const Tab &, const std::vector<Sound> &,
+                                            const std::vector<std::uint32_t> &);
             virtual void onHotKeyReceived(const std::vector<int> &);
-            virtual void onSoundProgressed(const PlayingSound &) = 0;
-            virtual void onDownloadProgressed(float, const std::string &) = 0;
+            virtual void onSoundProgressed(const SoundProgress &) = 0;
+            virtual void onDownloadProgressed(const Download &) = 0;
+#if defined(__linux__)
+            virtual void onOutputsChanged(const std::vector<std::shared_ptr<IconRecordingApp>> &) = 0;
+            virtual void onPlaybackChanged(const std::vector<std::shared_ptr<IconPlaybackApp>> &) = 0;
+#endif
         };
     } // namespace Objects
 } // namespace Soundux
\ No newline at end of file